@@ -15,5 +15,5 @@ echo ""
 echo Libraries and headers added into /lib and /headers
 echo ...
 echo Building infrakit-instance-oneview
-gcc infrakit-instance-oneview.c ./src/*.c -std=gnu99 -o3 -s -I./headers -L./lib -ljansson -lcurl -o infrakit-instance-oneview
+gcc infrakit-instance-oneview.c ./src/*.c -std=gnu99 -o3 -s -I./headers -L./lib -ljansson -lcurl -lpthread -o infrakit-instance-oneview
 ls -la ./infrakit-instance-oneview
@@ -15,6 +15,8 @@
 #ifndef oneview_h
 #define oneview_h
 
+#include <stddef.h>
+
 #define JSON_H
 
 #define OVPERIOD_1MIN 0
@@ -25,19 +27,44 @@
 typedef struct ovDebug oneviewDebug;
 typedef struct ovSession oneviewSession;
 typedef struct ovQuery oneviewQuery;
+typedef struct ovHardware oneviewHardware;
+typedef struct ovURL oneviewURL;
 
 
 struct ovQuery
 {
-    int start;
+    int start; // Index of the first response
     int count; // Number of responses from the query
     char *filter; // Filter used
     char *query; // Query
+    char *sort; // Sort order e.g. name:ascending
+    char *fields; // Comma separated list of fields to return
+};
+
+struct ovURL
+{
+    char *data; // URL being built (always NULL terminated)
+    size_t length; // Length of the URL
+    size_t size; // Allocated size of data
+    int parameters; // Number of query parameters added
+};
+
+struct ovHardware
+{
+    char *uri; // URI of the server hardware
+    char *name; // Name of the server hardware
+    char *state; // Current state e.g. ProfileApplied
+    char *powerState; // On / Off
+    char *serverProfileUri; // URI of the applied profile (NULL if unassigned)
+    char *serverHardwareTypeUri; // URI of the hardware type
+    char *enclosureUri; // URI of the enclosure holding the hardware (locationUri)
+    char *description; // Description of the server hardware
 };
 
 struct ovDebug
 {
-    char *usedAddress; // contains the last used address
+    char *usedAddress; // contains the last used address (points into url)
+    oneviewURL *url; // re-usable URL builder
     char *buffer; // contains the raw HTTP response
 };
 
@@ -48,6 +75,7 @@ struct ovSession
     const char *cookie;
     char *username;
     char *password;
+    int managed; // Session in the session manager it is attached to (-1 if it isn't attached)
     oneviewDebug *debug;
 };
 
@@ -58,6 +86,18 @@ struct ovSession
 
 oneviewSession *initSession();
 
+/*
+ * freeSession(oneviewSession) - Free a session and the copies it holds once it was attached
+ */
+
+void freeSession(oneviewSession *session);
+
+/*
+ * ovSessionFromEnvironment() - A logged in session from OV_ADDRESS, OV_USERNAME and OV_PASSWORD
+ */
+
+oneviewSession *ovSessionFromEnvironment();
+
 /*
  * loadSession(oneviewSession) - This will load the session from the home director
  */
@@ -66,11 +106,14 @@ int loadSession(oneviewSession *session);
 
  /* int create/delete profiles uses a profileURI
   * int poweroff requires a hardware URI
+  * the response (the OneView task) is returned if response isn't NULL
   */
 
-int ovPostProfile(oneviewSession *session, char *profile);
-int ovDeleteProfile(oneviewSession *session, char *profile);
-int ovPowerOffHardware(oneviewSession *session, const char *hardwareURI);
+int ovPostProfile(oneviewSession *session, char *profile, char **response);
+size_t ovPostProfiles(oneviewSession *session, char **profiles, size_t count, char **responses, int concurrency);
+int ovDeleteProfile(oneviewSession *session, char *profile, char **response);
+int ovPowerOffHardware(oneviewSession *session, const char *hardwareURI, char **response);
+size_t ovPowerOffHardwareBatch(oneviewSession *session, const char **hardwareURIs, size_t count, int concurrency, char **responses);
 
 /*
  * oneviewQuery *initQuery()
@@ -78,6 +121,28 @@ int ovPowerOffHardware(oneviewSession *session, const char *hardwareURI);
 
 oneviewQuery *initQuery();
 
+/*
+ * char *oneViewQuery(oneviewSession, query, uri) GET a REST uri with an optional query
+ */
+
+char *oneViewQuery(oneviewSession *session, oneviewQuery *query, char *queryType);
+
+/*
+ * char *oneViewQueryIfChanged(oneviewSession, query, uri, eTag, unchanged, newETag, size) GET a
+ * REST uri unless it still has the ETag
+ */
+
+char *oneViewQueryIfChanged(oneviewSession *session, oneviewQuery *query, char *queryType, const char *eTag, int *unchanged, char *newETag, size_t newETagSize);
+
+/*
+ * size_t oneViewMultiQuery(oneviewSession, uris, count, responses) GET a batch of REST uris
+ * concurrently, returns the number of responses (failed requests leave a NULL response)
+ */
+
+#define OV_QUERY_CONCURRENCY 8
+
+size_t oneViewMultiQuery(oneviewSession *session, char **uris, size_t count, char **responses);
+
 /*
  * char *ovQueryServerProfiles(oneviewSession, query string)
  */
@@ -92,8 +157,18 @@ char *ovQueryNewServerProfileTemplates(oneviewSession *session, oneviewQuery *qu
 
 char *ovQueryServerHardware(oneviewSession *session, oneviewQuery *query);
 
+char *ovQueryServerHardwareWithURI(oneviewSession *session, oneviewQuery *query, const char *hardwareURI);
+
 char *ovQueryEnclosureGroups(oneviewSession *session, oneviewQuery *query);
 
+/*
+ * Index search across resource categories
+ */
+
+char *ovQueryIndexResources(oneviewSession *session, oneviewQuery *query, const char *categories[], int categoryCount);
+
+char *ovQueryWithURI(oneviewSession *session, const char *uri);
+
 
 /*
  * Network queries
@@ -139,6 +214,16 @@ int ovLogin(oneviewSession *session);
 void createURL(oneviewSession *session, char *uri);
 void createURLWithQuery(oneviewSession *session, oneviewQuery *query, char *uri);
 
+// URL builder, percent-encodes into a buffer that is re-used between requests
+oneviewURL *initURL();
+void freeURL(oneviewURL *url);
+void ovURLReset(oneviewURL *url);
+int ovURLAppend(oneviewURL *url, const char *text);
+int ovURLAppendEscaped(oneviewURL *url, const char *text);
+int ovURLAddParameter(oneviewURL *url, const char *key, const char *value);
+int ovURLAddIntegerParameter(oneviewURL *url, const char *key, long long value);
+int ovURLBuild(oneviewURL *url, const char *address, const char *uri, oneviewQuery *query);
+
 
 
 int stringMatch(const char *string1, const char *string2);
@@ -148,8 +233,16 @@ void setOVHeaders(oneviewSession *session);
 //Determine version of HPE OneView
 long long identifyOneview(oneviewSession *session);
 
+/*
+ * Single server hardware lookups (one GET of the hardware resource)
+ */
+
+oneviewHardware *ovGetServerHardware(oneviewSession *session, const char *hardwareURI);
+int freeServerHardware(oneviewHardware *hardware);
+
 char *serverProfileFromHardwareURI(oneviewSession *session, const char *hardwareURI);
 char *stateFromHardwareURI(oneviewSession *session, const char *hardwareURI);
+char *ovServerPoweredOn(oneviewSession *session, char *hardwareURI);
 
 
 
@@ -0,0 +1,43 @@
+
+// oneviewArena.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewArena_h
+#define oneviewArena_h
+
+#include <stddef.h>
+#include <jansson.h>
+
+// Size of each block of arena memory
+#define OV_ARENA_CHUNK_SIZE (256 * 1024)
+
+// Allocations are aligned to this
+#define OV_ARENA_ALIGNMENT 16
+
+/* While a request is being handled every JSON value created on that thread comes from the
+ * thread's arena, and freeing them does nothing. The arena is reset in one step when the
+ * request ends, so anything that has to outlive the request must be promoted first (or be
+ * created between ovArenaSuspend and ovArenaResume).
+ *
+ * Text from json_dumps is freed with free(), so it must come from ovDumpJSON instead.
+ */
+
+void ovArenaInstall();
+void ovArenaBegin();
+void ovArenaEnd();
+void ovArenaSuspend();
+void ovArenaResume();
+int ovArenaOwns(const void *pointer);
+json_t *ovArenaPromote(json_t *json);
+char *ovDumpJSON(const json_t *json, size_t flags);
+
+#endif /* oneviewArena_h */
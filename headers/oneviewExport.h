@@ -0,0 +1,67 @@
+
+// oneviewExport.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewExport_h
+#define oneviewExport_h
+
+#include <stdio.h>
+#include "oneview.h"
+#include "oneviewExtract.h"
+
+// Output formats
+#define OV_EXPORT_CSV       0   // RFC 4180 quoting, with a header row
+#define OV_EXPORT_TSV       1   // Tabs, newlines and backslashes escaped, with a header row
+#define OV_EXPORT_JSONL     2   // One JSON object per member
+#define OV_EXPORT_DELIMITED 3   // Values as they are with any delimiter (ovParseArray)
+
+// Output is written once this much has been buffered
+#define OV_EXPORT_BUFFER_SIZE (1024 * 1024)
+
+/* Streams the members of collection responses out as rows. The columns are resolved into
+ * extractor fields once, so each member is read in a single pass over its text and nothing
+ * is parsed into a JSON document. Rows are built in a large buffer that is written out with
+ * a single fwrite() whenever it fills.
+ */
+
+typedef struct {
+    FILE *output;                               // Where the rows are written
+    int format;                                 // OV_EXPORT_*
+    char delimiter;                             // Between columns (CSV, TSV and DELIMITED)
+
+    char *buffer;                               // Rows waiting to be written
+    size_t used;
+    size_t size;
+    char *scratch;                              // Decoded strings that contain escapes
+    size_t scratchSize;
+
+    int columnCount;
+    char **columns;                             // Paths of the columns (borrowed)
+    ovJSONSlice values[OV_EXTRACT_MAX_FIELDS];  // Values of the current member
+    ovJSONField fields[OV_EXTRACT_MAX_FIELDS];  // Column paths mapped to the values
+
+    ovStructuralIndex structural;               // Reused for each large page
+    int headerWritten;                          // Set once the CSV or TSV header is written
+    size_t rows;                                // Members exported so far
+    int failed;                                 // Set if a write or allocation failed
+} oneviewExport;
+
+int initExport(oneviewExport *exporter, FILE *output, int format, char *columns[], int columnCount);
+int ovExportFormatFromString(const char *format);
+long ovExportMembers(oneviewExport *exporter, const char *rawJSON, size_t length, const char *arrayName);
+long ovExportCollection(oneviewSession *session, oneviewExport *exporter, char *rawJSON);
+int ovExportFlush(oneviewExport *exporter);
+int freeExport(oneviewExport *exporter);
+
+int startInventoryExport(const char *resource, const char *format, char *columns[], int columnCount);
+
+#endif /* oneviewExport_h */
@@ -0,0 +1,70 @@
+
+// oneviewExtract.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewExtract_h
+#define oneviewExtract_h
+
+#include <stddef.h>
+#include "oneviewStructural.h"
+
+// Types of an extracted value
+#define OV_JSON_MISSING 0
+#define OV_JSON_STRING  1
+#define OV_JSON_NUMBER  2
+#define OV_JSON_OBJECT  3
+#define OV_JSON_ARRAY   4
+#define OV_JSON_TRUE    5
+#define OV_JSON_FALSE   6
+#define OV_JSON_NULL    7
+
+// Maximum number of fields that can be extracted in a single pass
+#define OV_EXTRACT_MAX_FIELDS 32
+
+/* A slice is a value inside of the response buffer, nothing is copied. For strings the slice
+ * excludes the quotes and escapes are left as they are (see ovSliceCopy), for objects and
+ * arrays the slice includes the brackets.
+ */
+
+typedef struct {
+    const char *start;      // First byte of the value
+    size_t length;          // Length of the value
+    int type;               // OV_JSON_*
+} ovJSONSlice;
+
+/* A field to extract, the path is the keys of the nested objects separated by a dot
+ * e.g. "currentVersion" or "attributes.state"
+ */
+
+typedef struct {
+    const char *path;       // Path to the value
+    ovJSONSlice *slot;      // Where the value is placed (type is OV_JSON_MISSING if not found)
+} ovJSONField;
+
+int ovExtractFields(const char *buffer, size_t length, ovJSONField *fields, int fieldCount);
+int ovNextElement(const ovJSONSlice *array, size_t *offset, ovJSONSlice *element);
+int ovNextMember(const ovJSONSlice *object, size_t *offset, ovJSONSlice *key, ovJSONSlice *value);
+
+/*
+ * The same, using a structural index of the response (for large collections)
+ */
+
+int ovExtractIndexedFields(const ovStructuralIndex *index, const char *buffer, size_t length, ovJSONField *fields, int fieldCount);
+int ovNextIndexedElement(const ovStructuralIndex *index, const ovJSONSlice *array, size_t *offset, ovJSONSlice *element);
+int ovNextIndexedMember(const ovStructuralIndex *index, const ovJSONSlice *object, size_t *offset, ovJSONSlice *key, ovJSONSlice *value);
+
+int ovSliceEquals(const ovJSONSlice *slice, const char *value);
+size_t ovSliceCopy(const ovJSONSlice *slice, char *output, size_t size);
+char *ovSliceDup(const ovJSONSlice *slice);
+long long ovSliceInteger(const ovJSONSlice *slice);
+
+#endif /* oneviewExtract_h */
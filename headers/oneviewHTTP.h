@@ -24,8 +24,13 @@ void setHttpData(const char* dataString);
 void setHttpPort (long httpPort);
 void SetHttpMethod(int method);
 char *httpFunction(char *url);
+size_t httpMultiFunction(char **urls, size_t count, char **responses, int concurrency);
+size_t httpMultiDataFunction(char **urls, char **data, size_t count, char **responses, int concurrency);
+long httpResponseCode();
+const char *httpResponseETag();
 void PrintHttpAuth();
 void createHeader(char *key, const char *data);
+void setHttpRenewal(const char *(*renew)(void *context), void *context);
 
 #define DCHTTPPOST     0 // POST Operation
 #define DCHTTPPUT      1 // PUT Operation
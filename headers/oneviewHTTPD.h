@@ -12,6 +12,7 @@
  */
 
 #include <stddef.h>
+#include "oneviewJSONWriter.h"
 
 typedef struct {
     char *socketPath;       // Path to UNIX Socket to pind to
@@ -35,10 +36,17 @@ typedef struct {
     int responseCode;       // Response to a request
     size_t messageLength;   // Size of the reponse message for Content Length response
     char *messageBody;      // The response message
+    int ownsBody;           // The message is freed once it is sent (it isn't in the writer)
 } httpResponse;
 
 
 #define BUFFER_SIZE 1024*1024
+
+// Returned by the POST callback when the response will be sent later (httpRespondToConnection)
+#define OV_HTTPD_DEFERRED 2
+
+// Most connections that can be held waiting for a deferred response
+#define OV_HTTPD_MAX_HELD 64
 //#define MAX_FILE_SIZE 5*1024
 //#define TRUE 1
 //#define FALSE 0
@@ -54,9 +62,16 @@ void startHTTPDServer();
 httpRequest *processHttpRequest(char *rawData);
 int setSocketPath(char *path);
 int setHTTPResponse(char *messageBody, int responseCode);
+ovJSONWriter *httpResponseWriter();
+int setHTTPResponseFromWriter(ovJSONWriter *writer, int responseCode);
+int httpCurrentConnection();
+int httpRespondToConnection(int connection, ovJSONWriter *writer, int responseCode);
+void setHTTPCoalesceWindow(long milliseconds);
+long getHTTPCoalesceWindow();
 
 
 #ifndef HTTPDCALLBACK_H
 #define HTTPDCALLBACK_H
 void SetPostFunction( int (*postCallbackFunction)(httpRequest *));
+void SetFlushFunction( int (*flushCallbackFunction)(void));
 #endif
@@ -0,0 +1,40 @@
+
+// oneviewHash.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewHash_h
+#define oneviewHash_h
+
+#include <stddef.h>
+
+// Value returned when a key isn't in the index
+#define OV_HASH_NOT_FOUND -1
+
+/* An open addressing hash index from a string to an integer (typically the position of a
+ * record in an array). The keys aren't copied, they must stay allocated as long as the index.
+ */
+
+typedef struct {
+    size_t size;            // Number of slots (always a power of two)
+    size_t count;           // Number of keys in the index
+    const char **keys;      // Key held in each slot (NULL if empty)
+    int *values;            // Value held in each slot
+} oneviewHashIndex;
+
+unsigned long ovHashString(const char *key);
+
+int initHashIndex(oneviewHashIndex *index, size_t expected);
+int ovHashInsert(oneviewHashIndex *index, const char *key, int value);
+int ovHashFind(const oneviewHashIndex *index, const char *key);
+int freeHashIndex(oneviewHashIndex *index);
+
+#endif /* oneviewHash_h */
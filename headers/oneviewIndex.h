@@ -0,0 +1,58 @@
+
+// oneviewIndex.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewIndex_h
+#define oneviewIndex_h
+
+#include <stddef.h>
+#include "oneview.h"
+
+// Index categories
+#define OV_INDEX_SERVER_HARDWARE            0
+#define OV_INDEX_SERVER_PROFILES            1
+#define OV_INDEX_SERVER_PROFILE_TEMPLATES   2
+
+// Maximum number of keys that are placed into a single index search
+#define OV_INDEX_BATCH_SIZE 40
+
+typedef struct {
+    int category;               // Category to search (OV_INDEX_*)
+    const char *uri;            // Look up the resource by uri (or NULL)
+    const char *name;           // Look up the resource by name (or NULL)
+} oneviewIndexKey;
+
+typedef struct {
+    int category;               // Category of the resource (OV_INDEX_*)
+    char *uri;                  // uri of the resource
+    char *name;                 // name of the resource
+    char *state;                // state e.g. ProfileApplied
+    char *powerState;           // On / Off (server-hardware)
+    char *serverProfileUri;     // Profile applied to hardware (server-hardware)
+    char *serverHardwareUri;    // Hardware a profile is applied to (server-profiles)
+    char *serverHardwareTypeUri;// Hardware type (server-hardware / templates)
+    char *enclosureGroupUri;    // Enclosure group (server-profiles / templates)
+} oneviewIndexRecord;
+
+typedef struct {
+    size_t count;               // Number of records returned
+    oneviewIndexRecord *records;// Array of records
+} oneviewIndexResult;
+
+const char *ovIndexCategoryName(int category);
+
+oneviewIndexResult *ovIndexLookup(oneviewSession *session, const oneviewIndexKey *keys, size_t keyCount);
+oneviewIndexRecord *ovIndexFindURI(oneviewIndexResult *result, int category, const char *uri);
+oneviewIndexRecord *ovIndexFindName(oneviewIndexResult *result, int category, const char *name);
+int freeIndexResult(oneviewIndexResult *result);
+
+#endif /* oneviewIndex_h */
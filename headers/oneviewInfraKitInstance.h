@@ -12,6 +12,9 @@
  */
 
 #include "jansson.h"
+#include "oneviewIntern.h"
+#include "oneviewJSONWriter.h"
+#include "oneview.h"
 
 #ifndef PROFILE_H
 #define PROFILE_H
@@ -20,18 +23,23 @@
 #define INSTANCE_NETWORK 1
 #define INSTANCE_STORAGE 2
 
+/* The strings of an instance or profile are interned (see oneviewIntern.h), use
+ * ovInternString() to return the string of an id. The name of a profile is unique to its
+ * instance, so it is a copy owned by whoever made the profile instead.
+ */
+
 typedef struct {
-    char *instanceName;          // pointer to name of instance
+    int instanceName;           // interned name of instance
     size_t instanceType;              // signed integer to hold the instance type
 } instance;
 
 typedef struct {
-    char *profileName;          // pointer to name of Profile
-    char *templateName;         // pointer to name of Template Profile
-    char *uri;                  // pointer to uri of Profile
-    char *availableHardwareURI; // pointer to uri of available Hardware
-    char *hardwareTypeUri;      // pointer to hardwareURI string of profile
-    char *enclosureUri;         // pointer to hardwareURI string of profile
+    char *profileName;          // name of Profile (NULL for a template)
+    int templateName;           // interned name of Template Profile
+    int uri;                    // interned uri of Profile
+    int availableHardwareURI;   // interned uri of available Hardware
+    int hardwareTypeUri;        // interned hardwareURI string of profile
+    int enclosureUri;           // interned enclosureURI string of profile
 } profile;
 
 typedef struct {
@@ -41,11 +49,19 @@ typedef struct {
 
 #endif
 
-instance *processInstanceJSON(json_t *json_text, long long id);
+size_t processInstanceBatch(json_t *specs, long long id, const long long *ids, char **instanceNames);
+
+profile *findProfileTemplate(oneviewSession *session, const char *templateName);
+size_t reserveFreeHardware(oneviewSession *session, const char *hardwareTypeuri, int *hardware, size_t count);
+
+/* Each writes its JSON-RPC response into the writer
+ */
 
-char *ovInfraKitInstanceDescribe(json_t *params, long long id);
-char *ovInfraKitInstanceProvision(json_t *params, long long id);
-char *ovInfraKitInstanceDestroy(json_t *params, long long id);
+int ovInfraKitInstanceDescribe(json_t *params, long long id, ovJSONWriter *writer);
+int ovInfraKitInstanceProvision(json_t *params, long long id, ovJSONWriter *writer);
+int ovInfraKitInstanceProvisionBatch(json_t *specs, long long id, ovJSONWriter *writer);
+int ovInfraKitInstanceWriteProvisioned(const char *instanceName, long long id, ovJSONWriter *writer);
+int ovInfraKitInstanceDestroy(json_t *params, long long id, ovJSONWriter *writer);
 
 int instanceLogin(const char *address, const char *username, const char *password);
 
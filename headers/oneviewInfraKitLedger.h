@@ -0,0 +1,51 @@
+
+// oneviewInfraKitLedger.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewInfraKitLedger_h
+#define oneviewInfraKitLedger_h
+
+#include <stddef.h>
+
+// How a server is held in the ledger
+#define OV_LEDGER_FREE      0   // Not held by an instance
+#define OV_LEDGER_LEASED    1   // Reserved for an instance that isn't in the state yet
+#define OV_LEDGER_RECORDED  2   // Held by an instance in the state
+
+// Seconds a lease is held if the instance is never recorded in the state
+#define OV_LEDGER_LEASE_S   120
+
+/* The ledger holds the servers that instances have claimed, so a server can be checked without
+ * reading the state. It is loaded from the state once and then kept in step with it, a server
+ * is leased when it is reserved, recorded with the instance that owns it when the instance is
+ * added to the state and freed when the instance is removed.
+ *
+ * Servers are interned (see oneviewIntern.h), the name of the instance that holds a server
+ * is a copy owned by the ledger.
+ */
+
+typedef struct {
+    int hardwareURI;            // Server that is held
+    char *owner;                // Instance that holds it (NULL while leased)
+    int held;                   // OV_LEDGER_*
+    double leased;              // When the server was claimed (monotonic seconds)
+} ovLedgerEntry;
+
+int ovLedgerLoad();
+int ovLedgerClaim(int hardwareURI);
+int ovLedgerRecord(int hardwareURI, const char *instanceID);
+int ovLedgerRelease(int hardwareURI, const char *instanceID);
+int ovLedgerIsClaimed(int hardwareURI);
+char *ovLedgerOwner(int hardwareURI);
+size_t ovLedgerClaimed();
+
+#endif /* oneviewInfraKitLedger_h */
@@ -0,0 +1,58 @@
+
+// oneviewInfraKitPipeline.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewInfraKitPipeline_h
+#define oneviewInfraKitPipeline_h
+
+#include <stddef.h>
+
+// Types of job
+#define OV_JOB_PROFILE      0   // Create the profile of a new instance
+#define OV_JOB_POWER_OFF    1   // Power off a server so that it can be used later
+
+// Most jobs taken from the queue for each pass through the stages
+#define OV_PIPELINE_BATCH 64
+
+// Requests in flight in each stage
+#define OV_PIPELINE_POWER_CONCURRENCY       4
+#define OV_PIPELINE_POST_CONCURRENCY        8
+
+/* Provision replies once the hardware is reserved and the instance is recorded as pending,
+ * the slow OneView work is queued as jobs for the pipeline thread. It takes the queued jobs
+ * in batches and moves each batch through the stages (power off, new profiles from the
+ * templates, profile POSTs and a single state update), every stage sends its requests
+ * concurrently with a bounded number in flight.
+ *
+ * The queue is only held in memory, instances that are still pending when the plugin starts
+ * again are marked as failed.
+ *
+ * The name and description of a job are copies owned by the job (the queue takes them when
+ * the job is submitted), the other strings are interned (see oneviewIntern.h).
+ */
+
+typedef struct {
+    int type;                   // OV_JOB_*
+    char *instanceName;         // Name of the instance (and its profile), NULL for a power off
+    int hardwareURI;            // Server the job is for
+    int templateURI;            // Template the profile is created from
+    char *description;          // Description of the profile
+    int address;                // Appliance the job is sent to
+    int username;               // User the job is sent as (see oneviewSessions.h)
+} ovProvisionJob;
+
+int ovPipelineStart();
+int ovPipelineSubmit(const ovProvisionJob *jobs, size_t count);
+void ovPipelineFreeJobs(ovProvisionJob *jobs, size_t count);
+size_t ovPipelinePending();
+
+#endif /* oneviewInfraKitPipeline_h */
@@ -12,8 +12,12 @@
  */
 
 
+// Milliseconds Provision calls are held for so that they can be provisioned together (0 disables)
+#define OV_PROVISION_WINDOW 20
+
 int ovCreateInfraKitInstance();
 int setSocketName(char *name);
+int setProvisionWindow(long milliseconds);
 signed long getPluginTime();
 
 
@@ -13,13 +13,34 @@
 
 #include "oneview.h"
 #include "oneviewInfraKitInstance.h"
+#include "oneviewHash.h"
 
 #include "jansson.h"
 
+// Tag holding the provisioning status of an instance, and its values
+#define OV_INSTANCE_STATUS_TAG  "oneview.status"
+#define OV_INSTANCE_PENDING     "pending"       // Recorded, the profile hasn't been posted yet
+#define OV_INSTANCE_POSTING     "posting"       // The pipeline is posting the profile
+#define OV_INSTANCE_CREATING    "creating"      // The profile has been posted to OneView
+#define OV_INSTANCE_APPLIED     "applied"       // The task creating the profile completed
+#define OV_INSTANCE_FAILED      "failed"        // OneView didn't accept the profile, or its task failed
+#define OV_INSTANCE_DESTROYED   "destroyed"     // Destroyed while posting or creating, removed once that finishes
+
+// Tag holding the OneView task that is creating the profile of an instance
+#define OV_INSTANCE_TASK_TAG    "oneview.task"
+
+// What destroyInstanceInState did with an instance
+#define OV_DESTROY_NOT_FOUND    -1  // The instance isn't in the state
+#define OV_DESTROY_REMOVED      0   // Nothing was posted for it, it has been removed
+#define OV_DESTROY_DEFERRED     1   // Its profile is being posted or created, it is marked as destroyed
+#define OV_DESTROY_POSTED       2   // It has a profile, which has to be deleted before it is removed
+
  /*State file funcitons
   */
 json_t *openInstanceState();
 int saveInstanceState(char *jsonData);
+void lockInstanceState();
+void unlockInstanceState();
 int setStatePath(char *path);
 char *getStatePath();
 char *getArgStatePath();
@@ -29,13 +50,18 @@ int loginFromState(const char *groupName);
 
 // Add remove from state
 int appendInstanceToState(profile *foundServer, oneviewSession *session, json_t *paramsJSON);
+int appendInstancesToState(profile *foundServers, json_t **paramsJSON, size_t count, oneviewSession *session);
 int removeInstanceFromState(const char *instanceID, const char *groupName);
+int removeInstancesFromState(const char **instanceIDs, size_t count);
+size_t failPendingInstances();
+int destroyInstanceInState(const char *instanceID, const char *groupName);
+size_t markInstancesPosting(const char **instanceIDs, size_t count, char *posting);
+int setInstanceStatuses(const char **instanceIDs, const char **statuses, const char **tasks, size_t count, char *destroyed);
 
 // search state
-char *returnInstanceFromState(const char *InstanceID, char *key);
+const char *returnInstanceFromState(const char *InstanceID, char *key);
 json_t *returnObjectFromInstanceID(const char *InstanceID);
 json_t *findGroup(json_t *state, const char *groupName);
-int findUsedHWInState(const char *hardwareURI);
 
 // return instances
 json_t *returnAllInstances(json_t *state);
@@ -0,0 +1,62 @@
+
+// oneviewInfraKitTasks.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewInfraKitTasks_h
+#define oneviewInfraKitTasks_h
+
+#include <stddef.h>
+
+// Operations that are tracked
+#define OV_TASK_PROFILE_CREATE  0   // The status of the instance follows the task
+#define OV_TASK_PROFILE_DELETE  1   // The hardware is free once the task completes
+#define OV_TASK_POWER_OFF       2   // The hardware can be used once the task completes
+
+// Each task is checked after OV_TASK_POLL_MIN_MS, the interval doubles (up to
+// OV_TASK_POLL_MAX_MS) every time the task is found to be still running
+#define OV_TASK_POLL_MIN_MS     500
+#define OV_TASK_POLL_MAX_MS     10000
+
+// Most tasks checked with one request to /rest/tasks
+#define OV_TASK_POLL_BATCH      32
+
+// Tasks that are still running after this long are no longer tracked
+#define OV_TASK_TIMEOUT_S       3600
+
+/* OneView replies to profile creates and deletes and to power changes with a task, the
+ * tracker polls the tasks in batches and acts on each one as it finishes (the status of the
+ * instance is set to applied or failed, the cached hardware is refreshed).
+ *
+ * The uri of a task and the name of its instance are copies owned by the tracker (they are
+ * freed once the task stops being tracked), the other strings are interned (see
+ * oneviewIntern.h).
+ */
+
+typedef struct {
+    int kind;                   // OV_TASK_*
+    char *taskURI;              // Task returned by OneView
+    char *instanceName;         // Instance the task is for (OV_TASK_PROFILE_CREATE), or NULL
+    int resourceURI;            // Hardware the task acts on
+    int address;                // Appliance the task is running on
+    int username;               // User the task is checked as (see oneviewSessions.h)
+    double started;             // When the task was tracked (monotonic seconds)
+    double nextCheck;           // When the task is next checked
+    long interval;              // Milliseconds between checks
+} ovTrackedTask;
+
+char *ovTaskFromResponse(const char *response);
+int ovTrackTask(int kind, const char *taskURI, const char *instanceName, int resourceURI, int address, int username);
+int ovTaskIsTracked(const char *taskURI);
+size_t ovTasksTracked();
+int ovTaskTrackerStart();
+
+#endif /* oneviewInfraKitTasks_h */
@@ -0,0 +1,37 @@
+
+// oneviewIntern.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewIntern_h
+#define oneviewIntern_h
+
+// Id of a string that isn't set (NULL)
+#define OV_INTERN_NONE 0
+
+// Size of the blocks that interned strings are held in
+#define OV_INTERN_BLOCK_SIZE (64 * 1024)
+
+/*
+ * Every uri or name is held once for the life of the plugin and given a small integer id,
+ * two interned values are equal only if their ids are equal. The table is never freed, so
+ * only the uris and names of the appliance (servers, types, enclosures, templates, addresses
+ * and users) are interned. Strings that are unique to a task, instance or session are copies
+ * owned by whatever holds them.
+ */
+
+int ovIntern(const char *value);
+int ovInternFind(const char *value);
+const char *ovInternString(int id);
+const char *ovInternCanonical(const char *value);
+int ovInternCount();
+
+#endif /* oneviewIntern_h */
@@ -0,0 +1,56 @@
+
+// oneviewInventory.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewInventory_h
+#define oneviewInventory_h
+
+#include "oneview.h"
+#include <jansson.h>
+
+// Default number of seconds between full re-synchronisations of the inventory
+#define OV_INVENTORY_RESYNC 300
+
+// Change types sent on the state-change message bus
+#define OV_CHANGE_CREATED "Created"
+#define OV_CHANGE_UPDATED "Updated"
+#define OV_CHANGE_DELETED "Deleted"
+
+/*
+ * Subscriber, reads state-change messages (one JSON message per line) from a relay socket
+ */
+
+int inventoryStartSubscriber(const char *socketPath);
+int setInventorySocketPath(char *path);
+char *getInventorySocketPath();
+int setInventoryResyncInterval(long seconds);
+
+/*
+ * Inventory state
+ */
+
+int inventoryIsLive();
+int inventoryNeedsResync();
+int inventoryResync(oneviewSession *session);
+int inventoryApplyEvent(const char *message);
+oneviewHardware *inventoryGetServerHardware(const char *hardwareURI);
+json_t *inventoryCopyHardware(unsigned long *generation);
+unsigned long inventoryGeneration();
+json_t *inventoryLoadCollection(oneviewSession *session, char *(*queryFunction)(oneviewSession *, oneviewQuery *));
+
+/*
+ * Stand-in broker, replays messages from a file (or stdin) to any connected subscribers
+ */
+
+int startInventoryBroker(const char *socketPath, const char *eventsPath);
+
+#endif /* oneviewInventory_h */
@@ -16,6 +16,7 @@
 
 #include <stdio.h>
 #include "oneview.h"
+#include <jansson.h>
 
 
 // output types
@@ -27,13 +28,37 @@
 #define OV_PROFILE_STATISTIC_CURR 1 // latest statistic is set in the profile array
 
 
+/* A parsed response, values taken from a document are borrowed from it and are valid until
+ * the document is closed with ovCloseJSONDocument()
+ */
+
+typedef struct {
+    json_t *root;           // Parsed JSON (owned by the document)
+} oneviewJSONDocument;
+
+oneviewJSONDocument *ovOpenJSONDocument(const char *rawJSON);
+json_t *ovDocumentGet(oneviewJSONDocument *document, const char *path);
+size_t ovDocumentArraySize(oneviewJSONDocument *document, const char *path);
+json_t *ovDocumentArrayGet(oneviewJSONDocument *document, const char *path, size_t index);
+const char *ovDocumentString(oneviewJSONDocument *document, const char *path);
+char *ovDocumentDump(oneviewJSONDocument *document, const char *path, int format);
+void ovDocumentParseArray(oneviewJSONDocument *document, const char *arrayName, char delimiter, char *fields[], int fieldCount);
+void ovCloseJSONDocument(oneviewJSONDocument *document);
+
+/*
+ * Single use helpers (one parse per call)
+ */
+
 void ovParseMembers(char *rawJSON, char delimiter, char *fields[], int fieldCount);
 char *returnRawJSONFromObject(char* rawJSON, char *objectName);
 char *returnReadableJSONFromRaw(char *rawJSON);
 size_t returnJSONArraySize(char *rawJSON);
 char *returnJSONObjectAtIndex(size_t index, char *rawJSON);
 void ovParseArray(char *rawJSON, char *arrayName, char delimiter, char *fields[], int fieldCount);
-const char *returnStringfromJSON(char *rawJSON, char *field);
+char *returnStringfromJSON(char *rawJSON, char *field);
+oneviewHardware *ovHardwareFromJSON(json_t *hardwareJSON);
+int ovHardwareFieldsFromJSON(oneviewHardware *hardware, json_t *hardwareJSON);
+int freeServerHardwareFields(oneviewHardware *hardware);
 
 
 #endif /* oneviewJSONParse_h */
@@ -0,0 +1,69 @@
+
+// oneviewJSONWriter.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewJSONWriter_h
+#define oneviewJSONWriter_h
+
+#include <stddef.h>
+#include <jansson.h>
+
+// Bytes held in the writer itself, output only moves to the heap once it is larger than this
+#define OV_WRITER_INLINE_SIZE (16 * 1024)
+
+// Deepest nesting of objects and arrays
+#define OV_WRITER_MAX_DEPTH 32
+
+/* Writes JSON text straight into a buffer as the values are given, adding the commas and
+ * colons and escaping strings, so no JSON document is built to be dumped. Small output stays
+ * in the inline buffer, larger output is moved onto the heap.
+ */
+
+typedef struct {
+    char *data;                                 // The text (inline or on the heap)
+    size_t length;
+    size_t size;
+    int depth;                                  // Objects and arrays that are open
+    int afterKey;                               // A key has been written, the value is next
+    char hasMembers[OV_WRITER_MAX_DEPTH + 1];   // Whether each level has had a member yet
+    int failed;                                 // Set if the text couldn't be written
+    char inlineData[OV_WRITER_INLINE_SIZE];
+} ovJSONWriter;
+
+int initJSONWriter(ovJSONWriter *writer);
+void ovWriterReset(ovJSONWriter *writer);
+const char *ovWriterText(ovJSONWriter *writer);
+size_t ovWriterLength(ovJSONWriter *writer);
+
+int ovWriteBeginObject(ovJSONWriter *writer);
+int ovWriteEndObject(ovJSONWriter *writer);
+int ovWriteBeginArray(ovJSONWriter *writer);
+int ovWriteEndArray(ovJSONWriter *writer);
+int ovWriteKey(ovJSONWriter *writer, const char *key);
+int ovWriteString(ovJSONWriter *writer, const char *value);
+int ovWriteInteger(ovJSONWriter *writer, long long value);
+int ovWriteBoolean(ovJSONWriter *writer, int value);
+int ovWriteNull(ovJSONWriter *writer);
+int ovWriteJSON(ovJSONWriter *writer, const json_t *value);
+int ovWriteText(ovJSONWriter *writer, const char *text, size_t length);
+
+/*
+ * JSON-RPC envelopes, {"jsonrpc":"2.0", <members written by the caller>, "id":<id>}
+ */
+
+int ovWriteRPCBegin(ovJSONWriter *writer);
+int ovWriteRPCEnd(ovJSONWriter *writer, long long id);
+int ovWriteRPCError(ovJSONWriter *writer, long long code, long long id);
+
+int freeJSONWriter(ovJSONWriter *writer);
+
+#endif /* oneviewJSONWriter_h */
@@ -0,0 +1,194 @@
+
+// oneviewResources.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+/* Generated from schema/ by tools/oneviewSchema, edit the schema and run make rather than
+ * editing this file
+ */
+
+#ifndef oneviewResources_h
+#define oneviewResources_h
+
+#include "oneviewExtract.h"
+
+/* Each parser reads the top level members of one resource (a member of a collection, or the
+ * response of a GET) in a single pass. Strings, objects and arrays are slices of the buffer,
+ * so they are only valid while it is. A value is only taken if it has the type in the
+ * schema, the fields that were taken are set in present. Returns the number of fields that
+ * were found or -1 if the buffer isn't an object.
+ */
+
+// Enclosure groups (/rest/enclosure-groups)
+#define OV_ENCLOSURE_GROUP_URI (1ULL << 0)
+#define OV_ENCLOSURE_GROUP_NAME (1ULL << 1)
+#define OV_ENCLOSURE_GROUP_DESCRIPTION (1ULL << 2)
+#define OV_ENCLOSURE_GROUP_STATUS (1ULL << 3)
+#define OV_ENCLOSURE_GROUP_STACKING_MODE (1ULL << 4)
+#define OV_ENCLOSURE_GROUP_LOGICAL_INTERCONNECT_GROUP_URI (1ULL << 5)
+#define OV_ENCLOSURE_GROUP_E_TAG (1ULL << 6)
+#define OV_ENCLOSURE_GROUP_ENCLOSURE_COUNT (1ULL << 7)
+#define OV_ENCLOSURE_GROUP_INTERCONNECT_BAY_MAPPINGS (1ULL << 8)
+
+typedef struct {
+    ovJSONSlice uri;
+    ovJSONSlice name;
+    ovJSONSlice description;
+    ovJSONSlice status;
+    ovJSONSlice stackingMode;
+    ovJSONSlice logicalInterconnectGroupUri;
+    ovJSONSlice eTag;
+    long long enclosureCount;
+    ovJSONSlice interconnectBayMappings;
+    unsigned long long present;
+} oneviewEnclosureGroup;
+
+// Interconnects (/rest/interconnects)
+#define OV_INTERCONNECT_URI (1ULL << 0)
+#define OV_INTERCONNECT_NAME (1ULL << 1)
+#define OV_INTERCONNECT_STATE (1ULL << 2)
+#define OV_INTERCONNECT_STATUS (1ULL << 3)
+#define OV_INTERCONNECT_MODEL (1ULL << 4)
+#define OV_INTERCONNECT_PART_NUMBER (1ULL << 5)
+#define OV_INTERCONNECT_PRODUCT_NAME (1ULL << 6)
+#define OV_INTERCONNECT_ENCLOSURE_URI (1ULL << 7)
+#define OV_INTERCONNECT_LOGICAL_INTERCONNECT_URI (1ULL << 8)
+#define OV_INTERCONNECT_POWER_STATE (1ULL << 9)
+#define OV_INTERCONNECT_E_TAG (1ULL << 10)
+#define OV_INTERCONNECT_PORT_COUNT (1ULL << 11)
+#define OV_INTERCONNECT_ENABLE_FAST_MAC_CACHE_FAILOVER (1ULL << 12)
+#define OV_INTERCONNECT_PORTS (1ULL << 13)
+
+typedef struct {
+    ovJSONSlice uri;
+    ovJSONSlice name;
+    ovJSONSlice state;
+    ovJSONSlice status;
+    ovJSONSlice model;
+    ovJSONSlice partNumber;
+    ovJSONSlice productName;
+    ovJSONSlice enclosureUri;
+    ovJSONSlice logicalInterconnectUri;
+    ovJSONSlice powerState;
+    ovJSONSlice eTag;
+    long long portCount;
+    int enableFastMacCacheFailover;
+    ovJSONSlice ports;
+    unsigned long long present;
+} oneviewInterconnect;
+
+// Server hardware (/rest/server-hardware)
+#define OV_SERVER_HARDWARE_URI (1ULL << 0)
+#define OV_SERVER_HARDWARE_NAME (1ULL << 1)
+#define OV_SERVER_HARDWARE_DESCRIPTION (1ULL << 2)
+#define OV_SERVER_HARDWARE_STATE (1ULL << 3)
+#define OV_SERVER_HARDWARE_STATUS (1ULL << 4)
+#define OV_SERVER_HARDWARE_POWER_STATE (1ULL << 5)
+#define OV_SERVER_HARDWARE_MODEL (1ULL << 6)
+#define OV_SERVER_HARDWARE_SERIAL_NUMBER (1ULL << 7)
+#define OV_SERVER_HARDWARE_SERVER_PROFILE_URI (1ULL << 8)
+#define OV_SERVER_HARDWARE_SERVER_HARDWARE_TYPE_URI (1ULL << 9)
+#define OV_SERVER_HARDWARE_SERVER_GROUP_URI (1ULL << 10)
+#define OV_SERVER_HARDWARE_LOCATION_URI (1ULL << 11)
+#define OV_SERVER_HARDWARE_E_TAG (1ULL << 12)
+#define OV_SERVER_HARDWARE_POSITION (1ULL << 13)
+#define OV_SERVER_HARDWARE_MEMORY_MB (1ULL << 14)
+#define OV_SERVER_HARDWARE_PROCESSOR_COUNT (1ULL << 15)
+#define OV_SERVER_HARDWARE_PROCESSOR_CORE_COUNT (1ULL << 16)
+
+typedef struct {
+    ovJSONSlice uri;
+    ovJSONSlice name;
+    ovJSONSlice description;
+    ovJSONSlice state;
+    ovJSONSlice status;
+    ovJSONSlice powerState;
+    ovJSONSlice model;
+    ovJSONSlice serialNumber;
+    ovJSONSlice serverProfileUri;
+    ovJSONSlice serverHardwareTypeUri;
+    ovJSONSlice serverGroupUri;
+    ovJSONSlice locationUri;
+    ovJSONSlice eTag;
+    long long position;
+    long long memoryMb;
+    long long processorCount;
+    long long processorCoreCount;
+    unsigned long long present;
+} oneviewServerHardware;
+
+// Server profiles (/rest/server-profiles)
+#define OV_SERVER_PROFILE_URI (1ULL << 0)
+#define OV_SERVER_PROFILE_NAME (1ULL << 1)
+#define OV_SERVER_PROFILE_DESCRIPTION (1ULL << 2)
+#define OV_SERVER_PROFILE_STATE (1ULL << 3)
+#define OV_SERVER_PROFILE_STATUS (1ULL << 4)
+#define OV_SERVER_PROFILE_SERVER_HARDWARE_URI (1ULL << 5)
+#define OV_SERVER_PROFILE_SERVER_HARDWARE_TYPE_URI (1ULL << 6)
+#define OV_SERVER_PROFILE_ENCLOSURE_GROUP_URI (1ULL << 7)
+#define OV_SERVER_PROFILE_SERVER_PROFILE_TEMPLATE_URI (1ULL << 8)
+#define OV_SERVER_PROFILE_TEMPLATE_COMPLIANCE (1ULL << 9)
+#define OV_SERVER_PROFILE_TASK_URI (1ULL << 10)
+#define OV_SERVER_PROFILE_E_TAG (1ULL << 11)
+#define OV_SERVER_PROFILE_MODIFIED (1ULL << 12)
+
+typedef struct {
+    ovJSONSlice uri;
+    ovJSONSlice name;
+    ovJSONSlice description;
+    ovJSONSlice state;
+    ovJSONSlice status;
+    ovJSONSlice serverHardwareUri;
+    ovJSONSlice serverHardwareTypeUri;
+    ovJSONSlice enclosureGroupUri;
+    ovJSONSlice serverProfileTemplateUri;
+    ovJSONSlice templateCompliance;
+    ovJSONSlice taskUri;
+    ovJSONSlice eTag;
+    ovJSONSlice modified;
+    unsigned long long present;
+} oneviewServerProfile;
+
+// Server profile templates (/rest/server-profile-templates)
+#define OV_SERVER_PROFILE_TEMPLATE_URI (1ULL << 0)
+#define OV_SERVER_PROFILE_TEMPLATE_NAME (1ULL << 1)
+#define OV_SERVER_PROFILE_TEMPLATE_DESCRIPTION (1ULL << 2)
+#define OV_SERVER_PROFILE_TEMPLATE_SERVER_PROFILE_DESCRIPTION (1ULL << 3)
+#define OV_SERVER_PROFILE_TEMPLATE_SERVER_HARDWARE_TYPE_URI (1ULL << 4)
+#define OV_SERVER_PROFILE_TEMPLATE_ENCLOSURE_GROUP_URI (1ULL << 5)
+#define OV_SERVER_PROFILE_TEMPLATE_AFFINITY (1ULL << 6)
+#define OV_SERVER_PROFILE_TEMPLATE_STATUS (1ULL << 7)
+#define OV_SERVER_PROFILE_TEMPLATE_E_TAG (1ULL << 8)
+#define OV_SERVER_PROFILE_TEMPLATE_MODIFIED (1ULL << 9)
+#define OV_SERVER_PROFILE_TEMPLATE_CONNECTION_SETTINGS (1ULL << 10)
+
+typedef struct {
+    ovJSONSlice uri;
+    ovJSONSlice name;
+    ovJSONSlice description;
+    ovJSONSlice serverProfileDescription;
+    ovJSONSlice serverHardwareTypeUri;
+    ovJSONSlice enclosureGroupUri;
+    ovJSONSlice affinity;
+    ovJSONSlice status;
+    ovJSONSlice eTag;
+    ovJSONSlice modified;
+    ovJSONSlice connectionSettings;
+    unsigned long long present;
+} oneviewServerProfileTemplate;
+
+int ovParseEnclosureGroup(const ovStructuralIndex *index, const char *buffer, size_t length, oneviewEnclosureGroup *resource);
+int ovParseInterconnect(const ovStructuralIndex *index, const char *buffer, size_t length, oneviewInterconnect *resource);
+int ovParseServerHardware(const ovStructuralIndex *index, const char *buffer, size_t length, oneviewServerHardware *resource);
+int ovParseServerProfile(const ovStructuralIndex *index, const char *buffer, size_t length, oneviewServerProfile *resource);
+int ovParseServerProfileTemplate(const ovStructuralIndex *index, const char *buffer, size_t length, oneviewServerProfileTemplate *resource);
+
+#endif /* oneviewResources_h */
@@ -0,0 +1,35 @@
+
+// oneviewSessions.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewSessions_h
+#define oneviewSessions_h
+
+#include "oneview.h"
+
+// HPE OneView expires sessions that have been idle for 24 hours (by default), a session that
+// has been idle for this long is logged in again before it is used
+#define OV_SESSION_RENEW_S (23 * 60 * 60)
+
+/* One logged in session is kept for every appliance and user, every thread attaches its own
+ * oneviewSession to it (the request buffers of a session can't be shared) and uses the same
+ * token. The version of the appliance is identified once, and the token is renewed when it
+ * is refused (see setHttpRenewal) or has been idle for too long.
+ *
+ * The address and username of an attached session are interned (see oneviewIntern.h), the
+ * password and token are copies held by the session.
+ */
+
+int ovSessionAttach(oneviewSession *session, const char *address, const char *username, const char *password);
+const char *ovSessionRenew(oneviewSession *session);
+
+#endif /* oneviewSessions_h */
@@ -0,0 +1,146 @@
+
+// oneviewSnapshot.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewSnapshot_h
+#define oneviewSnapshot_h
+
+#include <stdint.h>
+#include <time.h>
+#include "oneview.h"
+#include "oneviewHash.h"
+#include "oneviewIntern.h"
+
+// Number of seconds a hardware snapshot is used for before it is reloaded
+#define OV_SNAPSHOT_TTL 10
+
+// Terminates the server chains (type, enclosure and free lists)
+#define OV_SNAPSHOT_END -1
+
+// Offset of a string that isn't set (the strings of a snapshot start with an empty string)
+#define OV_SNAPSHOT_NO_STRING 0
+
+// Server hardware states
+#define OV_HARDWARE_STATE_UNKNOWN           0
+#define OV_HARDWARE_STATE_ADDING            1
+#define OV_HARDWARE_STATE_NO_PROFILE        2
+#define OV_HARDWARE_STATE_MONITORED         3
+#define OV_HARDWARE_STATE_UNMANAGED         4
+#define OV_HARDWARE_STATE_REMOVING          5
+#define OV_HARDWARE_STATE_REMOVE_FAILED     6
+#define OV_HARDWARE_STATE_REMOVED           7
+#define OV_HARDWARE_STATE_APPLYING_PROFILE  8
+#define OV_HARDWARE_STATE_PROFILE_APPLIED   9
+#define OV_HARDWARE_STATE_REMOVING_PROFILE  10
+#define OV_HARDWARE_STATE_PROFILE_ERROR     11
+#define OV_HARDWARE_STATE_UNSUPPORTED       12
+#define OV_HARDWARE_STATE_UPDATING_FIRMWARE 13
+
+// Server hardware power states
+#define OV_POWER_UNKNOWN      0
+#define OV_POWER_ON           1
+#define OV_POWER_OFF          2
+#define OV_POWER_POWERING_ON  3
+#define OV_POWER_POWERING_OFF 4
+#define OV_POWER_RESETTING    5
+
+// Match any value in a snapshot filter
+#define OV_SNAPSHOT_ANY -1
+
+/* The snapshot is held as columns, every server is a row and each of the arrays below
+ * holds one value per row. Uris and names are held as interned ids (see oneviewIntern.h). The
+ * profile and description of a server change with every profile that is applied, so rather
+ * than growing the intern table they are packed one after another into the strings of the
+ * snapshot and held as offsets.
+ */
+
+typedef struct {
+    size_t count;                   // Number of servers (rows) in the snapshot
+    size_t allocated;               // Number of rows allocated
+
+    int *uri;                       // Interned uri of each server
+    int *name;                      // Interned name of each server
+    uint32_t *profileUri;           // Offset of the uri of the applied profile (OV_SNAPSHOT_NO_STRING if unassigned)
+    uint32_t *description;          // Offset of the description of each server (OV_SNAPSHOT_NO_STRING if none)
+    unsigned char *state;           // OV_HARDWARE_STATE_* of each server
+    unsigned char *powerState;      // OV_POWER_* of each server
+    int *typeOf;                    // Hardware type id of each server (-1 if unknown)
+    int *enclosureOf;               // Enclosure id of each server (-1 if unknown)
+    int *nextOfType;                // Next server of the same hardware type
+    int *nextInEnclosure;           // Next server in the same enclosure
+    int *nextFree;                  // Next unassigned server of the same hardware type
+
+    size_t typeCount;               // Number of hardware types
+    int *typeUri;                   // Interned uri of each hardware type
+    int *firstOfType;               // First server of each hardware type
+    int *freeOfType;                // Head of the free list of each hardware type
+    size_t enclosureCount;          // Number of enclosures
+    int *enclosureUri;              // Interned uri of each enclosure
+    int *firstInEnclosure;          // First server in each enclosure
+
+    char *strings;                  // Profile uris and descriptions, each one terminated
+    size_t stringsLength;
+    size_t stringsSize;
+
+    oneviewHashIndex uriIndex;      // hardware uri -> server
+    oneviewHashIndex typeIndex;     // serverHardwareTypeUri -> hardware type id
+    oneviewHashIndex enclosureIndex;// enclosure uri -> enclosure id
+
+    time_t expires;                 // Time the snapshot should be reloaded
+    unsigned long generation;       // Inventory generation it was built from (0 if REST)
+    int appliance;                  // Interned address of the appliance it was loaded from
+    int user;                       // Interned user it was loaded as
+    int references;                 // Number of holders of the snapshot
+} oneviewHardwareSnapshot;
+
+typedef struct {
+    int type;                       // Hardware type id (or OV_SNAPSHOT_ANY)
+    int enclosure;                  // Enclosure id (or OV_SNAPSHOT_ANY)
+    int state;                      // OV_HARDWARE_STATE_* (or OV_SNAPSHOT_ANY)
+    int powerState;                 // OV_POWER_* (or OV_SNAPSHOT_ANY)
+    int unassigned;                 // Only servers without a profile
+} oneviewHardwareFilter;
+
+/*
+ * Snapshot life cycle, every acquired snapshot must be released
+ */
+
+oneviewHardwareSnapshot *ovAcquireHardwareSnapshot(oneviewSession *session);
+oneviewHardwareSnapshot *ovCurrentHardwareSnapshot(oneviewSession *session);
+void ovReleaseHardwareSnapshot(oneviewHardwareSnapshot *snapshot);
+void ovInvalidateHardwareSnapshot();
+
+/*
+ * Encoded values
+ */
+
+int ovHardwareStateFromString(const char *state);
+const char *ovHardwareStateName(int state);
+int ovPowerStateFromString(const char *powerState);
+const char *ovPowerStateName(int powerState);
+
+/*
+ * Lookups, these return the server (row) or OV_SNAPSHOT_END
+ */
+
+int ovSnapshotFindURI(oneviewHardwareSnapshot *snapshot, const char *hardwareURI);
+int ovSnapshotTypeId(oneviewHardwareSnapshot *snapshot, const char *hardwareTypeURI);
+int ovSnapshotEnclosureId(oneviewHardwareSnapshot *snapshot, const char *enclosureURI);
+int ovSnapshotFirstOfType(oneviewHardwareSnapshot *snapshot, const char *hardwareTypeURI);
+int ovSnapshotFirstInEnclosure(oneviewHardwareSnapshot *snapshot, const char *enclosureURI);
+int ovSnapshotFirstFree(oneviewHardwareSnapshot *snapshot, const char *hardwareTypeURI);
+int ovSnapshotNextFree(oneviewHardwareSnapshot *snapshot, int server);
+size_t ovSnapshotSelect(oneviewHardwareSnapshot *snapshot, const oneviewHardwareFilter *filter, int *servers, size_t maxServers);
+
+oneviewHardware *ovSnapshotHardware(oneviewHardwareSnapshot *snapshot, int server);
+
+#endif /* oneviewSnapshot_h */
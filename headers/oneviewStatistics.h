@@ -0,0 +1,106 @@
+
+// oneviewStatistics.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewStatistics_h
+#define oneviewStatistics_h
+
+#include "oneview.h"
+#include "oneviewHash.h"
+#include "oneviewIntern.h"
+
+// Returned when a port isn't in the statistics
+#define OV_STATISTICS_END -1
+
+// Seconds between collections when reporting statistics
+#define OV_STATISTICS_INTERVAL 10
+
+// Most ports that are tracked, ports beyond this are ignored so memory stays bounded
+#define OV_STATISTICS_MAX_PORTS 4096
+
+// Raw samples kept for each port
+#define OV_STATISTICS_SAMPLES 32
+
+// Rollup periods (OVPERIOD_1MIN and OVPERIOD_5MIN)
+#define OV_STATISTICS_PERIODS 2
+
+// Direction of a counter
+#define OV_STATISTIC_TX 0
+#define OV_STATISTIC_RX 1
+
+/* A rollup of the KB/s of a port over a period, min, max and mean are of the rates between
+ * each pair of samples and rate is from the first and last counters of the period
+ */
+
+typedef struct {
+    double start;                   // Time of the first counter in the period
+    double seconds;                 // Seconds covered so far
+    unsigned int samples;           // Number of rates in the rollup
+    double min;                     // Lowest KB/s
+    double max;                     // Highest KB/s
+    double mean;                    // Mean KB/s
+    double rate;                    // KB/s across the period
+    int complete;                   // Set once the period has ended
+} oneviewRollup;
+
+typedef struct {
+    oneviewRollup rollup;           // Rollup of the period so far
+    double sum;                     // Sum of the rates so far
+    double firstOctets;             // Counter at the start of the period
+} oneviewRollupWindow;
+
+/* Port statistics of every interconnect, held as columns with one row per port. Every
+ * collection moves the latest counters to previous, so the rates are for the time between
+ * the last two collections.
+ *
+ * Each port also keeps a ring of its last OV_STATISTICS_SAMPLES samples and a rollup for each
+ * period and direction, the rollups are updated as samples arrive so reading one is a copy.
+ */
+
+typedef struct {
+    size_t count;                   // Number of ports (rows)
+    size_t allocated;               // Number of rows allocated
+
+    int *interconnect;              // Interned uri of the interconnect of each port
+    int *portName;                  // Interned name of each port
+    double *txOctets;               // Latest transmitted octets counter
+    double *rxOctets;               // Latest received octets counter
+    double *previousTxOctets;       // Transmitted octets at the previous collection
+    double *previousRxOctets;       // Received octets at the previous collection
+    double *txKBps;                 // KB transmitted per second between the collections
+    double *rxKBps;                 // KB received per second between the collections
+
+    double *sampleTime;             // Ring of raw samples (OV_STATISTICS_SAMPLES per port)
+    double *sampleTxOctets;
+    double *sampleRxOctets;
+    unsigned int *sampleNext;       // Next slot in the ring of each port
+    unsigned int *sampleCount;      // Number of samples in the ring of each port
+    oneviewRollupWindow *windows;   // Period in progress, for each port, period and direction
+    oneviewRollup *rollups;         // Last complete period, for each port, period and direction
+
+    oneviewHashIndex portIndex;     // "<interconnect uri> <port name>" -> port
+    size_t interconnectCount;       // Interconnects that responded to the latest collection
+    double sampled;                 // Time of the latest collection (seconds)
+    double previousSampled;         // Time of the previous collection (0 if there isn't one)
+} oneviewInterconnectStatistics;
+
+int initInterconnectStatistics(oneviewInterconnectStatistics *statistics);
+int ovCollectInterconnectStatistics(oneviewSession *session, oneviewInterconnectStatistics *statistics);
+int ovInterconnectPort(oneviewInterconnectStatistics *statistics, const char *interconnectURI, const char *portName);
+double ovPortCounter(oneviewInterconnectStatistics *statistics, int port, int direction, int mode);
+int ovPortRollup(oneviewInterconnectStatistics *statistics, int port, int period, int direction, oneviewRollup *rollup);
+size_t ovPortSamples(oneviewInterconnectStatistics *statistics, int port, double *times, double *txOctets, double *rxOctets, size_t maxSamples);
+int freeInterconnectStatistics(oneviewInterconnectStatistics *statistics);
+
+int startStatisticsReport(int interval);
+
+#endif /* oneviewStatistics_h */
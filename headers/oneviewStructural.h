@@ -0,0 +1,46 @@
+
+// oneviewStructural.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewStructural_h
+#define oneviewStructural_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Responses smaller than this are scanned byte by byte, building an index isn't worth it
+#define OV_STRUCTURAL_THRESHOLD 65536
+
+// Returned by ovStructuralSeek when there are no more structural characters
+#define OV_STRUCTURAL_END ((size_t)-1)
+
+/* A structural index holds the offset of every quote, brace, bracket, colon and comma that
+ * is outside of a string (both quotes of each string are included, escaped quotes are not).
+ * The index can be reused for several buffers, the positions are kept allocated.
+ */
+
+typedef struct {
+    const char *buffer;             // Buffer that was indexed
+    size_t length;                  // Length of the buffer
+    uint32_t *positions;            // Offsets of the structural characters, in order
+    size_t count;                   // Number of positions
+    size_t allocated;               // Number of positions allocated
+} ovStructuralIndex;
+
+int initStructuralIndex(ovStructuralIndex *index);
+int ovBuildStructuralIndex(ovStructuralIndex *index, const char *buffer, size_t length);
+const ovStructuralIndex *ovIndexLargeResponse(ovStructuralIndex *index, const char *buffer, size_t length);
+size_t ovStructuralSeek(const ovStructuralIndex *index, const char *p);
+const char *ovStructuralImplementation();
+int freeStructuralIndex(ovStructuralIndex *index);
+
+#endif /* oneviewStructural_h */
@@ -0,0 +1,57 @@
+
+// oneviewTemplates.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewTemplates_h
+#define oneviewTemplates_h
+
+#include "oneview.h"
+
+// Seconds before the templates of an appliance are revalidated (with the ETag of the collection)
+#define OV_TEMPLATE_TTL 300
+
+// Seconds between the refreshes caused by a name that isn't known
+#define OV_TEMPLATE_MISS_INTERVAL 5
+
+// Seconds before the templates are read again after a read failed (doubling up to OV_TEMPLATE_TTL)
+#define OV_TEMPLATE_RETRY_INTERVAL 5
+
+/* The server profile templates of each appliance are held by name, they are read at login
+ * and only read again once the TTL has passed (and then only if the ETag of the collection
+ * has changed) or when a template that isn't known is looked up. They are read by one thread at
+ * a time without holding the lock, so lookups aren't held up behind the requests.
+ *
+ * The strings of a template are interned (see oneviewIntern.h).
+ */
+
+typedef struct {
+    int name;                   // Name of the template
+    int uri;                    // Uri of the template
+    int serverHardwareTypeUri;  // Hardware type the template is for
+    int enclosureGroupUri;      // Enclosure group the template is for
+    int eTag;                   // ETag of the template when it was read
+    int modified;               // When the template was last modified
+} ovTemplate;
+
+int ovTemplatesRefresh(oneviewSession *session, int force);
+int ovTemplateFind(oneviewSession *session, const char *name, ovTemplate *found);
+
+/* The new profile of a template is the same for every instance, it is read once and held
+ * serialized until the template changes (its eTag or modified time), the body for an instance
+ * only has its name, server hardware and description patched in.
+ */
+
+size_t ovTemplatesPrepare(oneviewSession *session, const int *templateURIs, size_t count);
+char *ovTemplateProfile(oneviewSession *session, int templateURI, const char *name, const char *hardwareURI, const char *description);
+void ovTemplatesClear();
+
+#endif /* oneviewTemplates_h */
@@ -14,6 +14,9 @@
 #include "oneviewInfraKitPlugin.h"
 #include "oneviewInfraKitState.h"
 #include "oneviewInfraKitConsole.h"
+#include "oneviewInventory.h"
+#include "oneviewStatistics.h"
+#include "oneviewExport.h"
 
 #include <getopt.h>
 #include <stdio.h>
@@ -23,6 +26,8 @@ static struct option long_options[] =
     {"name", required_argument, NULL, 'n'},
     {"state", required_argument, NULL, 's'},
     {"log", required_argument, NULL, 'l'},
+    {"scmb", required_argument, NULL, 'm'},
+    {"window", required_argument, NULL, 'w'},
     {"help", optional_argument, NULL, 'h'},
     {NULL, 0, NULL, 0}
 };
@@ -39,8 +44,28 @@ int main(int argc, char* argv[])
             printf("\nHPE OneView Instance Plugin version 0.3.0\nContact: finneran@hpe.com\n\n");
             return 0;
         }
+        if (stringMatch("broker", argv[1])) {
+            if (argc < 3) {
+                printf("Usage: ./infrakit-instance-oneview broker <socket> [events file]\n");
+                return 1;
+            }
+            setStartTime();
+            return startInventoryBroker(argv[2], (argc >= 4) ? argv[3] : NULL);
+        }
+        if (stringMatch("statistics", argv[1])) {
+            setStartTime();
+            return startStatisticsReport((argc >= 3) ? atoi(argv[2]) : OV_STATISTICS_INTERVAL);
+        }
+        if (stringMatch("export", argv[1])) {
+            if (argc < 3) {
+                printf("Usage: ./infrakit-instance-oneview export <hardware|profiles> [csv|tsv|jsonl] [column ...]\n");
+                return 1;
+            }
+            setStartTime();
+            return startInventoryExport(argv[2], (argc >= 4) ? argv[3] : NULL, &argv[4], (argc >= 5) ? argc - 4 : 0);
+        }
     }
-    while ((ch = getopt_long(argc, argv, "n:s:l:h:", long_options, NULL)) != -1)
+    while ((ch = getopt_long(argc, argv, "n:s:l:m:w:h:", long_options, NULL)) != -1)
     {
         // check to see if a single character or long option came through
         switch (ch)
@@ -67,8 +92,18 @@ int main(int argc, char* argv[])
                     printf("\nError incorrect log level, maximum 5");
                 }
                 break;
+            case 'm':
+                if (optarg) {
+                    setInventorySocketPath(optarg);
+                }
+                break;
+            case 'w':
+                if (setProvisionWindow(atol(optarg)) == EXIT_FAILURE) {
+                    printf("\nError incorrect provision window, it is a number of milliseconds");
+                }
+                break;
             case 'h':
-                printf("HPE OneView Instance Plugin for Docker\n\n Usage:\n ./infrakit-instance-oneview [flags]\n\n Available Commands:\n version\t\t print build version information\n\n Flags:\n\t--name\tPlugin name to advertise\n\t--log\tLogging level, maximum 5 being the most verbose\n\t--state\tPath to a state file to handle instance state information\n\n");
+                printf("HPE OneView Instance Plugin for Docker\n\n Usage:\n ./infrakit-instance-oneview [flags]\n\n Available Commands:\n version\t\t print build version information\n broker\t\t run a stand-in state-change broker <socket> [events file]\n statistics\t report interconnect port rates every [interval] seconds\n export\t\t write <hardware|profiles> as [csv|tsv|jsonl] with [column ...]\n\n Flags:\n\t--name\tPlugin name to advertise\n\t--log\tLogging level, maximum 5 being the most verbose\n\t--state\tPath to a state file to handle instance state information\n\t--scmb\tPath to a state-change message relay socket\n\t--window\tMilliseconds to hold Provision calls so they are provisioned together (0 disables)\n\n");
                 return 0;
                 break;
         }
@@ -0,0 +1,187 @@
+
+// oneviewArena.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+
+#include "oneviewArena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/* A request builds (and frees) thousands of small JSON values, the request, the state file,
+ * the OneView responses and the response. Rather than each of those being a malloc() and a
+ * free(), they are bumped out of a per-thread arena that is reset when the request ends.
+ *
+ * The first chunk of each thread's arena is kept between requests, any further chunks (from
+ * a large request) are freed when the request ends so the resident size doesn't creep up.
+ */
+
+typedef struct ovArenaChunk {
+    struct ovArenaChunk *next;      // Older chunk
+    size_t size;                    // Usable bytes in the chunk
+    size_t used;                    // Bytes handed out
+    char *data;                     // First usable byte (aligned)
+} ovArenaChunk;
+
+typedef struct {
+    ovArenaChunk *chunks;           // Newest chunk first
+    int active;                     // Set between ovArenaBegin and ovArenaEnd
+    int suspended;                  // Depth of ovArenaSuspend calls
+} ovArena;
+
+static __thread ovArena threadArena;
+
+static pthread_once_t installOnce = PTHREAD_ONCE_INIT;
+
+static ovArenaChunk *newChunk(size_t size)
+{
+    ovArenaChunk *chunk = malloc(sizeof(ovArenaChunk) + size + OV_ARENA_ALIGNMENT);
+    if (!chunk) {
+        return NULL;
+    }
+    uintptr_t data = (uintptr_t)(chunk + 1);
+    data = (data + OV_ARENA_ALIGNMENT - 1) & ~(uintptr_t)(OV_ARENA_ALIGNMENT - 1);
+    chunk->data = (char *)data;
+    chunk->size = size;
+    chunk->used = 0;
+    chunk->next = NULL;
+    return chunk;
+}
+
+static void *arenaMalloc(size_t size)
+{
+    ovArena *arena = &threadArena;
+    if (!arena->active || arena->suspended) {
+        return malloc(size);
+    }
+    size = (size + OV_ARENA_ALIGNMENT - 1) & ~(size_t)(OV_ARENA_ALIGNMENT - 1);
+    ovArenaChunk *chunk = arena->chunks;
+    if (!chunk || chunk->used + size > chunk->size) {
+        chunk = newChunk((size > OV_ARENA_CHUNK_SIZE) ? size : OV_ARENA_CHUNK_SIZE);
+        if (!chunk) {
+            return NULL;
+        }
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+    }
+    void *pointer = chunk->data + chunk->used;
+    chunk->used += size;
+    return pointer;
+}
+
+/* Memory from the arena is given back when the request ends, anything else came from malloc()
+ */
+
+static void arenaFree(void *pointer)
+{
+    if (pointer && !ovArenaOwns(pointer)) {
+        free(pointer);
+    }
+}
+
+int ovArenaOwns(const void *pointer)
+{
+    const char *address = pointer;
+    for (ovArenaChunk *chunk = threadArena.chunks; chunk; chunk = chunk->next) {
+        if (address >= chunk->data && address < chunk->data + chunk->size) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void installAllocator()
+{
+    json_set_alloc_funcs(arenaMalloc, arenaFree);
+}
+
+/* Route every jansson allocation through the arena (this is safe to call more than once)
+ */
+
+void ovArenaInstall()
+{
+    pthread_once(&installOnce, installAllocator);
+}
+
+void ovArenaBegin()
+{
+    threadArena.active = 1;
+    threadArena.suspended = 0;
+}
+
+/* Reset the arena, keeping the oldest chunk (if it is a standard size) for the next request
+ */
+
+void ovArenaEnd()
+{
+    ovArena *arena = &threadArena;
+    ovArenaChunk *chunk = arena->chunks;
+    ovArenaChunk *kept = NULL;
+    while (chunk) {
+        ovArenaChunk *next = chunk->next;
+        if (!next && chunk->size == OV_ARENA_CHUNK_SIZE) {
+            kept = chunk;
+            kept->used = 0;
+        } else {
+            free(chunk);
+        }
+        chunk = next;
+    }
+    arena->chunks = kept;
+    arena->active = 0;
+    arena->suspended = 0;
+}
+
+/* Allocations between these come from the heap, suspending can be nested
+ */
+
+void ovArenaSuspend()
+{
+    threadArena.suspended++;
+}
+
+void ovArenaResume()
+{
+    if (threadArena.suspended > 0) {
+        threadArena.suspended--;
+    }
+}
+
+/* Move a value out of the arena so it can be kept after the request, the value passed in is
+ * released and the value to keep is returned (values not in the arena are returned as they
+ * are).
+ */
+
+json_t *ovArenaPromote(json_t *json)
+{
+    if (!json || !threadArena.active || !ovArenaOwns(json)) {
+        return json;
+    }
+    ovArenaSuspend();
+    json_t *promoted = json_deep_copy(json);
+    ovArenaResume();
+    json_decref(json);
+    return promoted;
+}
+
+/* json_dumps with the text allocated from the heap, so it can be freed with free()
+ */
+
+char *ovDumpJSON(const json_t *json, size_t flags)
+{
+    ovArenaSuspend();
+    char *text = json_dumps(json, flags);
+    ovArenaResume();
+    return text;
+}
@@ -0,0 +1,462 @@
+
+// oneviewExport.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+
+#include "oneviewExport.h"
+#include "oneviewInfraKitConsole.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Columns exported when none are given
+static char *hardwareColumns[] = { "uri", "name", "state", "powerState", "serverProfileUri", "serverHardwareTypeUri", "locationUri" };
+static char *profileColumns[] = { "uri", "name", "state", "status", "serverHardwareUri", "serverProfileTemplateUri" };
+
+int initExport(oneviewExport *exporter, FILE *output, int format, char *columns[], int columnCount)
+{
+    if (!exporter || !output || !columns || columnCount <= 0 || columnCount > OV_EXTRACT_MAX_FIELDS ||
+        format < OV_EXPORT_CSV || format > OV_EXPORT_DELIMITED) {
+        return EXIT_FAILURE;
+    }
+    memset(exporter, 0, sizeof(oneviewExport));
+    exporter->buffer = malloc(OV_EXPORT_BUFFER_SIZE);
+    if (!exporter->buffer) {
+        return EXIT_FAILURE;
+    }
+    exporter->size = OV_EXPORT_BUFFER_SIZE;
+    exporter->output = output;
+    exporter->format = format;
+    exporter->delimiter = (format == OV_EXPORT_TSV) ? '\t' : ',';
+    exporter->columns = columns;
+    exporter->columnCount = columnCount;
+    for (int i = 0; i < columnCount; i++) {
+        exporter->fields[i].path = columns[i];
+        exporter->fields[i].slot = &exporter->values[i];
+    }
+    initStructuralIndex(&exporter->structural);
+    return EXIT_SUCCESS;
+}
+
+/* "csv", "tsv" or "jsonl", returns -1 for anything else
+ */
+
+int ovExportFormatFromString(const char *format)
+{
+    if (stringMatch(format, "csv")) {
+        return OV_EXPORT_CSV;
+    }
+    if (stringMatch(format, "tsv")) {
+        return OV_EXPORT_TSV;
+    }
+    if (stringMatch(format, "jsonl")) {
+        return OV_EXPORT_JSONL;
+    }
+    return -1;
+}
+
+int ovExportFlush(oneviewExport *exporter)
+{
+    if (!exporter) {
+        return EXIT_FAILURE;
+    }
+    if (exporter->used && fwrite(exporter->buffer, 1, exporter->used, exporter->output) != exporter->used) {
+        exporter->failed = 1;
+    }
+    exporter->used = 0;
+    return exporter->failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/* Make room for a number of bytes, flushing the buffer (or growing it for a value that is
+ * larger than the whole buffer)
+ */
+
+static int reserve(oneviewExport *exporter, size_t bytes)
+{
+    if (exporter->used + bytes <= exporter->size) {
+        return EXIT_SUCCESS;
+    }
+    ovExportFlush(exporter);
+    if (bytes > exporter->size) {
+        char *buffer = realloc(exporter->buffer, bytes);
+        if (!buffer) {
+            exporter->failed = 1;
+            return EXIT_FAILURE;
+        }
+        exporter->buffer = buffer;
+        exporter->size = bytes;
+    }
+    return exporter->failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static void append(oneviewExport *exporter, const char *data, size_t length)
+{
+    if (reserve(exporter, length) == EXIT_SUCCESS) {
+        memcpy(exporter->buffer + exporter->used, data, length);
+        exporter->used += length;
+    }
+}
+
+static void appendCharacter(oneviewExport *exporter, char character)
+{
+    if (reserve(exporter, 1) == EXIT_SUCCESS) {
+        exporter->buffer[exporter->used++] = character;
+    }
+}
+
+static char *scratchSpace(oneviewExport *exporter, size_t bytes)
+{
+    if (bytes > exporter->scratchSize) {
+        char *scratch = realloc(exporter->scratch, bytes);
+        if (!scratch) {
+            exporter->failed = 1;
+            return NULL;
+        }
+        exporter->scratch = scratch;
+        exporter->scratchSize = bytes;
+    }
+    return exporter->scratch;
+}
+
+/* Write text as a single CSV or TSV field, CSV fields are only quoted when they need to be
+ */
+
+static void appendField(oneviewExport *exporter, const char *text, size_t length)
+{
+    size_t i = 0;
+    if (exporter->format == OV_EXPORT_CSV) {
+        while (i < length && text[i] != exporter->delimiter && text[i] != '"' && text[i] != '\n' && text[i] != '\r') {
+            i++;
+        }
+    } else if (exporter->format == OV_EXPORT_TSV) {
+        while (i < length && text[i] != '\t' && text[i] != '\n' && text[i] != '\r' && text[i] != '\\') {
+            i++;
+        }
+    } else {
+        i = length;
+    }
+    if (i == length) {
+        append(exporter, text, length);
+        return;
+    }
+    if (reserve(exporter, (length * 2) + 2) == EXIT_FAILURE) {
+        return;
+    }
+    char *out = exporter->buffer + exporter->used;
+    if (exporter->format == OV_EXPORT_CSV) {
+        *out++ = '"';
+        for (i = 0; i < length; i++) {
+            if (text[i] == '"') {
+                *out++ = '"';
+            }
+            *out++ = text[i];
+        }
+        *out++ = '"';
+    } else {
+        for (i = 0; i < length; i++) {
+            switch (text[i]) {
+                case '\t': *out++ = '\\'; *out++ = 't'; break;
+                case '\n': *out++ = '\\'; *out++ = 'n'; break;
+                case '\r': *out++ = '\\'; *out++ = 'r'; break;
+                case '\\': *out++ = '\\'; *out++ = '\\'; break;
+                default: *out++ = text[i]; break;
+            }
+        }
+    }
+    exporter->used = out - exporter->buffer;
+}
+
+/* Copy an object or array without the whitespace between its values, so it fits on one line
+ */
+
+static size_t compactJSON(const ovJSONSlice *value, char *out)
+{
+    size_t length = 0;
+    int inString = 0;
+    for (size_t i = 0; i < value->length; i++) {
+        char character = value->start[i];
+        if (inString) {
+            if (character == '\\' && (i + 1) < value->length) {
+                out[length++] = character;
+                character = value->start[++i];
+            } else if (character == '"') {
+                inString = 0;
+            }
+        } else if (character == ' ' || character == '\t' || character == '\n' || character == '\r') {
+            continue;
+        } else if (character == '"') {
+            inString = 1;
+        }
+        out[length++] = character;
+    }
+    return length;
+}
+
+static void appendValue(oneviewExport *exporter, const ovJSONSlice *value)
+{
+    switch (value->type) {
+        case OV_JSON_STRING:
+            if (exporter->format == OV_EXPORT_JSONL) {
+                // The escapes in the response are already valid JSON
+                appendCharacter(exporter, '"');
+                append(exporter, value->start, value->length);
+                appendCharacter(exporter, '"');
+            } else if (memchr(value->start, '\\', value->length)) {
+                char *decoded = scratchSpace(exporter, value->length + 1);
+                if (decoded) {
+                    appendField(exporter, decoded, ovSliceCopy(value, decoded, value->length + 1));
+                }
+            } else {
+                appendField(exporter, value->start, value->length);
+            }
+            break;
+        case OV_JSON_NUMBER:
+            append(exporter, value->start, value->length);
+            break;
+        case OV_JSON_TRUE:
+            append(exporter, "true", 4);
+            break;
+        case OV_JSON_FALSE:
+            append(exporter, "false", 5);
+            break;
+        case OV_JSON_OBJECT:
+        case OV_JSON_ARRAY: {
+            char *compact = scratchSpace(exporter, value->length);
+            if (!compact) {
+                break;
+            }
+            size_t length = compactJSON(value, compact);
+            if (exporter->format == OV_EXPORT_JSONL) {
+                append(exporter, compact, length);
+            } else {
+                appendField(exporter, compact, length);
+            }
+            break;
+        }
+        default:
+            // Missing values and nulls are empty (null in JSON lines)
+            if (exporter->format == OV_EXPORT_JSONL) {
+                append(exporter, "null", 4);
+            }
+            break;
+    }
+}
+
+static void appendJSONKey(oneviewExport *exporter, const char *key)
+{
+    appendCharacter(exporter, '"');
+    for (; *key; key++) {
+        if (*key == '"' || *key == '\\') {
+            appendCharacter(exporter, '\\');
+        }
+        appendCharacter(exporter, *key);
+    }
+    append(exporter, "\":", 2);
+}
+
+static void appendRow(oneviewExport *exporter)
+{
+    if (exporter->format == OV_EXPORT_JSONL) {
+        appendCharacter(exporter, '{');
+        for (int i = 0; i < exporter->columnCount; i++) {
+            if (i != 0) {
+                appendCharacter(exporter, ',');
+            }
+            appendJSONKey(exporter, exporter->columns[i]);
+            appendValue(exporter, &exporter->values[i]);
+        }
+        append(exporter, "}\n", 2);
+        return;
+    }
+    for (int i = 0; i < exporter->columnCount; i++) {
+        if (i != 0) {
+            appendCharacter(exporter, exporter->delimiter);
+        }
+        appendValue(exporter, &exporter->values[i]);
+    }
+    appendCharacter(exporter, '\n');
+}
+
+static void appendHeader(oneviewExport *exporter)
+{
+    if (exporter->headerWritten || (exporter->format != OV_EXPORT_CSV && exporter->format != OV_EXPORT_TSV)) {
+        return;
+    }
+    for (int i = 0; i < exporter->columnCount; i++) {
+        if (i != 0) {
+            appendCharacter(exporter, exporter->delimiter);
+        }
+        appendField(exporter, exporter->columns[i], strlen(exporter->columns[i]));
+    }
+    appendCharacter(exporter, '\n');
+    exporter->headerWritten = 1;
+}
+
+/* Write a row for every object in an array, each member is read in one pass for all of the
+ * columns
+ */
+
+static long exportArray(oneviewExport *exporter, const ovStructuralIndex *index, const ovJSONSlice *array)
+{
+    long rows = 0;
+    size_t offset = 0;
+    ovJSONSlice member;
+    appendHeader(exporter);
+    while (ovNextIndexedElement(index, array, &offset, &member)) {
+        if (member.type != OV_JSON_OBJECT ||
+            ovExtractIndexedFields(index, member.start, member.length, exporter->fields, exporter->columnCount) == -1) {
+            continue;
+        }
+        appendRow(exporter);
+        rows++;
+    }
+    exporter->rows += rows;
+    return exporter->failed ? -1 : rows;
+}
+
+/* Export the members of the array arrayName in a response (or if arrayName is NULL, the
+ * response is the array), returns the number of rows written or -1
+ */
+
+long ovExportMembers(oneviewExport *exporter, const char *rawJSON, size_t length, const char *arrayName)
+{
+    if (!exporter || !rawJSON) {
+        return -1;
+    }
+    const ovStructuralIndex *index = ovIndexLargeResponse(&exporter->structural, rawJSON, length);
+    ovJSONSlice array;
+    if (arrayName) {
+        ovJSONField arrayField[] = { { arrayName, &array } };
+        if (ovExtractIndexedFields(index, rawJSON, length, arrayField, 1) != 1) {
+            return -1;
+        }
+    } else {
+        const char *start = rawJSON;
+        const char *end = rawJSON + length;
+        while (start < end && (*start == ' ' || *start == '\t' || *start == '\n' || *start == '\r')) {
+            start++;
+        }
+        while (end > start && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\n' || end[-1] == '\r')) {
+            end--;
+        }
+        array.start = start;
+        array.length = end - start;
+        array.type = (array.length >= 2 && start[0] == '[' && end[-1] == ']') ? OV_JSON_ARRAY : OV_JSON_MISSING;
+    }
+    if (array.type != OV_JSON_ARRAY) {
+        return -1;
+    }
+    return exportArray(exporter, index, &array);
+}
+
+/* Export the members of every page of a collection, starting with the first page (which is
+ * freed along with the pages that follow it). Returns the number of rows written or -1.
+ */
+
+long ovExportCollection(oneviewSession *session, oneviewExport *exporter, char *rawJSON)
+{
+    if (!exporter) {
+        free(rawJSON);
+        return -1;
+    }
+    long rows = 0;
+    while (rawJSON) {
+        size_t length = strlen(rawJSON);
+        const ovStructuralIndex *index = ovIndexLargeResponse(&exporter->structural, rawJSON, length);
+        ovJSONSlice members, nextPageUri, errorCode;
+        ovJSONField pageFields[] = {
+            { "members", &members },
+            { "nextPageUri", &nextPageUri },
+            { "errorCode", &errorCode }
+        };
+        if (ovExtractIndexedFields(index, rawJSON, length, pageFields, 3) == -1 || errorCode.type != OV_JSON_MISSING ||
+            members.type != OV_JSON_ARRAY) {
+            free(rawJSON);
+            return -1;
+        }
+        long pageRows = exportArray(exporter, index, &members);
+        if (pageRows == -1) {
+            free(rawJSON);
+            return -1;
+        }
+        rows += pageRows;
+        char nextPage[1024];
+        int hasNextPage = (pageRows != 0) && (nextPageUri.type == OV_JSON_STRING) &&
+                          (ovSliceCopy(&nextPageUri, nextPage, sizeof(nextPage)) < sizeof(nextPage));
+        free(rawJSON);
+        rawJSON = hasNextPage ? ovQueryWithURI(session, nextPage) : NULL;
+    }
+    return rows;
+}
+
+/* Evaluate the struct and determine what is populated
+ then free resources back to the heap.
+ */
+
+int freeExport(oneviewExport *exporter)
+{
+    if (exporter) {
+        int result = ovExportFlush(exporter);
+        fflush(exporter->output);
+        free(exporter->buffer);
+        free(exporter->scratch);
+        freeStructuralIndex(&exporter->structural);
+        memset(exporter, 0, sizeof(oneviewExport));
+        return result;
+    }
+    return EXIT_FAILURE;
+}
+
+/* Write the server hardware or server profiles of an appliance to stdout, the session is
+ * created from the OV_ADDRESS, OV_USERNAME and OV_PASSWORD environment variables.
+ *
+ * ./infrakit-instance-oneview export <hardware|profiles> [csv|tsv|jsonl] [column ...]
+ */
+
+int startInventoryExport(const char *resource, const char *format, char *columns[], int columnCount)
+{
+    int exportFormat = format ? ovExportFormatFromString(format) : OV_EXPORT_CSV;
+    if (!resource || exportFormat == -1) {
+        ovPrintError(getPluginTime(), "Export needs a resource of hardware or profiles and a format of csv, tsv or jsonl\n");
+        return EXIT_FAILURE;
+    }
+    int hardware = stringMatch(resource, "hardware");
+    if (!hardware && !stringMatch(resource, "profiles")) {
+        ovPrintError(getPluginTime(), "Export needs a resource of hardware or profiles\n");
+        return EXIT_FAILURE;
+    }
+    if (columnCount <= 0) {
+        columns = hardware ? hardwareColumns : profileColumns;
+        columnCount = hardware ? (int)(sizeof(hardwareColumns) / sizeof(char *)) : (int)(sizeof(profileColumns) / sizeof(char *));
+    }
+
+    // Only errors are logged so they can't be mistaken for rows
+    setConsolOutputLevel(LOGERROR);
+    oneviewSession *session = ovSessionFromEnvironment();
+    if (!session) {
+        return EXIT_FAILURE;
+    }
+    oneviewExport exporter;
+    if (initExport(&exporter, stdout, exportFormat, columns, columnCount) == EXIT_FAILURE) {
+        ovPrintError(getPluginTime(), "Unable to start the export\n");
+        freeSession(session);
+        return EXIT_FAILURE;
+    }
+    char *rawJSON = hardware ? ovQueryServerHardware(session, NULL) : ovQueryServerProfiles(session, NULL);
+    long rows = ovExportCollection(session, &exporter, rawJSON);
+    freeSession(session);
+    if (freeExport(&exporter) == EXIT_FAILURE || rows == -1) {
+        ovPrintError(getPluginTime(), "Export failed\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
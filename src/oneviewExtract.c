@@ -0,0 +1,624 @@
+
+// oneviewExtract.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+
+#include "oneviewExtract.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Most of the responses we read only need a handful of values (the version, the session id,
+ * or a few fields of every member), so rather than building a complete JSON document these
+ * functions walk the response once and hand back slices of the response buffer. Nothing is
+ * allocated, and the walk stops as soon as every requested field has been found.
+ */
+
+/* When a structural index of the buffer is available the ends of strings, objects and arrays
+ * are found from the index rather than by looking at every byte (see oneviewStructural.h).
+ */
+
+typedef struct {
+    ovJSONField *fields;
+    int fieldCount;
+    int found;
+    const char *end;
+    const ovStructuralIndex *index;     // Structural index (or NULL)
+    size_t cursor;                      // Position in the index, it only moves forward
+} extractContext;
+
+/* Only use an index that covers the whole of the slice being read */
+
+static void useIndex(extractContext *context, const ovStructuralIndex *index, const char *start)
+{
+    context->index = NULL;
+    context->cursor = 0;
+    if (index && index->buffer && start >= index->buffer && context->end <= index->buffer + index->length) {
+        size_t cursor = ovStructuralSeek(index, start);
+        if (cursor != OV_STRUCTURAL_END) {
+            context->index = index;
+            context->cursor = cursor;
+        }
+    }
+}
+
+/* Move the cursor to the first structural character at or after p */
+
+static const char *nextStructural(extractContext *context, const char *p)
+{
+    const ovStructuralIndex *index = context->index;
+    size_t offset = p - index->buffer;
+    while (context->cursor < index->count && index->positions[context->cursor] < offset) {
+        context->cursor++;
+    }
+    if (context->cursor == index->count) {
+        return NULL;
+    }
+    const char *structural = index->buffer + index->positions[context->cursor];
+    return (structural < context->end) ? structural : NULL;
+}
+
+static const char *skipSpace(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+/* p is the opening quote, returns the closing quote (or NULL if the string isn't closed) */
+
+static const char *scanString(extractContext *context, const char *p)
+{
+    const char *end = context->end;
+    if (context->index) {
+        // Quotes inside of strings are escaped, so the closing quote is the next structural
+        const char *close = nextStructural(context, p + 1);
+        return (close && *close == '"') ? close : NULL;
+    }
+    for (p++; p < end; p++) {
+        if (*p == '\\') {
+            p++;
+        } else if (*p == '"') {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static int matchLiteral(const char *p, const char *end, const char *literal)
+{
+    size_t length = strlen(literal);
+    return ((size_t)(end - p) >= length) && (memcmp(p, literal, length) == 0);
+}
+
+/* Skip any value, filling value (if set) with the slice of the value. Returns the first byte
+ * after the value or NULL if the value is malformed.
+ */
+
+/* p is the opening bracket, returns the byte after the matching closing bracket. Strings
+ * aren't in the index (other than their quotes) so only the brackets need counting.
+ */
+
+static const char *skipContainer(extractContext *context, const char *p)
+{
+    const ovStructuralIndex *index = context->index;
+    if (!nextStructural(context, p)) {
+        return NULL;
+    }
+    size_t endOffset = context->end - index->buffer;
+    int depth = 0;
+    for (size_t i = context->cursor; i < index->count && index->positions[i] < endOffset; i++) {
+        char c = index->buffer[index->positions[i]];
+        if (c == '{' || c == '[') {
+            depth++;
+        } else if ((c == '}' || c == ']') && --depth == 0) {
+            context->cursor = i + 1;
+            return index->buffer + index->positions[i] + 1;
+        }
+    }
+    return NULL;
+}
+
+static const char *skipValue(extractContext *context, const char *p, ovJSONSlice *value)
+{
+    const char *end = context->end;
+    const char *start = p;
+    int type;
+    if (p >= end) {
+        return NULL;
+    }
+    switch (*p) {
+        case '"': {
+            const char *close = scanString(context, p);
+            if (!close) {
+                return NULL;
+            }
+            if (value) {
+                value->start = p + 1;
+                value->length = close - (p + 1);
+                value->type = OV_JSON_STRING;
+            }
+            return close + 1;
+        }
+        case '{':
+        case '[': {
+            int depth = 0;
+            type = (*p == '{') ? OV_JSON_OBJECT : OV_JSON_ARRAY;
+            if (context->index) {
+                p = skipContainer(context, p);
+                if (!p) {
+                    return NULL;
+                }
+                break;
+            }
+            for (; p < end; p++) {
+                if (*p == '"') {
+                    p = scanString(context, p);
+                    if (!p) {
+                        return NULL;
+                    }
+                } else if (*p == '{' || *p == '[') {
+                    depth++;
+                } else if (*p == '}' || *p == ']') {
+                    if (--depth == 0) {
+                        p++;
+                        break;
+                    }
+                }
+            }
+            if (depth != 0) {
+                return NULL;
+            }
+            break;
+        }
+        case 't':
+            if (!matchLiteral(p, end, "true")) {
+                return NULL;
+            }
+            type = OV_JSON_TRUE;
+            p += 4;
+            break;
+        case 'f':
+            if (!matchLiteral(p, end, "false")) {
+                return NULL;
+            }
+            type = OV_JSON_FALSE;
+            p += 5;
+            break;
+        case 'n':
+            if (!matchLiteral(p, end, "null")) {
+                return NULL;
+            }
+            type = OV_JSON_NULL;
+            p += 4;
+            break;
+        default:
+            type = OV_JSON_NUMBER;
+            while (p < end && ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E')) {
+                p++;
+            }
+            if (p == start) {
+                return NULL;
+            }
+            break;
+    }
+    if (value) {
+        value->start = start;
+        value->length = p - start;
+        value->type = type;
+    }
+    return p;
+}
+
+/* Compare a key with the segment of a path at a depth, setting last if it is the final
+ * segment of the path
+ */
+
+static int segmentMatches(const char *path, int depth, const char *key, size_t keyLength, int *last)
+{
+    for (int i = 0; i < depth; i++) {
+        path = strchr(path, '.');
+        if (!path) {
+            return 0;
+        }
+        path++;
+    }
+    const char *segmentEnd = strchr(path, '.');
+    size_t segmentLength = segmentEnd ? (size_t)(segmentEnd - path) : strlen(path);
+    *last = (segmentEnd == NULL);
+    return (segmentLength == keyLength) && (memcmp(path, key, keyLength) == 0);
+}
+
+static void setSlot(extractContext *context, int field, const ovJSONSlice *value)
+{
+    ovJSONSlice *slot = context->fields[field].slot;
+    if (slot->type == OV_JSON_MISSING) {
+        *slot = *value;
+        context->found++;
+    }
+}
+
+/* p is the opening brace, the mask holds the fields whose path matches every key so far.
+ * Returns the byte after the closing brace (or context->end once every field is found).
+ */
+
+static const char *extractObject(extractContext *context, const char *p, int depth, unsigned long mask)
+{
+    const char *end = context->end;
+    p = skipSpace(p + 1, end);
+    if (p < end && *p == '}') {
+        return p + 1;
+    }
+    while (p < end) {
+        if (*p != '"') {
+            return NULL;
+        }
+        const char *keyClose = scanString(context, p);
+        if (!keyClose) {
+            return NULL;
+        }
+        const char *key = p + 1;
+        size_t keyLength = keyClose - key;
+        p = skipSpace(keyClose + 1, end);
+        if (p >= end || *p != ':') {
+            return NULL;
+        }
+        p = skipSpace(p + 1, end);
+
+        unsigned long exact = 0, deeper = 0;
+        for (int i = 0; i < context->fieldCount; i++) {
+            int last;
+            if ((mask & (1UL << i)) && segmentMatches(context->fields[i].path, depth, key, keyLength, &last)) {
+                if (last) {
+                    exact |= (1UL << i);
+                } else {
+                    deeper |= (1UL << i);
+                }
+            }
+        }
+
+        const char *valueStart = p;
+        if (deeper && p < end && *p == '{') {
+            p = extractObject(context, p, depth + 1, deeper);
+            if (!p) {
+                return NULL;
+            }
+            if (context->found == context->fieldCount) {
+                return end;
+            }
+            if (exact) {
+                // Both the object and values inside of it were requested
+                ovJSONSlice value = { valueStart, p - valueStart, OV_JSON_OBJECT };
+                for (int i = 0; i < context->fieldCount; i++) {
+                    if (exact & (1UL << i)) {
+                        setSlot(context, i, &value);
+                    }
+                }
+            }
+        } else {
+            ovJSONSlice value;
+            p = skipValue(context, p, exact ? &value : NULL);
+            if (!p) {
+                return NULL;
+            }
+            for (int i = 0; exact && i < context->fieldCount; i++) {
+                if (exact & (1UL << i)) {
+                    setSlot(context, i, &value);
+                }
+            }
+        }
+        if (context->found == context->fieldCount) {
+            return end;
+        }
+
+        p = skipSpace(p, end);
+        if (p < end && *p == ',') {
+            p = skipSpace(p + 1, end);
+        } else if (p < end && *p == '}') {
+            return p + 1;
+        } else {
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+/* Extract every field from the object held in the buffer, returns the number of fields that
+ * were found or -1 if the buffer isn't a (well formed) object
+ */
+
+int ovExtractFields(const char *buffer, size_t length, ovJSONField *fields, int fieldCount)
+{
+    return ovExtractIndexedFields(NULL, buffer, length, fields, fieldCount);
+}
+
+/* As ovExtractFields, using the structural index of a buffer that holds the object (the
+ * index is ignored if it doesn't cover the object)
+ */
+
+int ovExtractIndexedFields(const ovStructuralIndex *index, const char *buffer, size_t length, ovJSONField *fields, int fieldCount)
+{
+    if (!buffer || !fields || fieldCount <= 0 || fieldCount > OV_EXTRACT_MAX_FIELDS) {
+        return -1;
+    }
+    for (int i = 0; i < fieldCount; i++) {
+        fields[i].slot->start = NULL;
+        fields[i].slot->length = 0;
+        fields[i].slot->type = OV_JSON_MISSING;
+    }
+    extractContext context = { fields, fieldCount, 0, buffer + length, NULL, 0 };
+    const char *p = skipSpace(buffer, context.end);
+    useIndex(&context, index, p);
+    if (p >= context.end || *p != '{') {
+        return -1;
+    }
+    unsigned long mask = (fieldCount == OV_EXTRACT_MAX_FIELDS) ? ~0UL : ((1UL << fieldCount) - 1);
+    if (!extractObject(&context, p, 0, mask)) {
+        return -1;
+    }
+    return context.found;
+}
+
+/* Step through the elements of an array slice, offset should start at 0. Returns 1 with the
+ * next element, or 0 once there are no more elements.
+ */
+
+int ovNextElement(const ovJSONSlice *array, size_t *offset, ovJSONSlice *element)
+{
+    return ovNextIndexedElement(NULL, array, offset, element);
+}
+
+int ovNextIndexedElement(const ovStructuralIndex *index, const ovJSONSlice *array, size_t *offset, ovJSONSlice *element)
+{
+    if (!array || array->type != OV_JSON_ARRAY || !offset || !element) {
+        return 0;
+    }
+    const char *end = array->start + array->length;
+    const char *p = array->start + ((*offset == 0) ? 1 : *offset);
+    p = skipSpace(p, end);
+    if (p >= end || *p == ']') {
+        *offset = array->length;
+        return 0;
+    }
+    extractContext context = { NULL, 0, 0, end, NULL, 0 };
+    useIndex(&context, index, p);
+    p = skipValue(&context, p, element);
+    if (!p) {
+        *offset = array->length;
+        return 0;
+    }
+    p = skipSpace(p, end);
+    if (p < end && *p == ',') {
+        p++;
+    }
+    *offset = p - array->start;
+    return 1;
+}
+
+/* Step through the members of an object slice, offset should start at 0. Returns 1 with the
+ * next key (a string slice) and value, or 0 once there are no more members.
+ */
+
+int ovNextMember(const ovJSONSlice *object, size_t *offset, ovJSONSlice *key, ovJSONSlice *value)
+{
+    return ovNextIndexedMember(NULL, object, offset, key, value);
+}
+
+int ovNextIndexedMember(const ovStructuralIndex *index, const ovJSONSlice *object, size_t *offset, ovJSONSlice *key, ovJSONSlice *value)
+{
+    if (!object || object->type != OV_JSON_OBJECT || !offset || !key || !value || *offset >= object->length) {
+        return 0;
+    }
+    const char *end = object->start + object->length;
+    const char *p = object->start + *offset;
+    if (*offset == 0) {
+        p = skipSpace(p, end);
+        if (p >= end || *p != '{') {
+            *offset = object->length;
+            return 0;
+        }
+        p++;
+    }
+    p = skipSpace(p, end);
+    extractContext context = { NULL, 0, 0, end, NULL, 0 };
+    useIndex(&context, index, p);
+    const char *keyClose = (p < end && *p == '"') ? scanString(&context, p) : NULL;
+    if (keyClose) {
+        key->start = p + 1;
+        key->length = keyClose - key->start;
+        key->type = OV_JSON_STRING;
+        p = skipSpace(keyClose + 1, end);
+    }
+    if (!keyClose || p >= end || *p != ':' || !(p = skipValue(&context, skipSpace(p + 1, end), value))) {
+        // The closing brace (or a malformed member)
+        *offset = object->length;
+        return 0;
+    }
+    p = skipSpace(p, end);
+    if (p < end && *p == ',') {
+        p++;
+    }
+    *offset = p - object->start;
+    return 1;
+}
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* Decode the next character of a string slice into out (up to 4 bytes of UTF-8), returning
+ * the number of bytes
+ */
+
+static size_t decodeNext(const char **position, const char *end, char *out)
+{
+    const char *p = *position;
+    if (*p != '\\' || (p + 1) >= end) {
+        out[0] = *p;
+        *position = p + 1;
+        return 1;
+    }
+    p++;
+    size_t bytes = 1;
+    switch (*p) {
+        case 'b': out[0] = '\b'; break;
+        case 'f': out[0] = '\f'; break;
+        case 'n': out[0] = '\n'; break;
+        case 'r': out[0] = '\r'; break;
+        case 't': out[0] = '\t'; break;
+        case 'u': {
+            unsigned long code = 0;
+            for (int i = 1; i <= 4; i++) {
+                int digit = (p + i < end) ? hexValue(p[i]) : -1;
+                if (digit < 0) {
+                    out[0] = '?';
+                    *position = p + 1;
+                    return 1;
+                }
+                code = (code << 4) | digit;
+            }
+            p += 4;
+            // Combine a surrogate pair
+            if (code >= 0xD800 && code <= 0xDBFF && (p + 6) < end && p[1] == '\\' && p[2] == 'u') {
+                unsigned long low = 0;
+                int valid = 1;
+                for (int i = 3; i <= 6; i++) {
+                    int digit = hexValue(p[i]);
+                    if (digit < 0) {
+                        valid = 0;
+                        break;
+                    }
+                    low = (low << 4) | digit;
+                }
+                if (valid && low >= 0xDC00 && low <= 0xDFFF) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+            }
+            if (code < 0x80) {
+                out[0] = (char)code;
+            } else if (code < 0x800) {
+                out[0] = (char)(0xC0 | (code >> 6));
+                out[1] = (char)(0x80 | (code & 0x3F));
+                bytes = 2;
+            } else if (code < 0x10000) {
+                out[0] = (char)(0xE0 | (code >> 12));
+                out[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+                out[2] = (char)(0x80 | (code & 0x3F));
+                bytes = 3;
+            } else {
+                out[0] = (char)(0xF0 | (code >> 18));
+                out[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+                out[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+                out[3] = (char)(0x80 | (code & 0x3F));
+                bytes = 4;
+            }
+            break;
+        }
+        default: out[0] = *p; break; // \" \\ and \/
+    }
+    *position = p + 1;
+    return bytes;
+}
+
+/* Compare a string slice with a value (decoding any escapes in the slice)
+ */
+
+int ovSliceEquals(const ovJSONSlice *slice, const char *value)
+{
+    if (!slice || !value || slice->type != OV_JSON_STRING) {
+        return 0;
+    }
+    if (!memchr(slice->start, '\\', slice->length)) {
+        return (strlen(value) == slice->length) && (memcmp(slice->start, value, slice->length) == 0);
+    }
+    const char *p = slice->start;
+    const char *end = slice->start + slice->length;
+    while (p < end) {
+        char decoded[4];
+        size_t bytes = decodeNext(&p, end, decoded);
+        if (strncmp(value, decoded, bytes) != 0) {
+            return 0;
+        }
+        value += bytes;
+    }
+    return *value == '\0';
+}
+
+/* Copy a string slice into output (decoding any escapes), the output is always terminated.
+ * Returns the length of the decoded string, if this is >= size the output was truncated.
+ */
+
+size_t ovSliceCopy(const ovJSONSlice *slice, char *output, size_t size)
+{
+    if (!slice || !output || size == 0 || slice->type != OV_JSON_STRING) {
+        if (output && size) {
+            output[0] = '\0';
+        }
+        return 0;
+    }
+    const char *p = slice->start;
+    const char *end = slice->start + slice->length;
+    size_t used = 0;
+    while (p < end) {
+        char decoded[4];
+        size_t bytes = decodeNext(&p, end, decoded);
+        for (size_t i = 0; i < bytes; i++, used++) {
+            if (used + 1 < size) {
+                output[used] = decoded[i];
+            }
+        }
+    }
+    output[(used < size) ? used : size - 1] = '\0';
+    return used;
+}
+
+/* Returns a copy of a string slice that will need freeing (NULL if the slice isn't a string)
+ */
+
+char *ovSliceDup(const ovJSONSlice *slice)
+{
+    if (!slice || slice->type != OV_JSON_STRING) {
+        return NULL;
+    }
+    // Decoding never makes a string longer
+    char *copy = malloc(slice->length + 1);
+    if (copy) {
+        ovSliceCopy(slice, copy, slice->length + 1);
+    }
+    return copy;
+}
+
+long long ovSliceInteger(const ovJSONSlice *slice)
+{
+    if (!slice || slice->type != OV_JSON_NUMBER) {
+        return 0;
+    }
+    const char *p = slice->start;
+    const char *end = slice->start + slice->length;
+    int negative = 0;
+    long long value = 0;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = (value * 10) + (*p - '0');
+        p++;
+    }
+    return negative ? -value : value;
+}
@@ -21,14 +21,35 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <pthread.h>
 
+/* A request is built up over several calls (headers, data, method) before it is sent, so the
+ * request being built is held per thread and threads can't send each other's requests.
+ */
+
+static __thread char *httpsAuth;    // String set as User:Pass
+static __thread const char *httpData;     // Data to send to web service
+static __thread long portNumber;     // Set the port to be used by curl
+static __thread int httpMethod;     // Method used to send Data to WebServer
+
+static __thread struct curl_slist *headers = NULL;
+
+// Status and ETag of the last response to httpFunction()
+static __thread long responseCode;
+static __thread char responseETag[256];
 
-char *httpsAuth;    // String set as User:Pass
-const char *httpData;     // Data to send to web service
-long portNumber;     // Set the port to be used by curl
-int httpMethod;     // Method used to send Data to WebServer
+// Called when a request is refused (401) to log in again, it returns the new session token
+static __thread const char *(*renewFunction)(void *context);
+static __thread void *renewContext;
 
-struct curl_slist *headers = NULL;
+// curl_global_init() isn't thread safe, so it is only called once
+static pthread_once_t curlOnce = PTHREAD_ONCE_INIT;
+
+static void initCurl()
+{
+    curl_global_init(CURL_GLOBAL_ALL);
+}
 
 #define BUFFER_SIZE  (1024 * 1024)  /* 1024 KB */
 
@@ -54,6 +75,40 @@ static size_t write_response(void *ptr, size_t size, size_t nmemb, void *stream)
     return size * nmemb;
 }
 
+/* Keep the ETag header of the response (without the quotes that some servers add)
+ */
+
+static size_t read_header(char *buffer, size_t size, size_t nitems, void *stream)
+{
+    size_t length = size * nitems;
+    if (length > 5 && strncasecmp(buffer, "ETag:", 5) == 0) {
+        const char *value = buffer + 5;
+        const char *end = buffer + length;
+        while (value < end && (*value == ' ' || *value == '"')) {
+            value++;
+        }
+        while (end > value && (end[-1] == '\r' || end[-1] == '\n' || end[-1] == ' ' || end[-1] == '"')) {
+            end--;
+        }
+        size_t valueLength = end - value;
+        if (valueLength < sizeof(responseETag)) {
+            memcpy(responseETag, value, valueLength);
+            responseETag[valueLength] = '\0';
+        }
+    }
+    return length;
+}
+
+long httpResponseCode()
+{
+    return responseCode;
+}
+
+const char *httpResponseETag()
+{
+    return responseETag[0] ? responseETag : NULL;
+}
+
 void setHttpAuth(char* authString)
 {
     httpsAuth = authString;
@@ -65,6 +120,54 @@ void appendHttpHeader(char *header)
     headers = curl_slist_append(headers, (const char*) header);
 }
 
+/* The session of the request can be renewed if the request is refused, the request is sent
+ * once more with the new token (set per request, like the headers)
+ */
+
+void setHttpRenewal(const char *(*renew)(void *context), void *context)
+{
+    renewFunction = renew;
+    renewContext = context;
+}
+
+/* Renew the session and replace the Auth header of the request being sent, logging in sends
+ * a request of its own so the request being retried is put aside until it has finished.
+ * The renewal is used up, so a request is only retried once.
+ */
+
+static int renewHeaders()
+{
+    if (!renewFunction) {
+        return EXIT_FAILURE;
+    }
+    struct curl_slist *sent = headers;
+    const char *sentData = httpData;
+    int sentMethod = httpMethod;
+    const char *(*renew)(void *context) = renewFunction;
+    headers = NULL;
+    renewFunction = NULL;
+    
+    const char *cookie = renew(renewContext);
+    
+    httpData = sentData;
+    httpMethod = sentMethod;
+    if (!cookie) {
+        headers = sent;
+        return EXIT_FAILURE;
+    }
+    for (struct curl_slist *header = sent; header; header = header->next) {
+        if (strncmp(header->data, "Auth: ", 6) == 0) {
+            char authHeader[1024];
+            snprintf(authHeader, sizeof(authHeader), "Auth: %s", cookie);
+            appendHttpHeader(authHeader);
+        } else {
+            appendHttpHeader(header->data);
+        }
+    }
+    curl_slist_free_all(sent);
+    return EXIT_SUCCESS;
+}
+
 void createHeader(char *key, const char *data)
 {
     char headerData[strlen(key)+strlen(data)];
@@ -87,53 +190,11 @@ void createURL(oneviewSession *session, char *uri)
 void createURLWithQuery(oneviewSession *session, oneviewQuery *query, char *uri)
 {
     if (((session) && session->address) && strlen(session->address) > 0) { // Ensure that our session exists and an address has been entered
-        // Ensure that the address memory is clear before writing
-        memset(session->debug->usedAddress, 0, 1024);
-        if (!query) { // No query, typically for a POST
-            snprintf(session->debug->usedAddress, 1024, "https://%s%s", session->address, uri);
-        } else { // A query needs constructing typically for a GET
-            // build up a bit mask for the query type
-            int queryMask = 0;
-            if ((query->count > 0) && query->start < query->count)
-                queryMask = queryMask + 1;
-            if (query->query)
-                queryMask = queryMask + 2;
-            if (query->filter)
-                queryMask = queryMask + 4;
-            
-            // Need to invoke curl so that we can make use of curl_easy_escape that will automatically escape characters in the URL (e.g. spaces into %20)
-            CURL *curl = curl_easy_init();
-            
-            switch (queryMask) {
-                case 1:
-                    snprintf(session->debug->usedAddress, 1024, "https://%s%s&count=%d", session->address, uri, query->count);
-                    break;
-                case 2:
-                    snprintf(session->debug->usedAddress, 1024, "https://%s%s?query=%s", session->address, uri, curl_easy_escape(curl, query->query, 0));
-                    break;
-                case 3:
-                    snprintf(session->debug->usedAddress, 1024, "https://%s%s?count=%d&?query=\"%s\"", session->address, uri, query->count, curl_easy_escape(curl, query->query, 0));
-                    break;
-                case 4:
-                    snprintf(session->debug->usedAddress, 1024, "https://%s%s?filter=%s", session->address, uri, curl_easy_escape(curl, query->filter, 0));
-                    break;
-                case 5:
-                    snprintf(session->debug->usedAddress, 1024, "https://%s%s?count=%d&?filter=\"%s\"", session->address, uri, query->count, curl_easy_escape(curl, query->filter, 0));
-                    break;
-                case 6:
-                    snprintf(session->debug->usedAddress, 1024, "https://%s%s?query=\"%s\"?filter=\"%s\"", session->address, uri, curl_easy_escape(curl, query->query, 0), curl_easy_escape(curl, query->filter, 0));
-                    break;
-                case 7:
-                    snprintf(session->debug->usedAddress, 1024, "https://%s%s?count=%d&?query=\"%s\"?filter=\"%s\"", session->address, uri, query->count, curl_easy_escape(curl, query->query, 0), curl_easy_escape(curl, query->filter, 0));
-                    break;
-                default:
-                    snprintf(session->debug->usedAddress, 1024, "https://%s%s", session->address, uri);
-                    break;
-            }
-            // Finished with curl, so free the instance
-            curl_easy_cleanup(curl);
-            
+        // Build the URL into the re-usable buffer, the buffer may move if it has to grow
+        if (ovURLBuild(session->debug->url, session->address, uri, query) == EXIT_FAILURE) {
+            ovPrintError(getPluginTime(), "Unable to build URL\n");
         }
+        session->debug->usedAddress = session->debug->url->data;
     }
     
 }
@@ -171,7 +232,9 @@ char *httpFunction(char *url)
     char *data = NULL;
     long code;
     
-    curl_global_init(CURL_GLOBAL_ALL);
+    responseCode = 0;
+    responseETag[0] = '\0';
+    pthread_once(&curlOnce, initCurl);
     curl = curl_easy_init();
     if(!curl)
         goto error;
@@ -198,6 +261,7 @@ char *httpFunction(char *url)
     }
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_response);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, &write_result);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, read_header);
     
     switch (httpMethod) {
         case DCHTTPPOST:
@@ -225,6 +289,7 @@ char *httpFunction(char *url)
     }
     
     curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+    responseCode = code;
     
     switch (code) {
         case 200:
@@ -260,10 +325,23 @@ char *httpFunction(char *url)
         goto error;
     }
     
+    // The session has expired, send the request again once it has been renewed
+    if (code == 401 && renewFunction) {
+        curl_easy_cleanup(curl);
+        curl = NULL;
+        if (renewHeaders() == EXIT_SUCCESS) {
+            free(data);
+            ovPrintInfo(getPluginTime(), "Session renewed, sending the request again\n");
+            return httpFunction(url);
+        }
+        goto error;
+    }
+    
     curl_easy_cleanup(curl);
     curl_slist_free_all(headers);
     // Set headers to NULL so that they can be reallocated by headers_append()
     headers = NULL;
+    renewFunction = NULL;
     //curl_global_cleanup();
     
     /* zero-terminate the result */
@@ -280,10 +358,224 @@ error:
         curl_slist_free_all(headers);
         headers = NULL;
     }
-    curl_global_cleanup();
+    renewFunction = NULL;
     return NULL;
 }
 
+/* Responses to concurrent requests grow as they arrive (there could be hundreds in flight so
+ * they don't each get a BUFFER_SIZE buffer)
+ */
+
+struct multi_result
+{
+    char *data;
+    size_t pos;
+    size_t size;
+    long code;
+    int failed;
+};
+
+static size_t write_multi_response(void *ptr, size_t size, size_t nmemb, void *stream)
+{
+    struct multi_result *result = (struct multi_result *)stream;
+    size_t length = size * nmemb;
+    if (result->pos + length + 1 > result->size) {
+        size_t newSize = result->size ? result->size : 16384;
+        while (result->pos + length + 1 > newSize) {
+            newSize *= 2;
+        }
+        if (newSize > BUFFER_SIZE * 64) {
+            result->failed = 1;
+            return 0;
+        }
+        char *newData = realloc(result->data, newSize);
+        if (!newData) {
+            result->failed = 1;
+            return 0;
+        }
+        result->data = newData;
+        result->size = newSize;
+    }
+    memcpy(result->data + result->pos, ptr, length);
+    result->pos += length;
+    return length;
+}
+
+static CURL *multiHandle(char *url, char *data, struct multi_result *result)
+{
+    CURL *curl = curl_easy_init();
+    if (!curl) {
+        return NULL;
+    }
+    if (portNumber != 0) {
+        curl_easy_setopt(curl, CURLOPT_PORT, portNumber);
+    }
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0); /* This is due to self signed Certs */
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 15);
+    if (data && httpMethod < 2) {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data);
+    }
+    if (httpMethod == DCHTTPPUT) {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
+    } else if (httpMethod == DCHTTPDELETE) {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+    }
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_multi_response);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, result);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, result);
+    return curl;
+}
+
+/* GET a batch of urls with at most concurrency requests in flight, the headers are shared by
+ * every request. Each response is placed in responses (NULL if the request failed or OneView
+ * returned an error status) and the number of successful requests is returned.
+ */
+
+size_t httpMultiFunction(char **urls, size_t count, char **responses, int concurrency)
+{
+    return httpMultiDataFunction(urls, NULL, count, responses, concurrency);
+}
+
+/* Send the requests listed in which (urls[which[i]] with data[which[i]]) with at most
+ * concurrency in flight, the outcome of each is left in its result
+ */
+
+static void performMulti(char **urls, char **data, const size_t *which, size_t count, struct multi_result *results, int concurrency)
+{
+    CURLM *multi = curl_multi_init();
+    if (!multi) {
+        for (size_t i = 0; i < count; i++) {
+            results[which[i]].failed = 1;
+        }
+        return;
+    }
+    curl_multi_setopt(multi, CURLMOPT_MAX_TOTAL_CONNECTIONS, (long)concurrency);
+
+    size_t added = 0;
+    int running = 0;
+    for (; added < count && added < (size_t)concurrency; added++) {
+        size_t request = which[added];
+        CURL *curl = multiHandle(urls[request], data ? data[request] : NULL, &results[request]);
+        if (curl) {
+            curl_multi_add_handle(multi, curl);
+        } else {
+            results[request].failed = 1;
+        }
+    }
+    do {
+        curl_multi_perform(multi, &running);
+        CURLMsg *message;
+        int remaining;
+        while ((message = curl_multi_info_read(multi, &remaining))) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+            CURL *curl = message->easy_handle;
+            struct multi_result *result = NULL;
+            long code = 0;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char **)&result);
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+            result->code = code;
+            if (message->data.result != CURLE_OK || code > 500) {
+                char *url = NULL;
+                curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &url);
+                fprintf(stderr, "[ERROR] unable to request data from %s:\n", url ? url : "");
+                fprintf(stderr, "%s\n", curl_easy_strerror(message->data.result));
+                result->failed = 1;
+            } else if (code >= 400 && code != 401) {
+                // The body is an error document rather than the resource (401 is renewed below)
+                char *url = NULL;
+                char ovOutput[1024];
+                curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &url);
+                snprintf(ovOutput, sizeof(ovOutput), "%s returned %ld => %.*s\n", url ? url : "", code,
+                         (int)(result->pos < 512 ? result->pos : 512), result->data ? result->data : "");
+                ovPrintWarning(getPluginTime(), ovOutput);
+                result->failed = 1;
+            }
+            curl_multi_remove_handle(multi, curl);
+            curl_easy_cleanup(curl);
+            // Keep the batch full
+            for (; added < count; added++) {
+                size_t request = which[added];
+                CURL *next = multiHandle(urls[request], data ? data[request] : NULL, &results[request]);
+                if (next) {
+                    curl_multi_add_handle(multi, next);
+                    running++;
+                    added++;
+                    break;
+                }
+                results[request].failed = 1;
+            }
+        }
+        if (running) {
+            curl_multi_wait(multi, NULL, 0, 1000, NULL);
+        }
+    } while (running);
+    curl_multi_cleanup(multi);
+}
+
+/* As above, but using the method set with SetHttpMethod() and sending data[i] (if data is
+ * set) with the request to urls[i]
+ */
+
+size_t httpMultiDataFunction(char **urls, char **data, size_t count, char **responses, int concurrency)
+{
+    size_t succeeded = 0;
+    if (!urls || !responses || count == 0) {
+        return 0;
+    }
+    struct multi_result *results = calloc(count, sizeof(struct multi_result));
+    size_t *which = calloc(count, sizeof(size_t));
+    if (!results || !which) {
+        goto done;
+    }
+    pthread_once(&curlOnce, initCurl);
+    if (concurrency < 1) {
+        concurrency = 1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        which[i] = i;
+    }
+    performMulti(urls, data, which, count, results, concurrency);
+    
+    // Requests refused because the session expired are sent again once it has been renewed
+    size_t refused = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (results[i].code == 401 && !results[i].failed) {
+            which[refused++] = i;
+        }
+    }
+    if (refused && renewHeaders() == EXIT_SUCCESS) {
+        for (size_t i = 0; i < refused; i++) {
+            free(results[which[i]].data);
+            memset(&results[which[i]], 0, sizeof(struct multi_result));
+        }
+        performMulti(urls, data, which, refused, results, concurrency);
+    }
+
+done:
+    for (size_t i = 0; i < count; i++) {
+        responses[i] = NULL;
+        // A request that is still refused once the session was renewed (or couldn't be) failed
+        if (results && !results[i].failed && results[i].data && results[i].code != 401) {
+            results[i].data[results[i].pos] = '\0';
+            responses[i] = results[i].data;
+            succeeded++;
+        } else if (results) {
+            free(results[i].data);
+        }
+    }
+    free(results);
+    free(which);
+    curl_slist_free_all(headers);
+    // Set headers to NULL so that they can be reallocated by headers_append()
+    headers = NULL;
+    renewFunction = NULL;
+    return succeeded;
+}
+
 void PrintHttpAuth()
 {
     if (httpsAuth) {
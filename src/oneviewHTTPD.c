@@ -25,6 +25,7 @@
 #include <time.h>
 #include <sys/wait.h>
 #include <unistd.h>
+#include <poll.h>
 
 #include <stddef.h>
 
@@ -33,6 +34,7 @@
 
 // Function Prototypes
 int receive(int socket);
+size_t sendString(char *message, int socket);
 
 
 int port;
@@ -49,7 +51,22 @@ socklen_t addr_size;
 
 httpResponse *response;
 
+// The response to the current connection and the writer its JSON is built in
+static httpResponse connectionResponse;
+static ovJSONWriter responseWriter;
+
 int (*postCallback)(httpRequest *);
+int (*flushCallback)(void);
+
+/* Connections whose response was deferred by the POST callback, they are held open until the
+ * coalescing window closes (or the limit is reached) and the flush callback answers them
+ */
+
+static int heldConnections[OV_HTTPD_MAX_HELD];
+static int heldCount;
+static int connectionDeferred;
+static long coalesceWindow;
+static struct timespec windowCloses;
 
 
 /*****************************************************************/
@@ -77,6 +94,24 @@ void SetPostFunction( int (*postCallbackFunction)(httpRequest *))
     postCallback = postCallbackFunction;
 }
 
+void SetFlushFunction( int (*flushCallbackFunction)(void))
+{
+    flushCallback = flushCallbackFunction;
+}
+
+/* Number of milliseconds deferred connections are held for before they are flushed
+ */
+
+void setHTTPCoalesceWindow(long milliseconds)
+{
+    coalesceWindow = (milliseconds > 0) ? milliseconds : 0;
+}
+
+long getHTTPCoalesceWindow()
+{
+    return coalesceWindow;
+}
+
  /* These functions will handle the steps of creating a socket, it can
   * either be a UNIX Socket or an INET socket. The INET Socket will sit on
   * a IP Stack, the UNIX Socket will allow Interprocess communiation
@@ -165,8 +200,58 @@ void acceptConnection()
         exit(-1);
     }
     
+    connectionDeferred = 0;
     handle(connecting_socket);
-    close(connecting_socket);
+    if (!connectionDeferred) {
+        close(connecting_socket);
+    }
+}
+
+/* The connection of the request being handled, so a deferred response can be sent to it
+ */
+
+int httpCurrentConnection()
+{
+    return connecting_socket;
+}
+
+static long millisecondsUntil(const struct timespec *deadline)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (deadline->tv_sec - now.tv_sec) * 1000 + (deadline->tv_nsec - now.tv_nsec) / 1000000;
+}
+
+/* Hand the held connections to the flush callback, any that it doesn't answer are sent an
+ * error so no client is left waiting
+ */
+
+static void flushHeldConnections()
+{
+    if (flushCallback) {
+        flushCallback();
+    }
+    for (int i = 0; i < heldCount; i++) {
+        sendString("HTTP/1.1 500 Error\r\n\r\n", heldConnections[i]);
+        close(heldConnections[i]);
+    }
+    heldCount = 0;
+}
+
+/* Keep accepting connections until the window of the held connections closes
+ */
+
+static void acceptUntilWindowCloses()
+{
+    long remaining = millisecondsUntil(&windowCloses);
+    if (remaining > 0 && heldCount < OV_HTTPD_MAX_HELD) {
+        struct pollfd listener = { .fd = current_socket, .events = POLLIN };
+        if (poll(&listener, 1, (int)remaining) > 0) {
+            acceptConnection();
+            return;
+        }
+    }
+    flushHeldConnections();
 }
 
 /* These functions will handle the steps of creating the sockets, binding to them
@@ -262,6 +347,7 @@ int setHTTPResponse(char *messageBody, int responseCode)
     if (messageBody) {
         response->messageBody = messageBody;
         response->messageLength = strlen(messageBody);
+        response->ownsBody = 1;
     } else {
         response->messageLength = 0;
     }
@@ -269,6 +355,25 @@ int setHTTPResponse(char *messageBody, int responseCode)
         return EXIT_SUCCESS;
 }
 
+/* The writer for the response to the current connection, it is empty for each request and
+ * the response is sent straight from it (see setHTTPResponseFromWriter)
+ */
+
+ovJSONWriter *httpResponseWriter()
+{
+    return &responseWriter;
+}
+
+int setHTTPResponseFromWriter(ovJSONWriter *writer, int responseCode)
+{
+    const char *text = ovWriterText(writer);
+    response->messageBody = (char *)text;
+    response->messageLength = text ? ovWriterLength(writer) : 0;
+    response->ownsBody = 0;
+    response->responseCode = responseCode;
+    return EXIT_SUCCESS;
+}
+
 size_t sendString(char *message, int socket)
 {
     size_t length, bytes_sent;
@@ -290,53 +395,15 @@ size_t sendBinary(int *byte, int length)
 
 void sendHeader(char *Status_code, char *Content_Type, size_t TotalSize, int socket)
 {
-    char *head = "HTTP/1.1 ";
-    char *content_head = "\r\nContent-Type: ";
-    char *server_head = "\r\nServer: InfraKit";
-    char *length_head = "\r\nContent-Length: ";
-    char *date_head = "\r\nDate: ";
-    char *newline = "\r\n";
-    char contentLength[100];
-    
+    char message[512];
     time_t rawtime;
     
     time ( &rawtime );
     
-    // int contentLength = strlen(HTML);
-    sprintf(contentLength, "%zu", TotalSize);
-    
-    char *message = malloc((
-                            strlen(head) +
-                            strlen(content_head) +
-                            strlen(server_head) +
-                            strlen(length_head) +
-                            strlen(date_head) +
-                            strlen(newline) +
-                            strlen(Status_code) +
-                            strlen(Content_Type) +
-                            strlen(contentLength) +
-                            28 +
-                            sizeof(char)) * 2);
-    
-    if ( message != NULL )
-    {
-        
-        strcpy(message, head);
-        
-        strcat(message, Status_code);
-        
-        strcat(message, content_head);
-        strcat(message, Content_Type);
-        strcat(message, server_head);
-        strcat(message, length_head);
-        strcat(message, contentLength);
-        strcat(message, date_head);
-        strcat(message, (char*)ctime(&rawtime));
-        strcat(message, newline);
-        
-        sendString(message, socket);
-        free(message);
-    }
+    // ctime() ends with a newline, which is kept as it always has been
+    snprintf(message, sizeof(message), "HTTP/1.1 %s\r\nContent-Type: %s\r\nServer: InfraKit\r\nContent-Length: %zu\r\nDate: %s\r\n",
+             Status_code, Content_Type, TotalSize, ctime(&rawtime));
+    sendString(message, socket);
 }
 
 void sendHTML(char *statusCode, char *contentType, char *content, int size, int socket)
@@ -353,7 +420,7 @@ int handleHttpGET(char *input)
 
 
 
-int respond()
+int respond(int socket)
 {
     /* Check reponse is allocated then
      * work through the response that the callback should have populated
@@ -364,22 +431,22 @@ int respond()
     if (response) {
         switch (response->responseCode) {
             case 200:
-                sendHeader("200 OK", "application/json", response->messageLength, connecting_socket);
+                sendHeader("200 OK", "application/json", response->messageLength, socket);
                 break;
             case 202:
-                sendHeader("202 Accepted", "application/json", response->messageLength, connecting_socket);
+                sendHeader("202 Accepted", "application/json", response->messageLength, socket);
                 break;
             case 204:
-                sendHeader("204 No Response", "application/json", response->messageLength, connecting_socket);
+                sendHeader("204 No Response", "application/json", response->messageLength, socket);
                 break;
             case 405:
-                sendHeader("405 Method Not Allowed", "application/json", response->messageLength, connecting_socket);
+                sendHeader("405 Method Not Allowed", "application/json", response->messageLength, socket);
                 break;
             case 415:
-                sendHeader("415 Unsupported Media Type", "application/json", response->messageLength, connecting_socket);
+                sendHeader("415 Unsupported Media Type", "application/json", response->messageLength, socket);
                 break;
             default:
-                sendString("HTTP/1.1 500 Error\r\n\r\n", connecting_socket);
+                sendString("HTTP/1.1 500 Error\r\n\r\n", socket);
         }
         
         /* If the message length is more that 0 and that the messageBody isn't NULL
@@ -388,15 +455,40 @@ int respond()
          */
 
         if ((response->messageLength > 0) && response->messageBody) {
-            sendString(response->messageBody, connecting_socket);
-            free(response->messageBody);
-            free(response);
+            sendString(response->messageBody, socket);
+            if (response->ownsBody) {
+                free(response->messageBody);
+            }
         }
+        ovWriterReset(&responseWriter);
         return EXIT_SUCCESS;
     }
     return EXIT_FAILURE;
 }
 
+/* Send the response in the writer to a connection that was deferred and close it
+ */
+
+int httpRespondToConnection(int connection, ovJSONWriter *writer, int responseCode)
+{
+    int held = -1;
+    for (int i = 0; i < heldCount; i++) {
+        if (heldConnections[i] == connection) {
+            held = i;
+        }
+    }
+    if (held == -1) {
+        return EXIT_FAILURE;
+    }
+    memset(&connectionResponse, 0, sizeof(httpResponse));
+    response = &connectionResponse;
+    setHTTPResponseFromWriter(writer, responseCode);
+    respond(connection);
+    close(connection);
+    heldConnections[held] = heldConnections[--heldCount];
+    return EXIT_SUCCESS;
+}
+
 int receive(int socket)
 {
     ssize_t msgLen = 0;
@@ -486,10 +578,26 @@ int receive(int socket)
              * respond accordingly to the client
              */
             
-            response = malloc(sizeof(httpResponse));
+            memset(&connectionResponse, 0, sizeof(httpResponse));
+            response = &connectionResponse;
+            ovWriterReset(&responseWriter);
             int callback = postCallback(request);
             if (callback == EXIT_SUCCESS) {
-                respond();
+                respond(connecting_socket);
+            } else if (callback == OV_HTTPD_DEFERRED) {
+                // The window starts with the first connection that is held
+                if (heldCount == 0) {
+                    clock_gettime(CLOCK_MONOTONIC, &windowCloses);
+                    windowCloses.tv_sec += coalesceWindow / 1000;
+                    windowCloses.tv_nsec += (coalesceWindow % 1000) * 1000000;
+                    if (windowCloses.tv_nsec >= 1000000000) {
+                        windowCloses.tv_sec++;
+                        windowCloses.tv_nsec -= 1000000000;
+                    }
+                }
+                // There is always room, the held connections are flushed once the limit is reached
+                heldConnections[heldCount++] = connecting_socket;
+                connectionDeferred = 1;
             }
             // Free
             
@@ -514,6 +622,7 @@ int receive(int socket)
 
 void startHTTPDServer()
 {
+    initJSONWriter(&responseWriter);
     // This will create a socket
     createUNIXSocket();
     // We will bind the plugin socket file to the socket structure
@@ -523,7 +632,11 @@ void startHTTPDServer()
     
     while (1) {
         // As connections come in, accept them and start processing them
-        acceptConnection();
+        if (heldCount > 0) {
+            acceptUntilWindowCloses();
+        } else {
+            acceptConnection();
+        }
     }
 
 }
@@ -0,0 +1,137 @@
+
+// oneviewHash.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+
+#include "oneviewHash.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* FNV-1a, the uris that are hashed share long prefixes (/rest/server-hardware/...) so every
+ * byte of the key needs to affect the result.
+ */
+
+unsigned long ovHashString(const char *key)
+{
+    unsigned long hash = 2166136261UL;
+    while (*key) {
+        hash ^= (unsigned char)*key++;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+int initHashIndex(oneviewHashIndex *index, size_t expected)
+{
+    if (!index) {
+        return EXIT_FAILURE;
+    }
+    // Keep the index at most half full
+    size_t size = 16;
+    while (size < expected * 2) {
+        size <<= 1;
+    }
+    index->keys = calloc(size, sizeof(const char *));
+    index->values = malloc(size * sizeof(int));
+    if (!index->keys || !index->values) {
+        free(index->keys);
+        free(index->values);
+        index->keys = NULL;
+        index->values = NULL;
+        index->size = 0;
+        index->count = 0;
+        return EXIT_FAILURE;
+    }
+    index->size = size;
+    index->count = 0;
+    return EXIT_SUCCESS;
+}
+
+static size_t findSlot(const oneviewHashIndex *index, const char *key)
+{
+    size_t mask = index->size - 1;
+    size_t slot = ovHashString(key) & mask;
+    while (index->keys[slot] && strcmp(index->keys[slot], key) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static int growHashIndex(oneviewHashIndex *index)
+{
+    oneviewHashIndex larger;
+    if (initHashIndex(&larger, index->size) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < index->size; i++) {
+        if (index->keys[i]) {
+            size_t slot = findSlot(&larger, index->keys[i]);
+            larger.keys[slot] = index->keys[i];
+            larger.values[slot] = index->values[i];
+            larger.count++;
+        }
+    }
+    freeHashIndex(index);
+    *index = larger;
+    return EXIT_SUCCESS;
+}
+
+/* Insert (or replace the value of) a key
+ */
+
+int ovHashInsert(oneviewHashIndex *index, const char *key, int value)
+{
+    if (!index || !key || index->size == 0) {
+        return EXIT_FAILURE;
+    }
+    if ((index->count + 1) * 2 > index->size && growHashIndex(index) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    size_t slot = findSlot(index, key);
+    if (!index->keys[slot]) {
+        index->keys[slot] = key;
+        index->count++;
+    }
+    index->values[slot] = value;
+    return EXIT_SUCCESS;
+}
+
+int ovHashFind(const oneviewHashIndex *index, const char *key)
+{
+    if (!index || !key || index->size == 0) {
+        return OV_HASH_NOT_FOUND;
+    }
+    size_t slot = findSlot(index, key);
+    if (index->keys[slot]) {
+        return index->values[slot];
+    }
+    return OV_HASH_NOT_FOUND;
+}
+
+/* Evaluate the struct and determine what is populated
+ then free resources back to the heap.
+ */
+
+int freeHashIndex(oneviewHashIndex *index)
+{
+    if (index) {
+        free(index->keys);
+        free(index->values);
+        index->keys = NULL;
+        index->values = NULL;
+        index->size = 0;
+        index->count = 0;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,292 @@
+
+// oneviewIndex.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+
+#include "oneviewIndex.h"
+#include "oneviewInfraKitConsole.h"
+#include "oneviewExtract.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* These functions resolve a set of uris or names, across the server-hardware, server-profiles
+ * and server-profile-templates categories, through the OneView index search API. Rather than
+ * downloading each full collection, every batch of up to OV_INDEX_BATCH_SIZE keys is sent as
+ * a single search (following nextPageUri if OneView pages the results).
+ */
+
+static const char *indexCategories[] = {
+    "server-hardware",
+    "server-profiles",
+    "server-profile-templates"
+};
+
+#define OV_INDEX_CATEGORY_COUNT (int)(sizeof(indexCategories) / sizeof(indexCategories[0]))
+
+const char *ovIndexCategoryName(int category)
+{
+    if (category >= 0 && category < OV_INDEX_CATEGORY_COUNT) {
+        return indexCategories[category];
+    }
+    return NULL;
+}
+
+static int ovIndexCategoryFromName(const char *name)
+{
+    for (int i = 0; i < OV_INDEX_CATEGORY_COUNT; i++) {
+        if (stringMatch(name, indexCategories[i])) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Index resources hold the resource specific values in the "attributes" object, however
+ * some of the common values are held at the top level of the member. Every member is read
+ * with the field extractor, so only the values that are kept are ever copied.
+ */
+
+#define INDEX_VALUE_COUNT 8
+
+static const char *indexValueNames[INDEX_VALUE_COUNT] = {
+    "uri", "name", "state", "powerState", "serverProfileUri",
+    "serverHardwareUri", "serverHardwareTypeUri", "enclosureGroupUri"
+};
+
+static const char *indexAttributePaths[INDEX_VALUE_COUNT] = {
+    "attributes.uri", "attributes.name", "attributes.state", "attributes.powerState", "attributes.serverProfileUri",
+    "attributes.serverHardwareUri", "attributes.serverHardwareTypeUri", "attributes.enclosureGroupUri"
+};
+
+static int appendIndexRecord(oneviewIndexResult *result, size_t *allocated, const ovStructuralIndex *index, const ovJSONSlice *member)
+{
+    ovJSONSlice category;
+    ovJSONSlice values[INDEX_VALUE_COUNT];
+    ovJSONSlice attributes[INDEX_VALUE_COUNT];
+    ovJSONField fields[(INDEX_VALUE_COUNT * 2) + 1];
+    for (int i = 0; i < INDEX_VALUE_COUNT; i++) {
+        fields[i].path = indexAttributePaths[i];
+        fields[i].slot = &attributes[i];
+        fields[INDEX_VALUE_COUNT + i].path = indexValueNames[i];
+        fields[INDEX_VALUE_COUNT + i].slot = &values[i];
+    }
+    fields[INDEX_VALUE_COUNT * 2].path = "category";
+    fields[INDEX_VALUE_COUNT * 2].slot = &category;
+    if (ovExtractIndexedFields(index, member->start, member->length, fields, (INDEX_VALUE_COUNT * 2) + 1) == -1) {
+        return EXIT_FAILURE;
+    }
+
+    char categoryName[64];
+    ovSliceCopy(&category, categoryName, sizeof(categoryName));
+    int categoryId = ovIndexCategoryFromName(categoryName);
+    if (categoryId == -1) {
+        return EXIT_FAILURE;
+    }
+    if (result->count == *allocated) {
+        size_t newAllocated = (*allocated) ? (*allocated) * 2 : OV_INDEX_BATCH_SIZE;
+        oneviewIndexRecord *newRecords = realloc(result->records, newAllocated * sizeof(oneviewIndexRecord));
+        if (!newRecords) {
+            return EXIT_FAILURE;
+        }
+        result->records = newRecords;
+        *allocated = newAllocated;
+    }
+    // Prefer the value from the attributes, otherwise use the top level value
+    char *copies[INDEX_VALUE_COUNT];
+    for (int i = 0; i < INDEX_VALUE_COUNT; i++) {
+        copies[i] = ovSliceDup((attributes[i].type == OV_JSON_STRING) ? &attributes[i] : &values[i]);
+    }
+    oneviewIndexRecord *record = &result->records[result->count++];
+    record->category = categoryId;
+    record->uri = copies[0];
+    record->name = copies[1];
+    record->state = copies[2];
+    record->powerState = copies[3];
+    record->serverProfileUri = copies[4];
+    record->serverHardwareUri = copies[5];
+    record->serverHardwareTypeUri = copies[6];
+    record->enclosureGroupUri = copies[7];
+    return EXIT_SUCCESS;
+}
+
+/* Parse a page of index results into the result set, returning the uri of the next page
+ * (which will need freeing) or NULL when there are no more pages
+ */
+
+static char *parseIndexPage(oneviewIndexResult *result, size_t *allocated, char *rawJSON)
+{
+    ovJSONSlice members, nextPageUri;
+    ovJSONField fields[] = {
+        { "members", &members },
+        { "nextPageUri", &nextPageUri }
+    };
+    ovStructuralIndex structural;
+    initStructuralIndex(&structural);
+    size_t length = strlen(rawJSON);
+    const ovStructuralIndex *index = ovIndexLargeResponse(&structural, rawJSON, length);
+    if (ovExtractIndexedFields(index, rawJSON, length, fields, 2) == -1) {
+        freeStructuralIndex(&structural);
+        return NULL;
+    }
+    size_t memberCount = 0;
+    size_t offset = 0;
+    ovJSONSlice member;
+    while (ovNextIndexedElement(index, &members, &offset, &member)) {
+        appendIndexRecord(result, allocated, index, &member);
+        memberCount++;
+    }
+    freeStructuralIndex(&structural);
+    if (memberCount != 0) {
+        return ovSliceDup(&nextPageUri);
+    }
+    return NULL;
+}
+
+/* Build the search expression for a batch of keys, uri:'<uri>' OR name:'<name>' ...
+ */
+
+static char *buildIndexQuery(const oneviewIndexKey *keys, size_t keyCount)
+{
+    size_t length = 1;
+    for (size_t i = 0; i < keyCount; i++) {
+        const char *value = keys[i].uri ? keys[i].uri : keys[i].name;
+        if (value) {
+            length += strlen(value) + 16;
+        }
+    }
+    char *query = malloc(length);
+    if (!query) {
+        return NULL;
+    }
+    size_t position = 0;
+    query[0] = '\0';
+    for (size_t i = 0; i < keyCount; i++) {
+        const char *field = keys[i].uri ? "uri" : "name";
+        const char *value = keys[i].uri ? keys[i].uri : keys[i].name;
+        if (value) {
+            position += snprintf(query + position, length - position, "%s%s:'%s'", (position == 0) ? "" : " OR ", field, value);
+        }
+    }
+    return query;
+}
+
+oneviewIndexResult *ovIndexLookup(oneviewSession *session, const oneviewIndexKey *keys, size_t keyCount)
+{
+    if (!session || !session->cookie || !keys) {
+        return NULL;
+    }
+    oneviewIndexResult *result = malloc(sizeof(oneviewIndexResult));
+    if (!result) {
+        return NULL;
+    }
+    result->count = 0;
+    result->records = NULL;
+    size_t allocated = 0;
+
+    for (size_t batchStart = 0; batchStart < keyCount; batchStart += OV_INDEX_BATCH_SIZE) {
+        size_t batchCount = keyCount - batchStart;
+        if (batchCount > OV_INDEX_BATCH_SIZE) {
+            batchCount = OV_INDEX_BATCH_SIZE;
+        }
+
+        // Only search the categories that are part of this batch
+        const char *categories[OV_INDEX_CATEGORY_COUNT];
+        int categoryCount = 0;
+        for (int category = 0; category < OV_INDEX_CATEGORY_COUNT; category++) {
+            for (size_t i = batchStart; i < batchStart + batchCount; i++) {
+                if (keys[i].category == category) {
+                    categories[categoryCount++] = indexCategories[category];
+                    break;
+                }
+            }
+        }
+        if (categoryCount == 0) {
+            continue;
+        }
+
+        char *searchQuery = buildIndexQuery(&keys[batchStart], batchCount);
+        if (!searchQuery) {
+            break;
+        }
+        oneviewQuery query = {0};
+        query.query = searchQuery;
+
+        char *rawJSON = ovQueryIndexResources(session, &query, categories, categoryCount);
+        free(searchQuery);
+
+        while (rawJSON) {
+            char *nextPage = parseIndexPage(result, &allocated, rawJSON);
+            free(rawJSON);
+            rawJSON = NULL;
+            if (nextPage) {
+                rawJSON = ovQueryWithURI(session, nextPage);
+                free(nextPage);
+            }
+        }
+    }
+
+    char ovOutput[1024];
+    snprintf(ovOutput, 1024, "Index search resolved %zu records from %zu keys\n", result->count, keyCount);
+    ovPrintDebug(getPluginTime(), ovOutput);
+    return result;
+}
+
+oneviewIndexRecord *ovIndexFindURI(oneviewIndexResult *result, int category, const char *uri)
+{
+    if (result && uri) {
+        for (size_t i = 0; i < result->count; i++) {
+            if (result->records[i].category == category && stringMatch(result->records[i].uri, uri)) {
+                return &result->records[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+oneviewIndexRecord *ovIndexFindName(oneviewIndexResult *result, int category, const char *name)
+{
+    if (result && name) {
+        for (size_t i = 0; i < result->count; i++) {
+            if (result->records[i].category == category && stringMatch(result->records[i].name, name)) {
+                return &result->records[i];
+            }
+        }
+    }
+    return NULL;
+}
+
+/* Evaluate the struct and determine what is populated
+ then free resources back to the heap.
+ */
+
+int freeIndexResult(oneviewIndexResult *result)
+{
+    if (result) {
+        for (size_t i = 0; i < result->count; i++) {
+            oneviewIndexRecord *record = &result->records[i];
+            free(record->uri);
+            free(record->name);
+            free(record->state);
+            free(record->powerState);
+            free(record->serverProfileUri);
+            free(record->serverHardwareUri);
+            free(record->serverHardwareTypeUri);
+            free(record->enclosureGroupUri);
+        }
+        free(result->records);
+        free(result);
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
@@ -15,7 +15,16 @@
 #include "oneviewInfraKitConsole.h"
 #include "oneviewInfraKitPlugin.h"
 #include "oneviewInfraKitState.h"
+#include "oneviewIndex.h"
+#include "oneviewInventory.h"
+#include "oneviewSnapshot.h"
 #include "oneview.h"
+#include "oneviewArena.h"
+#include "oneviewInfraKitPipeline.h"
+#include "oneviewInfraKitTasks.h"
+#include "oneviewSessions.h"
+#include "oneviewTemplates.h"
+#include "oneviewInfraKitLedger.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -34,34 +43,45 @@ json_int_t internal_error =     -32603;
 
 json_t *powerState;
 
-/* This session is for the duration of InfraKit and isn't designed to renew
- * cookies once they have expired
+/* This session is for the duration of InfraKit, it is attached to the session manager which
+ * keeps it logged in (see oneviewSessions.h)
  */
 
 oneviewSession *infrakitSession;
 
-/* These function(s) handle logging into the physical infrastructure.
+/* These function(s) handle logging into the physical infrastructure, the appliance and user
+ * are only logged in the first time (or once the session has expired). The templates of the
+ * appliance are read once it is logged in.
  *
  */
 
 int instanceLogin(const char *address, const char *username, const char *password)
 {
-    infrakitSession = initSession();
     if (!infrakitSession) {
+        infrakitSession = initSession();
+        if (!infrakitSession) {
+            return EXIT_FAILURE;
+        }
+    }
+    if (ovSessionAttach(infrakitSession, address, username, password) == EXIT_FAILURE) {
         return EXIT_FAILURE;
     }
-    infrakitSession->address = strdup(address);
-    infrakitSession->username = strdup(username);
-    infrakitSession->password = strdup(password);
-    infrakitSession->version = identifyOneview(infrakitSession);
-    return ovLogin(infrakitSession);
+    ovTemplatesRefresh(infrakitSession, 0);
+    return EXIT_SUCCESS;
 }
 
 int destroyServerProfile(const char *hardwareURI) {
     char *profileURI = serverProfileFromHardwareURI(infrakitSession, (char *) hardwareURI);
     if (profileURI) {
-        // remove the server profile
-        ovDeleteProfile(infrakitSession, profileURI);
+        // remove the server profile, the hardware is free once the task removing it completes
+        char *response = NULL;
+        if (ovDeleteProfile(infrakitSession, profileURI, &response) == EXIT_SUCCESS) {
+            char *taskURI = ovTaskFromResponse(response);
+            ovTrackTask(OV_TASK_PROFILE_DELETE, taskURI, NULL, ovIntern(hardwareURI), \
+                        ovIntern(infrakitSession->address), ovIntern(infrakitSession->username));
+            free(taskURI);
+            free(response);
+        }
     } else {
         // warning that the state lists a profile that isn't attached to hardware
         return EXIT_FAILURE;
@@ -69,321 +89,403 @@ int destroyServerProfile(const char *hardwareURI) {
     return EXIT_SUCCESS;
 }
 
-/* Find available hardware that matches the profile hardware type */
+/* A job for the provisioning pipeline that is sent with the session
+ */
 
-char *findFreeHardware(oneviewSession *session, const char *hardwareTypeuri)
+static ovProvisionJob jobForSession(oneviewSession *session, int type)
 {
-    if ((session) && session->address && session->cookie) {
+    ovProvisionJob job = { 0 };
+    job.type = type;
+    job.address = ovIntern(session->address);
+    job.username = ovIntern(session->username);
+    return job;
+}
+
+/* Reserve up to count free servers of a hardware type in one pass over the snapshot, servers
+ * held in the ledger are skipped and each reserved server is leased in it so that later
+ * passes don't reserve it again (the free list of the snapshot is only read, a server whose
+ * lease is released can be reserved again straight away). The interned uris are placed in
+ * hardware and the number reserved is returned.
+ *
+ * Servers that are on (when the spec asks for servers to be off) are left for a later request
+ * and the pipeline powers them off, they are leased until the power off has finished so they
+ * are only powered off once.
+ */
+
+size_t reserveFreeHardware(oneviewSession *session, const char *hardwareTypeuri, int *hardware, size_t count)
+{
+    size_t reserved = 0;
+    if ((session) && session->address && session->cookie && hardware) {
         
-        // Get the RAW JSON return from the Server Profiles
-        char *hardwareRAWJSON = NULL;
-        hardwareRAWJSON = ovQueryServerHardware(session, NULL);
+        oneviewHardwareSnapshot *snapshot = ovAcquireHardwareSnapshot(session);
+        if (!snapshot) {
+            return 0;
+        }
         
-        if (hardwareRAWJSON) {
-            json_t *hardwareJSON;
-            json_error_t error;
-            // Parse the JSON
-            hardwareJSON = json_loads(hardwareRAWJSON, 0, &error);
-            // If the JSON was loaded correctly attempt to parse it
-            if (hardwareJSON) {
-                free (hardwareRAWJSON);
-                json_t *memberArray = json_object_get(hardwareJSON, "members");
-                if ((memberArray) && json_array_size(memberArray) != 0) {
-                    size_t memberIndex;
-                    json_t *memberValue;
-                    
-                    json_array_foreach(memberArray, memberIndex, memberValue) {
-                    const char *hardwareuri = json_string_value(json_object_get(memberValue, "serverHardwareTypeUri"));
-                    const char *uri = json_string_value(json_object_get(memberValue, "uri"));
-                    if (stringMatch((char *)hardwareuri, (char *)hardwareTypeuri)) {
-                        
-                        // Check to see if the server appears in the state data (this is due to a delay in OneView reflecting the "Current" state)
-                        if (!findUsedHWInState(uri)) {
-                            const char *assignedProfile = json_string_value(json_object_get(memberValue, "serverProfileUri"));
-
-                            if (!assignedProfile) {
-                                // Found a server that is free
-                                if (json_is_true(powerState)) {
-                                    const char *power = json_string_value(json_object_get(memberValue, "powerState"));
-                                    if ((power) && stringMatch(power, "On")) {
-                                        // Free server has been found, however its power state is "on"
-                                        ovPrintInfo(getPluginTime(), "Available server being powered off, so profile can be applied\n");
-                                        ovPowerOffHardware(session, uri);
-                                    } else {
-                                        char *availableHarware = strdup(uri);
-                                        json_decref(hardwareJSON);
-                                        return availableHarware;
-                                    }
-                                } else {
-                                    char *availableHarware = strdup(uri);
-                                    json_decref(hardwareJSON);
-                                    return availableHarware;
-                                }
-                            }
-                        }
-                    }
+        for (int candidate = ovSnapshotFirstFree(snapshot, hardwareTypeuri); reserved < count && candidate != OV_SNAPSHOT_END;
+             candidate = ovSnapshotNextFree(snapshot, candidate)) {
+            if (ovLedgerClaim(snapshot->uri[candidate]) == EXIT_FAILURE) {
+                continue;
+            }
+            if (json_is_true(powerState) && snapshot->powerState[candidate] == OV_POWER_ON) {
+                ovPrintInfo(getPluginTime(), "Available server being powered off, so profile can be applied\n");
+                ovProvisionJob powerOff = jobForSession(session, OV_JOB_POWER_OFF);
+                powerOff.hardwareURI = snapshot->uri[candidate];
+                if (ovPipelineSubmit(&powerOff, 1) == EXIT_FAILURE) {
+                    ovLedgerRelease(snapshot->uri[candidate], NULL);
                 }
+                continue;
             }
-            json_decref(hardwareJSON);
+            hardware[reserved++] = snapshot->uri[candidate];
         }
+        ovReleaseHardwareSnapshot(snapshot);
     }
+    return reserved;
+}
+
+/* Find the server profile template with the name (see oneviewTemplates.h), no hardware is
+ * assigned to the profile that is returned.
+ */
+
+profile *findProfileTemplate(oneviewSession *session, const char *templateName)
+{
+    ovTemplate template;
+    if (ovTemplateFind(session, templateName, &template) == EXIT_FAILURE) {
+        return NULL;
     }
-    return NULL; // No available hardware
+    // all of the strings passed into the match struct are interned.
+    profile *match = malloc(sizeof(profile));
+    if (match) {
+        match->enclosureUri = template.enclosureGroupUri;
+        match->templateName = template.name;
+        match->hardwareTypeUri = template.serverHardwareTypeUri;
+        match->uri = template.uri;
+        match->profileName = NULL;
+        match->availableHardwareURI = OV_INTERN_NONE;
+    }
+    return match;
 }
 
-/* Iterate through all of the server profiles and find the URI that matches the profile name string */
+/* Log in with the environment variables, or the credentials in the OneView object of the
+ * spec properties if they aren't set.
+ */
 
-profile *mapProfileNameToURI(oneviewSession *session, const char *profileName)
+/* The OneView address, username and password for the properties of a spec, the environment
+ * takes precedence over the OneView object of the properties
+ */
+
+static void credentialsFromProperties(json_t *properties, const char **address, const char **username, const char **password)
 {
-    if ((session) && session->address && session->cookie) {
-        
-        // Get the RAW JSON return from the Server Profiles
-        char *profileHTTP = NULL;
-        profileHTTP = ovQueryServerProfileTemplates(session, NULL);
-        
-        if (profileHTTP) {
-            json_t *profileJSON;
-            json_error_t error;
-            // Parse the JSON
-            profileJSON = json_loads(profileHTTP, 0, &error);
-            // If the JSON was loaded correctly attempt to parse it
-            if (profileJSON) {
-                // Free the raw JSON as it has been processed
-                free(profileHTTP);
-                
-                json_t *memberArray = json_object_get(profileJSON, "members");
-                if ((memberArray) && json_array_size(memberArray) != 0) {
-                    
-                    size_t memberIndex;
-                    json_t *memberValue;
-                    
-                    json_array_foreach(memberArray, memberIndex, memberValue) {
-                        // retrieve needed statistics
-                        char *name = (char *)json_string_value(json_object_get(memberValue, "name"));
-                        if (stringMatch((char *)profileName, name)) {
-                            const char *uri = json_string_value(json_object_get(memberValue, "uri"));
-                            const char *hardwareuri = json_string_value(json_object_get(memberValue, "serverHardwareTypeUri"));
-                            const char *enclosureuri = json_string_value(json_object_get(memberValue, "enclosureGroupUri"));
-                            
-                            if (uri && hardwareuri && enclosureuri) {
-                                // There should always be the uris if there has been a name object, otherwise something
-                                // is internally broken inside of OneView
-                                
-                                // all of the strings passed into the match struct will need freeing.
-                                
-                                // Check if hardware is available before building rest of new profile
-                                char *availHWURI = findFreeHardware(session, hardwareuri);
-                                if (!availHWURI) {
-                                    ovPrintError(getPluginTime(), "No Server Hardware is available\n");
-                                    json_decref(profileJSON);
-                                    return NULL;
-                                }
-                                profile *match = malloc(sizeof(profile));
-                                if (match) {
-                                    match->enclosureUri = strdup(enclosureuri);
-                                    match->templateName = strdup(name);
-                                    match->hardwareTypeUri = strdup(hardwareuri);
-                                    match->uri = strdup(uri);
-                                    match->availableHardwareURI = availHWURI;
-                                    json_decref(profileJSON);
-                                    return match;
-                                }
-                            }
-                        }
-                    }
-                }
-                json_decref(profileJSON);
-            }
-        }
+    json_t *ovCredentials = json_object_get(properties, "OneView");
+    *address = getenv("OV_ADDRESS");
+    *username = getenv("OV_USERNAME");
+    *password = getenv("OV_PASSWORD");
+    if (!*address) {
+        *address = json_string_value(json_object_get(ovCredentials, "OneViewAddress"));
+    }
+    if (!*username) {
+        *username = json_string_value(json_object_get(ovCredentials, "OneViewUsername"));
+    }
+    if (!*password) {
+        *password = json_string_value(json_object_get(ovCredentials, "OneViewPassword"));
     }
-    return NULL;
 }
 
-instance *processInstanceJSON(json_t *paramsJSON, long long id)
+static int loginFromProperties(json_t *properties)
 {
-    // If the JSON was loaded correctly attempt to parse it
-    if (paramsJSON) {
-        // Check for the properties object
-        json_t *properties = json_object_get(paramsJSON, "Properties");
-        json_t *ovCredentials = json_object_get(properties, "OneView");
-        // Check for the session details first as these are required for interacting with OneView
-        const char *address = getenv("OV_ADDRESS");
-        const char *username = getenv("OV_USERNAME");
-        const char *password = getenv("OV_PASSWORD");
-
-        if (ovCredentials) {
-            if (!address) {
-                ovPrintInfo(getPluginTime(), "Environment variable OV_ADDRESS not set, looking in JSON config\n");
-                address = json_string_value(json_object_get(ovCredentials, "OneViewAddress"));
-            }
-            if (!username) {
-                ovPrintWarning(getPluginTime(), "Environment variable OV_USERNAME not set, looking in JSON config\n");
-                username = json_string_value(json_object_get(ovCredentials, "OneViewUsername"));
-            }
-            if (!password) {
-                ovPrintWarning(getPluginTime(), "Environment variable OV_PASSWORD not set, looking in JSON config\n");
-                password = json_string_value(json_object_get(ovCredentials, "OneViewPassword"));
-            }
+    // Check for the session details first as these are required for interacting with OneView
+    if (json_object_get(properties, "OneView")) {
+        if (!getenv("OV_ADDRESS")) {
+            ovPrintInfo(getPluginTime(), "Environment variable OV_ADDRESS not set, looking in JSON config\n");
         }
-        // ensure none of these values are NULL before attempting to log in
+        if (!getenv("OV_USERNAME")) {
+            ovPrintWarning(getPluginTime(), "Environment variable OV_USERNAME not set, looking in JSON config\n");
+        }
+        if (!getenv("OV_PASSWORD")) {
+            ovPrintWarning(getPluginTime(), "Environment variable OV_PASSWORD not set, looking in JSON config\n");
+        }
+    }
+    const char *address, *username, *password;
+    credentialsFromProperties(properties, &address, &username, &password);
+    // ensure none of these values are NULL before attempting to log in
+    
+    if (address && username && password) {
+        if (instanceLogin(address, username, password) == EXIT_FAILURE) {
+            ovPrintError(getPluginTime(), "Login Failed\n");
+            return EXIT_FAILURE;
+        }
+    } else {
+        ovPrintError(getPluginTime(), "No Credentials supplied to OneView\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
 
-        if (address && username && password) {
-            if (instanceLogin(address, username, password) == EXIT_FAILURE) {
-                ovPrintError(getPluginTime(), "Login Failed\n");
-                return NULL;
-            }
+/* Reserve a server for every spec that uses the same template (and power setting) as
+ * specs[first] in a single pass, a profile job is added to jobs for each server from placed
+ * and the new total is returned.
+ */
+
+static size_t placeTemplateGroup(json_t *specs, size_t first, char *grouped, long long id, const long long *ids, profile *servers, size_t *specOf, ovProvisionJob *jobs, size_t placed)
+{
+    size_t count = json_array_size(specs);
+    json_t *properties = json_object_get(json_array_get(specs, first), "Properties");
+    const char *templateName = json_string_value(json_object_get(properties, "TemplateName"));
+    int powerOff = json_is_true(json_object_get(properties, "PowerOff"));
+    
+    size_t *members = malloc(sizeof(size_t) * count);
+    int *hardware = malloc(sizeof(int) * count);
+    if (!members || !hardware) {
+        free(members);
+        free(hardware);
+        return placed;
+    }
+    size_t memberCount = 0;
+    for (size_t i = first; i < count; i++) {
+        json_t *memberProperties = json_object_get(json_array_get(specs, i), "Properties");
+        if (!grouped[i] && \
+            stringMatch(templateName, json_string_value(json_object_get(memberProperties, "TemplateName"))) && \
+            json_is_true(json_object_get(memberProperties, "PowerOff")) == powerOff) {
+            grouped[i] = 1;
+            members[memberCount++] = i;
+        }
+    }
+    
+    char ovOutput[1024];
+    profile *template = findProfileTemplate(infrakitSession, templateName);
+    if (!template) {
+        snprintf(ovOutput, sizeof(ovOutput), "Template %s could not be found\n", templateName);
+        ovPrintError(getPluginTime(), ovOutput);
+        goto done;
+    }
+    
+    // Used by the reservation to decide if servers that are on should be powered off
+    powerState = json_object_get(properties, "PowerOff");
+    size_t reserved = reserveFreeHardware(infrakitSession, ovInternString(template->hardwareTypeUri), hardware, memberCount);
+    if (reserved < memberCount) {
+        snprintf(ovOutput, sizeof(ovOutput), "Only %zu of %zu servers are available for %s\n", reserved, memberCount, templateName);
+        ovPrintWarning(getPluginTime(), ovOutput);
+    }
+    
+    for (size_t i = 0; i < reserved; i++) {
+        size_t spec = members[i];
+        json_t *specProperties = json_object_get(json_array_get(specs, spec), "Properties");
+        const char *profileName = json_string_value(json_object_get(specProperties, "ProfileName"));
+        if (!profileName) {
+            profileName = templateName;
+        }
+        
+        // Specs that share a request id are told apart by their position in the batch
+        size_t profileNameLength = strlen(profileName);
+        char newName[profileNameLength+100];
+        if (ids) {
+            sprintf(newName, "%s-%llu", profileName, ids[spec]);
         } else {
-            ovPrintError(getPluginTime(), "No Credentials supplied to OneView\n");
-            return NULL;
+            sprintf(newName, "%s-%llu-%zu", profileName, id, spec);
         }
         
-        if (properties && infrakitSession) {
-            if (!infrakitSession->cookie) {
-                ovPrintError(getPluginTime(), "OneView session not found\n");
-                return NULL;
-            }
-            
-            /*************
-              Work through the server profile creation
-             *************/
-            
-            // Name of the HPE OneView Profile to be used
-            const char *templateName = json_string_value(json_object_get(properties, "TemplateName"));
-            // Name to use when creating the server profile
-            const char *profileName = json_string_value(json_object_get(properties, "ProfileName"));
-            profile *foundServer = NULL;
-            
-            // Check to see if powerState variable is set (NULL if not set)
-            powerState = json_object_get(properties, "PowerOff");
-
-            if (templateName) {
-                 foundServer = mapProfileNameToURI(infrakitSession, templateName);
-                if (!foundServer) {
-                    ovPrintError(getPluginTime(), "Available Hardware could not be found\n");
-                    return NULL;
-                }
-
-                if (profileName) {
-                    size_t profileNameLength = strlen(profileName);
-                    char newName[profileNameLength+100];
-                    sprintf(newName, "%s-%llu", profileName, id);
-                    foundServer->profileName = strdup(newName);
-                } else {
-                    size_t profileNameLength = strlen(templateName);
-                    char newName[profileNameLength+100];
-                    sprintf(newName, "%s-%llu", templateName, id);
-                    foundServer->profileName = strdup(newName);
-                }
-                char ovOutput[1024];
-                sprintf(ovOutput, "Creating Instance => %s\n", foundServer->profileName);
-                ovPrintInfo(getPluginTime(), ovOutput);
-                
-                char *newProfile = ovQueryNewServerProfileTemplates(infrakitSession, NULL, foundServer->uri);
-                if (newProfile) {
-                    json_t *newProfileJSON;
-                    json_error_t error;
-                    // Parse the JSON
-                    newProfileJSON = json_loads(newProfile, 0, &error);
-                    if (newProfileJSON) {
-                        json_object_set(newProfileJSON, "name", json_string(foundServer->profileName));
-                        json_object_set(newProfileJSON, "serverHardwareUri", json_string(foundServer->availableHardwareURI));
-                        json_object_set(newProfileJSON, "description", json_string(getStatePath()));
-                        char *rawProfileJSON = json_dumps(newProfileJSON, JSON_ENSURE_ASCII);
-                        
-                        if (rawProfileJSON) {
-                            ovPostProfile(infrakitSession, rawProfileJSON);
-                            appendInstanceToState(foundServer, infrakitSession, paramsJSON);
-                            json_decref(newProfileJSON);
-                            
-                            instance *newInstance = malloc(sizeof(instance));
-                            newInstance->instanceName = strdup(foundServer->profileName);
-                            newInstance->instanceType = INSTANCE_SERVER_PROFILE;
-                            freeServerProfile(foundServer);
-                            free(rawProfileJSON);
-                            return newInstance;
-                        }
-                        json_decref(newProfileJSON);
-                    }
-                }
-                
-            }
-            
-            /* This will take either the template name or an assigned server profile name, 
-             and it will then append the unique ID to the end of the name to be used as a new profile name.
-             e.g.   TEMPLATE-NAME={123425436547-1234325436547-1243253}
-             */
-            
-
-            /*************
-             Work through the Network profile creation
-             *************/
-            
-            json_t *networksConfiguration = json_object_get(properties, "Networks");
-            if (networksConfiguration) {
-                json_t *uniqueNetworkName = json_object_get(properties, "Unique");
-                if (json_is_true(uniqueNetworkName)) {
-                    size_t networkNameLength = strlen(templateName);
-                    char newName[networkNameLength+100];
-                    sprintf(newName, "%s-%llu", templateName, id);
-                }
-                
-                json_t *networksConfigArray = json_object_get(properties, "NetworkConfig");
-                
-                if (networksConfigArray && (json_array_size(networksConfigArray) != 0)) {
-                
-                    size_t networkIndex;  // Array Index value
-                    json_t *networkValue; // Current Network Object
-                    /*
-                     { "networkName" : "name",
-                        "networkVlan" : <VlanID> }
-                     */
-                
-                    json_array_foreach(networksConfigArray, networkIndex, networkValue) {
-                        // Identify the Key/Value pairs needed to build our networks
-                        const char *networkName = json_string_value(json_object_get(networkValue, "networkName"));
-                        const char *networkVlan = json_string_value(json_object_get(networkValue, "networkVlan"));
-                        // Check that both aren't NUL in which case there is a configuration error
-                        if (networkName && networkVlan) {
-                            // We have a network name/vlan, lets create
-                        
-                            ovQueryNetworks(infrakitSession, NULL);
-                        
-                        } else {
-                            ovPrintError(getPluginTime(), "Error with commited networking configuration\n");
-                        }
-                    }
-                }
-            }
+        // The profile and the job each hold a copy of the name
+        char *serverName = strdup(newName);
+        char *jobName = strdup(newName);
+        if (!serverName || !jobName) {
+            free(serverName);
+            free(jobName);
+            ovLedgerRelease(hardware[i], NULL);
+            continue;
         }
+        
+        profile *server = &servers[placed];
+        *server = *template;
+        server->profileName = serverName;
+        server->availableHardwareURI = hardware[i];
+        
+        snprintf(ovOutput, sizeof(ovOutput), "Creating Instance => %s\n", newName);
+        ovPrintInfo(getPluginTime(), ovOutput);
+        
+        ovProvisionJob *job = &jobs[placed];
+        *job = jobForSession(infrakitSession, OV_JOB_PROFILE);
+        job->instanceName = jobName;
+        job->hardwareURI = hardware[i];
+        job->templateURI = template->uri;
+        job->description = getStatePath() ? strdup(getStatePath()) : NULL;
+        specOf[placed++] = spec;
     }
-    return EXIT_SUCCESS;
+    
+done:
+    freeServerProfile(template);
+    free(members);
+    free(hardware);
+    return placed;
 }
 
-/* Evaluate the struct and determine what is populated
-   then free resources back to the heap.
+/* Provision the specs of a batch that are set in members (which share an appliance and user)
+ * in one pass, logging in once, reading the state once and reserving distinct servers for
+ * all of them. The instances are recorded as pending with one update of the state and their
+ * profiles are left to the provisioning pipeline, so this returns without waiting for
+ * OneView. The number reserved is returned.
  */
 
-int freeServerProfile(profile *freeProfile)
+static size_t provisionCredentialSet(json_t *specs, const char *members, long long id, const long long *ids, char **instanceNames)
 {
-    if (freeProfile) {
-        if (freeProfile->availableHardwareURI) {
-            free(freeProfile->availableHardwareURI);
+    size_t count = json_array_size(specs);
+    size_t placed = 0;
+    size_t first = 0;
+    size_t memberCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (members[i] && memberCount++ == 0) {
+            first = i;
         }
-        if (freeProfile->enclosureUri) {
-            free(freeProfile->enclosureUri);
+    }
+    
+    json_t *properties = json_object_get(json_array_get(specs, first), "Properties");
+    if (loginFromProperties(properties) == EXIT_FAILURE) {
+        return 0;
+    }
+    if (!infrakitSession || !infrakitSession->cookie) {
+        ovPrintError(getPluginTime(), "OneView session not found\n");
+        return 0;
+    }
+    
+    profile *servers = calloc(count, sizeof(profile));
+    size_t *specOf = calloc(count, sizeof(size_t));
+    ovProvisionJob *jobs = calloc(count, sizeof(ovProvisionJob));
+    json_t **serverSpecs = calloc(count, sizeof(json_t *));
+    char *grouped = calloc(count, 1);
+    
+    // The servers held by instances come from the ledger (read from the state the first time)
+    if (!servers || !specOf || !jobs || !serverSpecs || !grouped || ovLedgerLoad() == EXIT_FAILURE) {
+        ovPrintError(getPluginTime(), "Unable to prepare the batch of instances\n");
+        goto cleanup;
+    }
+    // Specs of other appliances or users are provisioned in their own pass
+    for (size_t i = 0; i < count; i++) {
+        grouped[i] = !members[i];
+    }
+    
+    // Place every spec, the specs that share a template are placed together
+    for (size_t i = 0; i < count; i++) {
+        if (grouped[i]) {
+            continue;
         }
-        if (freeProfile->hardwareTypeUri) {
-            free(freeProfile->hardwareTypeUri);
+        json_t *specProperties = json_object_get(json_array_get(specs, i), "Properties");
+        if (!json_string_value(json_object_get(specProperties, "TemplateName"))) {
+            ovPrintError(getPluginTime(), "No TemplateName found in the instance spec\n");
+            grouped[i] = 1;
+            continue;
         }
-        if (freeProfile->profileName) {
-            free(freeProfile->profileName);
+        placed = placeTemplateGroup(specs, i, grouped, id, ids, servers, specOf, jobs, placed);
+    }
+    if (placed == 0) {
+        ovPrintError(getPluginTime(), "Available Hardware could not be found\n");
+        goto cleanup;
+    }
+    
+    // The instances are recorded before the pipeline can look for them
+    for (size_t i = 0; i < placed; i++) {
+        serverSpecs[i] = json_array_get(specs, specOf[i]);
+    }
+    if (appendInstancesToState(servers, serverSpecs, placed, infrakitSession) == EXIT_FAILURE) {
+        for (size_t i = 0; i < placed; i++) {
+            ovLedgerRelease(servers[i].availableHardwareURI, NULL);
         }
-        if (freeProfile->templateName) {
-            free(freeProfile->templateName);
+        placed = 0;
+        goto cleanup;
+    }
+    if (ovPipelineSubmit(jobs, placed) == EXIT_FAILURE) {
+        // Nothing will create the profiles, so the instances and their servers are given up
+        const char **instanceIDs = malloc(sizeof(char *) * placed);
+        for (size_t i = 0; instanceIDs && i < placed; i++) {
+            instanceIDs[i] = servers[i].profileName;
         }
-        if (freeProfile->uri) {
-            free(freeProfile->uri);
+        if (!instanceIDs || removeInstancesFromState(instanceIDs, placed) == EXIT_FAILURE) {
+            ovPrintError(getPluginTime(), "Unable to remove the instances that couldn't be queued\n");
         }
+        free(instanceIDs);
+        placed = 0;
+        goto cleanup;
+    }
+    // The queue has taken the jobs, and the caller takes the names
+    for (size_t i = 0; i < placed; i++) {
+        instanceNames[specOf[i]] = servers[i].profileName;
+        servers[i].profileName = NULL;
+        jobs[i].instanceName = NULL;
+        jobs[i].description = NULL;
+    }
+    
+    char ovOutput[1024];
+    snprintf(ovOutput, sizeof(ovOutput), "Reserved %zu of %zu instances\n", placed, memberCount);
+    ovPrintInfo(getPluginTime(), ovOutput);
+    
+cleanup:
+    // The names of instances that weren't provisioned
+    for (size_t i = 0; servers && i < count; i++) {
+        free(servers[i].profileName);
+    }
+    ovPipelineFreeJobs(jobs, count);
+    free(servers);
+    free(specOf);
+    free(jobs);
+    free(serverSpecs);
+    free(grouped);
+    return placed;
+}
+
+/* Provision a batch of specs, the specs are split by the appliance and user of their
+ * credentials and each set is provisioned in one pass (see provisionCredentialSet), so a spec
+ * is never provisioned with the session of another. instanceNames[i] is set to the name of the
+ * instance for specs[i] (NULL if no server was reserved), which the caller frees, and the
+ * number reserved is returned.
+ *
+ * If ids is set it holds the request id of each spec (coalesced Provision calls), otherwise
+ * every spec came from the request id.
+ */
+
+size_t processInstanceBatch(json_t *specs, long long id, const long long *ids, char **instanceNames)
+{
+    size_t count = json_array_size(specs);
+    size_t placed = 0;
+    for (size_t i = 0; i < count; i++) {
+        instanceNames[i] = NULL;
+    }
+    if (count == 0) {
+        return 0;
+    }
+    char *handled = calloc(count, 1);
+    char *members = calloc(count, 1);
+    if (!handled || !members) {
+        ovPrintError(getPluginTime(), "Unable to prepare the batch of instances\n");
+        free(handled);
+        free(members);
+        return 0;
+    }
+    for (size_t first = 0; first < count; first++) {
+        if (handled[first]) {
+            continue;
+        }
+        const char *address, *username, *password;
+        credentialsFromProperties(json_object_get(json_array_get(specs, first), "Properties"), &address, &username, &password);
+        for (size_t i = 0; i < count; i++) {
+            const char *memberAddress, *memberUsername, *memberPassword;
+            credentialsFromProperties(json_object_get(json_array_get(specs, i), "Properties"), &memberAddress, &memberUsername, &memberPassword);
+            members[i] = !handled[i] && (memberAddress == address || stringMatch(memberAddress, address)) && \
+                         (memberUsername == username || stringMatch(memberUsername, username));
+            handled[i] |= members[i];
+        }
+        placed += provisionCredentialSet(specs, members, id, ids, instanceNames);
+    }
+    free(handled);
+    free(members);
+    return placed;
+}
+
+/* Evaluate the struct and determine what is populated
+   then free resources back to the heap.
+ */
+
+int freeServerProfile(profile *freeProfile)
+{
+    if (freeProfile) {
+        // The strings are interned, so only the struct is freed
         free(freeProfile);
         freeProfile = NULL;
         return EXIT_SUCCESS;
@@ -415,9 +517,6 @@ int freeNetwork(network *freeNetworkInstance)
 int freeInstance(instance *freeInstance)
 {
     if (freeInstance) {
-        if (freeInstance->instanceName) {
-            free(freeInstance->instanceName);
-        }
         free(freeInstance);
         freeInstance = NULL;
         return EXIT_SUCCESS;
@@ -425,9 +524,163 @@ int freeInstance(instance *freeInstance)
     return EXIT_FAILURE;
 }
 
+/* Resolve the hardware details of every instance in a group with a single (batched) index
+ * search, rather than one request per instance. The results are looked up with
+ * hardwareFromIndex().
+ */
+
+oneviewIndexResult *resolveGroupHardware(json_t *previousInstances, json_t *previousNonFunctional)
+{
+    size_t keyCount = json_array_size(previousInstances) + json_array_size(previousNonFunctional);
+    if (keyCount == 0) {
+        return NULL;
+    }
+    oneviewIndexKey *keys = malloc(sizeof(oneviewIndexKey) * keyCount);
+    if (!keys) {
+        return NULL;
+    }
+    size_t memberIndex, keyIndex = 0;
+    json_t *memberValue;
+    json_array_foreach(previousInstances, memberIndex, memberValue) {
+        const char *hardwareURI = json_string_value(json_object_get(memberValue, "LogicalID"));
+        if (hardwareURI) {
+            keys[keyIndex++] = (oneviewIndexKey){ OV_INDEX_SERVER_HARDWARE, hardwareURI, NULL };
+        }
+    }
+    json_array_foreach(previousNonFunctional, memberIndex, memberValue) {
+        const char *hardwareURI = json_string_value(json_object_get(memberValue, "LogicalID"));
+        if (hardwareURI) {
+            keys[keyIndex++] = (oneviewIndexKey){ OV_INDEX_SERVER_HARDWARE, hardwareURI, NULL };
+        }
+    }
+    oneviewIndexResult *result = ovIndexLookup(infrakitSession, keys, keyIndex);
+    free(keys);
+    return result;
+}
+
+/* Return the hardware details from the index results, if the index didn't carry the state
+ * of the hardware then fall back to a GET of the hardware resource.
+ */
+
+oneviewHardware *hardwareFromIndex(oneviewIndexResult *result, const char *hardwareURI)
+{
+    if (inventoryIsLive()) {
+        return inventoryGetServerHardware(hardwareURI);
+    }
+    oneviewIndexRecord *record = ovIndexFindURI(result, OV_INDEX_SERVER_HARDWARE, hardwareURI);
+    if (!record || (!record->state && !record->serverProfileUri)) {
+        return ovGetServerHardware(infrakitSession, hardwareURI);
+    }
+    oneviewHardware *hardware = calloc(1, sizeof(oneviewHardware));
+    if (hardware) {
+        hardware->uri = strdup(record->uri);
+        hardware->name = record->name ? strdup(record->name) : NULL;
+        hardware->state = record->state ? strdup(record->state) : NULL;
+        hardware->powerState = record->powerState ? strdup(record->powerState) : NULL;
+        hardware->serverProfileUri = record->serverProfileUri ? strdup(record->serverProfileUri) : NULL;
+        hardware->serverHardwareTypeUri = record->serverHardwareTypeUri ? strdup(record->serverHardwareTypeUri) : NULL;
+    }
+    return hardware;
+}
+
+/* Keep the ledger in step with a group that has been synchronised, the servers of instances
+ * that were dropped are freed and the instances that are kept (or moved back from the
+ * non-functional instances) hold theirs.
+ */
+
+static void updateLedgerForGroup(json_t *previousInstances, json_t *currentInstances)
+{
+    oneviewHashIndex current = {0};
+    if (initHashIndex(&current, json_array_size(currentInstances)) == EXIT_FAILURE) {
+        return;
+    }
+    size_t memberIndex;
+    json_t *memberValue;
+    json_array_foreach(currentInstances, memberIndex, memberValue) {
+        const char *ID = json_string_value(json_object_get(memberValue, "ID"));
+        const char *hardwareURI = json_string_value(json_object_get(json_object_get(memberValue, "Tags"), "hw_uri"));
+        if (ID) {
+            ovHashInsert(&current, ID, (int)memberIndex);
+            ovLedgerRecord(ovIntern(hardwareURI), ID);
+        }
+    }
+    json_array_foreach(previousInstances, memberIndex, memberValue) {
+        const char *ID = json_string_value(json_object_get(memberValue, "ID"));
+        const char *hardwareURI = json_string_value(json_object_get(json_object_get(memberValue, "Tags"), "hw_uri"));
+        if (ID && ovHashFind(&current, ID) == OV_HASH_NOT_FOUND) {
+            ovLedgerRelease(ovIntern(hardwareURI), ID);
+        }
+    }
+    freeHashIndex(&current);
+}
+
+/* Look up the hardware of every instance in a group (this is the network I/O of a
+ * synchronise, so it is done without the state lock). The hardware of a uri is found with
+ * ovHashFind(uris) as its position in resolved, which is NULL if the hardware couldn't be read.
+ */
+
+static size_t resolveGroup(json_t *instances, json_t *nonFunctional, oneviewHashIndex *uris, oneviewHardware **resolved)
+{
+    // The change feed keeps the inventory current, a periodic full load is the safety net
+    if (inventoryNeedsResync()) {
+        inventoryResync(infrakitSession);
+    }
+    
+    /* Resolve all of the hardware in the group from the hardware snapshot (unless the
+     * inventory is live), so the calls made within OV_SNAPSHOT_TTL of each other share one read
+     * and our own writes invalidate it (see ovInvalidateHardwareSnapshot). If it can't be read
+     * the group is resolved in one pass of the index.
+     */
+    oneviewIndexResult *groupHardware = NULL;
+    oneviewHardwareSnapshot *snapshot = NULL;
+    if (!inventoryIsLive()) {
+        snapshot = ovAcquireHardwareSnapshot(infrakitSession);
+        if (!snapshot) {
+            groupHardware = resolveGroupHardware(instances, nonFunctional);
+        }
+    }
+    
+    size_t count = 0;
+    json_t *lists[2] = { nonFunctional, instances };
+    for (int list = 0; list < 2; list++) {
+        size_t memberIndex;
+        json_t *memberValue;
+        json_array_foreach(lists[list], memberIndex, memberValue) {
+            const char *hardwareURI = json_string_value(json_object_get(memberValue, "LogicalID"));
+            const char *status = json_string_value(json_object_get(json_object_get(memberValue, "Tags"), OV_INSTANCE_STATUS_TAG));
+            // Instances that are waiting on the pipeline or a task don't look at their hardware
+            if (!hardwareURI || ovHashFind(uris, hardwareURI) != OV_HASH_NOT_FOUND || \
+                (list == 1 && (stringMatch(status, OV_INSTANCE_PENDING) || stringMatch(status, OV_INSTANCE_POSTING) || \
+                               stringMatch(status, OV_INSTANCE_FAILED) || stringMatch(status, OV_INSTANCE_CREATING) || \
+                               stringMatch(status, OV_INSTANCE_DESTROYED)))) {
+                continue;
+            }
+            int server = ovSnapshotFindURI(snapshot, hardwareURI);
+            if (server != OV_SNAPSHOT_END) {
+                resolved[count] = ovSnapshotHardware(snapshot, server);
+            } else {
+                resolved[count] = hardwareFromIndex(groupHardware, hardwareURI);
+            }
+            if (ovHashInsert(uris, hardwareURI, (int)count) == EXIT_FAILURE) {
+                freeServerHardware(resolved[count]);
+                continue;
+            }
+            count++;
+        }
+    }
+    freeIndexResult(groupHardware);
+    ovReleaseHardwareSnapshot(snapshot);
+    return count;
+}
+
 /* Check through the state file and compare the physical state
  * then update the state file so that InfraKit is kept current with
  * the physical Infrastructure state.
+ *
+ * The group is read with the state lock held, the hardware is looked up without it (so that
+ * the pipeline and task tracker can update the state meanwhile), and the changes are made
+ * to the state as it is once the lock is taken again. An instance whose hardware wasn't looked
+ * up (it was added meanwhile) is left as it is until the next synchronise.
  */
 
 int synchroniseStateWithPhysical(json_t *params)
@@ -440,8 +693,28 @@ int synchroniseStateWithPhysical(json_t *params)
     const char *groupName = json_string_value(json_object_get(tags, "infrakit.group"));
 
     if (loginFromState(groupName) == EXIT_SUCCESS) {
+        lockInstanceState();
         json_t *stateJSON = openInstanceState();
         json_t *group = findGroup(stateJSON, groupName);
+        json_t *groupInstances = json_deep_copy(json_object_get(group, "Instances"));
+        json_t *groupNonFunctional = json_deep_copy(json_object_get(group, "NonFunctional"));
+        json_decref(stateJSON);
+        unlockInstanceState();
+        
+        size_t keyCount = json_array_size(groupInstances) + json_array_size(groupNonFunctional);
+        oneviewHardware **resolved = calloc(keyCount ? keyCount : 1, sizeof(oneviewHardware *));
+        oneviewHashIndex uris = {0};
+        if (!resolved || initHashIndex(&uris, keyCount ? keyCount : 1) == EXIT_FAILURE) {
+            free(resolved);
+            json_decref(groupInstances);
+            json_decref(groupNonFunctional);
+            return EXIT_FAILURE;
+        }
+        size_t resolvedCount = resolveGroup(groupInstances, groupNonFunctional, &uris, resolved);
+        
+        lockInstanceState();
+        stateJSON = openInstanceState();
+        group = findGroup(stateJSON, groupName);
 
         json_t *previousInstances = json_object_get(group, "Instances");
         json_t *previousNonFunctional = json_object_get(group, "NonFunctional");
@@ -461,8 +734,13 @@ int synchroniseStateWithPhysical(json_t *params)
         json_array_foreach(previousNonFunctional, memberIndex, memberValue) {
             const char *hardwareURI = json_string_value(json_object_get(memberValue, "LogicalID"));
             if (hardwareURI) {
-                char *profileURI = serverProfileFromHardwareURI(infrakitSession, (char *) hardwareURI);
-                if (profileURI) {
+                int position = ovHashFind(&uris, hardwareURI);
+                if (position == OV_HASH_NOT_FOUND) {
+                    json_array_append(currentNonFunctional, memberValue);
+                    continue;
+                }
+                oneviewHardware *hardware = resolved[position];
+                if (hardware && hardware->serverProfileUri) {
                     // Check power state and add to active / non-functional
                     json_array_append(currentInstances, memberValue);
                     //json_array_append(currentNonFunctional, memberValue);
@@ -482,9 +760,49 @@ int synchroniseStateWithPhysical(json_t *params)
             snprintf(debugString, 1024, "HW = %s Remaining = %zu\n", hardwareURI, retry_counter);
             ovPrintDebug(getPluginTime(), debugString);
 
+            // The pipeline hasn't posted the profile yet, so there is nothing to check
+            const char *status = json_string_value(json_object_get(tags, OV_INSTANCE_STATUS_TAG));
+            const char *task = json_string_value(json_object_get(tags, OV_INSTANCE_TASK_TAG));
+            if (stringMatch(status, OV_INSTANCE_PENDING) || stringMatch(status, OV_INSTANCE_POSTING) || \
+                (stringMatch(status, OV_INSTANCE_DESTROYED) && !task)) {
+                json_array_append(currentInstances, memberValue);
+                continue;
+            }
+            
+            // OneView didn't create the profile, so the instance is removed (InfraKit will replace it)
+            if (stringMatch(status, OV_INSTANCE_FAILED)) {
+                snprintf(debugString, 1024, "Instance %s failed to be created\n", json_string_value(json_object_get(memberValue, "ID")));
+                ovPrintWarning(getPluginTime(), debugString);
+                continue;
+            }
+            
+            /* The task tracker sets the status once the profile has been created, until then there
+             * is nothing to check (an instance destroyed meanwhile has its profile deleted then).
+             * If the plugin has restarted the task is tracked again.
+             */
+            if ((stringMatch(status, OV_INSTANCE_CREATING) || stringMatch(status, OV_INSTANCE_DESTROYED)) && task) {
+                if (!ovTaskIsTracked(task)) {
+                    ovTrackTask(OV_TASK_PROFILE_CREATE, task, json_string_value(json_object_get(memberValue, "ID")), \
+                                ovIntern(hardwareURI), ovIntern(infrakitSession->address), ovIntern(infrakitSession->username));
+                }
+                json_array_append(currentInstances, memberValue);
+                continue;
+            }
+
             if (hardwareURI) {
-                char *profileURI = serverProfileFromHardwareURI(infrakitSession, hardwareURI);
-                char *state = stateFromHardwareURI(infrakitSession, hardwareURI);
+                int position = ovHashFind(&uris, hardwareURI);
+                if (position == OV_HASH_NOT_FOUND) {
+                    json_array_append(currentInstances, memberValue);
+                    continue;
+                }
+                // The index search provides both the profile and the state
+                oneviewHardware *hardware = resolved[position];
+                const char *profileURI = NULL;
+                const char *state = NULL;
+                if (hardware) {
+                    profileURI = hardware->serverProfileUri;
+                    state = hardware->state;
+                }
 
                 if (profileURI) {
 
@@ -507,14 +825,25 @@ int synchroniseStateWithPhysical(json_t *params)
             }
         }
         
+        updateLedgerForGroup(previousInstances, currentInstances);
+        
         // Two updated new arrays to replace inside our state
         json_object_set(group, "Instances", currentInstances);
         json_object_set(group, "NonFunctional", currentNonFunctional);
 
-        char *json_text = json_dumps(stateJSON, JSON_ENSURE_ASCII);
+        char *json_text = ovDumpJSON(stateJSON, JSON_ENSURE_ASCII);
         saveInstanceState(json_text);
         free(json_text);
         json_decref(stateJSON);
+        unlockInstanceState();
+        
+        for (size_t i = 0; i < resolvedCount; i++) {
+            freeServerHardware(resolved[i]);
+        }
+        free(resolved);
+        freeHashIndex(&uris);
+        json_decref(groupInstances);
+        json_decref(groupNonFunctional);
         return EXIT_SUCCESS;
     }
     return EXIT_FAILURE;
@@ -538,29 +867,74 @@ int synchroniseStateWithPhysical(json_t *params)
   */
 
 
-char *ovInfraKitInstanceProvision(json_t *params, long long id)
+int ovInfraKitInstanceProvision(json_t *params, long long id, ovJSONWriter *writer)
 {
-    instance *newInstance = processInstanceJSON(params, id);
-    
-    char *successProvisionResponse = "{s:s,s:{s:s?},s:I}";
-    char *failProvisionResponse = "{s:s,s:{s:i},s:I}";
-
-    char *response;
-    json_t *responseJSON;
-    if (newInstance) {
-        responseJSON = json_pack(successProvisionResponse,  "jsonrpc", "2.0",                   \
-                                                            "result",                           \
-                                                                "ID", newInstance->instanceName,\
-                                                            "id", id);
-    } else {
-        responseJSON = json_pack(failProvisionResponse,     "jsonrpc", "2.0",                   \
-                                                            "error",                            \
-                                                                "code", parse_error,            \
-                                                            "id", id);
-    }
-    response = json_dumps(responseJSON, JSON_ENSURE_ASCII);
-    json_decref(responseJSON);
-    return response;
+    if (!params) {
+        return ovWriteRPCError(writer, invalid_params, id);
+    }
+    // A single spec is a batch of one, named with the request id
+    char *instanceName;
+    json_t *specs = json_array();
+    json_array_append(specs, params);
+    processInstanceBatch(specs, id, &id, &instanceName);
+    json_decref(specs);
+    int written = ovInfraKitInstanceWriteProvisioned(instanceName, id, writer);
+    free(instanceName);
+    return written;
+}
+
+/* The response to a Provision, instanceName is NULL if it wasn't provisioned
+ */
+
+int ovInfraKitInstanceWriteProvisioned(const char *instanceName, long long id, ovJSONWriter *writer)
+{
+    if (!instanceName) {
+        return ovWriteRPCError(writer, parse_error, id);
+    }
+    ovWriteRPCBegin(writer);
+    ovWriteKey(writer, "result");
+    ovWriteBeginObject(writer);
+    ovWriteKey(writer, "ID");
+    ovWriteString(writer, instanceName);
+    ovWriteEndObject(writer);
+    return ovWriteRPCEnd(writer, id);
+}
+
+/* ovInfraKitInstanceProvisionBatch(json_t *specs, long long id)
+ * specs = Array of the parameter JSON of each instance
+ * id = method call id, to ensure function sycnronisation
+ *
+ * The IDs are returned in the order of the specs, null for any spec that couldn't be
+ * provisioned.
+ */
+
+int ovInfraKitInstanceProvisionBatch(json_t *specs, long long id, ovJSONWriter *writer)
+{
+    size_t count = json_array_size(specs);
+    if (count == 0) {
+        return ovWriteRPCError(writer, invalid_params, id);
+    }
+    char **instanceNames = malloc(sizeof(char *) * count);
+    if (!instanceNames) {
+        return ovWriteRPCError(writer, internal_error, id);
+    }
+    if (processInstanceBatch(specs, id, NULL, instanceNames) == 0) {
+        free(instanceNames);
+        return ovWriteRPCError(writer, parse_error, id);
+    }
+    ovWriteRPCBegin(writer);
+    ovWriteKey(writer, "result");
+    ovWriteBeginObject(writer);
+    ovWriteKey(writer, "IDs");
+    ovWriteBeginArray(writer);
+    for (size_t i = 0; i < count; i++) {
+        ovWriteString(writer, instanceNames[i]);
+        free(instanceNames[i]);
+    }
+    ovWriteEndArray(writer);
+    ovWriteEndObject(writer);
+    free(instanceNames);
+    return ovWriteRPCEnd(writer, id);
 }
 
 /* ovInfraKitInstanceDescribe(json_t *params, long long id)
@@ -571,7 +945,7 @@ char *ovInfraKitInstanceProvision(json_t *params, long long id)
  * the state of the infrastructure we're hoping to configure.
  */
 
-char *ovInfraKitInstanceDescribe(json_t *params, long long id)
+int ovInfraKitInstanceDescribe(json_t *params, long long id, ovJSONWriter *writer)
 {
     if (synchroniseStateWithPhysical(params) == EXIT_FAILURE) {
         ovPrintWarning(getPluginTime(), "Failed to synchronise state\n");
@@ -587,20 +961,33 @@ char *ovInfraKitInstanceDescribe(json_t *params, long long id)
     } else {
         instanceArray = json_object_get(group, "Instances");
     }
-    char *DescriptionResponse = "{s:s,s:{s:[]},s:s?,s:I}";
-    json_t *responseJSON = json_pack(DescriptionResponse,   "jsonrpc", "2.0",                   \
-                                                            "result",                           \
-                                                                "Descriptions",                 \
-                                                            "error", NULL,                      \
-                                                            "id", id);
-    json_t *array = json_object_get(responseJSON, "result");
-    json_object_set(array, "Descriptions", instanceArray);
-    char *response = json_dumps(responseJSON, JSON_ENSURE_ASCII);
-    json_decref(responseJSON);
-    return response;
+    // Instances that have been destroyed are only kept until their profile has been created
+    json_t *described = json_array();
+    size_t instanceIndex;
+    json_t *instanceValue;
+    json_array_foreach(instanceArray, instanceIndex, instanceValue) {
+        const char *status = json_string_value(json_object_get(json_object_get(instanceValue, "Tags"), OV_INSTANCE_STATUS_TAG));
+        if (!stringMatch(status, OV_INSTANCE_DESTROYED)) {
+            json_array_append(described, instanceValue);
+        }
+    }
+    ovWriteRPCBegin(writer);
+    ovWriteKey(writer, "result");
+    ovWriteBeginObject(writer);
+    ovWriteKey(writer, "Descriptions");
+    if (json_is_array(instanceArray)) {
+        ovWriteJSON(writer, described);
+    } else {
+        ovWriteBeginArray(writer);
+        ovWriteEndArray(writer);
+    }
+    ovWriteEndObject(writer);
+    ovWriteKey(writer, "error");
+    ovWriteNull(writer);
+    return ovWriteRPCEnd(writer, id);
 }
 
-char *ovInfraKitInstanceDestroy(json_t *params, long long id)
+int ovInfraKitInstanceDestroy(json_t *params, long long id, ovJSONWriter *writer)
 {
     // Ensure that Instance Removed is initialised
     int InstanceRemoved = EXIT_FAILURE;
@@ -612,11 +999,21 @@ char *ovInfraKitInstanceDestroy(json_t *params, long long id)
     const char *instanceID = json_string_value(json_object_get(params, "Instance"));
     
     json_t *instance = returnObjectFromInstanceID(instanceID);
-    char *physicalID = returnInstanceFromState(instanceID, "LogicalID");
+    const char *physicalID = returnInstanceFromState(instanceID, "LogicalID");
     json_t *tags = json_object_get(instance, "Tags");
     const char *groupName = json_string_value(json_object_get(tags, "infrakit.group"));
     
-    if (loginFromState(groupName) == EXIT_SUCCESS) {
+    /* A pending instance (or one whose profile was never posted) has nothing in OneView to
+     * remove, one whose profile is being posted or created is removed (and its profile deleted)
+     * by the pipeline or task tracker once that finishes
+     */
+    int outcome = destroyInstanceInState(instanceID, groupName);
+    
+    if (outcome == OV_DESTROY_REMOVED || outcome == OV_DESTROY_DEFERRED) {
+        InstanceRemoved = EXIT_SUCCESS;
+    } else if (outcome == OV_DESTROY_NOT_FOUND) {
+        ovPrintError(getPluginTime(), "Failed to remove instance, it isn't in the state\n");
+    } else if (loginFromState(groupName) == EXIT_SUCCESS) {
         if (destroyServerProfile(physicalID) == EXIT_SUCCESS) {
             if (instanceID) {
                 InstanceRemoved = removeInstanceFromState(instanceID, groupName);
@@ -630,31 +1027,22 @@ char *ovInfraKitInstanceDestroy(json_t *params, long long id)
         }
     } else {
         ovPrintError(getPluginTime(), "Error connecting to HPE OneView\n");
-        return NULL;
+        return ovWriteRPCError(writer, parse_error, id);
     }
-    char *successProvisionResponse = "{s:s,s:{s:s?},s:I}";
-    char *failProvisionResponse = "{s:s,s:{s:i},s:I}";
-    char *response;
-    json_t *responseJSON;
-    if (InstanceRemoved == EXIT_SUCCESS) {
-        // Announce the server profile being removed
-        char ovOutput[1024];
-        sprintf(ovOutput, "Removing Instance => %s\n", instanceID);
-        ovPrintInfo(getPluginTime(), ovOutput);
-        
-        responseJSON = json_pack(successProvisionResponse,  "jsonrpc", "2.0",                   \
-                                                            "result",                           \
-                                                                "Instance", instanceID,         \
-                                                            "id", id);
-    } else {
-        responseJSON = json_pack(failProvisionResponse,     "jsonrpc", "2.0",                   \
-                                                            "error",                            \
-                                                                "code", parse_error,            \
-                                                            "id", id);
+    if (InstanceRemoved != EXIT_SUCCESS) {
+        return ovWriteRPCError(writer, parse_error, id);
     }
-    response = json_dumps(responseJSON, JSON_ENSURE_ASCII);
-    json_decref(responseJSON);
-    return response;
+    // Announce the server profile being removed
+    char ovOutput[1024];
+    sprintf(ovOutput, "Removing Instance => %s\n", instanceID);
+    ovPrintInfo(getPluginTime(), ovOutput);
 
+    ovWriteRPCBegin(writer);
+    ovWriteKey(writer, "result");
+    ovWriteBeginObject(writer);
+    ovWriteKey(writer, "Instance");
+    ovWriteString(writer, instanceID);
+    ovWriteEndObject(writer);
+    return ovWriteRPCEnd(writer, id);
 }
 
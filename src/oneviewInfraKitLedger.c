@@ -0,0 +1,247 @@
+
+// oneviewInfraKitLedger.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#include "oneviewInfraKitLedger.h"
+#include "oneviewInfraKitState.h"
+#include "oneviewInfraKitConsole.h"
+#include "oneviewIntern.h"
+#include "oneviewHash.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* The state lock is always taken before the ledger lock (the state updates the ledger while
+ * it holds its lock)
+ */
+
+pthread_mutex_t ledgerLock = PTHREAD_MUTEX_INITIALIZER;
+
+static ovLedgerEntry *entries;
+static size_t entryCount;
+static size_t entrySize;
+static oneviewHashIndex entryIndex;     // Uri of a server to its position in entries
+static int ledgerLoaded;
+
+static double monotonicSeconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+}
+
+/* Find the entry of a server, adding a free entry if it isn't in the ledger (servers are never
+ * removed, a server that is released is marked free), ledgerLock is held
+ */
+
+static ovLedgerEntry *findEntry(int hardwareURI, int add)
+{
+    if (hardwareURI == OV_INTERN_NONE) {
+        return NULL;
+    }
+    if (entryIndex.size == 0 && initHashIndex(&entryIndex, 256) == EXIT_FAILURE) {
+        return NULL;
+    }
+    // The uris are interned so they stay allocated as long as the index
+    const char *uri = ovInternString(hardwareURI);
+    int position = ovHashFind(&entryIndex, uri);
+    if (position != OV_HASH_NOT_FOUND) {
+        return &entries[position];
+    }
+    if (!add) {
+        return NULL;
+    }
+    if (entryCount == entrySize) {
+        size_t newSize = entrySize ? entrySize * 2 : 256;
+        ovLedgerEntry *newEntries = realloc(entries, sizeof(ovLedgerEntry) * newSize);
+        if (!newEntries) {
+            return NULL;
+        }
+        entries = newEntries;
+        entrySize = newSize;
+    }
+    if (ovHashInsert(&entryIndex, uri, (int)entryCount) == EXIT_FAILURE) {
+        return NULL;
+    }
+    entries[entryCount] = (ovLedgerEntry){ hardwareURI, NULL, OV_LEDGER_FREE, 0 };
+    return &entries[entryCount++];
+}
+
+/* Replace the owner of a server with a copy of the instance name (NULL for none), ledgerLock
+ * is held
+ */
+
+static int setOwner(ovLedgerEntry *entry, const char *instanceID)
+{
+    char *owner = instanceID ? strdup(instanceID) : NULL;
+    if (instanceID && !owner) {
+        return EXIT_FAILURE;
+    }
+    free(entry->owner);
+    entry->owner = owner;
+    return EXIT_SUCCESS;
+}
+
+/* A lease that was never recorded has run out, ledgerLock is held
+ */
+
+static int isHeld(const ovLedgerEntry *entry, double now)
+{
+    if (!entry || entry->held == OV_LEDGER_FREE) {
+        return 0;
+    }
+    return (entry->held == OV_LEDGER_RECORDED) || (now - entry->leased < OV_LEDGER_LEASE_S);
+}
+
+/* Record the server of every instance in the state, this is only done the first time (after
+ * that the ledger is kept in step by the changes to the state)
+ */
+
+int ovLedgerLoad()
+{
+    pthread_mutex_lock(&ledgerLock);
+    int loaded = ledgerLoaded;
+    pthread_mutex_unlock(&ledgerLock);
+    if (loaded) {
+        return EXIT_SUCCESS;
+    }
+
+    lockInstanceState();
+    json_t *stateJSON = openInstanceState();
+    if (!stateJSON) {
+        unlockInstanceState();
+        ovPrintError(getPluginTime(), "Can't read State Data\n");
+        return EXIT_FAILURE;
+    }
+    pthread_mutex_lock(&ledgerLock);
+    if (!ledgerLoaded) {
+        double now = monotonicSeconds();
+        size_t groupIndex, instanceIndex;
+        json_t *group, *instanceValue;
+        json_array_foreach(json_object_get(stateJSON, "OneViewGroups"), groupIndex, group) {
+            json_array_foreach(json_object_get(group, "Instances"), instanceIndex, instanceValue) {
+                json_t *tags = json_object_get(instanceValue, "Tags");
+                ovLedgerEntry *entry = findEntry(ovIntern(json_string_value(json_object_get(tags, "hw_uri"))), 1);
+                if (entry && setOwner(entry, json_string_value(json_object_get(instanceValue, "ID"))) == EXIT_SUCCESS) {
+                    entry->held = OV_LEDGER_RECORDED;
+                    entry->leased = now;
+                }
+            }
+        }
+        ledgerLoaded = 1;
+        char ovOutput[1024];
+        snprintf(ovOutput, sizeof(ovOutput), "Hardware ledger loaded with %zu servers\n", entryCount);
+        ovPrintDebug(getPluginTime(), ovOutput);
+    }
+    pthread_mutex_unlock(&ledgerLock);
+    json_decref(stateJSON);
+    unlockInstanceState();
+    return EXIT_SUCCESS;
+}
+
+/* Lease a server for an instance that is about to be added to the state, fails if the server
+ * is already held
+ */
+
+int ovLedgerClaim(int hardwareURI)
+{
+    pthread_mutex_lock(&ledgerLock);
+    double now = monotonicSeconds();
+    ovLedgerEntry *entry = findEntry(hardwareURI, 1);
+    if (!entry || isHeld(entry, now)) {
+        pthread_mutex_unlock(&ledgerLock);
+        return EXIT_FAILURE;
+    }
+    setOwner(entry, NULL);
+    entry->held = OV_LEDGER_LEASED;
+    entry->leased = now;
+    pthread_mutex_unlock(&ledgerLock);
+    return EXIT_SUCCESS;
+}
+
+/* The instance holding the server has been added to the state
+ */
+
+int ovLedgerRecord(int hardwareURI, const char *instanceID)
+{
+    pthread_mutex_lock(&ledgerLock);
+    ovLedgerEntry *entry = findEntry(hardwareURI, 1);
+    if (!entry || setOwner(entry, instanceID) == EXIT_FAILURE) {
+        pthread_mutex_unlock(&ledgerLock);
+        return EXIT_FAILURE;
+    }
+    if (entry->held == OV_LEDGER_FREE) {
+        entry->leased = monotonicSeconds();
+    }
+    entry->held = OV_LEDGER_RECORDED;
+    pthread_mutex_unlock(&ledgerLock);
+    return EXIT_SUCCESS;
+}
+
+/* Free a server, a server recorded for another instance is left as it is (instanceID can be
+ * NULL to free a lease)
+ */
+
+int ovLedgerRelease(int hardwareURI, const char *instanceID)
+{
+    pthread_mutex_lock(&ledgerLock);
+    ovLedgerEntry *entry = findEntry(hardwareURI, 0);
+    if (!entry || (entry->held == OV_LEDGER_RECORDED && !stringMatch(entry->owner, instanceID))) {
+        pthread_mutex_unlock(&ledgerLock);
+        return EXIT_FAILURE;
+    }
+    setOwner(entry, NULL);
+    entry->held = OV_LEDGER_FREE;
+    pthread_mutex_unlock(&ledgerLock);
+    return EXIT_SUCCESS;
+}
+
+int ovLedgerIsClaimed(int hardwareURI)
+{
+    pthread_mutex_lock(&ledgerLock);
+    int held = isHeld(findEntry(hardwareURI, 0), monotonicSeconds());
+    pthread_mutex_unlock(&ledgerLock);
+    return held;
+}
+
+/* A copy of the instance that holds a server (which must be freed), NULL if it is free or only
+ * leased
+ */
+
+char *ovLedgerOwner(int hardwareURI)
+{
+    pthread_mutex_lock(&ledgerLock);
+    ovLedgerEntry *entry = findEntry(hardwareURI, 0);
+    char *owner = (entry && entry->held == OV_LEDGER_RECORDED && entry->owner) ? strdup(entry->owner) : NULL;
+    pthread_mutex_unlock(&ledgerLock);
+    return owner;
+}
+
+/* Servers that are held (recorded or with a lease that hasn't run out)
+ */
+
+size_t ovLedgerClaimed()
+{
+    pthread_mutex_lock(&ledgerLock);
+    double now = monotonicSeconds();
+    size_t claimed = 0;
+    for (size_t i = 0; i < entryCount; i++) {
+        if (isHeld(&entries[i], now)) {
+            claimed++;
+        }
+    }
+    pthread_mutex_unlock(&ledgerLock);
+    return claimed;
+}
@@ -0,0 +1,333 @@
+
+// oneviewInfraKitPipeline.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#include "oneviewInfraKitPipeline.h"
+#include "oneviewInfraKitState.h"
+#include "oneviewInfraKitTasks.h"
+#include "oneviewInfraKitLedger.h"
+#include "oneviewInfraKitPlugin.h"
+#include "oneviewInfraKitConsole.h"
+#include "oneviewIntern.h"
+#include "oneviewHash.h"
+#include "oneview.h"
+#include "oneviewSessions.h"
+#include "oneviewTemplates.h"
+
+#include <jansson.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+pthread_mutex_t pipelineLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t pipelineReady = PTHREAD_COND_INITIALIZER;
+
+static ovProvisionJob *queue;       // Jobs waiting for the pipeline thread
+static size_t queueCount;
+static size_t queueSize;
+static size_t inProgress;           // Jobs taken by the pipeline thread that aren't finished
+static int pipelineStarted;
+
+// The session the pipeline sends its requests with (attached to the session of the jobs)
+static oneviewSession *pipelineSession;
+
+int ovPipelineSubmit(const ovProvisionJob *jobs, size_t count)
+{
+    if (!jobs || count == 0) {
+        return EXIT_SUCCESS;
+    }
+    pthread_mutex_lock(&pipelineLock);
+    if (queueCount + count > queueSize) {
+        size_t newSize = queueSize ? queueSize : OV_PIPELINE_BATCH;
+        while (queueCount + count > newSize) {
+            newSize *= 2;
+        }
+        ovProvisionJob *newQueue = realloc(queue, sizeof(ovProvisionJob) * newSize);
+        if (!newQueue) {
+            pthread_mutex_unlock(&pipelineLock);
+            ovPrintError(getPluginTime(), "Unable to queue provisioning jobs\n");
+            return EXIT_FAILURE;
+        }
+        queue = newQueue;
+        queueSize = newSize;
+    }
+    memcpy(queue + queueCount, jobs, sizeof(ovProvisionJob) * count);
+    queueCount += count;
+    pthread_cond_signal(&pipelineReady);
+    pthread_mutex_unlock(&pipelineLock);
+    return EXIT_SUCCESS;
+}
+
+/* Free the strings of jobs that weren't submitted (or that the pipeline has finished with)
+ */
+
+void ovPipelineFreeJobs(ovProvisionJob *jobs, size_t count)
+{
+    for (size_t i = 0; jobs && i < count; i++) {
+        free(jobs[i].instanceName);
+        free(jobs[i].description);
+        jobs[i].instanceName = NULL;
+        jobs[i].description = NULL;
+    }
+}
+
+/* Jobs that are queued or are moving through the stages
+ */
+
+size_t ovPipelinePending()
+{
+    pthread_mutex_lock(&pipelineLock);
+    size_t pending = queueCount + inProgress;
+    pthread_mutex_unlock(&pipelineLock);
+    return pending;
+}
+
+/* Wait for jobs and take up to OV_PIPELINE_BATCH of them, a batch only holds jobs for the
+ * same session so that it can be sent with one session
+ */
+
+static size_t takeJobs(ovProvisionJob *batch)
+{
+    pthread_mutex_lock(&pipelineLock);
+    while (queueCount == 0) {
+        pthread_cond_wait(&pipelineReady, &pipelineLock);
+    }
+    size_t count = 0;
+    while (count < queueCount && count < OV_PIPELINE_BATCH && \
+           queue[count].address == queue[0].address && queue[count].username == queue[0].username) {
+        count++;
+    }
+    memcpy(batch, queue, sizeof(ovProvisionJob) * count);
+    queueCount -= count;
+    memmove(queue, queue + count, sizeof(ovProvisionJob) * queueCount);
+    inProgress = count;
+    pthread_mutex_unlock(&pipelineLock);
+    return count;
+}
+
+static void finishJobs()
+{
+    pthread_mutex_lock(&pipelineLock);
+    inProgress = 0;
+    pthread_mutex_unlock(&pipelineLock);
+}
+
+static oneviewSession *sessionForJob(const ovProvisionJob *job)
+{
+    if (!pipelineSession) {
+        pipelineSession = initSession();
+        if (!pipelineSession) {
+            return NULL;
+        }
+    }
+    if (ovSessionAttach(pipelineSession, ovInternString(job->address), ovInternString(job->username), NULL) == EXIT_FAILURE) {
+        return NULL;
+    }
+    return pipelineSession;
+}
+
+/* Stage one, power off the servers that were found powered on while reserving hardware
+ */
+
+static void powerOffStage(oneviewSession *session, ovProvisionJob *jobs, size_t count)
+{
+    const char *hardwareURIs[OV_PIPELINE_BATCH];
+    ovProvisionJob *powerJobs[OV_PIPELINE_BATCH];
+    char *responses[OV_PIPELINE_BATCH] = { NULL };
+    size_t powerCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (jobs[i].type == OV_JOB_POWER_OFF) {
+            powerJobs[powerCount] = &jobs[i];
+            hardwareURIs[powerCount++] = ovInternString(jobs[i].hardwareURI);
+        }
+    }
+    if (powerCount == 0) {
+        return;
+    }
+    size_t accepted = ovPowerOffHardwareBatch(session, hardwareURIs, powerCount, OV_PIPELINE_POWER_CONCURRENCY, responses);
+    // The hardware can be used once the power off task completes
+    for (size_t i = 0; i < powerCount; i++) {
+        const ovProvisionJob *job = powerJobs[i];
+        char *taskURI = ovTaskFromResponse(responses[i]);
+        if (ovTrackTask(OV_TASK_POWER_OFF, taskURI, NULL, job->hardwareURI, job->address, job->username) == EXIT_FAILURE) {
+            // The server was leased until it is off (see reserveFreeHardware)
+            ovLedgerRelease(job->hardwareURI, NULL);
+        }
+        free(taskURI);
+        free(responses[i]);
+    }
+    char ovOutput[1024];
+    snprintf(ovOutput, sizeof(ovOutput), "Powering off %zu of %zu available servers\n", accepted, powerCount);
+    ovPrintInfo(getPluginTime(), ovOutput);
+}
+
+/* Instances can be destroyed while their job is queued, only the profiles of instances that
+ * are still pending are posted, and they are marked as posting first (see
+ * markInstancesPosting) so that a Destroy from then on leaves them to be removed afterwards
+ */
+
+static size_t keepInstancesInState(ovProvisionJob **profiles, size_t count)
+{
+    const char *instanceIDs[OV_PIPELINE_BATCH];
+    char posting[OV_PIPELINE_BATCH];
+    for (size_t i = 0; i < count; i++) {
+        instanceIDs[i] = profiles[i]->instanceName;
+    }
+    markInstancesPosting(instanceIDs, count, posting);
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (posting[i]) {
+            profiles[kept++] = profiles[i];
+        }
+    }
+    return kept;
+}
+
+/* Stage two and three, read the new profile of each template if it isn't held (see
+ * oneviewTemplates.h) then post a profile for every instance (concurrently), stage four
+ * records the outcome of every instance with one update of the state and hands the tasks
+ * creating the profiles to the task tracker
+ */
+
+static void profileStages(oneviewSession *session, ovProvisionJob *jobs, size_t count)
+{
+    ovProvisionJob *profiles[OV_PIPELINE_BATCH];
+    size_t profileCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (jobs[i].type == OV_JOB_PROFILE) {
+            profiles[profileCount++] = &jobs[i];
+        }
+    }
+    profileCount = keepInstancesInState(profiles, profileCount);
+    if (profileCount == 0) {
+        return;
+    }
+
+    // The new profiles of the templates used by the batch (only read if a template is new or
+    // has changed)
+    int templates[OV_PIPELINE_BATCH];
+    for (size_t i = 0; i < profileCount; i++) {
+        templates[i] = profiles[i]->templateURI;
+    }
+    ovTemplatesPrepare(session, templates, profileCount);
+
+    // Patch the fields of each instance into the new profile of its template
+    char *bodies[OV_PIPELINE_BATCH];
+    char *responses[OV_PIPELINE_BATCH];
+    size_t posted[OV_PIPELINE_BATCH];
+    size_t bodyCount = 0;
+    const char *instanceIDs[OV_PIPELINE_BATCH];
+    const char *statuses[OV_PIPELINE_BATCH];
+    for (size_t i = 0; i < profileCount; i++) {
+        instanceIDs[i] = profiles[i]->instanceName;
+        statuses[i] = OV_INSTANCE_FAILED;
+        bodies[bodyCount] = ovTemplateProfile(session, profiles[i]->templateURI, instanceIDs[i], \
+                                              ovInternString(profiles[i]->hardwareURI), profiles[i]->description);
+        if (bodies[bodyCount]) {
+            posted[bodyCount++] = i;
+        }
+    }
+
+    char *taskURIs[OV_PIPELINE_BATCH] = { NULL };
+    size_t created = ovPostProfiles(session, bodies, bodyCount, responses, OV_PIPELINE_POST_CONCURRENCY);
+    for (size_t i = 0; i < bodyCount; i++) {
+        if (responses[i]) {
+            statuses[posted[i]] = OV_INSTANCE_CREATING;
+            taskURIs[posted[i]] = ovTaskFromResponse(responses[i]);
+        }
+        free(bodies[i]);
+        free(responses[i]);
+    }
+    // The statuses are recorded before the tasks are tracked, so a task can't finish first
+    setInstanceStatuses(instanceIDs, statuses, (const char **)taskURIs, profileCount, NULL);
+    for (size_t i = 0; i < profileCount; i++) {
+        if (taskURIs[i]) {
+            ovTrackTask(OV_TASK_PROFILE_CREATE, taskURIs[i], profiles[i]->instanceName, profiles[i]->hardwareURI, \
+                        profiles[i]->address, profiles[i]->username);
+        }
+        free(taskURIs[i]);
+    }
+
+    char ovOutput[1024];
+    snprintf(ovOutput, sizeof(ovOutput), "Created %zu of %zu server profiles\n", created, profileCount);
+    ovPrintInfo(getPluginTime(), ovOutput);
+}
+
+/* A batch that can't be sent (there is no session for it) is dropped, the instances it would
+ * have created are marked as failed so that Describe removes them and frees their servers
+ */
+
+static void failJobs(ovProvisionJob *jobs, size_t count)
+{
+    const char *instanceIDs[OV_PIPELINE_BATCH];
+    const char *statuses[OV_PIPELINE_BATCH];
+    size_t profileCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (jobs[i].type == OV_JOB_PROFILE) {
+            instanceIDs[profileCount] = jobs[i].instanceName;
+            statuses[profileCount++] = OV_INSTANCE_FAILED;
+        } else if (jobs[i].type == OV_JOB_POWER_OFF) {
+            ovLedgerRelease(jobs[i].hardwareURI, NULL);
+        }
+    }
+    char ovOutput[1024];
+    snprintf(ovOutput, sizeof(ovOutput), "No OneView session for %s, %zu jobs dropped\n", ovInternString(jobs[0].address), count);
+    ovPrintError(getPluginTime(), ovOutput);
+    if (profileCount != 0) {
+        setInstanceStatuses(instanceIDs, statuses, NULL, profileCount, NULL);
+    }
+}
+
+static void *pipelineThread(void *argument)
+{
+    ovProvisionJob *batch = malloc(sizeof(ovProvisionJob) * OV_PIPELINE_BATCH);
+    if (!batch) {
+        return NULL;
+    }
+    while (1) {
+        size_t count = takeJobs(batch);
+        oneviewSession *session = sessionForJob(&batch[0]);
+        if (session) {
+            powerOffStage(session, batch, count);
+            profileStages(session, batch, count);
+        } else {
+            failJobs(batch, count);
+        }
+        ovPipelineFreeJobs(batch, count);
+        finishJobs();
+    }
+    free(batch);
+    return NULL;
+}
+
+int ovPipelineStart()
+{
+    if (pipelineStarted) {
+        return EXIT_FAILURE;
+    }
+    // The queue didn't survive the restart
+    size_t failed = failPendingInstances();
+    if (failed != 0) {
+        char ovOutput[1024];
+        snprintf(ovOutput, sizeof(ovOutput), "%zu instances were waiting to be provisioned when the plugin stopped, they are marked as failed\n", failed);
+        ovPrintWarning(getPluginTime(), ovOutput);
+    }
+    pthread_t pipeline;
+    if (pthread_create(&pipeline, NULL, pipelineThread, NULL) != 0) {
+        ovPrintError(getPluginTime(), "Unable to start the provisioning pipeline\n");
+        return EXIT_FAILURE;
+    }
+    pthread_detach(pipeline);
+    pipelineStarted = 1;
+    return EXIT_SUCCESS;
+}
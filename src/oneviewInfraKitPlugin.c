@@ -17,7 +17,11 @@
 #include "oneviewInfraKitInstance.h"
 #include "oneviewInfraKitPlugin.h"
 #include "oneviewInfraKitState.h"
+#include "oneviewInventory.h"
 #include "oneviewHTTPD.h"
+#include "oneviewArena.h"
+#include "oneviewInfraKitPipeline.h"
+#include "oneviewInfraKitTasks.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -54,10 +58,30 @@ char *stateName = NULL;
 char *socketDefault = "instance-oneview";
 char *stateDefault = "state-oneview.json";
 
+/* Provision calls that arrive within the window of each other are queued and provisioned as
+ * one batch, each still gets its own response (-1 until it is set by --window or the
+ * OV_PROVISION_WINDOW environment variable)
+ */
+
+static long provisionWindow = -1;
+static json_t *queuedSpecs[OV_HTTPD_MAX_HELD];
+static long long queuedIds[OV_HTTPD_MAX_HELD];
+static int queuedConnections[OV_HTTPD_MAX_HELD];
+static size_t queuedCount;
+
 // These will be built up to the fullpaths are runtime
 char builtSocketPath[PATH_MAX];
 char builtStatePath[PATH_MAX];
 
+int setProvisionWindow(long milliseconds)
+{
+    if (milliseconds < 0) {
+        return EXIT_FAILURE;
+    }
+    provisionWindow = milliseconds;
+    return EXIT_SUCCESS;
+}
+
 int setSocketName(char *name)
 {
     if (name) {
@@ -72,7 +96,100 @@ int setSocketName(char *name)
  * server will then send to the client
  */
 
+static int processPostData(httpRequest *request);
+
+/* The response to Handshake.Implements (and Plugin.Implements) */
+
+static void writeImplements(ovJSONWriter *writer, const char *version, long long id)
+{
+    ovWriteRPCBegin(writer);
+    ovWriteKey(writer, "result");
+    ovWriteBeginObject(writer);
+    ovWriteKey(writer, "APIs");
+    ovWriteBeginArray(writer);
+    ovWriteBeginObject(writer);
+    ovWriteKey(writer, "Name");
+    ovWriteString(writer, "Instance");
+    ovWriteKey(writer, "Version");
+    ovWriteString(writer, version);
+    ovWriteEndObject(writer);
+    ovWriteEndArray(writer);
+    ovWriteEndObject(writer);
+    ovWriteRPCEnd(writer, id);
+}
+
+/* Every JSON value built while handling the request comes from the request arena, which is
+ * reset once the response has been written (into the connection's writer, not the arena)
+ */
+
 int handlePostData(httpRequest *request)
+{
+    ovArenaBegin();
+    int result = processPostData(request);
+    ovArenaEnd();
+    return result;
+}
+
+/* Hold a Provision until the window closes, the spec is copied out of the request arena as it
+ * is kept after the request
+ */
+
+static int queueProvision(json_t *spec, long long id)
+{
+    if (provisionWindow <= 0 || !spec || queuedCount == OV_HTTPD_MAX_HELD) {
+        return EXIT_FAILURE;
+    }
+    json_t *heldSpec = ovArenaPromote(json_incref(spec));
+    if (!heldSpec) {
+        return EXIT_FAILURE;
+    }
+    queuedSpecs[queuedCount] = heldSpec;
+    queuedIds[queuedCount] = id;
+    queuedConnections[queuedCount] = httpCurrentConnection();
+    queuedCount++;
+    return EXIT_SUCCESS;
+}
+
+/* Called by the HTTPD server once the window closes, the queued Provision calls share one
+ * inventory snapshot, template resolution and state update
+ */
+
+int flushQueuedProvisions()
+{
+    if (queuedCount == 0) {
+        return EXIT_SUCCESS;
+    }
+    ovArenaBegin();
+    char ovOutput[1024];
+    snprintf(ovOutput, sizeof(ovOutput), "Provisioning %zu coalesced requests\n", queuedCount);
+    ovPrintInfo(getPluginTime(), ovOutput);
+    
+    // The array takes the queued specs, so they are freed with it
+    json_t *specs = json_array();
+    for (size_t i = 0; i < queuedCount; i++) {
+        json_array_append_new(specs, queuedSpecs[i]);
+    }
+    char *instanceNames[OV_HTTPD_MAX_HELD];
+    processInstanceBatch(specs, 0, queuedIds, instanceNames);
+    
+    ovJSONWriter *writer = httpResponseWriter();
+    for (size_t i = 0; i < queuedCount; i++) {
+        ovWriterReset(writer);
+        ovInfraKitInstanceWriteProvisioned(instanceNames[i], queuedIds[i], writer);
+        free(instanceNames[i]);
+        ovPrintDebug(getPluginTime(), "Outgoing Response =>\n");
+        if (ovWriterText(writer)) {
+            ovPrintDebug(getPluginTime(), ovWriterText(writer));
+        }
+        httpRespondToConnection(queuedConnections[i], writer, 200);
+    }
+    json_decref(specs);
+    queuedCount = 0;
+    ovArenaEnd();
+    return EXIT_SUCCESS;
+}
+
+static int processPostData(httpRequest *request)
 {
     json_t *requestJSON = NULL;
     json_error_t error;
@@ -84,65 +201,55 @@ int handlePostData(httpRequest *request)
         json_t *params = json_object_get(requestJSON, "params");
         
         if (getConsoleOutputLevel() == LOGDEBUG) {
-            char *debugMessage = json_dumps(requestJSON, JSON_INDENT(3));
+            char *debugMessage = ovDumpJSON(requestJSON, JSON_INDENT(3));
             ovPrintDebug(getPluginTime(), "Incoming Request =>\n");
             ovPrintDebug(getPluginTime(), debugMessage);
             free(debugMessage);
         }
         
+        ovJSONWriter *writer = httpResponseWriter();
+        int handled = 1;
         if (stringMatch(methodName, "Instance.DescribeInstances")) {
-            char *response = ovInfraKitInstanceDescribe(params, id);
-            ovPrintDebug(getPluginTime(), "Outgoing Response =>\n");
-            ovPrintDebug(getPluginTime(), response);
-            setHTTPResponse(response, 200);
-            json_decref(requestJSON);
-            return EXIT_SUCCESS;
-        }
-        if (stringMatch(methodName, "Handshake.Implements")) {
-            json_t *reponseJSON = json_pack("{s:s,s:{s:[{s:s,s:s}]},s:I}", "jsonrpc", "2.0", "result", "APIs", "Name", "Instance", "Version", "0.5.0", "id", id);
-            char *response = json_dumps(reponseJSON, JSON_ENSURE_ASCII);
-            setHTTPResponse(response, 200);
-            json_decref(requestJSON);
-            return EXIT_SUCCESS;
-        }
-        // Backwards compatability (should be removed in the future)
-        if (stringMatch(methodName, "Plugin.Implements")) {
-            json_t *reponseJSON = json_pack("{s:s,s:{s:[{s:s,s:s}]},s:I}", "jsonrpc", "2.0", "result", "APIs", "Name", "Instance", "Version", "0.1.0", "id", id);
-            char *response = json_dumps(reponseJSON, JSON_ENSURE_ASCII);
-            setHTTPResponse(response, 200);
-            json_decref(requestJSON);
-            return EXIT_SUCCESS;
-        }
-        if (stringMatch(methodName, "Instance.Validate")) {
-            json_t *reponseJSON = json_pack("{s:{s:b},s:s?,s:I}", "result", "OK", JSON_TRUE, "error", NULL, "id", id);
-            char *response = json_dumps(reponseJSON, JSON_ENSURE_ASCII);
-            setHTTPResponse(response, 200);
-            json_decref(requestJSON);
-            return EXIT_SUCCESS;
-        }
-        
-        if (stringMatch(methodName, "Instance.Provision")) {
-            json_t *spec = json_object_get(params, "Spec");
-            char *response = ovInfraKitInstanceProvision(spec, id);
-            ovPrintDebug(getPluginTime(), "Outgoing Response =>\n");
-            ovPrintDebug(getPluginTime(), response);
-            setHTTPResponse(response, 200);
-            json_decref(requestJSON);
-            return EXIT_SUCCESS;
+            ovInfraKitInstanceDescribe(params, id, writer);
+        } else if (stringMatch(methodName, "Handshake.Implements")) {
+            writeImplements(writer, "0.5.0", id);
+        } else if (stringMatch(methodName, "Plugin.Implements")) {
+            // Backwards compatability (should be removed in the future)
+            writeImplements(writer, "0.1.0", id);
+        } else if (stringMatch(methodName, "Instance.Validate")) {
+            ovWriteRPCBegin(writer);
+            ovWriteKey(writer, "result");
+            ovWriteBeginObject(writer);
+            ovWriteKey(writer, "OK");
+            ovWriteBoolean(writer, 1);
+            ovWriteEndObject(writer);
+            ovWriteKey(writer, "error");
+            ovWriteNull(writer);
+            ovWriteRPCEnd(writer, id);
+        } else if (stringMatch(methodName, "Instance.Provision")) {
+            // A scale up can provision all of its instances at once with an array of specs
+            json_t *specs = json_object_get(params, "Specs");
+            if (json_is_array(specs)) {
+                ovInfraKitInstanceProvisionBatch(specs, id, writer);
+            } else {
+                json_t *spec = json_object_get(params, "Spec");
+                if (queueProvision(spec, id) == EXIT_SUCCESS) {
+                    json_decref(requestJSON);
+                    return OV_HTTPD_DEFERRED;
+                }
+                ovInfraKitInstanceProvision(spec, id, writer);
+            }
+        } else if (stringMatch(methodName, "Instance.Destroy") || stringMatch(methodName, "Instance.Meta")) {
+            ovInfraKitInstanceDestroy(params, id, writer);
+        } else {
+            handled = 0;
         }
-        if (stringMatch(methodName, "Instance.Destroy")) {
-            char *response = ovInfraKitInstanceDestroy(params, id);
-            ovPrintDebug(getPluginTime(), "Outgoing Response =>\n");
-            ovPrintDebug(getPluginTime(), response);
-            setHTTPResponse(response, 200);
-            json_decref(requestJSON);
-            return EXIT_SUCCESS;
-        }
-        if (stringMatch(methodName, "Instance.Meta")) {
-            char *response = ovInfraKitInstanceDestroy(params, id);
-            ovPrintDebug(getPluginTime(), "Outgoing Response =>\n");
-            ovPrintDebug(getPluginTime(), response);
-            setHTTPResponse(response, 200);
+        if (handled) {
+            if (ovWriterText(writer)) {
+                ovPrintDebug(getPluginTime(), "Outgoing Response =>\n");
+                ovPrintDebug(getPluginTime(), ovWriterText(writer));
+            }
+            setHTTPResponseFromWriter(writer, 200);
             json_decref(requestJSON);
             return EXIT_SUCCESS;
         }
@@ -182,6 +289,7 @@ int ovCreateInfraKitInstance()
     }
     setConsolOutputLevel(LOGINFO);
     ovPrintInfo(getPluginTime(), "Starting OneView Instance Plugin\n");
+    ovArenaInstall();
     
     /* These two paths will build out to be the path for the socket and the state
      * we will build them out and ensure that the paths are fully created, including
@@ -245,7 +353,31 @@ int ovCreateInfraKitInstance()
     sprintf(ovOutput, "Path for State File => %s\n", builtStatePath);
     ovPrintInfo(getPluginTime(), ovOutput);
 
+    /* The state-change subscriber is optional, it is enabled by either --scmb or the
+     * OV_SCMB_SOCKET environment variable pointing at a message relay socket
+     */
+    
+    char *scmbPath = getInventorySocketPath();
+    if (!scmbPath) {
+        scmbPath = getenv("OV_SCMB_SOCKET");
+    }
+    if (scmbPath) {
+        inventoryStartSubscriber(scmbPath);
+    }
+
+    // The profiles of new instances are created in the background, and their tasks tracked
+    if (ovPipelineStart() == EXIT_FAILURE || ovTaskTrackerStart() == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    if (provisionWindow < 0) {
+        char *window = getenv("OV_PROVISION_WINDOW");
+        provisionWindow = window ? strtol(window, NULL, 10) : OV_PROVISION_WINDOW;
+    }
+    setHTTPCoalesceWindow(provisionWindow);
+
     SetPostFunction(handlePostData);
+    SetFlushFunction(flushQueuedProvisions);
 
     startHTTPDServer();
     return EXIT_SUCCESS;
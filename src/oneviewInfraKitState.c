@@ -15,12 +15,36 @@
 #include "oneviewInfraKitState.h"
 #include "oneviewInfraKitPlugin.h"
 #include "oneviewInfraKitConsole.h"
+#include "oneviewArena.h"
+#include "oneviewInfraKitLedger.h"
 
 #include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
 
 char *statePath = NULL;
 char *argStatePath = NULL;
 
+/* The state is updated by the requests and by the provisioning pipeline, each read, modify
+ * and save of the state is done while holding the lock
+ */
+
+static pthread_mutex_t stateLock = PTHREAD_MUTEX_INITIALIZER;
+
+void lockInstanceState()
+{
+    pthread_mutex_lock(&stateLock);
+}
+
+void unlockInstanceState()
+{
+    pthread_mutex_unlock(&stateLock);
+}
+
+/* The path is only set whilst the plugin starts, before any of the threads that read it
+ */
+
 char *getStatePath()
 {
     return statePath;
@@ -82,8 +106,11 @@ int loginFromState(const char *groupName)
         const char *address = json_string_value(json_object_get(oneViewState, "address"));
         const char *username = json_string_value(json_object_get(oneViewState, "username"));
         const char *password = json_string_value(json_object_get(oneViewState, "password"));
-        return instanceLogin(address, username, password);
+        int loggedIn = instanceLogin(address, username, password);
+        json_decref(stateJSON);
+        return loggedIn;
     }
+    json_decref(stateJSON);
     return EXIT_FAILURE;
 }
 
@@ -108,6 +135,10 @@ json_t *openInstanceState()
     return stateJSON;
 }
 
+/* The state is written to a temporary file that then replaces the state, so the state is
+ * never seen part written
+ */
+
 int saveInstanceState(char *jsonData)
 {
     if (!statePath) {
@@ -115,17 +146,22 @@ int saveInstanceState(char *jsonData)
         return EXIT_FAILURE;
     }
     
+    size_t pathLength = strlen(statePath);
+    char temporaryPath[pathLength + 5];
+    snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", statePath);
+    
     FILE *fp;
-    fp = fopen(statePath, "w");
+    fp = fopen(temporaryPath, "w");
     if (fp) { /*file opened succesfully */
-        fputs(jsonData, fp);
-        fclose(fp);
-    } else {
-        ovPrintError(getPluginTime(), "Unable to modify the state file =>\n");
-        ovPrintError(getPluginTime(), statePath);
-        return EXIT_FAILURE;
+        int written = (fputs(jsonData, fp) != EOF);
+        if (fclose(fp) == 0 && written && rename(temporaryPath, statePath) == 0) {
+            return EXIT_SUCCESS;
+        }
+        unlink(temporaryPath);
     }
-    return EXIT_SUCCESS;
+    ovPrintError(getPluginTime(), "Unable to modify the state file =>\n");
+    ovPrintError(getPluginTime(), statePath);
+    return EXIT_FAILURE;
 }
 
 /* This function will take the state data, and then find a group
@@ -156,56 +192,262 @@ json_t *findGroup(json_t *state, const char *groupName)
 
 int appendInstanceToState(profile *foundServer, oneviewSession *session, json_t *paramsJSON)
 {
-    json_t *tags = json_object_get(paramsJSON, "Tags");
-    const char *sha = json_string_value(json_object_get(tags, "infrakit.config_sha"));
-    const char *infrakitGroup = json_string_value(json_object_get(tags, "infrakit.group"));
-    
+    return appendInstancesToState(foundServer, &paramsJSON, 1, session);
+}
+
+/* The same for a batch of new profiles (paramsJSON[i] is the spec of foundServers[i]), the
+ * state is read and written once for the whole batch.
+ */
+
+int appendInstancesToState(profile *foundServers, json_t **paramsJSON, size_t count, oneviewSession *session)
+{
+    lockInstanceState();
     json_t *stateJSON = openInstanceState();
     if (!stateJSON) {
+        unlockInstanceState();
         ovPrintError(getPluginTime(), "Unable to preserve state\n");
         return EXIT_FAILURE;
     }
+    json_t *oneViewGroups = json_object_get(stateJSON, "OneViewGroups");
     
-    char ovOutput[1024];
-    sprintf(ovOutput, "Opening State for Group %s\n", infrakitGroup);
-    ovPrintDebug(getPluginTime(), ovOutput);
+    for (size_t i = 0; i < count; i++) {
+        profile *foundServer = &foundServers[i];
+        json_t *tags = json_object_get(paramsJSON[i], "Tags");
+        const char *sha = json_string_value(json_object_get(tags, "infrakit.config_sha"));
+        const char *infrakitGroup = json_string_value(json_object_get(tags, "infrakit.group"));
+        
+        char ovOutput[1024];
+        snprintf(ovOutput, sizeof(ovOutput), "Opening State for Group %s\n", infrakitGroup);
+        ovPrintDebug(getPluginTime(), ovOutput);
+        
+        json_t *group = findGroup(stateJSON, infrakitGroup);
+        
+        if (!group) {
+            group = json_pack ("{s:s,s:{},s:[],s:[]}", "groupName", infrakitGroup, "OneViewInstance", "Instances", "NonFunctional");
+            json_array_append_new(oneViewGroups, group);
+        }
+        
+        json_t *instances = json_object_get(group, "Instances");
+        if (json_object_size(json_object_get(group, "OneViewInstance")) == 0) {
+            char *oneviewDetails = "{s:s?,s:s?,s:s?,s:s?}";
+            json_t *oneviewJSON = json_pack(oneviewDetails, \
+                                                "address", session->address, \
+                                                "username", session->username, \
+                                                "password", session->password, \
+                                                "cookie", session->cookie);
+            
+            json_object_set_new(group, "OneViewInstance", oneviewJSON);
+        }
+        
+        // New instances are pending until the provisioning pipeline has created their profile
+        char *instanceDescription = "{s:s,s:s?,s:{s:s,s:s,s:s,s:s,s:s}}";
+        json_t *descriptionJSON = json_pack(instanceDescription, \
+                                                "ID", foundServer->profileName, \
+                                                "LogicalID", ovInternString(foundServer->availableHardwareURI), \
+                                                "Tags", \
+                                                    "hw_uri", ovInternString(foundServer->availableHardwareURI), \
+                                                    "retry-count", INSTANCE_RETRY, \
+                                                    "infrakit.config_sha", sha, \
+                                                    "infrakit.group", infrakitGroup, \
+                                                    OV_INSTANCE_STATUS_TAG, OV_INSTANCE_PENDING);
+        
+        json_array_append_new(instances, descriptionJSON);
+    }
+    char *json_text = ovDumpJSON(stateJSON, JSON_ENSURE_ASCII);
+    int saved = saveInstanceState(json_text);
+    free(json_text);
+    json_decref(stateJSON);
+    // The servers are held by the instances now that they are in the state
+    for (size_t i = 0; saved == EXIT_SUCCESS && i < count; i++) {
+        ovLedgerRecord(foundServers[i].availableHardwareURI, foundServers[i].profileName);
+    }
+    unlockInstanceState();
+    return saved;
+}
+
+/* Set the status of a batch of instances (statuses[i] is the OV_INSTANCE_* status of the
+ * instance named instanceIDs[i], NULL removes it) with one update of the state, instances that
+ * are no longer in the state are skipped. The OneView task of each instance is recorded when
+ * tasks is given (and tasks[i] isn't NULL).
+ *
+ * An instance that was destroyed while its profile was being posted or created keeps its
+ * status. If its profile failed nothing was created, so it is removed (and its server is
+ * released). Otherwise, once its profile has been created, destroyed[i] is set (when
+ * destroyed is given) and the caller deletes the profile.
+ */
+
+int setInstanceStatuses(const char **instanceIDs, const char **statuses, const char **tasks, size_t count, char *destroyed)
+{
+    lockInstanceState();
+    json_t *stateJSON = openInstanceState();
+    oneviewHashIndex ids = {0};
+    int *hardwareURIs = malloc(sizeof(int) * (count ? count : 1));
+    if (!stateJSON || !hardwareURIs || initHashIndex(&ids, count * 2) == EXIT_FAILURE) {
+        free(hardwareURIs);
+        json_decref(stateJSON);
+        unlockInstanceState();
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < count; i++) {
+        ovHashInsert(&ids, instanceIDs[i], (int)i);
+        hardwareURIs[i] = OV_INTERN_NONE;
+        if (destroyed) {
+            destroyed[i] = 0;
+        }
+    }
     
+    size_t groupIndex;
+    json_t *group;
     json_t *oneViewGroups = json_object_get(stateJSON, "OneViewGroups");
-    json_t *group = findGroup(stateJSON, infrakitGroup);
+    json_array_foreach(oneViewGroups, groupIndex, group) {
+        json_t *instances = json_object_get(group, "Instances");
+        for (size_t instanceIndex = 0; instanceIndex < json_array_size(instances);) {
+            json_t *instanceValue = json_array_get(instances, instanceIndex++);
+            int position = ovHashFind(&ids, json_string_value(json_object_get(instanceValue, "ID")));
+            json_t *tags = json_object_get(instanceValue, "Tags");
+            if (position == OV_HASH_NOT_FOUND || !tags) {
+                continue;
+            }
+            if (tasks && tasks[position]) {
+                json_object_set_new(tags, OV_INSTANCE_TASK_TAG, json_string(tasks[position]));
+            }
+            if (stringMatch(json_string_value(json_object_get(tags, OV_INSTANCE_STATUS_TAG)), OV_INSTANCE_DESTROYED)) {
+                if (stringMatch(statuses[position], OV_INSTANCE_FAILED)) {
+                    hardwareURIs[position] = ovIntern(json_string_value(json_object_get(tags, "hw_uri")));
+                    json_array_remove(instances, --instanceIndex);
+                } else if (destroyed && !stringMatch(statuses[position], OV_INSTANCE_CREATING)) {
+                    destroyed[position] = 1;
+                }
+                continue;
+            }
+            if (statuses[position]) {
+                json_object_set_new(tags, OV_INSTANCE_STATUS_TAG, json_string(statuses[position]));
+            } else {
+                json_object_del(tags, OV_INSTANCE_STATUS_TAG);
+            }
+        }
+    }
+    char *json_text = ovDumpJSON(stateJSON, JSON_ENSURE_ASCII);
+    int saved = saveInstanceState(json_text);
+    free(json_text);
+    for (size_t i = 0; saved == EXIT_SUCCESS && i < count; i++) {
+        if (hardwareURIs[i] != OV_INTERN_NONE) {
+            ovLedgerRelease(hardwareURIs[i], instanceIDs[i]);
+        }
+    }
+    free(hardwareURIs);
+    freeHashIndex(&ids);
+    json_decref(stateJSON);
+    unlockInstanceState();
+    return saved;
+}
 
-    if (!group) {
-       group = json_pack ("{s:s,s:{},s:[],s:[]}", "groupName", infrakitGroup, "OneViewInstance", "Instances", "NonFunctional");
-       json_array_append(oneViewGroups, group);
+/* Mark the instances whose profile the pipeline is about to post as posting, with one update
+ * of the state. Only pending instances are marked (posting[i] is set for them), the others
+ * have been destroyed since they were queued. The number marked is returned.
+ *
+ * Marking them under the state lock means a Destroy either removes an instance before the
+ * pipeline takes it, or finds it posting and leaves it to be removed once it has been posted
+ * (see destroyInstanceInState).
+ */
+
+size_t markInstancesPosting(const char **instanceIDs, size_t count, char *posting)
+{
+    for (size_t i = 0; i < count; i++) {
+        posting[i] = 0;
+    }
+    lockInstanceState();
+    json_t *stateJSON = openInstanceState();
+    oneviewHashIndex ids = {0};
+    if (!stateJSON || initHashIndex(&ids, count * 2) == EXIT_FAILURE) {
+        json_decref(stateJSON);
+        unlockInstanceState();
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        ovHashInsert(&ids, instanceIDs[i], (int)i);
+    }
+    size_t marked = 0;
+    size_t groupIndex, instanceIndex;
+    json_t *group, *instanceValue;
+    json_array_foreach(json_object_get(stateJSON, "OneViewGroups"), groupIndex, group) {
+        json_array_foreach(json_object_get(group, "Instances"), instanceIndex, instanceValue) {
+            int position = ovHashFind(&ids, json_string_value(json_object_get(instanceValue, "ID")));
+            json_t *tags = json_object_get(instanceValue, "Tags");
+            if (position != OV_HASH_NOT_FOUND && \
+                stringMatch(json_string_value(json_object_get(tags, OV_INSTANCE_STATUS_TAG)), OV_INSTANCE_PENDING)) {
+                json_object_set_new(tags, OV_INSTANCE_STATUS_TAG, json_string(OV_INSTANCE_POSTING));
+                posting[position] = 1;
+                marked++;
+            }
+        }
     }
+    if (marked != 0) {
+        char *json_text = ovDumpJSON(stateJSON, JSON_ENSURE_ASCII);
+        if (saveInstanceState(json_text) == EXIT_FAILURE) {
+            // Nothing is posted for instances that couldn't be marked
+            for (size_t i = 0; i < count; i++) {
+                posting[i] = 0;
+            }
+            marked = 0;
+        }
+        free(json_text);
+    }
+    freeHashIndex(&ids);
+    json_decref(stateJSON);
+    unlockInstanceState();
+    return marked;
+}
 
-    json_t *instances = json_object_get(group, "Instances");
-    if (json_object_size(json_object_get(group, "OneViewInstance")) == 0) {
-        char *oneviewDetails = "{s:s?,s:s?,s:s?,s:s?}";
-        json_t *oneviewJSON = json_pack(oneviewDetails, \
-                                            "address", session->address, \
-                                            "username", session->username, \
-                                            "password", session->password, \
-                                            "cookie", session->cookie);
-        
-        json_object_set(group, "OneViewInstance", oneviewJSON);
-    }
-
-    char *instanceDescription = "{s:s,s:s?,s:{s:s,s:s,s:s,s:s}}";
-    json_t *descriptionJSON = json_pack(instanceDescription, \
-                                            "ID", foundServer->profileName, \
-                                            "LogicalID", foundServer->availableHardwareURI, \
-                                            "Tags", \
-                                                "hw_uri", foundServer->availableHardwareURI, \
-                                                "retry-count", INSTANCE_RETRY, \
-                                                "infrakit.config_sha", sha, \
-                                                "infrakit.group", infrakitGroup);
-    
-    json_array_append(instances, descriptionJSON);
-    char *json_text = json_dumps(stateJSON, JSON_ENSURE_ASCII);
-    saveInstanceState(json_text);
-    free(json_text);
+/* Destroy an instance as far as the state is concerned, with the state lock held throughout
+ * so that the pipeline and task tracker can't change the instance meanwhile. An instance
+ * that nothing was posted for is removed (and its server released). An instance whose profile
+ * is being posted or created is marked as destroyed, the pipeline or task tracker removes it
+ * (and deletes the profile) once that finishes. Any other instance is left for the caller to
+ * delete its profile. Returns the OV_DESTROY_* of what was done.
+ */
+
+int destroyInstanceInState(const char *instanceID, const char *groupName)
+{
+    lockInstanceState();
+    json_t *stateJSON = openInstanceState();
+    json_t *instances = json_object_get(findGroup(stateJSON, groupName), "Instances");
+    int outcome = OV_DESTROY_NOT_FOUND;
+    size_t instanceIndex;
+    json_t *instanceValue = NULL;
+    for (instanceIndex = 0; instanceID && instanceIndex < json_array_size(instances); instanceIndex++) {
+        if (stringMatch(json_string_value(json_object_get(json_array_get(instances, instanceIndex), "ID")), instanceID)) {
+            instanceValue = json_array_get(instances, instanceIndex);
+            break;
+        }
+    }
+    if (instanceValue) {
+        json_t *tags = json_object_get(instanceValue, "Tags");
+        const char *status = json_string_value(json_object_get(tags, OV_INSTANCE_STATUS_TAG));
+        int hardwareURI = ovIntern(json_string_value(json_object_get(tags, "hw_uri")));
+        outcome = OV_DESTROY_POSTED;
+        if (stringMatch(status, OV_INSTANCE_PENDING) || \
+            (stringMatch(status, OV_INSTANCE_FAILED) && !json_object_get(tags, OV_INSTANCE_TASK_TAG))) {
+            json_array_remove(instances, instanceIndex);
+            outcome = OV_DESTROY_REMOVED;
+        } else if (stringMatch(status, OV_INSTANCE_POSTING) || stringMatch(status, OV_INSTANCE_CREATING) || \
+                   stringMatch(status, OV_INSTANCE_DESTROYED)) {
+            json_object_set_new(tags, OV_INSTANCE_STATUS_TAG, json_string(OV_INSTANCE_DESTROYED));
+            outcome = OV_DESTROY_DEFERRED;
+        }
+        if (outcome != OV_DESTROY_POSTED) {
+            char *json_text = ovDumpJSON(stateJSON, JSON_ENSURE_ASCII);
+            if (saveInstanceState(json_text) == EXIT_FAILURE) {
+                outcome = OV_DESTROY_NOT_FOUND;
+            } else if (outcome == OV_DESTROY_REMOVED) {
+                ovLedgerRelease(hardwareURI, instanceID);
+            }
+            free(json_text);
+        }
+    }
     json_decref(stateJSON);
-    return EXIT_SUCCESS;
+    unlockInstanceState();
+    return outcome;
 }
 
 
@@ -215,7 +457,7 @@ int appendInstanceToState(profile *foundServer, oneviewSession *session, json_t
 
 int removeInstanceFromState(const char *instanceID, const char *groupName)
 {
-    
+    lockInstanceState();
     json_t *stateJSON = openInstanceState();
     json_t *group = findGroup(stateJSON, groupName);
     json_t *instances = json_object_get(group, "Instances");
@@ -224,6 +466,8 @@ int removeInstanceFromState(const char *instanceID, const char *groupName)
      */
     
     if (json_array_size(instances) == 0) {
+        json_decref(stateJSON);
+        unlockInstanceState();
         return EXIT_FAILURE;
     }
     
@@ -231,28 +475,129 @@ int removeInstanceFromState(const char *instanceID, const char *groupName)
         size_t instanceIndex;
         json_t *instanceValue;
         signed long instanceLocation = -1;
+        int hardwareURI = OV_INTERN_NONE;
         json_array_foreach(instances, instanceIndex, instanceValue) {
             const char *currentValue = json_string_value(json_object_get(instanceValue, "ID"));
             if (currentValue) {
                 if (stringMatch((char *)currentValue, (char *)instanceID)) {
                     instanceLocation = instanceIndex;
+                    hardwareURI = ovIntern(json_string_value(json_object_get(json_object_get(instanceValue, "Tags"), "hw_uri")));
                 }
             }
         }
         // See if instance was found in array
         if (instanceLocation != -1) {
             json_array_remove(instances, instanceLocation);
-            char *json_text = json_dumps(stateJSON, JSON_ENSURE_ASCII);
-            saveInstanceState(json_text);
+            char *json_text = ovDumpJSON(stateJSON, JSON_ENSURE_ASCII);
+            if (saveInstanceState(json_text) == EXIT_SUCCESS) {
+                ovLedgerRelease(hardwareURI, instanceID);
+            }
             free(json_text);
             json_decref(stateJSON);
+            unlockInstanceState();
             return EXIT_SUCCESS;
         }
     }
     json_decref(stateJSON);
+    unlockInstanceState();
     return EXIT_FAILURE;
 }
 
+/* Remove a batch of instances (from any group) with one update of the state, the servers they
+ * held are released once the state is saved
+ */
+
+int removeInstancesFromState(const char **instanceIDs, size_t count)
+{
+    lockInstanceState();
+    json_t *stateJSON = openInstanceState();
+    oneviewHashIndex ids = {0};
+    if (!stateJSON || initHashIndex(&ids, count * 2) == EXIT_FAILURE) {
+        json_decref(stateJSON);
+        unlockInstanceState();
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < count; i++) {
+        ovHashInsert(&ids, instanceIDs[i], (int)i);
+    }
+    
+    int *hardwareURIs = malloc(sizeof(int) * (count ? count : 1));
+    for (size_t i = 0; hardwareURIs && i < count; i++) {
+        hardwareURIs[i] = OV_INTERN_NONE;
+    }
+    size_t removed = 0;
+    size_t groupIndex;
+    json_t *group;
+    json_array_foreach(json_object_get(stateJSON, "OneViewGroups"), groupIndex, group) {
+        json_t *instances = json_object_get(group, "Instances");
+        for (size_t instanceIndex = 0; hardwareURIs && instanceIndex < json_array_size(instances);) {
+            json_t *instanceValue = json_array_get(instances, instanceIndex);
+            int position = ovHashFind(&ids, json_string_value(json_object_get(instanceValue, "ID")));
+            if (position == OV_HASH_NOT_FOUND) {
+                instanceIndex++;
+                continue;
+            }
+            hardwareURIs[position] = ovIntern(json_string_value(json_object_get(json_object_get(instanceValue, "Tags"), "hw_uri")));
+            json_array_remove(instances, instanceIndex);
+            removed++;
+        }
+    }
+    int saved = EXIT_FAILURE;
+    if (hardwareURIs) {
+        char *json_text = ovDumpJSON(stateJSON, JSON_ENSURE_ASCII);
+        saved = saveInstanceState(json_text);
+        free(json_text);
+    }
+    for (size_t i = 0; saved == EXIT_SUCCESS && i < count; i++) {
+        if (hardwareURIs[i] != OV_INTERN_NONE) {
+            ovLedgerRelease(hardwareURIs[i], instanceIDs[i]);
+        }
+    }
+    free(hardwareURIs);
+    freeHashIndex(&ids);
+    json_decref(stateJSON);
+    unlockInstanceState();
+    return (saved == EXIT_SUCCESS && removed != 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* The queue of the provisioning pipeline is only held in memory, so the instances that were
+ * pending (or posting, or destroyed while posting) when the plugin stopped will never have
+ * their profile created. They are marked as failed (Describe then removes them, and InfraKit
+ * replaces them).
+ */
+
+size_t failPendingInstances()
+{
+    lockInstanceState();
+    json_t *stateJSON = openInstanceState();
+    if (!stateJSON) {
+        unlockInstanceState();
+        return 0;
+    }
+    size_t failed = 0;
+    size_t groupIndex, instanceIndex;
+    json_t *group, *instanceValue;
+    json_array_foreach(json_object_get(stateJSON, "OneViewGroups"), groupIndex, group) {
+        json_array_foreach(json_object_get(group, "Instances"), instanceIndex, instanceValue) {
+            json_t *tags = json_object_get(instanceValue, "Tags");
+            const char *status = json_string_value(json_object_get(tags, OV_INSTANCE_STATUS_TAG));
+            if (stringMatch(status, OV_INSTANCE_PENDING) || stringMatch(status, OV_INSTANCE_POSTING) || \
+                (stringMatch(status, OV_INSTANCE_DESTROYED) && !json_object_get(tags, OV_INSTANCE_TASK_TAG))) {
+                json_object_set_new(tags, OV_INSTANCE_STATUS_TAG, json_string(OV_INSTANCE_FAILED));
+                failed++;
+            }
+        }
+    }
+    if (failed != 0) {
+        char *json_text = ovDumpJSON(stateJSON, JSON_ENSURE_ASCII);
+        saveInstanceState(json_text);
+        free(json_text);
+    }
+    json_decref(stateJSON);
+    unlockInstanceState();
+    return failed;
+}
+
 /* These functions query the state of Instances, or can return values assigned to
  * instances.
  */
@@ -297,7 +642,7 @@ json_t *returnObjectFromInstanceID(const char *InstanceID)
 }
 
 
-char *returnInstanceFromState(const char *InstanceID, char *key)
+const char *returnInstanceFromState(const char *InstanceID, char *key)
 {
     json_t *state = openInstanceState();
     if (!state) {
@@ -328,8 +673,8 @@ char *returnInstanceFromState(const char *InstanceID, char *key)
                         // found our instance
                         const char *value = json_string_value(json_object_get(instanceValue, key));
                         if (value) {
-                            // Key exists and has returned a value
-                            char *returnValue = strdup(value);
+                            // Key exists and has returned a value (the canonical copy is never freed)
+                            const char *returnValue = ovInternCanonical(value);
                             json_decref(state);
                             return returnValue;
                         }
@@ -343,59 +688,6 @@ char *returnInstanceFromState(const char *InstanceID, char *key)
     return NULL;
 }
 
-/* This will iterate through the state file and determine
- * if the hardware URI is already applied to a server profile
- * This is because the plugin moves faster than OneView does.
- */
-
-int findUsedHWInState(const char *hardwareURI)
-{
-    json_t *state = openInstanceState();
-    if (!state) {
-        ovPrintError(getPluginTime(), "Can't read State Data\n");
-        return EXIT_FAILURE;
-    }
-    
-    if (state) {
-        size_t groupIndex;
-        json_t *group;
-        json_t *oneViewGroups = json_object_get(state, "OneViewGroups");
-        json_array_foreach(oneViewGroups, groupIndex, group) {
-            
-            json_t *instances = json_object_get(group, "Instances");
-            
-            /* No Instance to compare, so failure to match
-             */
-//            if (json_array_size(instances) == 0) {
-//                ovPrintInfo(getPluginTime(), "No instances or Hardware allocated\n");
-//                return EXIT_SUCCESS;
-//            }
-//            
-            if (instances) {
-                size_t instanceIndex;
-                json_t *instanceValue;
-                
-                json_array_foreach(instances, instanceIndex, instanceValue) {
-                    const char *ID = json_string_value(json_object_get(instanceValue, "ID"));
-                    json_t *tags = json_object_get(instanceValue, "Tags");
-                    const char *stateURI = json_string_value(json_object_get(tags, "hw_uri"));
-                    if (stringMatch(stateURI,hardwareURI)) {
-                        // Found the hardware URI applied to a server profile
-                        char ovOutput[1024];
-                        snprintf(ovOutput, 1024, "Hardware belongs to %s\n", ID);
-                        ovPrintDebug(getPluginTime(), ovOutput);
-                        json_decref(state);
-                        return EXIT_FAILURE;
-                    }
-                }
-            }
-        }
-    }
-    // Not found in our state
-    json_decref(state);
-    return EXIT_SUCCESS;
-}
-
  /*  In the event a describe is done directly to the plugin, then a group wont be specified
   *  For this will take ALL instances from ALL groups and compile a full list of instances
   *  that the plugin is managing.
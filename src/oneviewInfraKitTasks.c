@@ -0,0 +1,444 @@
+
+// oneviewInfraKitTasks.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#include "oneviewInfraKitTasks.h"
+#include "oneviewInfraKitState.h"
+#include "oneviewInfraKitLedger.h"
+#include "oneviewInfraKitPlugin.h"
+#include "oneviewInfraKitConsole.h"
+#include "oneviewIntern.h"
+#include "oneviewExtract.h"
+#include "oneviewSnapshot.h"
+#include "oneview.h"
+#include "oneviewSessions.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+
+// What the poll found out about a task
+#define TASK_RUNNING    0
+#define TASK_COMPLETED  1
+#define TASK_FAILED     2
+#define TASK_LOST       3   // Timed out, OneView didn't report it finishing
+
+pthread_mutex_t trackerLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t trackerWake = PTHREAD_COND_INITIALIZER; // Signalled when a task is tracked
+
+static ovTrackedTask *tracked;
+static size_t trackedCount;
+static size_t trackedSize;
+static int trackerStarted;
+
+// The session the tracker polls with (attached to the session of the tasks)
+static oneviewSession *trackerSession;
+
+static double monotonicSeconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+}
+
+/* OneView replies to an asynchronous operation with the task resource, the uri of the task is
+ * returned (NULL if the response isn't a task) and must be freed
+ */
+
+char *ovTaskFromResponse(const char *response)
+{
+    if (!response) {
+        return NULL;
+    }
+    ovJSONSlice category, uri;
+    ovJSONField fields[] = {
+        { "category", &category },
+        { "uri", &uri }
+    };
+    if (ovExtractFields(response, strlen(response), fields, 2) == -1 || !ovSliceEquals(&category, "tasks") ||
+        uri.type != OV_JSON_STRING) {
+        return NULL;
+    }
+    return ovSliceDup(&uri);
+}
+
+static ssize_t findTracked(const char *taskURI)
+{
+    for (size_t i = 0; i < trackedCount; i++) {
+        if (strcmp(tracked[i].taskURI, taskURI) == 0) {
+            return (ssize_t)i;
+        }
+    }
+    return -1;
+}
+
+/* Track a task until it finishes (the task uri and instance name are copied), a task that is
+ * already tracked is left as it is
+ */
+
+int ovTrackTask(int kind, const char *taskURI, const char *instanceName, int resourceURI, int address, int username)
+{
+    if (!taskURI) {
+        return EXIT_FAILURE;
+    }
+    pthread_mutex_lock(&trackerLock);
+    if (findTracked(taskURI) != -1) {
+        pthread_mutex_unlock(&trackerLock);
+        return EXIT_SUCCESS;
+    }
+    if (trackedCount == trackedSize) {
+        size_t newSize = trackedSize ? trackedSize * 2 : OV_TASK_POLL_BATCH;
+        ovTrackedTask *newTracked = realloc(tracked, sizeof(ovTrackedTask) * newSize);
+        if (!newTracked) {
+            pthread_mutex_unlock(&trackerLock);
+            ovPrintError(getPluginTime(), "Unable to track OneView task\n");
+            return EXIT_FAILURE;
+        }
+        tracked = newTracked;
+        trackedSize = newSize;
+    }
+    char *taskCopy = strdup(taskURI);
+    char *instanceCopy = instanceName ? strdup(instanceName) : NULL;
+    if (!taskCopy || (instanceName && !instanceCopy)) {
+        pthread_mutex_unlock(&trackerLock);
+        free(taskCopy);
+        free(instanceCopy);
+        ovPrintError(getPluginTime(), "Unable to track OneView task\n");
+        return EXIT_FAILURE;
+    }
+    ovTrackedTask *task = &tracked[trackedCount++];
+    task->kind = kind;
+    task->taskURI = taskCopy;
+    task->instanceName = instanceCopy;
+    task->resourceURI = resourceURI;
+    task->address = address;
+    task->username = username;
+    task->started = monotonicSeconds();
+    task->interval = OV_TASK_POLL_MIN_MS;
+    task->nextCheck = task->started + (OV_TASK_POLL_MIN_MS / 1000.0);
+    pthread_cond_signal(&trackerWake);
+    pthread_mutex_unlock(&trackerLock);
+    return EXIT_SUCCESS;
+}
+
+int ovTaskIsTracked(const char *taskURI)
+{
+    if (!taskURI) {
+        return 0;
+    }
+    pthread_mutex_lock(&trackerLock);
+    int found = (findTracked(taskURI) != -1);
+    pthread_mutex_unlock(&trackerLock);
+    return found;
+}
+
+size_t ovTasksTracked()
+{
+    pthread_mutex_lock(&trackerLock);
+    size_t count = trackedCount;
+    pthread_mutex_unlock(&trackerLock);
+    return count;
+}
+
+/* Wait until a task is due to be checked and take a copy of it along with the other tasks
+ * (on the same session) that are due within the shortest interval, so that tasks started
+ * around the same time are checked with one request. The copies share the strings of the
+ * tracked tasks, which are only freed by rescheduleTasks (on this thread).
+ */
+
+static size_t takeDueTasks(ovTrackedTask *batch)
+{
+    pthread_mutex_lock(&trackerLock);
+    while (1) {
+        if (trackedCount == 0) {
+            pthread_cond_wait(&trackerWake, &trackerLock);
+            continue;
+        }
+        size_t earliest = 0;
+        for (size_t i = 1; i < trackedCount; i++) {
+            if (tracked[i].nextCheck < tracked[earliest].nextCheck) {
+                earliest = i;
+            }
+        }
+        double now = monotonicSeconds();
+        if (tracked[earliest].nextCheck > now) {
+            struct timespec wake;
+            wake.tv_sec = (time_t)tracked[earliest].nextCheck;
+            wake.tv_nsec = (long)((tracked[earliest].nextCheck - (double)wake.tv_sec) * 1e9);
+            pthread_cond_timedwait(&trackerWake, &trackerLock, &wake);
+            continue;
+        }
+        size_t count = 0;
+        batch[count++] = tracked[earliest];
+        double dueBefore = now + (OV_TASK_POLL_MIN_MS / 1000.0);
+        for (size_t i = 0; i < trackedCount && count < OV_TASK_POLL_BATCH; i++) {
+            if (i != earliest && tracked[i].nextCheck <= dueBefore && \
+                tracked[i].address == batch[0].address && tracked[i].username == batch[0].username) {
+                batch[count++] = tracked[i];
+            }
+        }
+        pthread_mutex_unlock(&trackerLock);
+        return count;
+    }
+}
+
+static oneviewSession *sessionForTask(const ovTrackedTask *task)
+{
+    if (!trackerSession) {
+        trackerSession = initSession();
+        if (!trackerSession) {
+            return NULL;
+        }
+    }
+    if (ovSessionAttach(trackerSession, ovInternString(task->address), ovInternString(task->username), NULL) == EXIT_FAILURE) {
+        return NULL;
+    }
+    return trackerSession;
+}
+
+static int outcomeOfState(const ovJSONSlice *taskState)
+{
+    // Warning is a completed task that has something to report
+    if (ovSliceEquals(taskState, "Completed") || ovSliceEquals(taskState, "Warning")) {
+        return TASK_COMPLETED;
+    }
+    if (ovSliceEquals(taskState, "Error") || ovSliceEquals(taskState, "Terminated") || \
+        ovSliceEquals(taskState, "Killed") || ovSliceEquals(taskState, "Interrupted")) {
+        return TASK_FAILED;
+    }
+    return TASK_RUNNING;
+}
+
+/* Check every task of the batch with one GET of /rest/tasks (filtered to their uris), the
+ * outcome of each task is placed in outcomes
+ */
+
+static void pollTasks(ovTrackedTask *batch, size_t count, int *outcomes)
+{
+    double now = monotonicSeconds();
+    for (size_t i = 0; i < count; i++) {
+        outcomes[i] = (now - batch[i].started > OV_TASK_TIMEOUT_S) ? TASK_LOST : TASK_RUNNING;
+    }
+    oneviewSession *session = sessionForTask(&batch[0]);
+    if (!session) {
+        return;
+    }
+
+    // uri='<task>' OR uri='<task>' ...
+    size_t filterSize = 1;
+    for (size_t i = 0; i < count; i++) {
+        filterSize += strlen(batch[i].taskURI) + 12;
+    }
+    char *filter = malloc(filterSize);
+    if (!filter) {
+        return;
+    }
+    size_t filterLength = 0;
+    for (size_t i = 0; i < count; i++) {
+        filterLength += snprintf(filter + filterLength, filterSize - filterLength, "%suri='%s'", \
+                                 i ? " OR " : "", batch[i].taskURI);
+    }
+    oneviewQuery query = {0};
+    query.filter = filter;
+    query.count = (int)count;
+    char *rawJSON = oneViewQuery(session, &query, "/rest/tasks");
+    free(filter);
+    if (!rawJSON) {
+        ovPrintWarning(getPluginTime(), "Unable to check the progress of OneView tasks\n");
+        return;
+    }
+
+    ovJSONSlice members, member, uri, taskState, taskErrors, taskError, message;
+    ovJSONField pageFields[] = { { "members", &members } };
+    ovJSONField memberFields[] = {
+        { "uri", &uri },
+        { "taskState", &taskState },
+        { "taskErrors", &taskErrors }
+    };
+    ovJSONField errorFields[] = { { "message", &message } };
+    size_t offset = 0;
+    if (ovExtractFields(rawJSON, strlen(rawJSON), pageFields, 1) == 1) {
+        while (ovNextElement(&members, &offset, &member)) {
+            if (ovExtractFields(member.start, member.length, memberFields, 3) < 2) {
+                continue;
+            }
+            for (size_t i = 0; i < count; i++) {
+                if (!ovSliceEquals(&uri, batch[i].taskURI)) {
+                    continue;
+                }
+                outcomes[i] = outcomeOfState(&taskState);
+                if (outcomes[i] == TASK_FAILED) {
+                    // Report the first error of the task
+                    size_t errorOffset = 0;
+                    char errorMessage[512] = "";
+                    if (ovNextElement(&taskErrors, &errorOffset, &taskError) && \
+                        ovExtractFields(taskError.start, taskError.length, errorFields, 1) == 1) {
+                        ovSliceCopy(&message, errorMessage, sizeof(errorMessage));
+                    }
+                    char ovOutput[1024];
+                    snprintf(ovOutput, sizeof(ovOutput), "Task %s failed => %s\n", batch[i].taskURI, errorMessage);
+                    ovPrintWarning(getPluginTime(), ovOutput);
+                }
+            }
+        }
+    }
+    free(rawJSON);
+}
+
+/* The instances that were destroyed while their profile was being created (see
+ * destroyInstanceInState) have the profile deleted now that it has been created, and are
+ * removed from the state. instanceIDs[i] is the instance of batch[taskOf[i]].
+ */
+
+static void deleteDestroyedProfiles(ovTrackedTask *batch, const char **instanceIDs, const size_t *taskOf, const char *destroyed, size_t count)
+{
+    const char *removed[OV_TASK_POLL_BATCH];
+    size_t removedCount = 0;
+    oneviewSession *session = NULL;
+    for (size_t i = 0; i < count; i++) {
+        if (!destroyed[i]) {
+            continue;
+        }
+        const ovTrackedTask *task = &batch[taskOf[i]];
+        if (!session) {
+            session = sessionForTask(task);
+        }
+        // The profile uri is freed by ovDeleteProfile
+        char *profileURI = session ? serverProfileFromHardwareURI(session, ovInternString(task->resourceURI)) : NULL;
+        char *response = NULL;
+        if (profileURI && ovDeleteProfile(session, profileURI, &response) == EXIT_SUCCESS) {
+            char *taskURI = ovTaskFromResponse(response);
+            ovTrackTask(OV_TASK_PROFILE_DELETE, taskURI, NULL, task->resourceURI, task->address, task->username);
+            free(taskURI);
+        } else if (profileURI) {
+            char ovOutput[1024];
+            snprintf(ovOutput, sizeof(ovOutput), "Unable to delete the profile of destroyed instance %s\n", instanceIDs[i]);
+            ovPrintError(getPluginTime(), ovOutput);
+        }
+        free(response);
+        removed[removedCount++] = instanceIDs[i];
+    }
+    if (removedCount != 0 && removeInstancesFromState(removed, removedCount) == EXIT_FAILURE) {
+        ovPrintError(getPluginTime(), "Unable to remove the destroyed instances\n");
+    }
+}
+
+/* Act on the tasks that have finished, the instances that were being created have their
+ * status set with one update of the state and the cached hardware is refreshed so that the
+ * next reservation sees the hardware as it is now.
+ */
+
+static void finishTasks(ovTrackedTask *batch, size_t count, const int *outcomes)
+{
+    const char *instanceIDs[OV_TASK_POLL_BATCH];
+    const char *statuses[OV_TASK_POLL_BATCH];
+    size_t taskOf[OV_TASK_POLL_BATCH];
+    char destroyed[OV_TASK_POLL_BATCH];
+    size_t instanceCount = 0, finished = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (outcomes[i] == TASK_RUNNING) {
+            continue;
+        }
+        finished++;
+        if (batch[i].kind == OV_TASK_PROFILE_CREATE && batch[i].instanceName) {
+            taskOf[instanceCount] = i;
+            instanceIDs[instanceCount] = batch[i].instanceName;
+            // A lost task has its status removed, Describe then checks the hardware instead
+            statuses[instanceCount++] = (outcomes[i] == TASK_COMPLETED) ? OV_INSTANCE_APPLIED : \
+                                        (outcomes[i] == TASK_FAILED) ? OV_INSTANCE_FAILED : NULL;
+        }
+        // A server is leased while it is powered off (see reserveFreeHardware)
+        if (batch[i].kind == OV_TASK_POWER_OFF) {
+            ovLedgerRelease(batch[i].resourceURI, NULL);
+        }
+        if (outcomes[i] == TASK_LOST) {
+            char ovOutput[1024];
+            snprintf(ovOutput, sizeof(ovOutput), "Task %s hasn't finished after %d seconds, it is no longer tracked\n", \
+                     batch[i].taskURI, OV_TASK_TIMEOUT_S);
+            ovPrintWarning(getPluginTime(), ovOutput);
+        }
+    }
+    if (finished == 0) {
+        return;
+    }
+    if (instanceCount && setInstanceStatuses(instanceIDs, statuses, NULL, instanceCount, destroyed) == EXIT_SUCCESS) {
+        deleteDestroyedProfiles(batch, instanceIDs, taskOf, destroyed, instanceCount);
+    }
+    ovInvalidateHardwareSnapshot();
+
+    char ovOutput[1024];
+    snprintf(ovOutput, sizeof(ovOutput), "%zu of %zu OneView tasks finished\n", finished, count);
+    ovPrintDebug(getPluginTime(), ovOutput);
+}
+
+/* Finished tasks stop being tracked, the others are checked again after twice the interval
+ */
+
+static void rescheduleTasks(ovTrackedTask *batch, size_t count, const int *outcomes)
+{
+    pthread_mutex_lock(&trackerLock);
+    double now = monotonicSeconds();
+    for (size_t i = 0; i < count; i++) {
+        ssize_t position = findTracked(batch[i].taskURI);
+        if (position == -1) {
+            continue;
+        }
+        if (outcomes[i] != TASK_RUNNING) {
+            free(tracked[position].taskURI);
+            free(tracked[position].instanceName);
+            tracked[position] = tracked[--trackedCount];
+            continue;
+        }
+        long interval = tracked[position].interval * 2;
+        tracked[position].interval = (interval > OV_TASK_POLL_MAX_MS) ? OV_TASK_POLL_MAX_MS : interval;
+        tracked[position].nextCheck = now + (tracked[position].interval / 1000.0);
+    }
+    pthread_mutex_unlock(&trackerLock);
+}
+
+static void *trackerThread(void *argument)
+{
+    ovTrackedTask batch[OV_TASK_POLL_BATCH];
+    int outcomes[OV_TASK_POLL_BATCH];
+    while (1) {
+        size_t count = takeDueTasks(batch);
+        pollTasks(batch, count, outcomes);
+        finishTasks(batch, count, outcomes);
+        rescheduleTasks(batch, count, outcomes);
+    }
+    return NULL;
+}
+
+int ovTaskTrackerStart()
+{
+    if (trackerStarted) {
+        return EXIT_FAILURE;
+    }
+    // The tracker waits for the next check against the monotonic clock
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&trackerWake, &attributes);
+    pthread_condattr_destroy(&attributes);
+
+    pthread_t tracker;
+    if (pthread_create(&tracker, NULL, trackerThread, NULL) != 0) {
+        ovPrintError(getPluginTime(), "Unable to start the OneView task tracker\n");
+        return EXIT_FAILURE;
+    }
+    pthread_detach(tracker);
+    trackerStarted = 1;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+
+// oneviewIntern.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+
+#include "oneviewIntern.h"
+#include "oneviewHash.h"
+#include "oneviewInfraKitConsole.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The same hardware, profile and template uris (and names) are seen on every request, so
+ * rather than every structure holding its own copy they are interned. Each distinct value is
+ * copied once into a block of strings that is never moved or freed, and is given an id that
+ * indexes internStrings. Ids can be compared directly and the canonical strings can be held
+ * by anything without being freed.
+ */
+
+oneviewHashIndex internIndex;       // canonical string -> id
+const char **internStrings = NULL;  // id -> canonical string
+size_t internAllocated = 0;
+int internCount = 1;                // id 0 is OV_INTERN_NONE
+
+char *internBlock = NULL;           // Block that new strings are copied into
+size_t internBlockUsed = 0;
+size_t internBlockSize = 0;
+
+pthread_mutex_t internLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Copy a string into the current block (starting a new block if it won't fit), values that
+ * are larger than a block are given a block of their own. Called with the internLock held.
+ */
+
+static const char *copyIntoBlock(const char *value, size_t length)
+{
+    if (length > OV_INTERN_BLOCK_SIZE) {
+        return strdup(value);
+    }
+    if (!internBlock || (internBlockUsed + length) > internBlockSize) {
+        internBlock = malloc(OV_INTERN_BLOCK_SIZE);
+        if (!internBlock) {
+            return NULL;
+        }
+        internBlockUsed = 0;
+        internBlockSize = OV_INTERN_BLOCK_SIZE;
+    }
+    char *copy = internBlock + internBlockUsed;
+    memcpy(copy, value, length);
+    internBlockUsed += length;
+    return copy;
+}
+
+/* Returns the id of a value, interning it if it hasn't been seen before
+ */
+
+int ovIntern(const char *value)
+{
+    if (!value) {
+        return OV_INTERN_NONE;
+    }
+    pthread_mutex_lock(&internLock);
+    if (internIndex.size == 0 && initHashIndex(&internIndex, 1024) == EXIT_FAILURE) {
+        pthread_mutex_unlock(&internLock);
+        return OV_INTERN_NONE;
+    }
+    int id = ovHashFind(&internIndex, value);
+    if (id == OV_HASH_NOT_FOUND) {
+        if ((size_t)internCount >= internAllocated) {
+            size_t newAllocated = internAllocated ? internAllocated * 2 : 1024;
+            const char **newStrings = realloc(internStrings, newAllocated * sizeof(const char *));
+            if (!newStrings) {
+                pthread_mutex_unlock(&internLock);
+                return OV_INTERN_NONE;
+            }
+            newStrings[OV_INTERN_NONE] = NULL;
+            internStrings = newStrings;
+            internAllocated = newAllocated;
+        }
+        const char *canonical = copyIntoBlock(value, strlen(value) + 1);
+        if (!canonical || ovHashInsert(&internIndex, canonical, internCount) == EXIT_FAILURE) {
+            pthread_mutex_unlock(&internLock);
+            ovPrintError(getPluginTime(), "Unable to intern string\n");
+            return OV_INTERN_NONE;
+        }
+        id = internCount++;
+        internStrings[id] = canonical;
+    }
+    pthread_mutex_unlock(&internLock);
+    return id;
+}
+
+/* Returns the id of a value only if it has already been interned, otherwise OV_INTERN_NONE
+ * (a value that has never been interned can't be equal to any interned value)
+ */
+
+int ovInternFind(const char *value)
+{
+    int id = OV_INTERN_NONE;
+    if (value) {
+        pthread_mutex_lock(&internLock);
+        int found = ovHashFind(&internIndex, value);
+        if (found != OV_HASH_NOT_FOUND) {
+            id = found;
+        }
+        pthread_mutex_unlock(&internLock);
+    }
+    return id;
+}
+
+const char *ovInternString(int id)
+{
+    const char *value = NULL;
+    pthread_mutex_lock(&internLock);
+    if (id > OV_INTERN_NONE && id < internCount) {
+        value = internStrings[id];
+    }
+    pthread_mutex_unlock(&internLock);
+    return value;
+}
+
+/* Returns the canonical copy of a value (interning it if needed), which is never freed
+ */
+
+const char *ovInternCanonical(const char *value)
+{
+    return ovInternString(ovIntern(value));
+}
+
+int ovInternCount()
+{
+    pthread_mutex_lock(&internLock);
+    int count = internCount;
+    pthread_mutex_unlock(&internLock);
+    return count;
+}
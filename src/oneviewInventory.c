@@ -0,0 +1,394 @@
+
+// oneviewInventory.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+
+#include "oneviewInventory.h"
+#include "oneviewJSONParse.h"
+#include "oneviewInfraKitConsole.h"
+#include "oneviewArena.h"
+
+#include <jansson.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* The inventory holds the server-hardware and server-profiles resources in memory, keyed
+ * by their uri. It is filled by a full re-synchronisation from the REST API and then kept
+ * current by create, update and delete messages from the OneView state-change message bus.
+ *
+ * The message bus itself is AMQP (with certificate authentication), so the subscriber reads
+ * the message bodies from a relay socket that writes one JSON message per line. The relay can
+ * be replaced by the stand-in broker in oneviewInventoryBroker.c for testing.
+ *
+ * Only the subscriber thread and the functions below touch the inventory, all REST calls
+ * (the re-synchronisation) happen on the thread that calls inventoryResync().
+ */
+
+json_t *hardwareInventory = NULL; // uri -> server-hardware resource
+json_t *profileInventory = NULL;  // uri -> server-profile resource
+
+pthread_mutex_t inventoryLock = PTHREAD_MUTEX_INITIALIZER;
+
+char *argSubscriberSocketPath = NULL;
+char *subscriberSocketPath = NULL;
+int subscriberEnabled = 0;
+int subscriberConnected = 0;
+time_t lastResync = 0;
+unsigned long changeGeneration = 0; // Incremented on every change to the inventory
+long resyncInterval = OV_INVENTORY_RESYNC;
+
+int setInventorySocketPath(char *path)
+{
+    if (path && (strlen(path) > 1)) {
+        argSubscriberSocketPath = path;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
+
+char *getInventorySocketPath()
+{
+    return argSubscriberSocketPath;
+}
+
+int setInventoryResyncInterval(long seconds)
+{
+    if (seconds > 0) {
+        resyncInterval = seconds;
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
+
+/* The inventory can only be trusted when the subscriber is connected to the change feed and
+ * a full re-synchronisation has happened recently (a missed message will be corrected by the
+ * next re-synchronisation)
+ */
+
+int inventoryIsLive()
+{
+    pthread_mutex_lock(&inventoryLock);
+    int live = subscriberConnected && (lastResync != 0) && ((time(NULL) - lastResync) < resyncInterval);
+    pthread_mutex_unlock(&inventoryLock);
+    return live;
+}
+
+int inventoryNeedsResync()
+{
+    pthread_mutex_lock(&inventoryLock);
+    int needed = subscriberEnabled && subscriberConnected && ((lastResync == 0) || ((time(NULL) - lastResync) >= resyncInterval));
+    pthread_mutex_unlock(&inventoryLock);
+    return needed;
+}
+
+/* Load every member of a collection into an object keyed by uri, following nextPageUri
+ */
+
+json_t *inventoryLoadCollection(oneviewSession *session, char *(*queryFunction)(oneviewSession *, oneviewQuery *))
+{
+    json_t *collection = json_object();
+    char *rawJSON = queryFunction(session, NULL);
+    if (!rawJSON) {
+        json_decref(collection);
+        return NULL;
+    }
+    while (rawJSON) {
+        json_t *pageJSON;
+        json_error_t error;
+        char *nextPage = NULL;
+        pageJSON = json_loads(rawJSON, 0, &error);
+        free(rawJSON);
+        rawJSON = NULL;
+        if (!pageJSON) {
+            json_decref(collection);
+            return NULL;
+        }
+        size_t memberIndex;
+        json_t *memberValue;
+        json_t *memberArray = json_object_get(pageJSON, "members");
+        json_array_foreach(memberArray, memberIndex, memberValue) {
+            const char *uri = json_string_value(json_object_get(memberValue, "uri"));
+            if (uri) {
+                json_object_set(collection, uri, memberValue);
+            }
+        }
+        const char *nextPageUri = json_string_value(json_object_get(pageJSON, "nextPageUri"));
+        if (nextPageUri && json_array_size(memberArray) != 0) {
+            nextPage = strdup(nextPageUri);
+        }
+        json_decref(pageJSON);
+        if (nextPage) {
+            rawJSON = ovQueryWithURI(session, nextPage);
+            free(nextPage);
+        }
+    }
+    return collection;
+}
+
+int inventoryResync(oneviewSession *session)
+{
+    json_t *newHardware = inventoryLoadCollection(session, ovQueryServerHardware);
+    json_t *newProfiles = inventoryLoadCollection(session, ovQueryServerProfiles);
+    if (!newHardware || !newProfiles) {
+        json_decref(newHardware);
+        json_decref(newProfiles);
+        ovPrintWarning(getPluginTime(), "Unable to re-synchronise the inventory\n");
+        return EXIT_FAILURE;
+    }
+    // A resync can be started by a request, the inventory has to outlive the request arena
+    newHardware = ovArenaPromote(newHardware);
+    newProfiles = ovArenaPromote(newProfiles);
+    if (!newHardware || !newProfiles) {
+        json_decref(newHardware);
+        json_decref(newProfiles);
+        return EXIT_FAILURE;
+    }
+
+    pthread_mutex_lock(&inventoryLock);
+    json_decref(hardwareInventory);
+    json_decref(profileInventory);
+    hardwareInventory = newHardware;
+    profileInventory = newProfiles;
+    lastResync = time(NULL);
+    changeGeneration++;
+    pthread_mutex_unlock(&inventoryLock);
+
+    char ovOutput[1024];
+    snprintf(ovOutput, 1024, "Inventory re-synchronised, %zu servers %zu profiles\n", json_object_size(newHardware), json_object_size(newProfiles));
+    ovPrintInfo(getPluginTime(), ovOutput);
+    return EXIT_SUCCESS;
+}
+
+/* A profile change is reflected in the hardware it is assigned to, so that a lookup of the
+ * hardware is correct even if the hardware message hasn't arrived yet.
+ */
+
+static void applyProfileToHardware(json_t *profile, int deleted)
+{
+    const char *profileURI = json_string_value(json_object_get(profile, "uri"));
+    const char *hardwareURI = json_string_value(json_object_get(profile, "serverHardwareUri"));
+    json_t *hardware = json_object_get(hardwareInventory, hardwareURI);
+    if (!hardware || !profileURI) {
+        return;
+    }
+    if (deleted) {
+        if (stringMatch(json_string_value(json_object_get(hardware, "serverProfileUri")), profileURI)) {
+            json_object_set_new(hardware, "serverProfileUri", json_null());
+        }
+    } else {
+        json_object_set_new(hardware, "serverProfileUri", json_string(profileURI));
+    }
+}
+
+/* Apply a single state-change message, e.g.
+ * {"changeType":"Updated","resourceUri":"/rest/server-hardware/..","resource":{...}}
+ */
+
+int inventoryApplyEvent(const char *message)
+{
+    json_t *eventJSON;
+    json_error_t error;
+    eventJSON = json_loads(message, 0, &error);
+    if (!eventJSON) {
+        ovPrintWarning(getPluginTime(), "Unable to parse state-change message\n");
+        return EXIT_FAILURE;
+    }
+    const char *changeType = json_string_value(json_object_get(eventJSON, "changeType"));
+    const char *resourceURI = json_string_value(json_object_get(eventJSON, "resourceUri"));
+    json_t *resource = json_object_get(eventJSON, "resource");
+    if (!resourceURI) {
+        resourceURI = json_string_value(json_object_get(resource, "uri"));
+    }
+    if (!changeType || !resourceURI) {
+        json_decref(eventJSON);
+        return EXIT_FAILURE;
+    }
+
+    int result = EXIT_SUCCESS;
+    pthread_mutex_lock(&inventoryLock);
+    int isHardware = (strncmp(resourceURI, "/rest/server-hardware/", strlen("/rest/server-hardware/")) == 0);
+    int isProfile = (strncmp(resourceURI, "/rest/server-profiles/", strlen("/rest/server-profiles/")) == 0);
+    json_t *inventory = isHardware ? hardwareInventory : (isProfile ? profileInventory : NULL);
+
+    if (!inventory) {
+        // Either a category we don't track, or nothing has been loaded yet
+        result = EXIT_FAILURE;
+    } else if (stringMatch(changeType, OV_CHANGE_DELETED)) {
+        json_t *previous = json_object_get(inventory, resourceURI);
+        if (previous && isProfile) {
+            applyProfileToHardware(previous, 1);
+        }
+        json_object_del(inventory, resourceURI);
+    } else if ((stringMatch(changeType, OV_CHANGE_CREATED) || stringMatch(changeType, OV_CHANGE_UPDATED)) && json_is_object(resource)) {
+        json_object_set(inventory, resourceURI, resource);
+        if (isProfile) {
+            applyProfileToHardware(resource, 0);
+        }
+    } else {
+        result = EXIT_FAILURE;
+    }
+    if (result == EXIT_SUCCESS) {
+        changeGeneration++;
+    }
+    pthread_mutex_unlock(&inventoryLock);
+
+    if (result == EXIT_SUCCESS) {
+        char ovOutput[1024];
+        snprintf(ovOutput, 1024, "Inventory %s => %s\n", changeType, resourceURI);
+        ovPrintDebug(getPluginTime(), ovOutput);
+    }
+    json_decref(eventJSON);
+    return result;
+}
+
+oneviewHardware *inventoryGetServerHardware(const char *hardwareURI)
+{
+    oneviewHardware *hardware = NULL;
+    pthread_mutex_lock(&inventoryLock);
+    json_t *hardwareJSON = json_object_get(hardwareInventory, hardwareURI);
+    if (hardwareJSON) {
+        hardware = ovHardwareFromJSON(hardwareJSON);
+    }
+    pthread_mutex_unlock(&inventoryLock);
+    return hardware;
+}
+
+/* A copy of the server-hardware inventory (uri -> resource) that can be used without holding
+ * the lock, along with the generation of the inventory it was copied from
+ */
+
+json_t *inventoryCopyHardware(unsigned long *generation)
+{
+    pthread_mutex_lock(&inventoryLock);
+    json_t *copy = json_deep_copy(hardwareInventory);
+    if (generation) {
+        *generation = changeGeneration;
+    }
+    pthread_mutex_unlock(&inventoryLock);
+    return copy;
+}
+
+unsigned long inventoryGeneration()
+{
+    pthread_mutex_lock(&inventoryLock);
+    unsigned long generation = changeGeneration;
+    pthread_mutex_unlock(&inventoryLock);
+    return generation;
+}
+
+/* The subscriber thread connects to the relay socket and applies every line it reads as a
+ * state-change message. If the connection drops the inventory is no longer live (lookups go
+ * back to REST) and the subscriber will attempt to reconnect.
+ */
+
+#define SUBSCRIBER_BUFFER_SIZE (1024 * 1024)
+#define SUBSCRIBER_RECONNECT 5
+
+static int connectToRelay(const char *socketPath)
+{
+    int relaySocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (relaySocket == -1) {
+        return -1;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath, sizeof(addr.sun_path)-1);
+    if (connect(relaySocket, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+        close(relaySocket);
+        return -1;
+    }
+    return relaySocket;
+}
+
+static void setSubscriberConnected(int connected)
+{
+    pthread_mutex_lock(&inventoryLock);
+    subscriberConnected = connected;
+    if (!connected) {
+        // Force a full re-synchronisation once the feed is back
+        lastResync = 0;
+    }
+    pthread_mutex_unlock(&inventoryLock);
+}
+
+static void *subscriberThread(void *argument)
+{
+    char *buffer = malloc(SUBSCRIBER_BUFFER_SIZE);
+    if (!buffer) {
+        return NULL;
+    }
+    while (1) {
+        int relaySocket = connectToRelay(subscriberSocketPath);
+        if (relaySocket == -1) {
+            sleep(SUBSCRIBER_RECONNECT);
+            continue;
+        }
+        ovPrintInfo(getPluginTime(), "Connected to state-change message relay\n");
+        setSubscriberConnected(1);
+
+        size_t used = 0;
+        ssize_t received;
+        while ((received = recv(relaySocket, buffer + used, SUBSCRIBER_BUFFER_SIZE - used - 1, 0)) > 0) {
+            used += received;
+            buffer[used] = '\0';
+            // Apply every complete line, then move any partial line to the start of the buffer
+            char *lineStart = buffer;
+            char *lineEnd;
+            while ((lineEnd = strchr(lineStart, '\n'))) {
+                *lineEnd = '\0';
+                if (lineEnd != lineStart) {
+                    inventoryApplyEvent(lineStart);
+                }
+                lineStart = lineEnd + 1;
+            }
+            used = (buffer + used) - lineStart;
+            memmove(buffer, lineStart, used);
+            if (used == SUBSCRIBER_BUFFER_SIZE - 1) {
+                ovPrintWarning(getPluginTime(), "State-change message too large, discarding\n");
+                used = 0;
+            }
+        }
+        close(relaySocket);
+        setSubscriberConnected(0);
+        ovPrintWarning(getPluginTime(), "Disconnected from state-change message relay\n");
+        sleep(SUBSCRIBER_RECONNECT);
+    }
+    free(buffer);
+    return NULL;
+}
+
+int inventoryStartSubscriber(const char *socketPath)
+{
+    if (!socketPath || subscriberEnabled) {
+        return EXIT_FAILURE;
+    }
+    subscriberSocketPath = strdup(socketPath);
+    pthread_t subscriber;
+    if (pthread_create(&subscriber, NULL, subscriberThread, NULL) != 0) {
+        ovPrintError(getPluginTime(), "Unable to start state-change subscriber\n");
+        return EXIT_FAILURE;
+    }
+    pthread_detach(subscriber);
+    subscriberEnabled = 1;
+
+    char ovOutput[1024];
+    snprintf(ovOutput, 1024, "State-change subscriber using => %s\n", socketPath);
+    ovPrintInfo(getPluginTime(), ovOutput);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+
+// oneviewInventoryBroker.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+
+#include "oneviewInventory.h"
+#include "oneviewInfraKitConsole.h"
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* A stand-in for the state-change message bus, used for testing the subscriber without an
+ * appliance. It listens on a UNIX socket, every subscriber that connects is sent the messages
+ * in the events file (one JSON message per line) and then any messages that are written to
+ * stdin while the broker is running.
+ *
+ * ./infrakit-instance-oneview broker <socket> [events file]
+ */
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define BROKER_MAX_SUBSCRIBERS 64
+#define BROKER_LINE_SIZE (1024 * 1024)
+
+static int sendAll(int socket, const char *data, size_t length)
+{
+    while (length > 0) {
+        ssize_t sent = send(socket, data, length, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return EXIT_FAILURE;
+        }
+        data += sent;
+        length -= sent;
+    }
+    return EXIT_SUCCESS;
+}
+
+static int replayEvents(int socket, const char *eventsPath)
+{
+    if (!eventsPath) {
+        return EXIT_SUCCESS;
+    }
+    FILE *fp = fopen(eventsPath, "r");
+    if (!fp) {
+        ovPrintError(getPluginTime(), "Unable to open events file\n");
+        return EXIT_FAILURE;
+    }
+    char *line = malloc(BROKER_LINE_SIZE);
+    int result = EXIT_SUCCESS;
+    while (line && fgets(line, BROKER_LINE_SIZE, fp)) {
+        if (sendAll(socket, line, strlen(line)) == EXIT_FAILURE) {
+            result = EXIT_FAILURE;
+            break;
+        }
+    }
+    free(line);
+    fclose(fp);
+    return result;
+}
+
+int startInventoryBroker(const char *socketPath, const char *eventsPath)
+{
+    if (!socketPath) {
+        return EXIT_FAILURE;
+    }
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener == -1) {
+        perror("socket error");
+        return EXIT_FAILURE;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath, sizeof(addr.sun_path)-1);
+    unlink(socketPath);
+    if (bind(listener, (struct sockaddr*)&addr, sizeof(addr)) == -1 || listen(listener, SOMAXCONN) == -1) {
+        perror("bind error");
+        close(listener);
+        return EXIT_FAILURE;
+    }
+
+    char ovOutput[1024];
+    snprintf(ovOutput, 1024, "Stand-in broker listening on => %s\n", socketPath);
+    ovPrintInfo(getPluginTime(), ovOutput);
+
+    struct pollfd fds[BROKER_MAX_SUBSCRIBERS + 2];
+    int subscriberCount = 0;
+    int inputOpen = 1;
+    char *input = malloc(BROKER_LINE_SIZE);
+    size_t inputUsed = 0;
+    if (!input) {
+        close(listener);
+        return EXIT_FAILURE;
+    }
+
+    while (1) {
+        // [0] listener, [1] stdin, [2..] subscribers (only watched for hang-ups)
+        fds[0].fd = listener;
+        fds[0].events = POLLIN;
+        fds[1].fd = inputOpen ? STDIN_FILENO : -1;
+        fds[1].events = POLLIN;
+        for (int i = 0; i < subscriberCount; i++) {
+            fds[i + 2].events = POLLIN;
+        }
+        if (poll(fds, subscriberCount + 2, -1) == -1) {
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int subscriber = accept(listener, NULL, NULL);
+            if (subscriber != -1) {
+                if (subscriberCount == BROKER_MAX_SUBSCRIBERS || replayEvents(subscriber, eventsPath) == EXIT_FAILURE) {
+                    close(subscriber);
+                } else {
+                    fds[subscriberCount + 2].fd = subscriber;
+                    fds[subscriberCount + 2].revents = 0;
+                    subscriberCount++;
+                    ovPrintInfo(getPluginTime(), "Subscriber connected\n");
+                }
+            }
+        }
+
+        if (fds[1].revents & (POLLIN | POLLHUP)) {
+            ssize_t received = read(STDIN_FILENO, input + inputUsed, BROKER_LINE_SIZE - inputUsed - 1);
+            if (received <= 0) {
+                inputOpen = 0;
+            } else {
+                inputUsed += received;
+                // Forward only complete lines, keeping any partial line for the next read
+                size_t completeLength = inputUsed;
+                while (completeLength > 0 && input[completeLength - 1] != '\n') {
+                    completeLength--;
+                }
+                if (completeLength > 0) {
+                    for (int i = 0; i < subscriberCount; i++) {
+                        sendAll(fds[i + 2].fd, input, completeLength);
+                    }
+                    inputUsed -= completeLength;
+                    memmove(input, input + completeLength, inputUsed);
+                } else if (inputUsed == BROKER_LINE_SIZE - 1) {
+                    inputUsed = 0;
+                }
+            }
+        }
+
+        // Drop any subscriber that has gone away
+        for (int i = 0; i < subscriberCount; i++) {
+            if (fds[i + 2].revents & (POLLHUP | POLLERR | POLLIN)) {
+                char discard[256];
+                if (recv(fds[i + 2].fd, discard, sizeof(discard), MSG_DONTWAIT) <= 0) {
+                    close(fds[i + 2].fd);
+                    fds[i + 2] = fds[subscriberCount + 1];
+                    subscriberCount--;
+                    i--;
+                    ovPrintInfo(getPluginTime(), "Subscriber disconnected\n");
+                }
+            }
+        }
+    }
+    free(input);
+    close(listener);
+    return EXIT_FAILURE;
+}
@@ -15,23 +15,23 @@
 
 #include "oneviewJSONParse.h"
 #include "oneviewInfraKitState.h"
+#include "oneviewInventory.h"
+#include "oneviewSnapshot.h"
+#include "oneviewInfraKitConsole.h"
+#include "oneviewArena.h"
+#include "oneviewExport.h"
+#include "oneviewResources.h"
 
 #ifdef JSON_H
 // Ensure that we're going to be using libjansson
 
 #include <jansson.h>
+#include <stdlib.h>
 #include <string.h>
 
 json_t *json_singleton; // Shared JSON
 
 
-struct interconnectLookup
-{
-    const char *interconnectName;
-    json_t *interconnectJSON;
-    json_t *portStatisticsJSON;
-};
-
 /*
  * Character based operations.
  */
@@ -39,7 +39,7 @@ struct interconnectLookup
 char *returnRawFromJson()
 {
     if (json_singleton) {
-        char *rawText = json_dumps(json_singleton, JSON_ENSURE_ASCII);
+        char *rawText = ovDumpJSON(json_singleton, JSON_ENSURE_ASCII);
         if (rawText) {
             return rawText;
         }
@@ -50,7 +50,7 @@ char *returnRawFromJson()
 char *returnReadableFromJson()
 {
     if (json_singleton) {
-        char *rawText = json_dumps(json_singleton, JSON_INDENT(4));
+        char *rawText = ovDumpJSON(json_singleton, JSON_INDENT(4));
         if (rawText) {
             return rawText;
         }
@@ -85,52 +85,152 @@ void clearJSON()
 
 
 
-char *returnRawJSONFromObject(char* rawJSON, char *objectName)
+/*
+ * Document handles, a response is parsed once and then navigated as often as needed. Values
+ * returned from a document are borrowed and remain valid until the document is closed.
+ */
+
+oneviewJSONDocument *ovOpenJSONDocument(const char *rawJSON)
 {
-    if (rawJSON) {
-        
-        json_t *root; // Contains all of the json data once processed by jansson
-        json_error_t error; // Used as a passback for error data during json processing
-        
-        // Parse the JSON
-        root = json_loads(rawJSON, 0, &error);
-        // If the JSON was loaded correctly attempt to parse it
-        if (root) {
-            json_t *jsonObject = json_object_get(root, objectName);
-            char *json_text = NULL;
-            if (jsonObject) {
-                json_incref(root); // Borrowed reference to jsonObject
-                // Dump the json if found
-                json_text = json_dumps(jsonObject, JSON_ENSURE_ASCII);
-                // Free all references
-                json_decref(jsonObject);
-                json_decref(root);
-            }
-            if (json_text)
-                return json_text;
+    if (!rawJSON) {
+        return NULL;
+    }
+    oneviewJSONDocument *document = malloc(sizeof(oneviewJSONDocument));
+    if (!document) {
+        return NULL;
+    }
+    json_error_t error; // Used as a passback for error data during json processing
+    document->root = json_loads(rawJSON, 0, &error);
+    if (!document->root) {
+        char ovOutput[1024];
+        snprintf(ovOutput, 1024, "Unable to parse JSON, line %d: %s\n", error.line, error.text);
+        ovPrintDebug(getPluginTime(), ovOutput);
+        free(document);
+        return NULL;
+    }
+    return document;
+}
+
+/* Find a value by path, the keys of nested objects (or the index of an array element)
+ * separated by a dot e.g. "members.0.uri". A NULL or empty path is the root.
+ */
+
+json_t *ovDocumentGet(oneviewJSONDocument *document, const char *path)
+{
+    if (!document) {
+        return NULL;
+    }
+    json_t *value = document->root;
+    while (value && path && *path) {
+        const char *segmentEnd = strchr(path, '.');
+        size_t length = segmentEnd ? (size_t)(segmentEnd - path) : strlen(path);
+        char segment[256];
+        if (length >= sizeof(segment)) {
+            return NULL;
+        }
+        memcpy(segment, path, length);
+        segment[length] = '\0';
+        if (json_is_array(value)) {
+            char *digitsEnd;
+            unsigned long index = strtoul(segment, &digitsEnd, 10);
+            value = (length && *digitsEnd == '\0') ? json_array_get(value, index) : NULL;
+        } else {
+            value = json_object_get(value, segment);
         }
+        path = segmentEnd ? segmentEnd + 1 : NULL;
     }
-    return NULL;
+    return value;
 }
 
-char *returnReadableJSONFromRaw(char *rawJSON)
+size_t ovDocumentArraySize(oneviewJSONDocument *document, const char *path)
 {
-    if (rawJSON) {
-        json_t *root; // Contains all of the json data once processed by jansson
-        json_error_t error; // Used as a passback for error data during json processing
-        
-        // Parse the JSON
-        root = json_loads(rawJSON, 0, &error);
-        if (root) {
-            char *json_text = json_dumps(root, JSON_INDENT(4));
-            // free the original JSON
-            json_decref(root);
-            // return the raw JSON
-            if (json_text)
-                return json_text;
+    return json_array_size(ovDocumentGet(document, path));
+}
+
+json_t *ovDocumentArrayGet(oneviewJSONDocument *document, const char *path, size_t index)
+{
+    return json_array_get(ovDocumentGet(document, path), index);
+}
+
+const char *ovDocumentString(oneviewJSONDocument *document, const char *path)
+{
+    return json_string_value(ovDocumentGet(document, path));
+}
+
+/* Dump a value from the document as JSON_RAW or JSON_READABLE text, the text will need freeing
+ */
+
+char *ovDocumentDump(oneviewJSONDocument *document, const char *path, int format)
+{
+    json_t *value = ovDocumentGet(document, path);
+    if (!value) {
+        return NULL;
+    }
+    return ovDumpJSON(value, (format == JSON_READABLE) ? JSON_INDENT(4) : JSON_ENSURE_ASCII);
+}
+
+/* Print the fields of every element of an array in the document, one element per line
+ */
+
+void ovDocumentParseArray(oneviewJSONDocument *document, const char *arrayName, char delimiter, char *fields[], int fieldCount)
+{
+    // Ensure that some fields to search through exist before trying to access them
+    // WARNING, if fieldcount is more than fields[] (array size) then unexpected behaviour will occur
+    json_t *memberArray = ovDocumentGet(document, arrayName);
+    if (!fields || json_array_size(memberArray) == 0) {
+        return;
+    }
+    size_t index;
+    json_t *value;
+    json_array_foreach(memberArray, index, value) {
+        for (int i = 0; i< fieldCount; i++) {
+            json_t *field = json_object_get(value, fields[i]);
+            if (json_is_number(field)) {
+                printf("%lli", json_integer_value(field));
+            } else if (json_is_string(field)) {
+                printf("%s", json_string_value(field));
+            } // If NULL value is returned or Field not found then "" is returned
+            if (i != (fieldCount - 1))
+                printf("%c", delimiter);
         }
+        printf(" \n"); // New line
     }
-    return NULL;
+}
+
+/* Evaluate the struct and determine what is populated
+ then free resources back to the heap.
+ */
+
+void ovCloseJSONDocument(oneviewJSONDocument *document)
+{
+    if (document) {
+        json_decref(document->root);
+        free(document);
+    }
+}
+
+/*
+ * Single use helpers, each of these parses the raw JSON once. When more than one value is
+ * needed from a response open a document instead.
+ */
+
+char *returnRawJSONFromObject(char* rawJSON, char *objectName)
+{
+    oneviewJSONDocument *document = ovOpenJSONDocument(rawJSON);
+    char *json_text = NULL;
+    if (document && objectName && json_object_get(document->root, objectName)) {
+        json_text = ovDumpJSON(json_object_get(document->root, objectName), JSON_ENSURE_ASCII);
+    }
+    ovCloseJSONDocument(document);
+    return json_text;
+}
+
+char *returnReadableJSONFromRaw(char *rawJSON)
+{
+    oneviewJSONDocument *document = ovOpenJSONDocument(rawJSON);
+    char *json_text = ovDocumentDump(document, NULL, JSON_READABLE);
+    ovCloseJSONDocument(document);
+    return json_text;
 }
 
 void ovParseJSONWithObjectName(char *arrayName, char *rawJSON)
@@ -144,88 +244,53 @@ void ovParseMembers(char *rawJSON, char delimiter, char *fields[], int fieldCoun
 }
 
 
+/* The members are streamed straight from the raw JSON into a buffered export (no document is
+ * parsed), with the values written as they are between delimiters
+ */
+
 void ovParseArray(char *rawJSON, char *arrayName, char delimiter, char *fields[], int fieldCount)
 {
-    // Ensure that some fields to search through exist before trying to access them
-    // WARNING, if fieldcount is more than fields[] (array size) then unexpected behaviour will occur
-    if (fields) {
-        json_t *root; // Contains all of the json data once processed by jansson
-        json_error_t error; // Used as a passback for error data during json processing
-    
-        root = json_loads(rawJSON, 0, &error);
-    
-        json_t *memberArray = json_object_get(root, arrayName);
-    
-        if (json_array_size(memberArray) != 0) {
-            size_t index;
-            json_t *value;
-            json_array_foreach(memberArray, index, value) {
-                for (int i = 0; i< fieldCount; i++) {
-                    if (json_is_number(json_object_get(value, fields[i]))) {
-                        printf("%lli", json_integer_value(json_object_get(value, fields[i])));
-                        if (i != (fieldCount - 1))
-                            printf("%c", delimiter);
-                    } else if (json_is_string(json_object_get(value, fields[i]))) {
-                        printf("%s", json_string_value(json_object_get(value, fields[i])) );
-                        if (i != (fieldCount - 1))
-                            printf("%c", delimiter);
-                    } else {
-                        if (i != (fieldCount - 1))
-                            printf("%c", delimiter); // If NULL value is returned or Field not found then "" is returned
-                    }
-                }
-                printf(" \n"); // New line
-            }
+    if (rawJSON && fields && arrayName) {
+        oneviewExport exporter;
+        if (initExport(&exporter, stdout, OV_EXPORT_DELIMITED, fields, fieldCount) == EXIT_FAILURE) {
+            return;
         }
+        exporter.delimiter = delimiter;
+        ovExportMembers(&exporter, rawJSON, strlen(rawJSON), arrayName);
+        freeExport(&exporter);
     }
 }
 
 char *returnJSONObjectAtIndex(size_t index, char *rawJSON)
 {
-    if (rawJSON) {
-        json_t *root; // Contains all of the json data once processed by jansson
-        json_error_t error; // Used as a passback for error data during json processing
-        
-        root = json_loads(rawJSON, 0, &error);
-        if (root) {
-            json_t *json_object = json_array_get(root, index);
-            char *json_text = json_dumps(json_object, JSON_ENSURE_ASCII);
-            json_decref(root);
-            if (json_text)
-                return json_text;
-        }
+    oneviewJSONDocument *document = ovOpenJSONDocument(rawJSON);
+    char *json_text = NULL;
+    json_t *json_object = document ? json_array_get(document->root, index) : NULL;
+    if (json_object) {
+        json_text = ovDumpJSON(json_object, JSON_ENSURE_ASCII);
     }
-    return NULL;
+    ovCloseJSONDocument(document);
+    return json_text;
 }
 
 size_t returnJSONArraySize(char *rawJSON)
 {
-    if (rawJSON) {
-        json_t *root; // Contains all of the json data once processed by jansson
-        json_error_t error; // Used as a passback for error data during json processing
-        
-        root = json_loads(rawJSON, 0, &error);
-        if (root) {
-            //size_t count = json_integer_value(json_object_get(root, "count"));
-            size_t count = json_array_size(root);
-            json_decref(root);
-            return count;
-        }
-    }
-    return 0;
+    oneviewJSONDocument *document = ovOpenJSONDocument(rawJSON);
+    size_t count = ovDocumentArraySize(document, NULL);
+    ovCloseJSONDocument(document);
+    return count;
 }
 
-const char *returnStringfromJSON(char *rawJSON, char *field)
-{
-    json_t *root; // Contains all of the json data once processed by jansson
-    json_error_t error; // Used as a passback for error data during json processing
-    
-    root = json_loads(rawJSON, 0, &error);
+/* The string is copied out of the parsed JSON (which is then freed), so it will need freeing
+ */
 
-    if (json_is_string(json_object_get(root, field))) {
-        return json_string_value(json_object_get(root, field));
-    }
-    return NULL;
+char *returnStringfromJSON(char *rawJSON, char *field)
+{
+    oneviewJSONDocument *document = ovOpenJSONDocument(rawJSON);
+    const char *value = document ? json_string_value(json_object_get(document->root, field)) : NULL;
+    char *copy = value ? strdup(value) : NULL;
+    ovCloseJSONDocument(document);
+    return copy;
 }
 
 json_t *jsonFromObjects(json_t *json, int count,  ...)
@@ -246,143 +311,194 @@ json_t *jsonFromObjects(json_t *json, int count,  ...)
     return json;
 }
 
- /* This will iterate through all of ther Server Hardware in a OneView platform
-  * and attempt to match the hardwareURI string to a hardwareURI that OneView is
-  * aware of. If found it will then look at the hardware instance to determine if a
-  * profile is assigned, if found it will return the URI of the profile
+/* Duplicate a string value from a JSON object, returning NULL if the key
+ * doesn't exist or isn't a string.
+ */
+
+static char *dupStringFromObject(json_t *object, const char *key)
+{
+    const char *value = json_string_value(json_object_get(object, key));
+    if (value) {
+        return strdup(value);
+    }
+    return NULL;
+}
+
+ /* Populate an existing oneviewHardware structure from a server-hardware JSON resource, the
+  * fields will need freeing with freeServerHardwareFields()
   */
 
-char *serverProfileFromHardwareURI(oneviewSession *session, const char *hardwareURI)
+int ovHardwareFieldsFromJSON(oneviewHardware *hardware, json_t *hardwareJSON)
+{
+    const char *uri = json_string_value(json_object_get(hardwareJSON, "uri"));
+    if (!hardware || !uri) {
+        return EXIT_FAILURE;
+    }
+    hardware->uri = strdup(uri);
+    hardware->name = dupStringFromObject(hardwareJSON, "name");
+    hardware->state = dupStringFromObject(hardwareJSON, "state");
+    hardware->powerState = dupStringFromObject(hardwareJSON, "powerState");
+    hardware->serverProfileUri = dupStringFromObject(hardwareJSON, "serverProfileUri");
+    hardware->serverHardwareTypeUri = dupStringFromObject(hardwareJSON, "serverHardwareTypeUri");
+    hardware->enclosureUri = dupStringFromObject(hardwareJSON, "locationUri");
+    hardware->description = dupStringFromObject(hardwareJSON, "description");
+    return EXIT_SUCCESS;
+}
+
+ /* Build a oneviewHardware structure from a server-hardware JSON resource, the returned
+  * structure will need freeing with freeServerHardware()
+  */
+
+oneviewHardware *ovHardwareFromJSON(json_t *hardwareJSON)
+{
+    oneviewHardware *hardware = malloc(sizeof(oneviewHardware));
+    if (hardware && ovHardwareFieldsFromJSON(hardware, hardwareJSON) == EXIT_FAILURE) {
+        free(hardware);
+        return NULL;
+    }
+    return hardware;
+}
+
+ /* Build a oneviewHardware structure from a parsed server-hardware resource, the returned
+  * structure will need freeing with freeServerHardware()
+  */
+
+static oneviewHardware *ovHardwareFromResource(const oneviewServerHardware *resource)
+{
+    oneviewHardware *hardware = malloc(sizeof(oneviewHardware));
+    if (hardware) {
+        hardware->uri = ovSliceDup(&resource->uri);
+        hardware->name = ovSliceDup(&resource->name);
+        hardware->state = ovSliceDup(&resource->state);
+        hardware->powerState = ovSliceDup(&resource->powerState);
+        hardware->serverProfileUri = ovSliceDup(&resource->serverProfileUri);
+        hardware->serverHardwareTypeUri = ovSliceDup(&resource->serverHardwareTypeUri);
+        hardware->enclosureUri = ovSliceDup(&resource->locationUri);
+        hardware->description = ovSliceDup(&resource->description);
+    }
+    return hardware;
+}
+
+ /* This will request a single Server Hardware resource from OneView using the
+  * hardwareURI, rather than downloading the entire server-hardware collection.
+  * The returned structure will need freeing with freeServerHardware()
+  */
+
+oneviewHardware *ovGetServerHardware(oneviewSession *session, const char *hardwareURI)
 {
-    if ((session) && session->address && session->cookie) {
+    // A live inventory (kept current by the change feed) answers without a request
+    if (inventoryIsLive()) {
+        return inventoryGetServerHardware(hardwareURI);
+    }
+    // As does a hardware snapshot that hasn't expired
+    oneviewHardwareSnapshot *snapshot = ovCurrentHardwareSnapshot(session);
+    if (snapshot) {
+        oneviewHardware *hardware = ovSnapshotHardware(snapshot, ovSnapshotFindURI(snapshot, hardwareURI));
+        ovReleaseHardwareSnapshot(snapshot);
+        if (hardware) {
+            return hardware;
+        }
+    }
+    if ((session) && session->address && session->cookie && hardwareURI) {
         
-        // Get the RAW JSON return from the Server Profiles
+        // Get the RAW JSON return from the Server Hardware resource
         char *hardwareRAWJSON = NULL;
-        hardwareRAWJSON = ovQueryServerHardware(session, NULL);
+        hardwareRAWJSON = ovQueryServerHardwareWithURI(session, NULL, hardwareURI);
         
         if (hardwareRAWJSON) {
-            json_t *hardwareJSON;
-            json_error_t error;
-            // Parse the JSON
-            hardwareJSON = json_loads(hardwareRAWJSON, 0, &error);
-            // If the JSON was loaded correctly attempt to parse it
-            if (hardwareJSON) {
-                free (hardwareRAWJSON);
-                json_t *memberArray = json_object_get(hardwareJSON, "members");
-                if ((memberArray) && json_array_size(memberArray) != 0) {
-                    size_t memberIndex;
-                    json_t *memberValue;
-                    
-                    json_array_foreach(memberArray, memberIndex, memberValue) {
-                        const char *uri = json_string_value(json_object_get(memberValue, "uri"));
-                        if (stringMatch((char *)uri, (char *)hardwareURI)) {
-                            const char *serverProfile = json_string_value(json_object_get(memberValue, "serverProfileUri"));
-                            setStatePath((char *)json_string_value(json_object_get(memberValue, "description")));
-                            if (serverProfile) {
-                                // Found the Server Profile URI
-                                char *returnedProfileURI = strdup(serverProfile);
-                                json_decref(hardwareJSON);
-                                return returnedProfileURI;
-                            }
-                        }
-                    }
-                }
+            oneviewHardware *hardware = NULL;
+            oneviewServerHardware resource;
+            // An error response (e.g. 404) won't contain the uri of the hardware
+            if (ovParseServerHardware(NULL, hardwareRAWJSON, strlen(hardwareRAWJSON), &resource) != -1 &&
+                ovSliceEquals(&resource.uri, hardwareURI)) {
+                hardware = ovHardwareFromResource(&resource);
             }
+            free(hardwareRAWJSON);
+            return hardware;
         }
     }
     return NULL;
 }
 
+/* Evaluate the struct and determine what is populated
+ then free resources back to the heap.
+ */
+
+int freeServerHardwareFields(oneviewHardware *hardware)
+{
+    if (hardware) {
+        free(hardware->uri);
+        free(hardware->name);
+        free(hardware->state);
+        free(hardware->powerState);
+        free(hardware->serverProfileUri);
+        free(hardware->serverHardwareTypeUri);
+        free(hardware->enclosureUri);
+        free(hardware->description);
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
+
+int freeServerHardware(oneviewHardware *hardware)
+{
+    if (hardware) {
+        freeServerHardwareFields(hardware);
+        free(hardware);
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
+
+ /* This will look up the Server Hardware in a OneView platform using the
+  * hardwareURI. If found it will then look at the hardware instance to determine if a
+  * profile is assigned, if found it will return the URI of the profile
+  */
+
+char *serverProfileFromHardwareURI(oneviewSession *session, const char *hardwareURI)
+{
+    oneviewHardware *hardware = ovGetServerHardware(session, hardwareURI);
+    if (hardware) {
+        // Take ownership of the Server Profile URI (NULL if no profile is assigned)
+        char *returnedProfileURI = hardware->serverProfileUri;
+        hardware->serverProfileUri = NULL;
+        freeServerHardware(hardware);
+        return returnedProfileURI;
+    }
+    return NULL;
+}
+
 
-/* This will iterate through all of ther Server Hardware in a OneView platform
- * and attempt to match the hardwareURI string to a hardwareURI that OneView is
- * aware of. If found it will then look at the hardware instance to determine the current
+/* This will look up the Server Hardware in a OneView platform using the
+ * hardwareURI. If found it will then look at the hardware instance to determine the current
  * state of the hardware, such as if a profile is being applied.
  */
 
 char *stateFromHardwareURI(oneviewSession *session, const char *hardwareURI)
 {
-    if ((session) && session->address && session->cookie) {
-        
-        // Get the RAW JSON return from the Server Profiles
-        char *hardwareRAWJSON = NULL;
-        hardwareRAWJSON = ovQueryServerHardware(session, NULL);
-        
-        if (hardwareRAWJSON) {
-            json_t *hardwareJSON;
-            json_error_t error;
-            // Parse the JSON
-            hardwareJSON = json_loads(hardwareRAWJSON, 0, &error);
-            // If the JSON was loaded correctly attempt to parse it
-            if (hardwareJSON) {
-                free (hardwareRAWJSON);
-                json_t *memberArray = json_object_get(hardwareJSON, "members");
-                if ((memberArray) && json_array_size(memberArray) != 0) {
-                    size_t memberIndex;
-                    json_t *memberValue;
-                    
-                    json_array_foreach(memberArray, memberIndex, memberValue) {
-                        const char *uri = json_string_value(json_object_get(memberValue, "uri"));
-                        if (stringMatch((char *)uri, (char *)hardwareURI)) {
-                            const char *serverHardwareState = json_string_value(json_object_get(memberValue, "state"));
-                            if (serverHardwareState) {
-                                // Found the Server Profile URI
-                                char *returnedState = strdup(serverHardwareState);
-                                json_decref(hardwareJSON);
-                                return returnedState;
-                            }
-                        }
-                    }
-                }
-            }
-        }
+    oneviewHardware *hardware = ovGetServerHardware(session, hardwareURI);
+    if (hardware) {
+        char *returnedState = hardware->state;
+        hardware->state = NULL;
+        freeServerHardware(hardware);
+        return returnedState;
     }
     return NULL;
 }
 
-/* This will iterate through all of ther Server Hardware in a OneView platform
- * and attempt to match the hardwareURI string to a hardwareURI that OneView is
- * aware of. If found it will then look at the hardware instance to determine if a
+/* This will look up the Server Hardware in a OneView platform using the
+ * hardwareURI. If found it will then look at the hardware instance to determine if a
  * profile is assigned, if found it will return the URI of the profile
  */
 
 char *ovServerPoweredOn(oneviewSession *session, char *hardwareURI)
 {
-    if ((session) && session->address && session->cookie) {
-        
-        // Get the RAW JSON return from the Server Profiles
-        char *hardwareRAWJSON = NULL;
-        hardwareRAWJSON = ovQueryServerHardware(session, NULL);
-        
-        if (hardwareRAWJSON) {
-            json_t *hardwareJSON;
-            json_error_t error;
-            // Parse the JSON
-            hardwareJSON = json_loads(hardwareRAWJSON, 0, &error);
-            // If the JSON was loaded correctly attempt to parse it
-            if (hardwareJSON) {
-                free (hardwareRAWJSON);
-                json_t *memberArray = json_object_get(hardwareJSON, "members");
-                if ((memberArray) && json_array_size(memberArray) != 0) {
-                    size_t memberIndex;
-                    json_t *memberValue;
-                    
-                    json_array_foreach(memberArray, memberIndex, memberValue) {
-                        const char *uri = json_string_value(json_object_get(memberValue, "uri"));
-                        if (stringMatch((char *)uri, (char *)hardwareURI)) {
-                            const char *serverProfile = json_string_value(json_object_get(memberValue, "serverProfileUri"));
-                            //printf ("\n %s \n", json_dumps(memberValue, JSON_INDENT(3)));
-                            if (serverProfile) {
-                                // Found the Server Profile URI
-                                char *returnedProfileURI = strdup(serverProfile);
-                                json_decref(hardwareJSON);
-                                return returnedProfileURI;
-                            }
-                        }
-                    }
-                }
-            }
-        }
+    oneviewHardware *hardware = ovGetServerHardware(session, hardwareURI);
+    if (hardware) {
+        char *returnedProfileURI = hardware->serverProfileUri;
+        hardware->serverProfileUri = NULL;
+        freeServerHardware(hardware);
+        return returnedProfileURI;
     }
     return NULL;
 }
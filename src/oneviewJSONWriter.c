@@ -0,0 +1,307 @@
+
+// oneviewJSONWriter.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+
+#include "oneviewJSONWriter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int initJSONWriter(ovJSONWriter *writer)
+{
+    if (!writer) {
+        return EXIT_FAILURE;
+    }
+    writer->data = writer->inlineData;
+    writer->size = OV_WRITER_INLINE_SIZE;
+    ovWriterReset(writer);
+    return EXIT_SUCCESS;
+}
+
+/* Empty the writer so it can be used for the next document, any heap memory is given back so
+ * one large document doesn't keep the memory
+ */
+
+void ovWriterReset(ovJSONWriter *writer)
+{
+    if (writer->data != writer->inlineData) {
+        free(writer->data);
+        writer->data = writer->inlineData;
+        writer->size = OV_WRITER_INLINE_SIZE;
+    }
+    writer->length = 0;
+    writer->data[0] = '\0';
+    writer->depth = 0;
+    writer->afterKey = 0;
+    writer->hasMembers[0] = 0;
+    writer->failed = 0;
+}
+
+/* The text is always terminated, NULL is returned if anything failed to be written
+ */
+
+const char *ovWriterText(ovJSONWriter *writer)
+{
+    return (writer && !writer->failed) ? writer->data : NULL;
+}
+
+size_t ovWriterLength(ovJSONWriter *writer)
+{
+    return (writer && !writer->failed) ? writer->length : 0;
+}
+
+static int reserve(ovJSONWriter *writer, size_t bytes)
+{
+    if (writer->failed) {
+        return EXIT_FAILURE;
+    }
+    if (writer->length + bytes + 1 <= writer->size) {
+        return EXIT_SUCCESS;
+    }
+    size_t size = writer->size * 2;
+    while (size < writer->length + bytes + 1) {
+        size *= 2;
+    }
+    char *data = (writer->data == writer->inlineData) ? malloc(size) : realloc(writer->data, size);
+    if (!data) {
+        writer->failed = 1;
+        return EXIT_FAILURE;
+    }
+    if (writer->data == writer->inlineData) {
+        memcpy(data, writer->inlineData, writer->length + 1);
+    }
+    writer->data = data;
+    writer->size = size;
+    return EXIT_SUCCESS;
+}
+
+static int append(ovJSONWriter *writer, const char *text, size_t length)
+{
+    if (reserve(writer, length) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    memcpy(writer->data + writer->length, text, length);
+    writer->length += length;
+    writer->data[writer->length] = '\0';
+    return EXIT_SUCCESS;
+}
+
+/* Write the comma that separates this value from the one before it (values after a key
+ * don't need one)
+ */
+
+static void beforeValue(ovJSONWriter *writer)
+{
+    if (writer->afterKey) {
+        writer->afterKey = 0;
+        return;
+    }
+    if (writer->depth > 0) {
+        if (writer->hasMembers[writer->depth]) {
+            append(writer, ",", 1);
+        }
+        writer->hasMembers[writer->depth] = 1;
+    }
+}
+
+static int appendEscaped(ovJSONWriter *writer, const char *text)
+{
+    static const char hex[] = "0123456789abcdef";
+    if (append(writer, "\"", 1) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    const char *run = text;
+    for (const char *p = text; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        // Copy the characters that don't need escaping in one go
+        append(writer, run, p - run);
+        run = p + 1;
+        switch (c) {
+            case '"': append(writer, "\\\"", 2); break;
+            case '\\': append(writer, "\\\\", 2); break;
+            case '\n': append(writer, "\\n", 2); break;
+            case '\r': append(writer, "\\r", 2); break;
+            case '\t': append(writer, "\\t", 2); break;
+            case '\b': append(writer, "\\b", 2); break;
+            case '\f': append(writer, "\\f", 2); break;
+            default: {
+                char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+                append(writer, escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+    append(writer, run, strlen(run));
+    return append(writer, "\"", 1);
+}
+
+static int openContainer(ovJSONWriter *writer, const char *bracket)
+{
+    if (writer->depth == OV_WRITER_MAX_DEPTH) {
+        writer->failed = 1;
+        return EXIT_FAILURE;
+    }
+    beforeValue(writer);
+    writer->hasMembers[++writer->depth] = 0;
+    return append(writer, bracket, 1);
+}
+
+static int closeContainer(ovJSONWriter *writer, const char *bracket)
+{
+    if (writer->depth == 0 || writer->afterKey) {
+        writer->failed = 1;
+        return EXIT_FAILURE;
+    }
+    writer->depth--;
+    return append(writer, bracket, 1);
+}
+
+int ovWriteBeginObject(ovJSONWriter *writer)
+{
+    return openContainer(writer, "{");
+}
+
+int ovWriteEndObject(ovJSONWriter *writer)
+{
+    return closeContainer(writer, "}");
+}
+
+int ovWriteBeginArray(ovJSONWriter *writer)
+{
+    return openContainer(writer, "[");
+}
+
+int ovWriteEndArray(ovJSONWriter *writer)
+{
+    return closeContainer(writer, "]");
+}
+
+int ovWriteKey(ovJSONWriter *writer, const char *key)
+{
+    if (!key || writer->depth == 0 || writer->afterKey) {
+        writer->failed = 1;
+        return EXIT_FAILURE;
+    }
+    beforeValue(writer);
+    appendEscaped(writer, key);
+    writer->afterKey = 1;
+    return append(writer, ":", 1);
+}
+
+/* A NULL string is written as null
+ */
+
+int ovWriteString(ovJSONWriter *writer, const char *value)
+{
+    if (!value) {
+        return ovWriteNull(writer);
+    }
+    beforeValue(writer);
+    return appendEscaped(writer, value);
+}
+
+int ovWriteInteger(ovJSONWriter *writer, long long value)
+{
+    char number[24];
+    int length = snprintf(number, sizeof(number), "%lld", value);
+    beforeValue(writer);
+    return append(writer, number, length);
+}
+
+int ovWriteBoolean(ovJSONWriter *writer, int value)
+{
+    beforeValue(writer);
+    return value ? append(writer, "true", 4) : append(writer, "false", 5);
+}
+
+int ovWriteNull(ovJSONWriter *writer)
+{
+    beforeValue(writer);
+    return append(writer, "null", 4);
+}
+
+static int dumpCallback(const char *buffer, size_t size, void *data)
+{
+    return (append((ovJSONWriter *)data, buffer, size) == EXIT_SUCCESS) ? 0 : -1;
+}
+
+/* Write a jansson value as it is (e.g. instances from the state), it is streamed into the
+ * writer rather than dumped to a string first
+ */
+
+int ovWriteJSON(ovJSONWriter *writer, const json_t *value)
+{
+    if (!value) {
+        return ovWriteNull(writer);
+    }
+    beforeValue(writer);
+    if (json_dump_callback(value, dumpCallback, writer, JSON_COMPACT | JSON_ENSURE_ASCII | JSON_ENCODE_ANY) != 0) {
+        writer->failed = 1;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/* Write text that is already JSON as it is (e.g. part of a document that was serialized
+ * earlier), no comma is written before it
+ */
+
+int ovWriteText(ovJSONWriter *writer, const char *text, size_t length)
+{
+    if (!text) {
+        return EXIT_FAILURE;
+    }
+    return append(writer, text, length);
+}
+
+int ovWriteRPCBegin(ovJSONWriter *writer)
+{
+    ovWriteBeginObject(writer);
+    ovWriteKey(writer, "jsonrpc");
+    return ovWriteString(writer, "2.0");
+}
+
+int ovWriteRPCEnd(ovJSONWriter *writer, long long id)
+{
+    ovWriteKey(writer, "id");
+    ovWriteInteger(writer, id);
+    return ovWriteEndObject(writer);
+}
+
+int ovWriteRPCError(ovJSONWriter *writer, long long code, long long id)
+{
+    ovWriteRPCBegin(writer);
+    ovWriteKey(writer, "error");
+    ovWriteBeginObject(writer);
+    ovWriteKey(writer, "code");
+    ovWriteInteger(writer, code);
+    ovWriteEndObject(writer);
+    return ovWriteRPCEnd(writer, id);
+}
+
+/* Evaluate the struct and determine what is populated
+ then free resources back to the heap.
+ */
+
+int freeJSONWriter(ovJSONWriter *writer)
+{
+    if (writer) {
+        ovWriterReset(writer);
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
@@ -17,6 +17,7 @@
 #include "oneviewHTTP.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 char *oneViewQuery(oneviewSession *session, oneviewQuery *query, char *queryType)
@@ -25,9 +26,6 @@ char *oneViewQuery(oneviewSession *session, oneviewQuery *query, char *queryType
     // Check that session has been initialised, an address has been set and auth cookie exists
     if (session && session->address && session->cookie) {
         
-        // Wipe the contents of the allocated memory
-        memset(session->debug->usedAddress, 0, 1024);
-        
         // Create the url and store it in the debug structure
         createURLWithQuery(session, query, queryType);
         
@@ -51,6 +49,72 @@ char *oneViewQuery(oneviewSession *session, oneviewQuery *query, char *queryType
     return NULL; // Return nothing
 }
 
+/* GET a REST uri only if it has changed since it had the ETag (If-None-Match), NULL is returned
+ * with *unchanged set if it hasn't changed. The ETag of the response is copied to newETag.
+ */
+
+char *oneViewQueryIfChanged(oneviewSession *session, oneviewQuery *query, char *queryType, const char *eTag, int *unchanged, char *newETag, size_t newETagSize)
+{
+    *unchanged = 0;
+    if (newETag && newETagSize) {
+        newETag[0] = '\0';
+    }
+    if (!session || !session->address || !session->cookie) {
+        return NULL;
+    }
+    createURLWithQuery(session, query, queryType);
+    setOVHeaders(session);
+    if (eTag) {
+        char eTagHeader[1024];
+        snprintf(eTagHeader, sizeof(eTagHeader), "If-None-Match: \"%s\"", eTag);
+        appendHttpHeader(eTagHeader);
+    }
+    SetHttpMethod(DCHTTPGET);
+    char *httpData = httpFunction(session->debug->usedAddress);
+    if (httpData && httpResponseCode() == 304) {
+        *unchanged = 1;
+        free(httpData);
+        return NULL;
+    }
+    if (httpData && newETag && httpResponseETag()) {
+        snprintf(newETag, newETagSize, "%s", httpResponseETag());
+    }
+    return httpData;
+}
+
+size_t oneViewMultiQuery(oneviewSession *session, char **uris, size_t count, char **responses)
+{
+    size_t succeeded = 0;
+    if (!session || !session->address || !session->cookie || !uris || !responses || count == 0) {
+        return 0;
+    }
+    // The url buffer in the session is re-used for every url, so each one is copied
+    char **urls = calloc(count, sizeof(char *));
+    if (!urls) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        responses[i] = NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        createURLWithQuery(session, NULL, uris[i]);
+        urls[i] = strdup(session->debug->usedAddress);
+        if (!urls[i]) {
+            goto cleanup;
+        }
+    }
+    setOVHeaders(session);
+    SetHttpMethod(DCHTTPGET);
+    succeeded = httpMultiFunction(urls, count, responses, OV_QUERY_CONCURRENCY);
+
+cleanup:
+    for (size_t i = 0; i < count; i++) {
+        free(urls[i]);
+    }
+    free(urls);
+    return succeeded;
+}
+
 /*
  * Server Infrastructure queries
  */
@@ -77,11 +141,40 @@ char *ovQueryServerHardware(oneviewSession *session, oneviewQuery *query)
     return oneViewQuery(session, query, "/rest/server-hardware");
 }
 
+char *ovQueryServerHardwareWithURI(oneviewSession *session, oneviewQuery *query, const char *hardwareURI)
+{
+    // The hardware URI is already a full /rest/server-hardware/<id> path
+    return oneViewQuery(session, query, (char *)hardwareURI);
+}
+
 char *ovQueryEnclosureGroups(oneviewSession *session, oneviewQuery *query)
 {
     return oneViewQuery(session, query, "/rest/enclosure-groups");
 }
 
+/*
+ * Index search, the categories are added as repeated category= parameters
+ */
+
+char *ovQueryIndexResources(oneviewSession *session, oneviewQuery *query, const char *categories[], int categoryCount)
+{
+    char indexAddress[1024];
+    int length = snprintf(indexAddress, 1024, "/rest/index/resources");
+    for (int i = 0; i < categoryCount && length < 1024; i++) {
+        length += snprintf(indexAddress + length, 1024 - length, "%scategory=%s", (i == 0) ? "?" : "&", categories[i]);
+    }
+    return oneViewQuery(session, query, indexAddress);
+}
+
+/*
+ * Follow a uri returned by OneView (e.g. nextPageUri)
+ */
+
+char *ovQueryWithURI(oneviewSession *session, const char *uri)
+{
+    return oneViewQuery(session, NULL, (char *)uri);
+}
+
  /*
   * Network queries
   */
@@ -0,0 +1,589 @@
+
+// oneviewResources.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+/* Generated from schema/ by tools/oneviewSchema, edit the schema and run make rather than
+ * editing this file
+ */
+
+#include "oneviewResources.h"
+
+#include <string.h>
+
+static int isObject(const char *buffer, size_t length)
+{
+    const char *end = buffer + length;
+    while (buffer < end && (*buffer == ' ' || *buffer == '\t' || *buffer == '\n' || *buffer == '\r')) {
+        buffer++;
+    }
+    return (buffer < end) && (*buffer == '{');
+}
+
+/* Enclosure groups (/rest/enclosure-groups) */
+
+int ovParseEnclosureGroup(const ovStructuralIndex *index, const char *buffer, size_t length, oneviewEnclosureGroup *resource)
+{
+    if (!buffer || !resource || !isObject(buffer, length)) {
+        return -1;
+    }
+    memset(resource, 0, sizeof(oneviewEnclosureGroup));
+    ovJSONSlice object = { buffer, length, OV_JSON_OBJECT };
+    ovJSONSlice key, value;
+    size_t offset = 0;
+    while (resource->present != 0x1ffULL && ovNextIndexedMember(index, &object, &offset, &key, &value)) {
+        switch (key.length) {
+            case 3:
+                if (memcmp(key.start, "uri", 3) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->uri = value;
+                        resource->present |= OV_ENCLOSURE_GROUP_URI;
+                    }
+                }
+                break;
+            case 4:
+                if (memcmp(key.start, "eTag", 4) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->eTag = value;
+                        resource->present |= OV_ENCLOSURE_GROUP_E_TAG;
+                    }
+                } else if (memcmp(key.start, "name", 4) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->name = value;
+                        resource->present |= OV_ENCLOSURE_GROUP_NAME;
+                    }
+                }
+                break;
+            case 6:
+                if (memcmp(key.start, "status", 6) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->status = value;
+                        resource->present |= OV_ENCLOSURE_GROUP_STATUS;
+                    }
+                }
+                break;
+            case 11:
+                if (memcmp(key.start, "description", 11) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->description = value;
+                        resource->present |= OV_ENCLOSURE_GROUP_DESCRIPTION;
+                    }
+                }
+                break;
+            case 12:
+                if (memcmp(key.start, "stackingMode", 12) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->stackingMode = value;
+                        resource->present |= OV_ENCLOSURE_GROUP_STACKING_MODE;
+                    }
+                }
+                break;
+            case 14:
+                if (memcmp(key.start, "enclosureCount", 14) == 0) {
+                    if (value.type == OV_JSON_NUMBER) {
+                        resource->enclosureCount = ovSliceInteger(&value);
+                        resource->present |= OV_ENCLOSURE_GROUP_ENCLOSURE_COUNT;
+                    }
+                }
+                break;
+            case 23:
+                if (memcmp(key.start, "interconnectBayMappings", 23) == 0) {
+                    if (value.type == OV_JSON_ARRAY) {
+                        resource->interconnectBayMappings = value;
+                        resource->present |= OV_ENCLOSURE_GROUP_INTERCONNECT_BAY_MAPPINGS;
+                    }
+                }
+                break;
+            case 27:
+                if (memcmp(key.start, "logicalInterconnectGroupUri", 27) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->logicalInterconnectGroupUri = value;
+                        resource->present |= OV_ENCLOSURE_GROUP_LOGICAL_INTERCONNECT_GROUP_URI;
+                    }
+                }
+                break;
+        }
+    }
+    return __builtin_popcountll(resource->present);
+}
+
+/* Interconnects (/rest/interconnects) */
+
+int ovParseInterconnect(const ovStructuralIndex *index, const char *buffer, size_t length, oneviewInterconnect *resource)
+{
+    if (!buffer || !resource || !isObject(buffer, length)) {
+        return -1;
+    }
+    memset(resource, 0, sizeof(oneviewInterconnect));
+    ovJSONSlice object = { buffer, length, OV_JSON_OBJECT };
+    ovJSONSlice key, value;
+    size_t offset = 0;
+    while (resource->present != 0x3fffULL && ovNextIndexedMember(index, &object, &offset, &key, &value)) {
+        switch (key.length) {
+            case 3:
+                if (memcmp(key.start, "uri", 3) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->uri = value;
+                        resource->present |= OV_INTERCONNECT_URI;
+                    }
+                }
+                break;
+            case 4:
+                if (memcmp(key.start, "eTag", 4) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->eTag = value;
+                        resource->present |= OV_INTERCONNECT_E_TAG;
+                    }
+                } else if (memcmp(key.start, "name", 4) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->name = value;
+                        resource->present |= OV_INTERCONNECT_NAME;
+                    }
+                }
+                break;
+            case 5:
+                if (memcmp(key.start, "model", 5) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->model = value;
+                        resource->present |= OV_INTERCONNECT_MODEL;
+                    }
+                } else if (memcmp(key.start, "ports", 5) == 0) {
+                    if (value.type == OV_JSON_ARRAY) {
+                        resource->ports = value;
+                        resource->present |= OV_INTERCONNECT_PORTS;
+                    }
+                } else if (memcmp(key.start, "state", 5) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->state = value;
+                        resource->present |= OV_INTERCONNECT_STATE;
+                    }
+                }
+                break;
+            case 6:
+                if (memcmp(key.start, "status", 6) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->status = value;
+                        resource->present |= OV_INTERCONNECT_STATUS;
+                    }
+                }
+                break;
+            case 9:
+                if (memcmp(key.start, "portCount", 9) == 0) {
+                    if (value.type == OV_JSON_NUMBER) {
+                        resource->portCount = ovSliceInteger(&value);
+                        resource->present |= OV_INTERCONNECT_PORT_COUNT;
+                    }
+                }
+                break;
+            case 10:
+                if (memcmp(key.start, "partNumber", 10) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->partNumber = value;
+                        resource->present |= OV_INTERCONNECT_PART_NUMBER;
+                    }
+                } else if (memcmp(key.start, "powerState", 10) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->powerState = value;
+                        resource->present |= OV_INTERCONNECT_POWER_STATE;
+                    }
+                }
+                break;
+            case 11:
+                if (memcmp(key.start, "productName", 11) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->productName = value;
+                        resource->present |= OV_INTERCONNECT_PRODUCT_NAME;
+                    }
+                }
+                break;
+            case 12:
+                if (memcmp(key.start, "enclosureUri", 12) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->enclosureUri = value;
+                        resource->present |= OV_INTERCONNECT_ENCLOSURE_URI;
+                    }
+                }
+                break;
+            case 22:
+                if (memcmp(key.start, "logicalInterconnectUri", 22) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->logicalInterconnectUri = value;
+                        resource->present |= OV_INTERCONNECT_LOGICAL_INTERCONNECT_URI;
+                    }
+                }
+                break;
+            case 26:
+                if (memcmp(key.start, "enableFastMacCacheFailover", 26) == 0) {
+                    if (value.type == OV_JSON_TRUE || value.type == OV_JSON_FALSE) {
+                        resource->enableFastMacCacheFailover = (value.type == OV_JSON_TRUE);
+                        resource->present |= OV_INTERCONNECT_ENABLE_FAST_MAC_CACHE_FAILOVER;
+                    }
+                }
+                break;
+        }
+    }
+    return __builtin_popcountll(resource->present);
+}
+
+/* Server hardware (/rest/server-hardware) */
+
+int ovParseServerHardware(const ovStructuralIndex *index, const char *buffer, size_t length, oneviewServerHardware *resource)
+{
+    if (!buffer || !resource || !isObject(buffer, length)) {
+        return -1;
+    }
+    memset(resource, 0, sizeof(oneviewServerHardware));
+    ovJSONSlice object = { buffer, length, OV_JSON_OBJECT };
+    ovJSONSlice key, value;
+    size_t offset = 0;
+    while (resource->present != 0x1ffffULL && ovNextIndexedMember(index, &object, &offset, &key, &value)) {
+        switch (key.length) {
+            case 3:
+                if (memcmp(key.start, "uri", 3) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->uri = value;
+                        resource->present |= OV_SERVER_HARDWARE_URI;
+                    }
+                }
+                break;
+            case 4:
+                if (memcmp(key.start, "eTag", 4) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->eTag = value;
+                        resource->present |= OV_SERVER_HARDWARE_E_TAG;
+                    }
+                } else if (memcmp(key.start, "name", 4) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->name = value;
+                        resource->present |= OV_SERVER_HARDWARE_NAME;
+                    }
+                }
+                break;
+            case 5:
+                if (memcmp(key.start, "model", 5) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->model = value;
+                        resource->present |= OV_SERVER_HARDWARE_MODEL;
+                    }
+                } else if (memcmp(key.start, "state", 5) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->state = value;
+                        resource->present |= OV_SERVER_HARDWARE_STATE;
+                    }
+                }
+                break;
+            case 6:
+                if (memcmp(key.start, "status", 6) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->status = value;
+                        resource->present |= OV_SERVER_HARDWARE_STATUS;
+                    }
+                }
+                break;
+            case 8:
+                if (memcmp(key.start, "memoryMb", 8) == 0) {
+                    if (value.type == OV_JSON_NUMBER) {
+                        resource->memoryMb = ovSliceInteger(&value);
+                        resource->present |= OV_SERVER_HARDWARE_MEMORY_MB;
+                    }
+                } else if (memcmp(key.start, "position", 8) == 0) {
+                    if (value.type == OV_JSON_NUMBER) {
+                        resource->position = ovSliceInteger(&value);
+                        resource->present |= OV_SERVER_HARDWARE_POSITION;
+                    }
+                }
+                break;
+            case 10:
+                if (memcmp(key.start, "powerState", 10) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->powerState = value;
+                        resource->present |= OV_SERVER_HARDWARE_POWER_STATE;
+                    }
+                }
+                break;
+            case 11:
+                if (memcmp(key.start, "description", 11) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->description = value;
+                        resource->present |= OV_SERVER_HARDWARE_DESCRIPTION;
+                    }
+                } else if (memcmp(key.start, "locationUri", 11) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->locationUri = value;
+                        resource->present |= OV_SERVER_HARDWARE_LOCATION_URI;
+                    }
+                }
+                break;
+            case 12:
+                if (memcmp(key.start, "serialNumber", 12) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->serialNumber = value;
+                        resource->present |= OV_SERVER_HARDWARE_SERIAL_NUMBER;
+                    }
+                }
+                break;
+            case 14:
+                if (memcmp(key.start, "processorCount", 14) == 0) {
+                    if (value.type == OV_JSON_NUMBER) {
+                        resource->processorCount = ovSliceInteger(&value);
+                        resource->present |= OV_SERVER_HARDWARE_PROCESSOR_COUNT;
+                    }
+                } else if (memcmp(key.start, "serverGroupUri", 14) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->serverGroupUri = value;
+                        resource->present |= OV_SERVER_HARDWARE_SERVER_GROUP_URI;
+                    }
+                }
+                break;
+            case 16:
+                if (memcmp(key.start, "serverProfileUri", 16) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->serverProfileUri = value;
+                        resource->present |= OV_SERVER_HARDWARE_SERVER_PROFILE_URI;
+                    }
+                }
+                break;
+            case 18:
+                if (memcmp(key.start, "processorCoreCount", 18) == 0) {
+                    if (value.type == OV_JSON_NUMBER) {
+                        resource->processorCoreCount = ovSliceInteger(&value);
+                        resource->present |= OV_SERVER_HARDWARE_PROCESSOR_CORE_COUNT;
+                    }
+                }
+                break;
+            case 21:
+                if (memcmp(key.start, "serverHardwareTypeUri", 21) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->serverHardwareTypeUri = value;
+                        resource->present |= OV_SERVER_HARDWARE_SERVER_HARDWARE_TYPE_URI;
+                    }
+                }
+                break;
+        }
+    }
+    return __builtin_popcountll(resource->present);
+}
+
+/* Server profiles (/rest/server-profiles) */
+
+int ovParseServerProfile(const ovStructuralIndex *index, const char *buffer, size_t length, oneviewServerProfile *resource)
+{
+    if (!buffer || !resource || !isObject(buffer, length)) {
+        return -1;
+    }
+    memset(resource, 0, sizeof(oneviewServerProfile));
+    ovJSONSlice object = { buffer, length, OV_JSON_OBJECT };
+    ovJSONSlice key, value;
+    size_t offset = 0;
+    while (resource->present != 0x1fffULL && ovNextIndexedMember(index, &object, &offset, &key, &value)) {
+        switch (key.length) {
+            case 3:
+                if (memcmp(key.start, "uri", 3) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->uri = value;
+                        resource->present |= OV_SERVER_PROFILE_URI;
+                    }
+                }
+                break;
+            case 4:
+                if (memcmp(key.start, "eTag", 4) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->eTag = value;
+                        resource->present |= OV_SERVER_PROFILE_E_TAG;
+                    }
+                } else if (memcmp(key.start, "name", 4) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->name = value;
+                        resource->present |= OV_SERVER_PROFILE_NAME;
+                    }
+                }
+                break;
+            case 5:
+                if (memcmp(key.start, "state", 5) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->state = value;
+                        resource->present |= OV_SERVER_PROFILE_STATE;
+                    }
+                }
+                break;
+            case 6:
+                if (memcmp(key.start, "status", 6) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->status = value;
+                        resource->present |= OV_SERVER_PROFILE_STATUS;
+                    }
+                }
+                break;
+            case 7:
+                if (memcmp(key.start, "taskUri", 7) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->taskUri = value;
+                        resource->present |= OV_SERVER_PROFILE_TASK_URI;
+                    }
+                }
+                break;
+            case 8:
+                if (memcmp(key.start, "modified", 8) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->modified = value;
+                        resource->present |= OV_SERVER_PROFILE_MODIFIED;
+                    }
+                }
+                break;
+            case 11:
+                if (memcmp(key.start, "description", 11) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->description = value;
+                        resource->present |= OV_SERVER_PROFILE_DESCRIPTION;
+                    }
+                }
+                break;
+            case 17:
+                if (memcmp(key.start, "enclosureGroupUri", 17) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->enclosureGroupUri = value;
+                        resource->present |= OV_SERVER_PROFILE_ENCLOSURE_GROUP_URI;
+                    }
+                } else if (memcmp(key.start, "serverHardwareUri", 17) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->serverHardwareUri = value;
+                        resource->present |= OV_SERVER_PROFILE_SERVER_HARDWARE_URI;
+                    }
+                }
+                break;
+            case 18:
+                if (memcmp(key.start, "templateCompliance", 18) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->templateCompliance = value;
+                        resource->present |= OV_SERVER_PROFILE_TEMPLATE_COMPLIANCE;
+                    }
+                }
+                break;
+            case 21:
+                if (memcmp(key.start, "serverHardwareTypeUri", 21) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->serverHardwareTypeUri = value;
+                        resource->present |= OV_SERVER_PROFILE_SERVER_HARDWARE_TYPE_URI;
+                    }
+                }
+                break;
+            case 24:
+                if (memcmp(key.start, "serverProfileTemplateUri", 24) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->serverProfileTemplateUri = value;
+                        resource->present |= OV_SERVER_PROFILE_SERVER_PROFILE_TEMPLATE_URI;
+                    }
+                }
+                break;
+        }
+    }
+    return __builtin_popcountll(resource->present);
+}
+
+/* Server profile templates (/rest/server-profile-templates) */
+
+int ovParseServerProfileTemplate(const ovStructuralIndex *index, const char *buffer, size_t length, oneviewServerProfileTemplate *resource)
+{
+    if (!buffer || !resource || !isObject(buffer, length)) {
+        return -1;
+    }
+    memset(resource, 0, sizeof(oneviewServerProfileTemplate));
+    ovJSONSlice object = { buffer, length, OV_JSON_OBJECT };
+    ovJSONSlice key, value;
+    size_t offset = 0;
+    while (resource->present != 0x7ffULL && ovNextIndexedMember(index, &object, &offset, &key, &value)) {
+        switch (key.length) {
+            case 3:
+                if (memcmp(key.start, "uri", 3) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->uri = value;
+                        resource->present |= OV_SERVER_PROFILE_TEMPLATE_URI;
+                    }
+                }
+                break;
+            case 4:
+                if (memcmp(key.start, "eTag", 4) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->eTag = value;
+                        resource->present |= OV_SERVER_PROFILE_TEMPLATE_E_TAG;
+                    }
+                } else if (memcmp(key.start, "name", 4) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->name = value;
+                        resource->present |= OV_SERVER_PROFILE_TEMPLATE_NAME;
+                    }
+                }
+                break;
+            case 6:
+                if (memcmp(key.start, "status", 6) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->status = value;
+                        resource->present |= OV_SERVER_PROFILE_TEMPLATE_STATUS;
+                    }
+                }
+                break;
+            case 8:
+                if (memcmp(key.start, "affinity", 8) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->affinity = value;
+                        resource->present |= OV_SERVER_PROFILE_TEMPLATE_AFFINITY;
+                    }
+                } else if (memcmp(key.start, "modified", 8) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->modified = value;
+                        resource->present |= OV_SERVER_PROFILE_TEMPLATE_MODIFIED;
+                    }
+                }
+                break;
+            case 11:
+                if (memcmp(key.start, "description", 11) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->description = value;
+                        resource->present |= OV_SERVER_PROFILE_TEMPLATE_DESCRIPTION;
+                    }
+                }
+                break;
+            case 17:
+                if (memcmp(key.start, "enclosureGroupUri", 17) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->enclosureGroupUri = value;
+                        resource->present |= OV_SERVER_PROFILE_TEMPLATE_ENCLOSURE_GROUP_URI;
+                    }
+                }
+                break;
+            case 18:
+                if (memcmp(key.start, "connectionSettings", 18) == 0) {
+                    if (value.type == OV_JSON_OBJECT) {
+                        resource->connectionSettings = value;
+                        resource->present |= OV_SERVER_PROFILE_TEMPLATE_CONNECTION_SETTINGS;
+                    }
+                }
+                break;
+            case 21:
+                if (memcmp(key.start, "serverHardwareTypeUri", 21) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->serverHardwareTypeUri = value;
+                        resource->present |= OV_SERVER_PROFILE_TEMPLATE_SERVER_HARDWARE_TYPE_URI;
+                    }
+                }
+                break;
+            case 24:
+                if (memcmp(key.start, "serverProfileDescription", 24) == 0) {
+                    if (value.type == OV_JSON_STRING) {
+                        resource->serverProfileDescription = value;
+                        resource->present |= OV_SERVER_PROFILE_TEMPLATE_SERVER_PROFILE_DESCRIPTION;
+                    }
+                }
+                break;
+        }
+    }
+    return __builtin_popcountll(resource->present);
+}
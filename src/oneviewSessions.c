@@ -0,0 +1,260 @@
+
+// oneviewSessions.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#include "oneviewSessions.h"
+#include "oneviewIntern.h"
+#include "oneviewInfraKitConsole.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+
+typedef struct {
+    int address;                // Appliance (interned)
+    int username;               // User (interned)
+    char *password;             // Password of the user
+    char *cookie;               // Current token, NULL if not logged in
+    long long version;          // API version of the appliance, 0 until identified
+    double lastUsed;            // When the session was last attached (monotonic seconds)
+    int loggingIn;              // A thread is logging in (without holding sessionsLock)
+} ovManagedSession;
+
+pthread_mutex_t sessionsLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t sessionsLoggedIn = PTHREAD_COND_INITIALIZER;    // A login has finished
+
+static ovManagedSession *sessions;
+static size_t sessionCount;
+static size_t sessionSize;
+
+// Logins are sent with this session so the request buffers of the callers aren't touched
+static __thread oneviewSession *loginSession;
+
+static double monotonicSeconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+}
+
+static ssize_t findSession(int address, int username)
+{
+    for (size_t i = 0; i < sessionCount; i++) {
+        if (sessions[i].address == address && sessions[i].username == username) {
+            return (ssize_t)i;
+        }
+    }
+    return -1;
+}
+
+/* Log in (identifying the appliance the first time), sessionsLock is held. The lock is let go
+ * for the requests, so that a slow appliance doesn't hold up the sessions of the others, the
+ * session is marked as logging in and anyone else that needs it to log in waits for the login
+ * to finish. The managed sessions can move whilst the lock isn't held, so the session is given
+ * by its position.
+ */
+
+static int loginManagedSession(size_t position)
+{
+    if (sessions[position].loggingIn) {
+        while (sessions[position].loggingIn) {
+            pthread_cond_wait(&sessionsLoggedIn, &sessionsLock);
+        }
+        return sessions[position].cookie ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (!loginSession) {
+        loginSession = initSession();
+        if (!loginSession) {
+            return EXIT_FAILURE;
+        }
+    }
+    ovManagedSession *managed = &sessions[position];
+    loginSession->address = (char *)ovInternString(managed->address);
+    loginSession->username = (char *)ovInternString(managed->username);
+    loginSession->password = strdup(managed->password);
+    loginSession->cookie = NULL;
+    if (!loginSession->password) {
+        return EXIT_FAILURE;
+    }
+    managed->loggingIn = 1;
+    free(managed->cookie);
+    managed->cookie = NULL;
+    long long version = managed->version;
+    pthread_mutex_unlock(&sessionsLock);
+
+    if (version == 0) {
+        version = identifyOneview(loginSession);
+    }
+    loginSession->version = version;
+    int loggedIn = ovLogin(loginSession);
+
+    pthread_mutex_lock(&sessionsLock);
+    managed = &sessions[position];
+    managed->version = version;
+    if (loggedIn == EXIT_SUCCESS) {
+        managed->cookie = (char *)loginSession->cookie;
+    } else {
+        free((char *)loginSession->cookie);
+    }
+    loginSession->cookie = NULL;
+    free(loginSession->password);
+    loginSession->password = NULL;
+    managed->loggingIn = 0;
+    pthread_cond_broadcast(&sessionsLoggedIn);
+    if (loggedIn == EXIT_FAILURE || !managed->cookie) {
+        return EXIT_FAILURE;
+    }
+
+    char ovOutput[1024];
+    snprintf(ovOutput, sizeof(ovOutput), "Logged in to %s as %s\n", ovInternString(managed->address), ovInternString(managed->username));
+    ovPrintDebug(getPluginTime(), ovOutput);
+    return EXIT_SUCCESS;
+}
+
+/* Give an attached session its own copies of the password and token (the token of the managed
+ * session is replaced when it is renewed), sessionsLock is held
+ */
+
+static int copyToSession(oneviewSession *session, const ovManagedSession *managed)
+{
+    char *password = strdup(managed->password);
+    char *cookie = strdup(managed->cookie);
+    if (!password || !cookie) {
+        free(password);
+        free(cookie);
+        return EXIT_FAILURE;
+    }
+    // Only a session that has been attached before holds copies
+    if (session->managed >= 0) {
+        free(session->password);
+        free((char *)session->cookie);
+    }
+    session->password = password;
+    session->cookie = cookie;
+    return EXIT_SUCCESS;
+}
+
+/* Attach a session to the logged in session of the appliance and user (logging in if there
+ * isn't one), the password can be NULL once the appliance and user have been attached before.
+ */
+
+int ovSessionAttach(oneviewSession *session, const char *address, const char *username, const char *password)
+{
+    if (!session || !address || !username) {
+        return EXIT_FAILURE;
+    }
+    int addressID = ovIntern(address);
+    int usernameID = ovIntern(username);
+    pthread_mutex_lock(&sessionsLock);
+    ssize_t position = findSession(addressID, usernameID);
+    if (position == -1) {
+        char *passwordCopy = password ? strdup(password) : NULL;
+        if (!passwordCopy) {
+            pthread_mutex_unlock(&sessionsLock);
+            return EXIT_FAILURE;
+        }
+        if (sessionCount == sessionSize) {
+            size_t newSize = sessionSize ? sessionSize * 2 : 4;
+            ovManagedSession *newSessions = realloc(sessions, sizeof(ovManagedSession) * newSize);
+            if (!newSessions) {
+                pthread_mutex_unlock(&sessionsLock);
+                free(passwordCopy);
+                return EXIT_FAILURE;
+            }
+            sessions = newSessions;
+            sessionSize = newSize;
+        }
+        position = (ssize_t)sessionCount++;
+        sessions[position] = (ovManagedSession){ addressID, usernameID, passwordCopy, NULL, 0, 0, 0 };
+    }
+    ovManagedSession *managed = &sessions[position];
+
+    // New credentials replace the session (once a login with the old ones has finished)
+    while (managed->loggingIn && password && !stringMatch(password, managed->password)) {
+        pthread_cond_wait(&sessionsLoggedIn, &sessionsLock);
+        managed = &sessions[position];
+    }
+    if (password && !stringMatch(password, managed->password)) {
+        char *passwordCopy = strdup(password);
+        if (!passwordCopy) {
+            pthread_mutex_unlock(&sessionsLock);
+            return EXIT_FAILURE;
+        }
+        free(managed->password);
+        managed->password = passwordCopy;
+        free(managed->cookie);
+        managed->cookie = NULL;
+    }
+    double now = monotonicSeconds();
+    if (managed->cookie && !managed->loggingIn && now - managed->lastUsed > OV_SESSION_RENEW_S) {
+        ovPrintInfo(getPluginTime(), "Session has been idle, logging in again\n");
+        free(managed->cookie);
+        managed->cookie = NULL;
+    }
+    if (!managed->cookie && loginManagedSession((size_t)position) == EXIT_FAILURE) {
+        pthread_mutex_unlock(&sessionsLock);
+        return EXIT_FAILURE;
+    }
+    managed = &sessions[position];
+    managed->lastUsed = now;
+
+    if (copyToSession(session, managed) == EXIT_FAILURE) {
+        pthread_mutex_unlock(&sessionsLock);
+        return EXIT_FAILURE;
+    }
+    session->address = (char *)ovInternString(managed->address);
+    session->username = (char *)ovInternString(managed->username);
+    session->version = managed->version;
+    session->managed = (int)position;
+    pthread_mutex_unlock(&sessionsLock);
+    return EXIT_SUCCESS;
+}
+
+/* The token of the session was refused, log in again (unless another thread already has) and
+ * return the new token, NULL if the session couldn't be renewed
+ */
+
+const char *ovSessionRenew(oneviewSession *session)
+{
+    if (!session || session->managed < 0) {
+        return NULL;
+    }
+    pthread_mutex_lock(&sessionsLock);
+    if ((size_t)session->managed >= sessionCount) {
+        pthread_mutex_unlock(&sessionsLock);
+        return NULL;
+    }
+    ovManagedSession *managed = &sessions[session->managed];
+    if (!managed->cookie || stringMatch(managed->cookie, session->cookie)) {
+        if (!managed->loggingIn) {
+            ovPrintInfo(getPluginTime(), "Session was refused, logging in again\n");
+        }
+        if (loginManagedSession((size_t)session->managed) == EXIT_FAILURE) {
+            pthread_mutex_unlock(&sessionsLock);
+            ovPrintError(getPluginTime(), "Unable to renew the session\n");
+            return NULL;
+        }
+        managed = &sessions[session->managed];
+    }
+    managed->lastUsed = monotonicSeconds();
+    char *cookie = strdup(managed->cookie);
+    pthread_mutex_unlock(&sessionsLock);
+    if (!cookie) {
+        return NULL;
+    }
+    free((char *)session->cookie);
+    session->cookie = cookie;
+    return session->cookie;
+}
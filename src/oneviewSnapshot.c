@@ -0,0 +1,721 @@
+
+// oneviewSnapshot.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+
+#include "oneviewSnapshot.h"
+#include "oneviewInventory.h"
+#include "oneviewIntern.h"
+#include "oneviewExtract.h"
+#include "oneviewResources.h"
+#include "oneviewInfraKitConsole.h"
+
+#include <jansson.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* A snapshot is a read-only copy of every server-hardware resource, loaded once and then
+ * shared by every lookup until it expires (or one of our own writes invalidates it). Servers
+ * are indexed by uri, and chained together by hardware type and by enclosure, with a free
+ * list per hardware type of the servers that have no profile assigned.
+ *
+ * Rather than keeping a JSON object (and a heap string per field) for each server, the
+ * snapshot is held as columns of interned string ids, encoded states and type ids. A server
+ * costs a few tens of bytes, and filters are loops over arrays.
+ *
+ * The snapshot is built from the live inventory when the change feed is connected, otherwise
+ * from the server-hardware collection.
+ */
+
+oneviewHardwareSnapshot *currentSnapshot = NULL;
+pthread_mutex_t snapshotLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t snapshotLoadLock = PTHREAD_MUTEX_INITIALIZER; // Only one caller loads a snapshot
+static unsigned long invalidations;     // Bumped by every invalidation, guarded by snapshotLock
+
+// Names of the encoded values, in the order of the OV_HARDWARE_STATE_* and OV_POWER_* values
+static const char *hardwareStateNames[] = {
+    "Unknown", "Adding", "NoProfileApplied", "Monitored", "Unmanaged", "Removing",
+    "RemoveFailed", "Removed", "ApplyingProfile", "ProfileApplied", "RemovingProfile",
+    "ProfileError", "Unsupported", "UpdatingFirmware"
+};
+
+static const char *powerStateNames[] = {
+    "Unknown", "On", "Off", "PoweringOn", "PoweringOff", "Resetting"
+};
+
+#define OV_HARDWARE_STATE_COUNT (int)(sizeof(hardwareStateNames) / sizeof(hardwareStateNames[0]))
+#define OV_POWER_COUNT (int)(sizeof(powerStateNames) / sizeof(powerStateNames[0]))
+
+int ovHardwareStateFromString(const char *state)
+{
+    for (int i = 0; state && i < OV_HARDWARE_STATE_COUNT; i++) {
+        if (stringMatch(state, hardwareStateNames[i])) {
+            return i;
+        }
+    }
+    return OV_HARDWARE_STATE_UNKNOWN;
+}
+
+const char *ovHardwareStateName(int state)
+{
+    if (state >= 0 && state < OV_HARDWARE_STATE_COUNT) {
+        return hardwareStateNames[state];
+    }
+    return hardwareStateNames[OV_HARDWARE_STATE_UNKNOWN];
+}
+
+int ovPowerStateFromString(const char *powerState)
+{
+    for (int i = 0; powerState && i < OV_POWER_COUNT; i++) {
+        if (stringMatch(powerState, powerStateNames[i])) {
+            return i;
+        }
+    }
+    return OV_POWER_UNKNOWN;
+}
+
+const char *ovPowerStateName(int powerState)
+{
+    if (powerState >= 0 && powerState < OV_POWER_COUNT) {
+        return powerStateNames[powerState];
+    }
+    return powerStateNames[OV_POWER_UNKNOWN];
+}
+
+static void freeSnapshot(oneviewHardwareSnapshot *snapshot)
+{
+    if (snapshot) {
+        free(snapshot->uri);
+        free(snapshot->name);
+        free(snapshot->profileUri);
+        free(snapshot->description);
+        free(snapshot->state);
+        free(snapshot->powerState);
+        free(snapshot->typeOf);
+        free(snapshot->enclosureOf);
+        free(snapshot->nextOfType);
+        free(snapshot->nextInEnclosure);
+        free(snapshot->nextFree);
+        free(snapshot->typeUri);
+        free(snapshot->firstOfType);
+        free(snapshot->freeOfType);
+        free(snapshot->enclosureUri);
+        free(snapshot->firstInEnclosure);
+        free(snapshot->strings);
+        freeHashIndex(&snapshot->uriIndex);
+        freeHashIndex(&snapshot->typeIndex);
+        freeHashIndex(&snapshot->enclosureIndex);
+        free(snapshot);
+    }
+}
+
+static int internFromObject(json_t *object, const char *key)
+{
+    return ovIntern(json_string_value(json_object_get(object, key)));
+}
+
+// Returned when a string can't be added to the snapshot
+#define STRING_FAILED UINT32_MAX
+
+/* Make room for bytes more of strings, the strings start with an empty string so that no
+ * string is at OV_SNAPSHOT_NO_STRING
+ */
+
+static int reserveStrings(oneviewHardwareSnapshot *snapshot, size_t bytes)
+{
+    if (snapshot->stringsLength + bytes <= snapshot->stringsSize) {
+        return EXIT_SUCCESS;
+    }
+    if (snapshot->stringsLength + bytes >= STRING_FAILED) {
+        return EXIT_FAILURE;
+    }
+    size_t size = snapshot->stringsSize ? snapshot->stringsSize : 4096;
+    while (size < snapshot->stringsLength + bytes + 1) {
+        size *= 2;
+    }
+    char *strings = realloc(snapshot->strings, size);
+    if (!strings) {
+        return EXIT_FAILURE;
+    }
+    if (!snapshot->strings) {
+        strings[0] = '\0';
+        snapshot->stringsLength = 1;
+    }
+    snapshot->strings = strings;
+    snapshot->stringsSize = size;
+    return EXIT_SUCCESS;
+}
+
+static uint32_t stringFromObject(oneviewHardwareSnapshot *snapshot, json_t *object, const char *key)
+{
+    const char *value = json_string_value(json_object_get(object, key));
+    if (!value) {
+        return OV_SNAPSHOT_NO_STRING;
+    }
+    size_t length = strlen(value) + 1;
+    if (reserveStrings(snapshot, length) == EXIT_FAILURE) {
+        return STRING_FAILED;
+    }
+    uint32_t offset = (uint32_t)snapshot->stringsLength;
+    memcpy(snapshot->strings + offset, value, length);
+    snapshot->stringsLength += length;
+    return offset;
+}
+
+/* Decode a string slice into the strings of the snapshot (decoding never makes it longer) */
+
+static uint32_t stringFromSlice(oneviewHardwareSnapshot *snapshot, const ovJSONSlice *slice)
+{
+    if (slice->type != OV_JSON_STRING) {
+        return OV_SNAPSHOT_NO_STRING;
+    }
+    if (reserveStrings(snapshot, slice->length + 1) == EXIT_FAILURE) {
+        return STRING_FAILED;
+    }
+    uint32_t offset = (uint32_t)snapshot->stringsLength;
+    snapshot->stringsLength += ovSliceCopy(slice, snapshot->strings + offset, slice->length + 1) + 1;
+    return offset;
+}
+
+static char *dupSnapshotString(const oneviewHardwareSnapshot *snapshot, uint32_t offset)
+{
+    return (offset != OV_SNAPSHOT_NO_STRING) ? strdup(snapshot->strings + offset) : NULL;
+}
+
+/* Intern a string slice, slices are decoded into a stack buffer unless they are too large */
+
+static int internSlice(const ovJSONSlice *slice)
+{
+    if (slice->type != OV_JSON_STRING) {
+        return OV_INTERN_NONE;
+    }
+    char buffer[2048];
+    if (ovSliceCopy(slice, buffer, sizeof(buffer)) < sizeof(buffer)) {
+        return ovIntern(buffer);
+    }
+    char *value = ovSliceDup(slice);
+    int id = ovIntern(value);
+    free(value);
+    return id;
+}
+
+/* Assign an id to a key, returns the existing id if the key has been seen before
+ */
+
+static int idForKey(oneviewHashIndex *index, size_t *count, int *keyStrings, int key)
+{
+    const char *canonical = ovInternString(key);
+    if (!canonical) {
+        return OV_SNAPSHOT_END;
+    }
+    int id = ovHashFind(index, canonical);
+    if (id == OV_HASH_NOT_FOUND) {
+        id = (int)*count;
+        keyStrings[id] = key;
+        if (ovHashInsert(index, canonical, id) == EXIT_FAILURE) {
+            return OV_SNAPSHOT_END;
+        }
+        (*count)++;
+    }
+    return id;
+}
+
+static int growArray(void **array, size_t elementSize, size_t count)
+{
+    void *larger = realloc(*array, elementSize * count);
+    if (!larger) {
+        return EXIT_FAILURE;
+    }
+    *array = larger;
+    return EXIT_SUCCESS;
+}
+
+/* Make room for rows, every column (and the type and enclosure uris, as there can't be more
+ * of those than servers) grows together
+ */
+
+static int reserveRows(oneviewHardwareSnapshot *snapshot, size_t rows)
+{
+    if (rows <= snapshot->allocated) {
+        return EXIT_SUCCESS;
+    }
+    size_t allocated = snapshot->allocated ? snapshot->allocated : 64;
+    while (allocated < rows) {
+        allocated *= 2;
+    }
+    if (growArray((void **)&snapshot->uri, sizeof(int), allocated) == EXIT_FAILURE ||
+        growArray((void **)&snapshot->name, sizeof(int), allocated) == EXIT_FAILURE ||
+        growArray((void **)&snapshot->profileUri, sizeof(uint32_t), allocated) == EXIT_FAILURE ||
+        growArray((void **)&snapshot->description, sizeof(uint32_t), allocated) == EXIT_FAILURE ||
+        growArray((void **)&snapshot->state, 1, allocated) == EXIT_FAILURE ||
+        growArray((void **)&snapshot->powerState, 1, allocated) == EXIT_FAILURE ||
+        growArray((void **)&snapshot->typeOf, sizeof(int), allocated) == EXIT_FAILURE ||
+        growArray((void **)&snapshot->enclosureOf, sizeof(int), allocated) == EXIT_FAILURE ||
+        growArray((void **)&snapshot->nextOfType, sizeof(int), allocated) == EXIT_FAILURE ||
+        growArray((void **)&snapshot->nextInEnclosure, sizeof(int), allocated) == EXIT_FAILURE ||
+        growArray((void **)&snapshot->nextFree, sizeof(int), allocated) == EXIT_FAILURE ||
+        growArray((void **)&snapshot->typeUri, sizeof(int), allocated) == EXIT_FAILURE ||
+        growArray((void **)&snapshot->enclosureUri, sizeof(int), allocated) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    snapshot->allocated = allocated;
+    return EXIT_SUCCESS;
+}
+
+static oneviewHardwareSnapshot *newSnapshot(size_t expected)
+{
+    oneviewHardwareSnapshot *snapshot = calloc(1, sizeof(oneviewHardwareSnapshot));
+    if (!snapshot) {
+        return NULL;
+    }
+    if (reserveRows(snapshot, expected ? expected : 1) == EXIT_FAILURE ||
+        initHashIndex(&snapshot->uriIndex, expected) == EXIT_FAILURE ||
+        initHashIndex(&snapshot->typeIndex, 16) == EXIT_FAILURE ||
+        initHashIndex(&snapshot->enclosureIndex, 16) == EXIT_FAILURE) {
+        freeSnapshot(snapshot);
+        return NULL;
+    }
+    return snapshot;
+}
+
+/* Add a server, the uris and name are interned ids and the profile uri and description are
+ * offsets in the strings of the snapshot
+ */
+
+static int addServer(oneviewHardwareSnapshot *snapshot, int uri, int name, uint32_t profileUri, uint32_t description,
+                     int state, int powerState, int typeUri, int enclosureUri)
+{
+    // A profile uri that couldn't be kept would make the server look unassigned
+    if (uri == OV_INTERN_NONE || profileUri == STRING_FAILED || description == STRING_FAILED ||
+        reserveRows(snapshot, snapshot->count + 1) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    size_t i = snapshot->count++;
+    snapshot->uri[i] = uri;
+    snapshot->name[i] = name;
+    snapshot->profileUri[i] = profileUri;
+    snapshot->description[i] = description;
+    snapshot->state[i] = state;
+    snapshot->powerState[i] = powerState;
+    snapshot->typeOf[i] = idForKey(&snapshot->typeIndex, &snapshot->typeCount, snapshot->typeUri, typeUri);
+    snapshot->enclosureOf[i] = idForKey(&snapshot->enclosureIndex, &snapshot->enclosureCount, snapshot->enclosureUri, enclosureUri);
+    // The index keys are the canonical strings, which are never freed
+    return ovHashInsert(&snapshot->uriIndex, ovInternString(uri), (int)i);
+}
+
+/* Chain the servers together once every server has been added */
+
+static int finishSnapshot(oneviewHardwareSnapshot *snapshot)
+{
+    snapshot->firstOfType = malloc((snapshot->typeCount + 1) * sizeof(int));
+    snapshot->freeOfType = malloc((snapshot->typeCount + 1) * sizeof(int));
+    snapshot->firstInEnclosure = malloc((snapshot->enclosureCount + 1) * sizeof(int));
+    if (!snapshot->firstOfType || !snapshot->freeOfType || !snapshot->firstInEnclosure) {
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < snapshot->typeCount; i++) {
+        snapshot->firstOfType[i] = OV_SNAPSHOT_END;
+        snapshot->freeOfType[i] = OV_SNAPSHOT_END;
+    }
+    for (size_t i = 0; i < snapshot->enclosureCount; i++) {
+        snapshot->firstInEnclosure[i] = OV_SNAPSHOT_END;
+    }
+    // Chain the servers in reverse, so every chain is in the order of the collection
+    for (size_t i = snapshot->count; i-- > 0;) {
+        int type = snapshot->typeOf[i];
+        int enclosure = snapshot->enclosureOf[i];
+        snapshot->nextOfType[i] = OV_SNAPSHOT_END;
+        snapshot->nextInEnclosure[i] = OV_SNAPSHOT_END;
+        snapshot->nextFree[i] = OV_SNAPSHOT_END;
+        if (type != OV_SNAPSHOT_END) {
+            snapshot->nextOfType[i] = snapshot->firstOfType[type];
+            snapshot->firstOfType[type] = (int)i;
+            if (snapshot->profileUri[i] == OV_SNAPSHOT_NO_STRING) {
+                snapshot->nextFree[i] = snapshot->freeOfType[type];
+                snapshot->freeOfType[type] = (int)i;
+            }
+        }
+        if (enclosure != OV_SNAPSHOT_END) {
+            snapshot->nextInEnclosure[i] = snapshot->firstInEnclosure[enclosure];
+            snapshot->firstInEnclosure[enclosure] = (int)i;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+/* Build a snapshot from an object of server-hardware resources keyed by uri (the inventory)
+ */
+
+static oneviewHardwareSnapshot *snapshotFromInventory(json_t *collection)
+{
+    oneviewHardwareSnapshot *snapshot = newSnapshot(json_object_size(collection));
+    if (!snapshot) {
+        return NULL;
+    }
+    const char *key;
+    json_t *value;
+    json_object_foreach(collection, key, value) {
+        addServer(snapshot, internFromObject(value, "uri"),
+                  internFromObject(value, "name"),
+                  stringFromObject(snapshot, value, "serverProfileUri"),
+                  stringFromObject(snapshot, value, "description"),
+                  ovHardwareStateFromString(json_string_value(json_object_get(value, "state"))),
+                  ovPowerStateFromString(json_string_value(json_object_get(value, "powerState"))),
+                  internFromObject(value, "serverHardwareTypeUri"),
+                  internFromObject(value, "locationUri"));
+    }
+    if (finishSnapshot(snapshot) == EXIT_FAILURE) {
+        freeSnapshot(snapshot);
+        return NULL;
+    }
+    return snapshot;
+}
+
+/* Build a snapshot from the server-hardware collection, the members of every page are read
+ * straight out of the response with the generated parser (no JSON document is built). Large
+ * pages are given a structural index first so the extractor can skip over values quickly.
+ */
+
+static oneviewHardwareSnapshot *snapshotFromREST(oneviewSession *session)
+{
+    char *rawJSON = ovQueryServerHardware(session, NULL);
+    if (!rawJSON) {
+        return NULL;
+    }
+    oneviewHardwareSnapshot *snapshot = newSnapshot(0);
+    if (!snapshot) {
+        free(rawJSON);
+        return NULL;
+    }
+    ovStructuralIndex structural;
+    initStructuralIndex(&structural);
+    while (rawJSON) {
+        size_t length = strlen(rawJSON);
+        const ovStructuralIndex *index = ovIndexLargeResponse(&structural, rawJSON, length);
+        ovJSONSlice members, nextPageUri, errorCode;
+        ovJSONField pageFields[] = {
+            { "members", &members },
+            { "nextPageUri", &nextPageUri },
+            { "errorCode", &errorCode }
+        };
+        if (ovExtractIndexedFields(index, rawJSON, length, pageFields, 3) == -1 || errorCode.type != OV_JSON_MISSING) {
+            free(rawJSON);
+            freeStructuralIndex(&structural);
+            freeSnapshot(snapshot);
+            return NULL;
+        }
+
+        oneviewServerHardware hardware;
+        char stateText[64], powerText[64];
+        size_t memberCount = 0;
+        size_t offset = 0;
+        ovJSONSlice member;
+        while (ovNextIndexedElement(index, &members, &offset, &member)) {
+            if (ovParseServerHardware(index, member.start, member.length, &hardware) == -1) {
+                continue;
+            }
+            ovSliceCopy(&hardware.state, stateText, sizeof(stateText));
+            ovSliceCopy(&hardware.powerState, powerText, sizeof(powerText));
+            addServer(snapshot, internSlice(&hardware.uri), internSlice(&hardware.name), stringFromSlice(snapshot, &hardware.serverProfileUri),
+                      stringFromSlice(snapshot, &hardware.description), ovHardwareStateFromString(stateText), ovPowerStateFromString(powerText),
+                      internSlice(&hardware.serverHardwareTypeUri), internSlice(&hardware.locationUri));
+            memberCount++;
+        }
+
+        // The uri of the next page is copied out before the page it points into is freed
+        char nextPage[1024];
+        int hasNextPage = (memberCount != 0) && (nextPageUri.type == OV_JSON_STRING) && (nextPageUri.length != 0);
+        int copied = hasNextPage && ovSliceCopy(&nextPageUri, nextPage, sizeof(nextPage)) < sizeof(nextPage);
+        free(rawJSON);
+        rawJSON = NULL;
+        if (hasNextPage) {
+            // A page that can't be read would leave its servers out, so the load fails
+            if (copied) {
+                rawJSON = ovQueryWithURI(session, nextPage);
+            }
+            if (!rawJSON) {
+                freeStructuralIndex(&structural);
+                freeSnapshot(snapshot);
+                return NULL;
+            }
+        }
+    }
+    freeStructuralIndex(&structural);
+    if (finishSnapshot(snapshot) == EXIT_FAILURE) {
+        freeSnapshot(snapshot);
+        return NULL;
+    }
+    return snapshot;
+}
+
+/* A snapshot is fresh until it expires, or if it was built from the inventory, until the
+ * inventory changes (or stops being live). It is only handed to sessions of the appliance and
+ * user it was loaded for (a NULL session takes any snapshot). Called with the snapshotLock held.
+ */
+
+static int snapshotIsFresh(oneviewHardwareSnapshot *snapshot, oneviewSession *session)
+{
+    if (!snapshot || snapshot->expires <= time(NULL)) {
+        return 0;
+    }
+    if (session && snapshot->appliance != OV_INTERN_NONE &&
+        (snapshot->appliance != ovIntern(session->address) || snapshot->user != ovIntern(session->username))) {
+        return 0;
+    }
+    if (snapshot->generation != 0) {
+        return inventoryIsLive() && (inventoryGeneration() == snapshot->generation);
+    }
+    return 1;
+}
+
+static void releaseLocked(oneviewHardwareSnapshot *snapshot)
+{
+    if (snapshot && --snapshot->references == 0) {
+        freeSnapshot(snapshot);
+    }
+}
+
+static oneviewHardwareSnapshot *loadSnapshot(oneviewSession *session)
+{
+    oneviewHardwareSnapshot *snapshot = NULL;
+    unsigned long generation = 0;
+    // A write that invalidates the snapshot whilst it is loading may not be in what we read
+    pthread_mutex_lock(&snapshotLock);
+    unsigned long loadStarted = invalidations;
+    pthread_mutex_unlock(&snapshotLock);
+    if (inventoryIsLive()) {
+        json_t *collection = inventoryCopyHardware(&generation);
+        if (collection) {
+            snapshot = snapshotFromInventory(collection);
+            json_decref(collection);
+        }
+    }
+    if (!snapshot) {
+        generation = 0;
+        if (!session || !session->cookie) {
+            return NULL;
+        }
+        snapshot = snapshotFromREST(session);
+    }
+    if (!snapshot) {
+        ovPrintWarning(getPluginTime(), "Unable to load the server hardware snapshot\n");
+        return NULL;
+    }
+    snapshot->expires = time(NULL) + OV_SNAPSHOT_TTL;
+    snapshot->generation = generation;
+    snapshot->appliance = session ? ovIntern(session->address) : OV_INTERN_NONE;
+    snapshot->user = session ? ovIntern(session->username) : OV_INTERN_NONE;
+    snapshot->references = 1;
+
+    pthread_mutex_lock(&snapshotLock);
+    if (invalidations == loadStarted) {
+        // One reference is held as the current snapshot, the other by the caller
+        snapshot->references++;
+        releaseLocked(currentSnapshot);
+        currentSnapshot = snapshot;
+    }
+    pthread_mutex_unlock(&snapshotLock);
+
+    char ovOutput[1024];
+    snprintf(ovOutput, 1024, "Hardware snapshot loaded, %zu servers %zu types %zu enclosures\n", snapshot->count, snapshot->typeCount, snapshot->enclosureCount);
+    ovPrintDebug(getPluginTime(), ovOutput);
+    return snapshot;
+}
+
+/* Returns the current snapshot, reloading it first if it isn't fresh. The snapshot must be
+ * released with ovReleaseHardwareSnapshot()
+ */
+
+oneviewHardwareSnapshot *ovAcquireHardwareSnapshot(oneviewSession *session)
+{
+    oneviewHardwareSnapshot *snapshot = ovCurrentHardwareSnapshot(session);
+    if (snapshot) {
+        return snapshot;
+    }
+    pthread_mutex_lock(&snapshotLoadLock);
+    // Another caller may have loaded the snapshot whilst we waited
+    snapshot = ovCurrentHardwareSnapshot(session);
+    if (!snapshot) {
+        snapshot = loadSnapshot(session);
+    }
+    pthread_mutex_unlock(&snapshotLoadLock);
+    return snapshot;
+}
+
+/* Returns the current snapshot only if it is fresh (without loading one), otherwise NULL
+ */
+
+oneviewHardwareSnapshot *ovCurrentHardwareSnapshot(oneviewSession *session)
+{
+    oneviewHardwareSnapshot *snapshot = NULL;
+    pthread_mutex_lock(&snapshotLock);
+    if (snapshotIsFresh(currentSnapshot, session)) {
+        snapshot = currentSnapshot;
+        snapshot->references++;
+    }
+    pthread_mutex_unlock(&snapshotLock);
+    return snapshot;
+}
+
+void ovReleaseHardwareSnapshot(oneviewHardwareSnapshot *snapshot)
+{
+    pthread_mutex_lock(&snapshotLock);
+    releaseLocked(snapshot);
+    pthread_mutex_unlock(&snapshotLock);
+}
+
+/* Called after any of our own writes to OneView, the next acquire will reload the snapshot
+ * (anyone holding the current snapshot can continue to use it, a snapshot that was loading
+ * at the time is handed to its caller but not kept)
+ */
+
+void ovInvalidateHardwareSnapshot()
+{
+    pthread_mutex_lock(&snapshotLock);
+    invalidations++;
+    releaseLocked(currentSnapshot);
+    currentSnapshot = NULL;
+    pthread_mutex_unlock(&snapshotLock);
+}
+
+int ovSnapshotFindURI(oneviewHardwareSnapshot *snapshot, const char *hardwareURI)
+{
+    if (snapshot) {
+        int server = ovHashFind(&snapshot->uriIndex, hardwareURI);
+        if (server != OV_HASH_NOT_FOUND) {
+            return server;
+        }
+    }
+    return OV_SNAPSHOT_END;
+}
+
+int ovSnapshotTypeId(oneviewHardwareSnapshot *snapshot, const char *hardwareTypeURI)
+{
+    if (snapshot) {
+        int type = ovHashFind(&snapshot->typeIndex, hardwareTypeURI);
+        if (type != OV_HASH_NOT_FOUND) {
+            return type;
+        }
+    }
+    return OV_SNAPSHOT_END;
+}
+
+int ovSnapshotEnclosureId(oneviewHardwareSnapshot *snapshot, const char *enclosureURI)
+{
+    if (snapshot) {
+        int enclosure = ovHashFind(&snapshot->enclosureIndex, enclosureURI);
+        if (enclosure != OV_HASH_NOT_FOUND) {
+            return enclosure;
+        }
+    }
+    return OV_SNAPSHOT_END;
+}
+
+/* Returns the first server of a hardware type (or in an enclosure), the rest of the servers
+ * are found by following nextOfType (or nextInEnclosure) until OV_SNAPSHOT_END
+ */
+
+int ovSnapshotFirstOfType(oneviewHardwareSnapshot *snapshot, const char *hardwareTypeURI)
+{
+    int type = ovSnapshotTypeId(snapshot, hardwareTypeURI);
+    if (type != OV_SNAPSHOT_END) {
+        return snapshot->firstOfType[type];
+    }
+    return OV_SNAPSHOT_END;
+}
+
+int ovSnapshotFirstInEnclosure(oneviewHardwareSnapshot *snapshot, const char *enclosureURI)
+{
+    int enclosure = ovSnapshotEnclosureId(snapshot, enclosureURI);
+    if (enclosure != OV_SNAPSHOT_END) {
+        return snapshot->firstInEnclosure[enclosure];
+    }
+    return OV_SNAPSHOT_END;
+}
+
+/* Walk the unassigned servers of a hardware type. The free lists aren't changed once the
+ * snapshot is built, so they can be walked without a lock and every holder of the snapshot
+ * sees every server (the ledger decides who gets a server, see oneviewInfraKitLedger.h).
+ */
+
+int ovSnapshotFirstFree(oneviewHardwareSnapshot *snapshot, const char *hardwareTypeURI)
+{
+    int type = ovSnapshotTypeId(snapshot, hardwareTypeURI);
+    if (type == OV_SNAPSHOT_END) {
+        return OV_SNAPSHOT_END;
+    }
+    return snapshot->freeOfType[type];
+}
+
+int ovSnapshotNextFree(oneviewHardwareSnapshot *snapshot, int server)
+{
+    if (!snapshot || server < 0 || (size_t)server >= snapshot->count) {
+        return OV_SNAPSHOT_END;
+    }
+    return snapshot->nextFree[server];
+}
+
+/* Fill servers with every server that matches the filter (up to maxServers), returning the
+ * number of matches
+ */
+
+size_t ovSnapshotSelect(oneviewHardwareSnapshot *snapshot, const oneviewHardwareFilter *filter, int *servers, size_t maxServers)
+{
+    size_t found = 0;
+    if (!snapshot || !filter || !servers) {
+        return 0;
+    }
+    for (size_t i = 0; i < snapshot->count && found < maxServers; i++) {
+        int match = (filter->type == OV_SNAPSHOT_ANY || snapshot->typeOf[i] == filter->type) &
+                    (filter->enclosure == OV_SNAPSHOT_ANY || snapshot->enclosureOf[i] == filter->enclosure) &
+                    (filter->state == OV_SNAPSHOT_ANY || snapshot->state[i] == filter->state) &
+                    (filter->powerState == OV_SNAPSHOT_ANY || snapshot->powerState[i] == filter->powerState) &
+                    (!filter->unassigned || snapshot->profileUri[i] == OV_SNAPSHOT_NO_STRING);
+        if (match) {
+            servers[found++] = (int)i;
+        }
+    }
+    return found;
+}
+
+static char *dupInternString(int id)
+{
+    const char *value = ovInternString(id);
+    return value ? strdup(value) : NULL;
+}
+
+/* Build a oneviewHardware structure from a server in the snapshot, the returned structure
+ * will need freeing with freeServerHardware()
+ */
+
+oneviewHardware *ovSnapshotHardware(oneviewHardwareSnapshot *snapshot, int server)
+{
+    if (!snapshot || server < 0 || (size_t)server >= snapshot->count) {
+        return NULL;
+    }
+    oneviewHardware *hardware = malloc(sizeof(oneviewHardware));
+    if (hardware) {
+        int type = snapshot->typeOf[server];
+        int enclosure = snapshot->enclosureOf[server];
+        hardware->uri = dupInternString(snapshot->uri[server]);
+        hardware->name = dupInternString(snapshot->name[server]);
+        hardware->state = strdup(ovHardwareStateName(snapshot->state[server]));
+        hardware->powerState = strdup(ovPowerStateName(snapshot->powerState[server]));
+        hardware->serverProfileUri = dupSnapshotString(snapshot, snapshot->profileUri[server]);
+        hardware->serverHardwareTypeUri = (type != OV_SNAPSHOT_END) ? dupInternString(snapshot->typeUri[type]) : NULL;
+        hardware->enclosureUri = (enclosure != OV_SNAPSHOT_END) ? dupInternString(snapshot->enclosureUri[enclosure]) : NULL;
+        hardware->description = dupSnapshotString(snapshot, snapshot->description[server]);
+    }
+    return hardware;
+}
@@ -0,0 +1,614 @@
+
+// oneviewStatistics.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+
+#include "oneviewStatistics.h"
+#include "oneviewExtract.h"
+#include "oneviewJSONParse.h"
+#include "oneviewInfraKitConsole.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* The statistics of every interconnect are requested together (OV_QUERY_CONCURRENCY at a
+ * time) rather than one port at a time, and the port counters are read straight out of the
+ * responses into flat arrays so the rates for every port are worked out in a single pass.
+ */
+
+// Length of OVPERIOD_1MIN and OVPERIOD_5MIN in seconds
+static const double periodSeconds[OV_STATISTICS_PERIODS] = { 60, 300 };
+
+// Rollups are held for every port, period and direction
+#define ROLLUP_SLOT(port, period, direction) ((((size_t)(port) * OV_STATISTICS_PERIODS) + (period)) * 2 + (direction))
+#define ROLLUPS_PER_PORT (OV_STATISTICS_PERIODS * 2)
+
+static double monotonicSeconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+}
+
+/* OneView returns the counters as strings of digits (older versions as numbers)
+ */
+
+static double sliceCounter(const ovJSONSlice *slice)
+{
+    char digits[32];
+    if (slice->type != OV_JSON_STRING && slice->type != OV_JSON_NUMBER) {
+        return 0;
+    }
+    if (ovSliceCopy(slice, digits, sizeof(digits)) >= sizeof(digits)) {
+        return 0;
+    }
+    return strtod(digits, NULL);
+}
+
+int initInterconnectStatistics(oneviewInterconnectStatistics *statistics)
+{
+    if (!statistics) {
+        return EXIT_FAILURE;
+    }
+    memset(statistics, 0, sizeof(oneviewInterconnectStatistics));
+    return initHashIndex(&statistics->portIndex, 64);
+}
+
+static int growColumn(void **column, size_t elementSize, size_t count)
+{
+    void *larger = realloc(*column, elementSize * count);
+    if (!larger) {
+        return EXIT_FAILURE;
+    }
+    *column = larger;
+    return EXIT_SUCCESS;
+}
+
+static int reservePorts(oneviewInterconnectStatistics *statistics, size_t ports)
+{
+    if (ports <= statistics->allocated) {
+        return EXIT_SUCCESS;
+    }
+    size_t allocated = statistics->allocated ? statistics->allocated : 64;
+    while (allocated < ports) {
+        allocated *= 2;
+    }
+    if (allocated > OV_STATISTICS_MAX_PORTS) {
+        allocated = OV_STATISTICS_MAX_PORTS;
+    }
+    if (growColumn((void **)&statistics->interconnect, sizeof(int), allocated) == EXIT_FAILURE ||
+        growColumn((void **)&statistics->portName, sizeof(int), allocated) == EXIT_FAILURE ||
+        growColumn((void **)&statistics->txOctets, sizeof(double), allocated) == EXIT_FAILURE ||
+        growColumn((void **)&statistics->rxOctets, sizeof(double), allocated) == EXIT_FAILURE ||
+        growColumn((void **)&statistics->previousTxOctets, sizeof(double), allocated) == EXIT_FAILURE ||
+        growColumn((void **)&statistics->previousRxOctets, sizeof(double), allocated) == EXIT_FAILURE ||
+        growColumn((void **)&statistics->txKBps, sizeof(double), allocated) == EXIT_FAILURE ||
+        growColumn((void **)&statistics->rxKBps, sizeof(double), allocated) == EXIT_FAILURE ||
+        growColumn((void **)&statistics->sampleTime, sizeof(double) * OV_STATISTICS_SAMPLES, allocated) == EXIT_FAILURE ||
+        growColumn((void **)&statistics->sampleTxOctets, sizeof(double) * OV_STATISTICS_SAMPLES, allocated) == EXIT_FAILURE ||
+        growColumn((void **)&statistics->sampleRxOctets, sizeof(double) * OV_STATISTICS_SAMPLES, allocated) == EXIT_FAILURE ||
+        growColumn((void **)&statistics->sampleNext, sizeof(unsigned int), allocated) == EXIT_FAILURE ||
+        growColumn((void **)&statistics->sampleCount, sizeof(unsigned int), allocated) == EXIT_FAILURE ||
+        growColumn((void **)&statistics->windows, sizeof(oneviewRollupWindow) * ROLLUPS_PER_PORT, allocated) == EXIT_FAILURE ||
+        growColumn((void **)&statistics->rollups, sizeof(oneviewRollup) * ROLLUPS_PER_PORT, allocated) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    statistics->allocated = allocated;
+    return EXIT_SUCCESS;
+}
+
+/* The port index is keyed by "<interconnect uri> <port name>", the interned copy of the key
+ * is used so that it lives as long as the index
+ */
+
+static const char *portKey(const char *interconnectURI, const char *portName)
+{
+    char key[2048];
+    if ((size_t)snprintf(key, sizeof(key), "%s %s", interconnectURI, portName) >= sizeof(key)) {
+        return NULL;
+    }
+    return ovInternString(ovIntern(key));
+}
+
+int ovInterconnectPort(oneviewInterconnectStatistics *statistics, const char *interconnectURI, const char *portName)
+{
+    if (!statistics || !interconnectURI || !portName) {
+        return OV_STATISTICS_END;
+    }
+    char key[2048];
+    if ((size_t)snprintf(key, sizeof(key), "%s %s", interconnectURI, portName) >= sizeof(key)) {
+        return OV_STATISTICS_END;
+    }
+    int port = ovHashFind(&statistics->portIndex, key);
+    return (port == OV_HASH_NOT_FOUND) ? OV_STATISTICS_END : port;
+}
+
+/* Record the counters of a port, a port that hasn't been seen before starts with no change.
+ * Fails once OV_STATISTICS_MAX_PORTS are being tracked.
+ */
+
+static int recordPort(oneviewInterconnectStatistics *statistics, int interconnect, const char *portName, double tx, double rx)
+{
+    const char *key = portKey(ovInternString(interconnect), portName);
+    if (!key) {
+        return EXIT_FAILURE;
+    }
+    int port = ovHashFind(&statistics->portIndex, key);
+    if (port == OV_HASH_NOT_FOUND) {
+        if (statistics->count >= OV_STATISTICS_MAX_PORTS || reservePorts(statistics, statistics->count + 1) == EXIT_FAILURE) {
+            return EXIT_FAILURE;
+        }
+        port = (int)statistics->count;
+        if (ovHashInsert(&statistics->portIndex, key, port) == EXIT_FAILURE) {
+            return EXIT_FAILURE;
+        }
+        statistics->count++;
+        statistics->interconnect[port] = interconnect;
+        statistics->portName[port] = ovIntern(portName);
+        statistics->previousTxOctets[port] = tx;
+        statistics->previousRxOctets[port] = rx;
+        statistics->sampleNext[port] = 0;
+        statistics->sampleCount[port] = 0;
+        memset(&statistics->windows[ROLLUP_SLOT(port, 0, 0)], 0, sizeof(oneviewRollupWindow) * ROLLUPS_PER_PORT);
+        memset(&statistics->rollups[ROLLUP_SLOT(port, 0, 0)], 0, sizeof(oneviewRollup) * ROLLUPS_PER_PORT);
+    }
+    statistics->txOctets[port] = tx;
+    statistics->rxOctets[port] = rx;
+
+    // Add the sample to the ring, overwriting the oldest once it is full
+    size_t slot = ((size_t)port * OV_STATISTICS_SAMPLES) + statistics->sampleNext[port];
+    statistics->sampleTime[slot] = statistics->sampled;
+    statistics->sampleTxOctets[slot] = tx;
+    statistics->sampleRxOctets[slot] = rx;
+    statistics->sampleNext[port] = (statistics->sampleNext[port] + 1) % OV_STATISTICS_SAMPLES;
+    if (statistics->sampleCount[port] < OV_STATISTICS_SAMPLES) {
+        statistics->sampleCount[port]++;
+    }
+    return EXIT_SUCCESS;
+}
+
+/* Add the rate between two samples to the period in progress, once the period has run for
+ * its length it becomes the complete rollup and the next period starts from this sample
+ */
+
+static void updateWindow(oneviewRollupWindow *window, oneviewRollup *complete, double length,
+                         double previousTime, double previousOctets, double time, double octets)
+{
+    double elapsed = time - previousTime;
+    double delta = octets - previousOctets;
+    double KBps = (elapsed > 0 && delta > 0) ? delta / (1024.0 * elapsed) : 0;
+    oneviewRollup *rollup = &window->rollup;
+    if (rollup->samples == 0) {
+        rollup->start = previousTime;
+        rollup->min = KBps;
+        rollup->max = KBps;
+        rollup->complete = 0;
+        window->sum = 0;
+        window->firstOctets = previousOctets;
+    }
+    rollup->samples++;
+    window->sum += KBps;
+    if (KBps < rollup->min) {
+        rollup->min = KBps;
+    }
+    if (KBps > rollup->max) {
+        rollup->max = KBps;
+    }
+    rollup->mean = window->sum / rollup->samples;
+    rollup->seconds = time - rollup->start;
+    delta = octets - window->firstOctets;
+    rollup->rate = (rollup->seconds > 0 && delta > 0) ? delta / (1024.0 * rollup->seconds) : 0;
+    if (rollup->seconds >= length) {
+        *complete = *rollup;
+        complete->complete = 1;
+        rollup->samples = 0;
+    }
+}
+
+/* Roll the latest sample of every port that was in this collection into its rollups
+ */
+
+static void updateRollups(oneviewInterconnectStatistics *statistics)
+{
+    for (size_t port = 0; port < statistics->count; port++) {
+        if (statistics->sampleCount[port] < 2) {
+            continue;
+        }
+        size_t base = port * OV_STATISTICS_SAMPLES;
+        size_t latest = base + ((statistics->sampleNext[port] + OV_STATISTICS_SAMPLES - 1) % OV_STATISTICS_SAMPLES);
+        size_t previous = base + ((statistics->sampleNext[port] + OV_STATISTICS_SAMPLES - 2) % OV_STATISTICS_SAMPLES);
+        if (statistics->sampleTime[latest] != statistics->sampled) {
+            continue;
+        }
+        for (int period = 0; period < OV_STATISTICS_PERIODS; period++) {
+            size_t tx = ROLLUP_SLOT(port, period, OV_STATISTIC_TX);
+            size_t rx = ROLLUP_SLOT(port, period, OV_STATISTIC_RX);
+            updateWindow(&statistics->windows[tx], &statistics->rollups[tx], periodSeconds[period],
+                         statistics->sampleTime[previous], statistics->sampleTxOctets[previous],
+                         statistics->sampleTime[latest], statistics->sampleTxOctets[latest]);
+            updateWindow(&statistics->windows[rx], &statistics->rollups[rx], periodSeconds[period],
+                         statistics->sampleTime[previous], statistics->sampleRxOctets[previous],
+                         statistics->sampleTime[latest], statistics->sampleRxOctets[latest]);
+        }
+    }
+}
+
+/* The latest counter of a port in KB (OV_PROFILE_STATISTIC_CURR), or the KB since the previous
+ * collection (OV_PROFILE_STATISTIC_DIFF)
+ */
+
+double ovPortCounter(oneviewInterconnectStatistics *statistics, int port, int direction, int mode)
+{
+    if (!statistics || port < 0 || (size_t)port >= statistics->count) {
+        return 0;
+    }
+    double latest = (direction == OV_STATISTIC_TX) ? statistics->txOctets[port] : statistics->rxOctets[port];
+    if (mode == OV_PROFILE_STATISTIC_CURR) {
+        return latest / 1024.0;
+    }
+    double previous = (direction == OV_STATISTIC_TX) ? statistics->previousTxOctets[port] : statistics->previousRxOctets[port];
+    return (latest > previous) ? (latest - previous) / 1024.0 : 0;
+}
+
+/* Copy the rollup of a port for a period (OVPERIOD_1MIN or OVPERIOD_5MIN), this is the last
+ * complete period or if one hasn't completed yet the period so far (complete isn't set)
+ */
+
+int ovPortRollup(oneviewInterconnectStatistics *statistics, int port, int period, int direction, oneviewRollup *rollup)
+{
+    if (!statistics || !rollup || port < 0 || (size_t)port >= statistics->count ||
+        period < 0 || period >= OV_STATISTICS_PERIODS || (direction != OV_STATISTIC_TX && direction != OV_STATISTIC_RX)) {
+        return EXIT_FAILURE;
+    }
+    size_t slot = ROLLUP_SLOT(port, period, direction);
+    if (statistics->rollups[slot].complete) {
+        *rollup = statistics->rollups[slot];
+    } else if (statistics->windows[slot].rollup.samples != 0) {
+        *rollup = statistics->windows[slot].rollup;
+    } else {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+/* Copy the raw samples of a port (oldest first), any of the arrays can be NULL. Returns the
+ * number of samples copied.
+ */
+
+size_t ovPortSamples(oneviewInterconnectStatistics *statistics, int port, double *times, double *txOctets, double *rxOctets, size_t maxSamples)
+{
+    if (!statistics || port < 0 || (size_t)port >= statistics->count) {
+        return 0;
+    }
+    size_t count = statistics->sampleCount[port];
+    if (count > maxSamples) {
+        count = maxSamples;
+    }
+    size_t base = (size_t)port * OV_STATISTICS_SAMPLES;
+    size_t first = (statistics->sampleNext[port] + OV_STATISTICS_SAMPLES - count) % OV_STATISTICS_SAMPLES;
+    for (size_t i = 0; i < count; i++) {
+        size_t slot = base + ((first + i) % OV_STATISTICS_SAMPLES);
+        if (times) {
+            times[i] = statistics->sampleTime[slot];
+        }
+        if (txOctets) {
+            txOctets[i] = statistics->sampleTxOctets[slot];
+        }
+        if (rxOctets) {
+            rxOctets[i] = statistics->sampleRxOctets[slot];
+        }
+    }
+    return count;
+}
+
+/* Read the portStatistics of an interconnect statistics response
+ */
+
+static size_t parseInterconnectStatistics(oneviewInterconnectStatistics *statistics, int interconnect, const char *rawJSON)
+{
+    size_t ignored = 0;
+    ovStructuralIndex structural;
+    initStructuralIndex(&structural);
+    size_t length = strlen(rawJSON);
+    const ovStructuralIndex *index = ovIndexLargeResponse(&structural, rawJSON, length);
+
+    ovJSONSlice ports;
+    ovJSONField responseFields[] = { { "portStatistics", &ports } };
+    if (ovExtractIndexedFields(index, rawJSON, length, responseFields, 1) != 1) {
+        freeStructuralIndex(&structural);
+        return 0;
+    }
+    ovJSONSlice portName, txOctets, rxOctets;
+    ovJSONField portFields[] = {
+        { "portName", &portName },
+        { "commonStatistics.rfc1213IfOutOctets", &txOctets },
+        { "commonStatistics.rfc1213IfInOctets", &rxOctets }
+    };
+    size_t offset = 0;
+    ovJSONSlice port;
+    while (ovNextIndexedElement(index, &ports, &offset, &port)) {
+        char name[256];
+        if (ovExtractIndexedFields(index, port.start, port.length, portFields, 3) == -1 || portName.type != OV_JSON_STRING) {
+            continue;
+        }
+        if (ovSliceCopy(&portName, name, sizeof(name)) >= sizeof(name)) {
+            continue;
+        }
+        if (recordPort(statistics, interconnect, name, sliceCounter(&txOctets), sliceCounter(&rxOctets)) == EXIT_FAILURE) {
+            ignored++;
+        }
+    }
+    freeStructuralIndex(&structural);
+    return ignored;
+}
+
+/* rate = (latest - previous) * scale, a counter that has gone backwards (the interconnect was
+ * reset) gives a rate of 0. Two ports at a time with SSE2.
+ */
+
+static void counterRates(const double *latest, const double *previous, double *rates, size_t count, double scale)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128d scales = _mm_set1_pd(scale);
+    const __m128d zero = _mm_setzero_pd();
+    for (; i + 2 <= count; i += 2) {
+        __m128d delta = _mm_sub_pd(_mm_loadu_pd(latest + i), _mm_loadu_pd(previous + i));
+        _mm_storeu_pd(rates + i, _mm_mul_pd(_mm_max_pd(delta, zero), scales));
+    }
+#endif
+    for (; i < count; i++) {
+        double delta = latest[i] - previous[i];
+        rates[i] = (delta > 0) ? delta * scale : 0;
+    }
+}
+
+/* Find the uri of every interconnect, following the pages of the collection
+ */
+
+static size_t findInterconnects(oneviewSession *session, int **interconnects)
+{
+    size_t count = 0, allocated = 0;
+    *interconnects = NULL;
+    char *rawJSON = ovQueryInterconnects(session, NULL);
+    while (rawJSON) {
+        ovJSONSlice members, nextPageUri, uri;
+        ovJSONField pageFields[] = {
+            { "members", &members },
+            { "nextPageUri", &nextPageUri }
+        };
+        ovJSONField memberFields[] = { { "uri", &uri } };
+        if (ovExtractFields(rawJSON, strlen(rawJSON), pageFields, 2) == -1) {
+            free(rawJSON);
+            break;
+        }
+        size_t memberCount = 0;
+        size_t offset = 0;
+        ovJSONSlice member;
+        while (ovNextElement(&members, &offset, &member)) {
+            char value[1024];
+            memberCount++;
+            if (ovExtractFields(member.start, member.length, memberFields, 1) != 1 ||
+                ovSliceCopy(&uri, value, sizeof(value)) >= sizeof(value)) {
+                continue;
+            }
+            if (count == allocated) {
+                allocated = allocated ? allocated * 2 : 64;
+                if (growColumn((void **)interconnects, sizeof(int), allocated) == EXIT_FAILURE) {
+                    free(rawJSON);
+                    return count;
+                }
+            }
+            (*interconnects)[count++] = ovIntern(value);
+        }
+        char nextPage[1024];
+        int hasNextPage = (memberCount != 0) && (nextPageUri.type == OV_JSON_STRING) &&
+                          (ovSliceCopy(&nextPageUri, nextPage, sizeof(nextPage)) < sizeof(nextPage));
+        free(rawJSON);
+        rawJSON = hasNextPage ? ovQueryWithURI(session, nextPage) : NULL;
+    }
+    return count;
+}
+
+/* Collect the port statistics of every interconnect and work out the rates since the previous
+ * collection (every rate is 0 after the first collection)
+ */
+
+int ovCollectInterconnectStatistics(oneviewSession *session, oneviewInterconnectStatistics *statistics)
+{
+    if (!session || !statistics) {
+        return EXIT_FAILURE;
+    }
+    int *interconnects;
+    size_t interconnectCount = findInterconnects(session, &interconnects);
+    if (interconnectCount == 0) {
+        free(interconnects);
+        ovPrintWarning(getPluginTime(), "No interconnects were found\n");
+        return EXIT_FAILURE;
+    }
+
+    char **uris = calloc(interconnectCount, sizeof(char *));
+    char **responses = calloc(interconnectCount, sizeof(char *));
+    if (!uris || !responses) {
+        free(uris);
+        free(responses);
+        free(interconnects);
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < interconnectCount; i++) {
+        const char *uri = ovInternString(interconnects[i]);
+        size_t length = strlen(uri) + strlen("/statistics") + 1;
+        uris[i] = malloc(length);
+        if (uris[i]) {
+            snprintf(uris[i], length, "%s/statistics", uri);
+        }
+    }
+    double started = monotonicSeconds();
+    size_t responded = oneViewMultiQuery(session, uris, interconnectCount, responses);
+    char ovOutput[1024];
+    snprintf(ovOutput, 1024, "Statistics of %zu/%zu interconnects collected in %.3fs\n", responded, interconnectCount, monotonicSeconds() - started);
+    ovPrintDebug(getPluginTime(), ovOutput);
+
+    // The latest counters become the previous ones, ports missing from this collection show no change
+    size_t count = statistics->count;
+    if (count) {
+        memcpy(statistics->previousTxOctets, statistics->txOctets, count * sizeof(double));
+        memcpy(statistics->previousRxOctets, statistics->rxOctets, count * sizeof(double));
+    }
+    statistics->previousSampled = statistics->sampled;
+    statistics->sampled = monotonicSeconds();
+    statistics->interconnectCount = responded;
+    size_t ignored = 0;
+    for (size_t i = 0; i < interconnectCount; i++) {
+        if (responses[i]) {
+            ignored += parseInterconnectStatistics(statistics, interconnects[i], responses[i]);
+        }
+        free(responses[i]);
+        free(uris[i]);
+    }
+    free(responses);
+    free(uris);
+    free(interconnects);
+    if (ignored) {
+        snprintf(ovOutput, 1024, "%zu ports were ignored, the statistics hold at most %d ports\n", ignored, OV_STATISTICS_MAX_PORTS);
+        ovPrintWarning(getPluginTime(), ovOutput);
+    }
+
+    double elapsed = statistics->sampled - statistics->previousSampled;
+    double scale = (statistics->previousSampled > 0 && elapsed > 0) ? 1.0 / (1024.0 * elapsed) : 0;
+    counterRates(statistics->txOctets, statistics->previousTxOctets, statistics->txKBps, statistics->count, scale);
+    counterRates(statistics->rxOctets, statistics->previousRxOctets, statistics->rxKBps, statistics->count, scale);
+    updateRollups(statistics);
+    return (responded != 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* Evaluate the struct and determine what is populated
+ then free resources back to the heap.
+ */
+
+int freeInterconnectStatistics(oneviewInterconnectStatistics *statistics)
+{
+    if (statistics) {
+        free(statistics->interconnect);
+        free(statistics->portName);
+        free(statistics->txOctets);
+        free(statistics->rxOctets);
+        free(statistics->previousTxOctets);
+        free(statistics->previousRxOctets);
+        free(statistics->txKBps);
+        free(statistics->rxKBps);
+        free(statistics->sampleTime);
+        free(statistics->sampleTxOctets);
+        free(statistics->sampleRxOctets);
+        free(statistics->sampleNext);
+        free(statistics->sampleCount);
+        free(statistics->windows);
+        free(statistics->rollups);
+        freeHashIndex(&statistics->portIndex);
+        memset(statistics, 0, sizeof(oneviewInterconnectStatistics));
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
+
+/* Return the KB transmitted by an interface (port) from the statistics of an interconnect or
+ * of a single port, or -1 if the interface isn't in the statistics
+ */
+
+long long returnKBTXforInterface(oneviewSession *session, char *interface, char *rawJSON)
+{
+    if (!interface || !rawJSON) {
+        return -1;
+    }
+    ovJSONSlice ports, portName, txOctets;
+    ovJSONField responseFields[] = {
+        { "portStatistics", &ports },
+        { "portName", &portName },
+        { "commonStatistics.rfc1213IfOutOctets", &txOctets }
+    };
+    if (ovExtractFields(rawJSON, strlen(rawJSON), responseFields, 3) == -1) {
+        return -1;
+    }
+    // Statistics of a single port
+    if (ovSliceEquals(&portName, interface)) {
+        return (long long)(sliceCounter(&txOctets) / 1024);
+    }
+    ovJSONField portFields[] = {
+        { "portName", &portName },
+        { "commonStatistics.rfc1213IfOutOctets", &txOctets }
+    };
+    size_t offset = 0;
+    ovJSONSlice port;
+    while (ovNextElement(&ports, &offset, &port)) {
+        if (ovExtractFields(port.start, port.length, portFields, 2) != -1 && ovSliceEquals(&portName, interface)) {
+            return (long long)(sliceCounter(&txOctets) / 1024);
+        }
+    }
+    return -1;
+}
+
+/* Print the rates of every port each interval, the session is created from the OV_ADDRESS,
+ * OV_USERNAME and OV_PASSWORD environment variables.
+ *
+ * ./infrakit-instance-oneview statistics [interval]
+ */
+
+int startStatisticsReport(int interval)
+{
+    oneviewSession *session = ovSessionFromEnvironment();
+    if (!session) {
+        return EXIT_FAILURE;
+    }
+    if (interval <= 0) {
+        interval = OV_STATISTICS_INTERVAL;
+    }
+
+    oneviewInterconnectStatistics statistics;
+    if (initInterconnectStatistics(&statistics) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    ovCollectInterconnectStatistics(session, &statistics);
+    while (1) {
+        sleep(interval);
+        if (ovCollectInterconnectStatistics(session, &statistics) == EXIT_FAILURE) {
+            continue;
+        }
+        printf("%-40s %-8s %10s %10s %10s %10s %10s %10s\n", "Interconnect", "Port", "TX KB/s", "RX KB/s",
+               "TX 1m", "RX 1m", "TX 5m", "RX 5m");
+        for (size_t i = 0; i < statistics.count; i++) {
+            double periodRates[OV_STATISTICS_PERIODS][2] = { { 0 } };
+            for (int period = 0; period < OV_STATISTICS_PERIODS; period++) {
+                for (int direction = OV_STATISTIC_TX; direction <= OV_STATISTIC_RX; direction++) {
+                    oneviewRollup rollup;
+                    if (ovPortRollup(&statistics, (int)i, period, direction, &rollup) == EXIT_SUCCESS) {
+                        periodRates[period][direction] = rollup.rate;
+                    }
+                }
+            }
+            printf("%-40s %-8s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", ovInternString(statistics.interconnect[i]),
+                   ovInternString(statistics.portName[i]), statistics.txKBps[i], statistics.rxKBps[i],
+                   periodRates[OVPERIOD_1MIN][OV_STATISTIC_TX], periodRates[OVPERIOD_1MIN][OV_STATISTIC_RX],
+                   periodRates[OVPERIOD_5MIN][OV_STATISTIC_TX], periodRates[OVPERIOD_5MIN][OV_STATISTIC_RX]);
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+    freeInterconnectStatistics(&statistics);
+    return EXIT_SUCCESS;
+}
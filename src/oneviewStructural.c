@@ -0,0 +1,329 @@
+
+// oneviewStructural.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+
+#include "oneviewStructural.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OV_STRUCTURAL_X86 1
+#include <immintrin.h>
+#endif
+
+/* The buffer is classified 64 bytes at a time, giving a bit mask of the quotes, backslashes
+ * and structural characters in each block. The masks are then used to work out which quotes
+ * are escaped and which bytes are inside of strings, so that only the structural characters
+ * outside of strings (and the quotes themselves) are written to the index.
+ *
+ * The classification is the only part that looks at every byte, so that is done with AVX2 or
+ * SSE2 when the processor has them and a scalar loop otherwise.
+ */
+
+#define BLOCK_SIZE 64
+
+typedef struct {
+    uint64_t quotes;
+    uint64_t backslashes;
+    uint64_t structurals;
+} blockMasks;
+
+typedef void (*classifyFunction)(const unsigned char *block, blockMasks *masks);
+
+static void classifyScalar(const unsigned char *block, blockMasks *masks)
+{
+    uint64_t quotes = 0, backslashes = 0, structurals = 0;
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        uint64_t bit = 1ULL << i;
+        switch (block[i]) {
+            case '"':
+                quotes |= bit;
+                break;
+            case '\\':
+                backslashes |= bit;
+                break;
+            case '{':
+            case '}':
+            case '[':
+            case ']':
+            case ':':
+            case ',':
+                structurals |= bit;
+                break;
+        }
+    }
+    masks->quotes = quotes;
+    masks->backslashes = backslashes;
+    masks->structurals = structurals;
+}
+
+#ifdef OV_STRUCTURAL_X86
+
+/* '{' and '[' (and '}' and ']') only differ by 0x20, so setting that bit finds both brackets
+ * with a single compare
+ */
+
+__attribute__((target("sse2")))
+static void classifySSE2(const unsigned char *block, blockMasks *masks)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i openBrace = _mm_set1_epi8('{');
+    const __m128i closeBrace = _mm_set1_epi8('}');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    uint64_t quotes = 0, backslashes = 0, structurals = 0;
+    for (int i = 0; i < BLOCK_SIZE; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(block + i));
+        __m128i folded = _mm_or_si128(chunk, caseBit);
+        __m128i structural = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, openBrace), _mm_cmpeq_epi8(folded, closeBrace)),
+                                          _mm_or_si128(_mm_cmpeq_epi8(chunk, colon), _mm_cmpeq_epi8(chunk, comma)));
+        quotes |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)) << i;
+        backslashes |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslash)) << i;
+        structurals |= (uint64_t)(uint16_t)_mm_movemask_epi8(structural) << i;
+    }
+    masks->quotes = quotes;
+    masks->backslashes = backslashes;
+    masks->structurals = structurals;
+}
+
+__attribute__((target("avx2")))
+static void classifyAVX2(const unsigned char *block, blockMasks *masks)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    const __m256i openBrace = _mm256_set1_epi8('{');
+    const __m256i closeBrace = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    uint64_t quotes = 0, backslashes = 0, structurals = 0;
+    for (int i = 0; i < BLOCK_SIZE; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)(block + i));
+        __m256i folded = _mm256_or_si256(chunk, caseBit);
+        __m256i structural = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(folded, openBrace), _mm256_cmpeq_epi8(folded, closeBrace)),
+                                             _mm256_or_si256(_mm256_cmpeq_epi8(chunk, colon), _mm256_cmpeq_epi8(chunk, comma)));
+        quotes |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quote)) << i;
+        backslashes |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, backslash)) << i;
+        structurals |= (uint64_t)(uint32_t)_mm256_movemask_epi8(structural) << i;
+    }
+    masks->quotes = quotes;
+    masks->backslashes = backslashes;
+    masks->structurals = structurals;
+}
+
+#endif
+
+static classifyFunction classifyBlock = classifyScalar;
+static const char *classifyName = "scalar";
+static pthread_once_t classifyOnce = PTHREAD_ONCE_INIT;
+
+/* Pick the widest implementation the processor supports, OV_STRUCTURAL can be set to "sse2"
+ * or "scalar" to force a narrower one
+ */
+
+static void selectClassifier()
+{
+    const char *forced = getenv("OV_STRUCTURAL");
+    if (forced && strcmp(forced, "scalar") == 0) {
+        return;
+    }
+#ifdef OV_STRUCTURAL_X86
+    __builtin_cpu_init();
+    if (!(forced && strcmp(forced, "sse2") == 0) && __builtin_cpu_supports("avx2")) {
+        classifyBlock = classifyAVX2;
+        classifyName = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        classifyBlock = classifySSE2;
+        classifyName = "sse2";
+    }
+#endif
+}
+
+const char *ovStructuralImplementation()
+{
+    pthread_once(&classifyOnce, selectClassifier);
+    return classifyName;
+}
+
+/* Every bit is set to the xor of itself and all of the lower bits, so a bit is set between
+ * an opening quote (inclusive) and its closing quote (exclusive)
+ */
+
+static inline uint64_t prefixXor(uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+/* Work out which characters are escaped, a backslash escapes the next character unless it is
+ * escaped itself. Backslashes are rare in OneView responses, so they are walked one at a time.
+ */
+
+static inline uint64_t escapedCharacters(uint64_t backslashes, uint64_t *carry)
+{
+    uint64_t escaped = 0;
+    if (*carry) {
+        escaped = 1;
+        backslashes &= ~1ULL;
+    }
+    *carry = 0;
+    while (backslashes) {
+        int bit = __builtin_ctzll(backslashes);
+        backslashes &= backslashes - 1;
+        if (bit == BLOCK_SIZE - 1) {
+            *carry = 1;
+            break;
+        }
+        escaped |= 1ULL << (bit + 1);
+        backslashes &= ~(1ULL << (bit + 1));
+    }
+    return escaped;
+}
+
+int initStructuralIndex(ovStructuralIndex *index)
+{
+    if (!index) {
+        return EXIT_FAILURE;
+    }
+    memset(index, 0, sizeof(ovStructuralIndex));
+    return EXIT_SUCCESS;
+}
+
+static int reservePositions(ovStructuralIndex *index, size_t positions)
+{
+    if (index->count + positions <= index->allocated) {
+        return EXIT_SUCCESS;
+    }
+    size_t allocated = index->allocated ? index->allocated : 4096;
+    while (allocated < index->count + positions) {
+        allocated *= 2;
+    }
+    uint32_t *newPositions = realloc(index->positions, allocated * sizeof(uint32_t));
+    if (!newPositions) {
+        return EXIT_FAILURE;
+    }
+    index->positions = newPositions;
+    index->allocated = allocated;
+    return EXIT_SUCCESS;
+}
+
+/* Index a buffer, replacing whatever the index held before. Fails if the buffer is too large
+ * for 32 bit offsets or if the positions can't be allocated.
+ */
+
+int ovBuildStructuralIndex(ovStructuralIndex *index, const char *buffer, size_t length)
+{
+    if (!index || !buffer || length >= UINT32_MAX) {
+        return EXIT_FAILURE;
+    }
+    pthread_once(&classifyOnce, selectClassifier);
+    index->buffer = NULL;
+    index->length = 0;
+    index->count = 0;
+    // A typical response has a structural character in every 6-8 bytes
+    if (reservePositions(index, (length / 4) + BLOCK_SIZE) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+
+    uint64_t escapeCarry = 0;
+    uint64_t inString = 0;
+    for (size_t offset = 0; offset < length; offset += BLOCK_SIZE) {
+        blockMasks masks;
+        if (length - offset >= BLOCK_SIZE) {
+            classifyBlock((const unsigned char *)buffer + offset, &masks);
+        } else {
+            unsigned char tail[BLOCK_SIZE];
+            memset(tail, ' ', BLOCK_SIZE);
+            memcpy(tail, buffer + offset, length - offset);
+            classifyBlock(tail, &masks);
+        }
+
+        uint64_t quotes = masks.quotes;
+        if (masks.backslashes || escapeCarry) {
+            quotes &= ~escapedCharacters(masks.backslashes, &escapeCarry);
+        }
+        uint64_t strings = prefixXor(quotes) ^ inString;
+        inString = (uint64_t)((int64_t)strings >> 63);
+        uint64_t structurals = (masks.structurals & ~strings) | quotes;
+
+        if (reservePositions(index, BLOCK_SIZE) == EXIT_FAILURE) {
+            return EXIT_FAILURE;
+        }
+        uint32_t *positions = index->positions + index->count;
+        while (structurals) {
+            *positions++ = (uint32_t)(offset + __builtin_ctzll(structurals));
+            structurals &= structurals - 1;
+        }
+        index->count = positions - index->positions;
+    }
+    index->buffer = buffer;
+    index->length = length;
+    return EXIT_SUCCESS;
+}
+
+/* Index a response only if it is large enough to be worth it, returns the index or NULL if
+ * the response should be scanned byte by byte
+ */
+
+const ovStructuralIndex *ovIndexLargeResponse(ovStructuralIndex *index, const char *buffer, size_t length)
+{
+    if (length < OV_STRUCTURAL_THRESHOLD || ovBuildStructuralIndex(index, buffer, length) == EXIT_FAILURE) {
+        return NULL;
+    }
+    return index;
+}
+
+/* Find the first structural character at or after p, returning its position in the index or
+ * OV_STRUCTURAL_END
+ */
+
+size_t ovStructuralSeek(const ovStructuralIndex *index, const char *p)
+{
+    if (!index || !index->buffer || p < index->buffer) {
+        return OV_STRUCTURAL_END;
+    }
+    size_t offset = p - index->buffer;
+    size_t low = 0, high = index->count;
+    while (low < high) {
+        size_t middle = low + ((high - low) / 2);
+        if (index->positions[middle] < offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return (low < index->count) ? low : OV_STRUCTURAL_END;
+}
+
+/* Evaluate the struct and determine what is populated
+ then free resources back to the heap.
+ */
+
+int freeStructuralIndex(ovStructuralIndex *index)
+{
+    if (index) {
+        free(index->positions);
+        memset(index, 0, sizeof(ovStructuralIndex));
+        return EXIT_SUCCESS;
+    }
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,619 @@
+
+// oneviewTemplates.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#include "oneviewTemplates.h"
+#include "oneviewHash.h"
+#include "oneviewIntern.h"
+#include "oneviewResources.h"
+#include "oneviewInfraKitConsole.h"
+#include "oneviewJSONWriter.h"
+#include "oneviewArena.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <jansson.h>
+
+// Size of the ETag kept for the collection
+#define OV_TEMPLATE_ETAG_SIZE 256
+
+// Fields of a new profile that are set for every instance, and the markers they are held by
+#define OV_PROTOTYPE_FIELDS 3
+
+static const char *prototypeFields[OV_PROTOTYPE_FIELDS] = { "name", "serverHardwareUri", "description" };
+static const char *prototypeMarkers[OV_PROTOTYPE_FIELDS] = { "@ov.name@", "@ov.serverHardwareUri@", "@ov.description@" };
+
+/* The new profile of a template, serialized with a marker in place of each field that is set
+ * for every instance. The fields are patched into the text in the order they appear.
+ */
+
+typedef struct {
+    int templateURI;                            // Template the new profile is for (interned)
+    int eTag;                                   // ETag of the template it was read with
+    int modified;                               // Modified time of the template it was read with
+    char *text;                                 // The serialized new profile
+    int fields[OV_PROTOTYPE_FIELDS];            // Field of each marker, in the order of the text
+    size_t markerStart[OV_PROTOTYPE_FIELDS];    // Offset of each marker in the text
+    size_t markerLength[OV_PROTOTYPE_FIELDS];   // Length of each marker (with its quotes)
+} ovPrototype;
+
+typedef struct {
+    int address;                        // Appliance the templates were read from (interned)
+    char eTag[OV_TEMPLATE_ETAG_SIZE];   // ETag of the collection, empty if it can't be revalidated
+    double refreshed;                   // When the templates were read or revalidated (monotonic seconds)
+    double missRefreshed;               // When a lookup miss last read the templates
+    int refreshing;                     // A thread is reading the templates (without holding templatesLock)
+    double retryAfter;                  // A read failed, they aren't read again before then
+    double retryInterval;               // Seconds between the reads while they are failing
+    ovTemplate *templates;              // Templates of the appliance
+    size_t count;                       // Number of templates
+    oneviewHashIndex names;             // Name of a template to its position in templates
+    oneviewHashIndex uris;              // Uri of a template to its position in templates
+    ovPrototype *prototypes;            // New profiles of the templates that have been used
+    size_t prototypeCount;
+    size_t prototypeSize;
+    oneviewHashIndex prototypeURIs;     // Uri of a template to its position in prototypes
+} ovTemplateSet;
+
+pthread_mutex_t templatesLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t templatesRefreshed = PTHREAD_COND_INITIALIZER;  // A read of the templates has finished
+
+static ovTemplateSet *sets;
+static size_t setCount;
+static size_t setSize;
+
+static double monotonicSeconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+}
+
+static int internSlice(const ovJSONSlice *slice)
+{
+    char *copy = ovSliceDup(slice);
+    int id = ovIntern(copy);
+    free(copy);
+    return id;
+}
+
+/* Find the templates of an appliance, templatesLock is held
+ */
+
+static ovTemplateSet *findSet(int address)
+{
+    for (size_t i = 0; i < setCount; i++) {
+        if (sets[i].address == address) {
+            return &sets[i];
+        }
+    }
+    if (setCount == setSize) {
+        size_t newSize = setSize ? setSize * 2 : 4;
+        ovTemplateSet *newSets = realloc(sets, sizeof(ovTemplateSet) * newSize);
+        if (!newSets) {
+            return NULL;
+        }
+        sets = newSets;
+        setSize = newSize;
+    }
+    ovTemplateSet *set = &sets[setCount++];
+    memset(set, 0, sizeof(ovTemplateSet));
+    set->address = address;
+    return set;
+}
+
+/* Parse a page of the templates collection, the uri of the next page (which will need
+ * freeing) is returned in nextPage
+ */
+
+static int parseTemplatePage(const char *rawJSON, ovTemplate **templates, size_t *count, size_t *allocated, char **nextPage)
+{
+    *nextPage = NULL;
+    ovJSONSlice members, nextPageUri;
+    ovJSONField fields[] = {
+        { "members", &members },
+        { "nextPageUri", &nextPageUri }
+    };
+    ovStructuralIndex structural;
+    initStructuralIndex(&structural);
+    size_t length = strlen(rawJSON);
+    const ovStructuralIndex *index = ovIndexLargeResponse(&structural, rawJSON, length);
+    if (ovExtractIndexedFields(index, rawJSON, length, fields, 2) == -1 || members.type != OV_JSON_ARRAY) {
+        freeStructuralIndex(&structural);
+        return EXIT_FAILURE;
+    }
+    size_t memberCount = 0;
+    size_t offset = 0;
+    ovJSONSlice member;
+    while (ovNextIndexedElement(index, &members, &offset, &member)) {
+        memberCount++;
+        oneviewServerProfileTemplate resource;
+        if (ovParseServerProfileTemplate(index, member.start, member.length, &resource) == -1) {
+            continue;
+        }
+        // There should always be the uris if there is a name, otherwise something is
+        // internally broken inside of OneView
+        unsigned long long required = OV_SERVER_PROFILE_TEMPLATE_NAME | OV_SERVER_PROFILE_TEMPLATE_URI | \
+                                      OV_SERVER_PROFILE_TEMPLATE_SERVER_HARDWARE_TYPE_URI | OV_SERVER_PROFILE_TEMPLATE_ENCLOSURE_GROUP_URI;
+        if ((resource.present & required) != required) {
+            continue;
+        }
+        if (*count == *allocated) {
+            size_t newAllocated = (*allocated) ? (*allocated) * 2 : 16;
+            ovTemplate *newTemplates = realloc(*templates, sizeof(ovTemplate) * newAllocated);
+            if (!newTemplates) {
+                freeStructuralIndex(&structural);
+                return EXIT_FAILURE;
+            }
+            *templates = newTemplates;
+            *allocated = newAllocated;
+        }
+        ovTemplate *template = &(*templates)[(*count)++];
+        template->name = internSlice(&resource.name);
+        template->uri = internSlice(&resource.uri);
+        template->serverHardwareTypeUri = internSlice(&resource.serverHardwareTypeUri);
+        template->enclosureGroupUri = internSlice(&resource.enclosureGroupUri);
+        template->eTag = (resource.present & OV_SERVER_PROFILE_TEMPLATE_E_TAG) ? internSlice(&resource.eTag) : OV_INTERN_NONE;
+        template->modified = (resource.present & OV_SERVER_PROFILE_TEMPLATE_MODIFIED) ? internSlice(&resource.modified) : OV_INTERN_NONE;
+    }
+    freeStructuralIndex(&structural);
+    if (memberCount != 0) {
+        *nextPage = ovSliceDup(&nextPageUri);
+    }
+    return EXIT_SUCCESS;
+}
+
+/* Read the templates of the appliance into read (without templatesLock held), unchanged is
+ * set instead if the collection still has the ETag in read->eTag
+ */
+
+static int fetchSet(oneviewSession *session, ovTemplateSet *read, int *unchanged)
+{
+    char eTag[OV_TEMPLATE_ETAG_SIZE];
+    char *rawJSON = oneViewQueryIfChanged(session, NULL, "/rest/server-profile-templates", read->eTag[0] ? read->eTag : NULL, \
+                                          unchanged, eTag, sizeof(eTag));
+    if (*unchanged) {
+        ovPrintDebug(getPluginTime(), "Server profile templates are unchanged\n");
+        return EXIT_SUCCESS;
+    }
+    if (!rawJSON) {
+        ovPrintError(getPluginTime(), "Unable to read the server profile templates\n");
+        return EXIT_FAILURE;
+    }
+
+    ovTemplate *templates = NULL;
+    size_t count = 0;
+    size_t allocated = 0;
+    int paged = 0;
+    int result = EXIT_SUCCESS;
+    while (rawJSON) {
+        char *nextPage = NULL;
+        if (parseTemplatePage(rawJSON, &templates, &count, &allocated, &nextPage) == EXIT_FAILURE) {
+            result = EXIT_FAILURE;
+        }
+        free(rawJSON);
+        rawJSON = NULL;
+        if (nextPage) {
+            if (result == EXIT_SUCCESS) {
+                paged = 1;
+                rawJSON = ovQueryWithURI(session, nextPage);
+                if (!rawJSON) {
+                    result = EXIT_FAILURE;
+                }
+            }
+            free(nextPage);
+        }
+    }
+
+    oneviewHashIndex names = {0}, uris = {0};
+    if (result == EXIT_FAILURE || initHashIndex(&names, count) == EXIT_FAILURE || initHashIndex(&uris, count) == EXIT_FAILURE) {
+        if (names.size) {
+            freeHashIndex(&names);
+        }
+        free(templates);
+        ovPrintError(getPluginTime(), "Unable to read the server profile templates\n");
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < count; i++) {
+        // The names and uris are interned so they stay allocated as long as the indexes
+        ovHashInsert(&names, ovInternString(templates[i].name), (int)i);
+        ovHashInsert(&uris, ovInternString(templates[i].uri), (int)i);
+    }
+    read->templates = templates;
+    read->count = count;
+    read->names = names;
+    read->uris = uris;
+
+    // The ETag of the first page doesn't change with the pages that follow it
+    snprintf(read->eTag, sizeof(read->eTag), "%s", paged ? "" : eTag);
+
+    char ovOutput[1024];
+    snprintf(ovOutput, sizeof(ovOutput), "Read %zu server profile templates\n", count);
+    ovPrintDebug(getPluginTime(), ovOutput);
+    return EXIT_SUCCESS;
+}
+
+/* Read the templates of the appliance again, templatesLock is held but isn't while they are
+ * read (so the set has to be found again afterwards, the sets may have moved). Only one thread
+ * reads them at a time, the others wait for what it reads. Once a read has failed they aren't
+ * read again (unless forced) until retryAfter, lookups use the templates that were last read.
+ */
+
+static int refreshSet(oneviewSession *session, int address, int force)
+{
+    ovTemplateSet *set = findSet(address);
+    if (set && set->refreshing) {
+        while ((set = findSet(address)) && set->refreshing) {
+            pthread_cond_wait(&templatesRefreshed, &templatesLock);
+        }
+        return (set && set->retryAfter == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (!set || (!force && monotonicSeconds() < set->retryAfter)) {
+        return EXIT_FAILURE;
+    }
+    ovTemplateSet read;
+    memset(&read, 0, sizeof(ovTemplateSet));
+    snprintf(read.eTag, sizeof(read.eTag), "%s", set->eTag);
+    set->refreshing = 1;
+    pthread_mutex_unlock(&templatesLock);
+    int unchanged = 0;
+    int result = fetchSet(session, &read, &unchanged);
+    pthread_mutex_lock(&templatesLock);
+
+    set = findSet(address);
+    if (set && result == EXIT_SUCCESS) {
+        if (!unchanged) {
+            free(set->templates);
+            if (set->names.size) {
+                freeHashIndex(&set->names);
+                freeHashIndex(&set->uris);
+            }
+            set->templates = read.templates;
+            set->count = read.count;
+            set->names = read.names;
+            set->uris = read.uris;
+            memcpy(set->eTag, read.eTag, sizeof(set->eTag));
+        }
+        set->refreshed = monotonicSeconds();
+        set->retryAfter = 0;
+        set->retryInterval = 0;
+    } else {
+        if (read.names.size) {
+            freeHashIndex(&read.names);
+            freeHashIndex(&read.uris);
+        }
+        free(read.templates);
+        if (set) {
+            set->retryInterval = set->retryInterval ? set->retryInterval * 2 : OV_TEMPLATE_RETRY_INTERVAL;
+            if (set->retryInterval > OV_TEMPLATE_TTL) {
+                set->retryInterval = OV_TEMPLATE_TTL;
+            }
+            set->retryAfter = monotonicSeconds() + set->retryInterval;
+        }
+        result = EXIT_FAILURE;
+    }
+    if (set) {
+        set->refreshing = 0;
+    }
+    pthread_cond_broadcast(&templatesRefreshed);
+    return result;
+}
+
+/* Read the templates of the appliance of the session, unless they were read less than
+ * OV_TEMPLATE_TTL seconds ago (force reads them regardless)
+ */
+
+int ovTemplatesRefresh(oneviewSession *session, int force)
+{
+    if (!session || !session->address || !session->cookie) {
+        return EXIT_FAILURE;
+    }
+    int address = ovIntern(session->address);
+    pthread_mutex_lock(&templatesLock);
+    ovTemplateSet *set = findSet(address);
+    int result = EXIT_FAILURE;
+    if (set) {
+        if (!force && set->refreshed != 0 && monotonicSeconds() - set->refreshed < OV_TEMPLATE_TTL) {
+            result = EXIT_SUCCESS;
+        } else {
+            result = refreshSet(session, address, force);
+        }
+    }
+    pthread_mutex_unlock(&templatesLock);
+    return result;
+}
+
+/* Find a template by name, a name that isn't known reads the templates again (at most once
+ * every OV_TEMPLATE_MISS_INTERVAL seconds) as it may have been created since they were read
+ */
+
+int ovTemplateFind(oneviewSession *session, const char *name, ovTemplate *found)
+{
+    if (!session || !session->address || !session->cookie || !name || !found) {
+        return EXIT_FAILURE;
+    }
+    int address = ovIntern(session->address);
+    pthread_mutex_lock(&templatesLock);
+    ovTemplateSet *set = findSet(address);
+    double now = monotonicSeconds();
+    if (set && (set->refreshed == 0 || now - set->refreshed >= OV_TEMPLATE_TTL)) {
+        refreshSet(session, address, 0);
+        set = findSet(address);
+    }
+    int position = set ? ovHashFind(&set->names, name) : OV_HASH_NOT_FOUND;
+    if (set && position == OV_HASH_NOT_FOUND && now - set->missRefreshed >= OV_TEMPLATE_MISS_INTERVAL) {
+        ovPrintDebug(getPluginTime(), "Server profile template not known, reading the templates again\n");
+        set->missRefreshed = now;
+        refreshSet(session, address, 0);
+        set = findSet(address);
+        position = set ? ovHashFind(&set->names, name) : OV_HASH_NOT_FOUND;
+    }
+    if (position == OV_HASH_NOT_FOUND) {
+        pthread_mutex_unlock(&templatesLock);
+        return EXIT_FAILURE;
+    }
+    *found = set->templates[position];
+    pthread_mutex_unlock(&templatesLock);
+    return EXIT_SUCCESS;
+}
+
+/* Serialize the new profile of a template with the markers in place of the fields that are
+ * set for every instance
+ */
+
+static int buildPrototype(ovPrototype *prototype, const char *newProfile)
+{
+    json_error_t error;
+    json_t *newProfileJSON = json_loads(newProfile, 0, &error);
+    if (!json_is_object(newProfileJSON)) {
+        json_decref(newProfileJSON);
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < OV_PROTOTYPE_FIELDS; i++) {
+        json_object_set_new(newProfileJSON, prototypeFields[i], json_string(prototypeMarkers[i]));
+    }
+    char *text = ovDumpJSON(newProfileJSON, JSON_ENSURE_ASCII);
+    json_decref(newProfileJSON);
+    if (!text) {
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < OV_PROTOTYPE_FIELDS; i++) {
+        char marker[64];
+        snprintf(marker, sizeof(marker), "\"%s\"", prototypeMarkers[i]);
+        const char *found = strstr(text, marker);
+        if (!found) {
+            free(text);
+            return EXIT_FAILURE;
+        }
+        // Keep the markers in the order of the text
+        int position = i;
+        while (position > 0 && prototype->markerStart[position - 1] > (size_t)(found - text)) {
+            prototype->fields[position] = prototype->fields[position - 1];
+            prototype->markerStart[position] = prototype->markerStart[position - 1];
+            prototype->markerLength[position] = prototype->markerLength[position - 1];
+            position--;
+        }
+        prototype->fields[position] = i;
+        prototype->markerStart[position] = (size_t)(found - text);
+        prototype->markerLength[position] = strlen(marker);
+    }
+    prototype->text = text;
+    return EXIT_SUCCESS;
+}
+
+/* The prototype of a template if it was made from the template as it is now, templatesLock
+ * is held. A template without an eTag or modified time can't be told apart from an edited
+ * one, its prototype is only good for the batch that read it (so it is never current for
+ * ovTemplatesPrepare, which reads it again, but is used by ovTemplateProfile).
+ */
+
+static ovPrototype *currentPrototype(ovTemplateSet *set, int templateURI, const ovTemplate **template, int oneShot)
+{
+    int position = ovHashFind(&set->uris, ovInternString(templateURI));
+    if (position == OV_HASH_NOT_FOUND) {
+        return NULL;
+    }
+    *template = &set->templates[position];
+    if (!oneShot && (*template)->eTag == OV_INTERN_NONE && (*template)->modified == OV_INTERN_NONE) {
+        return NULL;
+    }
+    position = ovHashFind(&set->prototypeURIs, ovInternString(templateURI));
+    if (position == OV_HASH_NOT_FOUND) {
+        return NULL;
+    }
+    ovPrototype *prototype = &set->prototypes[position];
+    if (prototype->eTag != (*template)->eTag || prototype->modified != (*template)->modified) {
+        return NULL;
+    }
+    return prototype;
+}
+
+/* Replace (or add) the prototype of a template, templatesLock is held
+ */
+
+static int storePrototype(ovTemplateSet *set, ovPrototype *prototype)
+{
+    const char *uri = ovInternString(prototype->templateURI);
+    if (set->prototypeURIs.size == 0 && initHashIndex(&set->prototypeURIs, 16) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    int position = ovHashFind(&set->prototypeURIs, uri);
+    if (position != OV_HASH_NOT_FOUND) {
+        free(set->prototypes[position].text);
+        set->prototypes[position] = *prototype;
+        return EXIT_SUCCESS;
+    }
+    if (set->prototypeCount == set->prototypeSize) {
+        size_t newSize = set->prototypeSize ? set->prototypeSize * 2 : 8;
+        ovPrototype *newPrototypes = realloc(set->prototypes, sizeof(ovPrototype) * newSize);
+        if (!newPrototypes) {
+            return EXIT_FAILURE;
+        }
+        set->prototypes = newPrototypes;
+        set->prototypeSize = newSize;
+    }
+    set->prototypes[set->prototypeCount] = *prototype;
+    return ovHashInsert(&set->prototypeURIs, uri, (int)set->prototypeCount++);
+}
+
+/* Make sure the new profile of each of the templates has been read since the template last
+ * changed, the ones that haven't are read (concurrently) and serialized for ovTemplateProfile
+ */
+
+size_t ovTemplatesPrepare(oneviewSession *session, const int *templateURIs, size_t count)
+{
+    if (!session || !session->address || !session->cookie || !templateURIs) {
+        return 0;
+    }
+    int address = ovIntern(session->address);
+    ovPrototype *stale = calloc(count ? count : 1, sizeof(ovPrototype));
+    char **newProfileURIs = calloc(count ? count : 1, sizeof(char *));
+    char **newProfiles = calloc(count ? count : 1, sizeof(char *));
+    if (!stale || !newProfileURIs || !newProfiles) {
+        free(stale);
+        free(newProfileURIs);
+        free(newProfiles);
+        return 0;
+    }
+
+    // Find the templates that don't have a current prototype (the templates are revalidated
+    // once their TTL has passed, which is how an edited template is noticed)
+    size_t staleCount = 0;
+    size_t prepared = 0;
+    pthread_mutex_lock(&templatesLock);
+    ovTemplateSet *set = findSet(address);
+    if (set && (set->refreshed == 0 || monotonicSeconds() - set->refreshed >= OV_TEMPLATE_TTL)) {
+        refreshSet(session, address, 0);
+        set = findSet(address);
+    }
+    for (size_t i = 0; set && i < count; i++) {
+        const ovTemplate *template = NULL;
+        if (currentPrototype(set, templateURIs[i], &template, 0)) {
+            prepared++;
+            continue;
+        }
+        size_t found = 0;
+        while (found < staleCount && stale[found].templateURI != templateURIs[i]) {
+            found++;
+        }
+        if (template && found == staleCount) {
+            stale[staleCount].templateURI = templateURIs[i];
+            stale[staleCount].eTag = template->eTag;
+            stale[staleCount].modified = template->modified;
+            char newProfileURI[1024];
+            snprintf(newProfileURI, sizeof(newProfileURI), "/%s/new-profile", ovInternString(templateURIs[i]));
+            newProfileURIs[staleCount++] = strdup(newProfileURI);
+        }
+    }
+    pthread_mutex_unlock(&templatesLock);
+
+    // The new profiles are read and serialized without holding the lock
+    if (staleCount != 0) {
+        oneViewMultiQuery(session, newProfileURIs, staleCount, newProfiles);
+    }
+    size_t built = 0;
+    for (size_t i = 0; i < staleCount; i++) {
+        if (newProfiles[i] && buildPrototype(&stale[built], newProfiles[i]) == EXIT_SUCCESS) {
+            stale[built].templateURI = stale[i].templateURI;
+            stale[built].eTag = stale[i].eTag;
+            stale[built].modified = stale[i].modified;
+            built++;
+        }
+        free(newProfiles[i]);
+        free(newProfileURIs[i]);
+    }
+
+    pthread_mutex_lock(&templatesLock);
+    set = findSet(address);
+    for (size_t i = 0; i < built; i++) {
+        if (!set || storePrototype(set, &stale[i]) == EXIT_FAILURE) {
+            free(stale[i].text);
+        }
+    }
+    pthread_mutex_unlock(&templatesLock);
+    if (staleCount != 0) {
+        char ovOutput[1024];
+        snprintf(ovOutput, sizeof(ovOutput), "Read the new profiles of %zu of %zu templates\n", built, staleCount);
+        ovPrintDebug(getPluginTime(), ovOutput);
+    }
+    free(stale);
+    free(newProfileURIs);
+    free(newProfiles);
+    return prepared + built;
+}
+
+/* The body of a new profile of the template for an instance, the fields of the instance are
+ * patched into the serialized new profile (see ovTemplatesPrepare). Returns NULL if there
+ * isn't a current new profile for the template.
+ */
+
+char *ovTemplateProfile(oneviewSession *session, int templateURI, const char *name, const char *hardwareURI, const char *description)
+{
+    static ovJSONWriter *profileWriter;
+    if (!session || !session->address) {
+        return NULL;
+    }
+    const char *values[OV_PROTOTYPE_FIELDS] = { name, hardwareURI, description };
+    char *body = NULL;
+    pthread_mutex_lock(&templatesLock);
+    ovTemplateSet *set = findSet(ovIntern(session->address));
+    const ovTemplate *template = NULL;
+    ovPrototype *prototype = set ? currentPrototype(set, templateURI, &template, 1) : NULL;
+    if (prototype && !profileWriter) {
+        profileWriter = malloc(sizeof(ovJSONWriter));
+        if (profileWriter && initJSONWriter(profileWriter) == EXIT_FAILURE) {
+            free(profileWriter);
+            profileWriter = NULL;
+        }
+    }
+    if (prototype && profileWriter) {
+        ovWriterReset(profileWriter);
+        size_t position = 0;
+        for (int i = 0; i < OV_PROTOTYPE_FIELDS; i++) {
+            ovWriteText(profileWriter, prototype->text + position, prototype->markerStart[i] - position);
+            ovWriteString(profileWriter, values[prototype->fields[i]]);
+            position = prototype->markerStart[i] + prototype->markerLength[i];
+        }
+        ovWriteText(profileWriter, prototype->text + position, strlen(prototype->text + position));
+        const char *text = ovWriterText(profileWriter);
+        body = text ? strdup(text) : NULL;
+    }
+    pthread_mutex_unlock(&templatesLock);
+    return body;
+}
+
+void ovTemplatesClear()
+{
+    pthread_mutex_lock(&templatesLock);
+    for (size_t i = 0; i < setCount; i++) {
+        free(sets[i].templates);
+        if (sets[i].names.size) {
+            freeHashIndex(&sets[i].names);
+            freeHashIndex(&sets[i].uris);
+        }
+        for (size_t j = 0; j < sets[i].prototypeCount; j++) {
+            free(sets[i].prototypes[j].text);
+        }
+        free(sets[i].prototypes);
+        if (sets[i].prototypeURIs.size) {
+            freeHashIndex(&sets[i].prototypeURIs);
+        }
+    }
+    free(sets);
+    sets = NULL;
+    setCount = 0;
+    setSize = 0;
+    pthread_mutex_unlock(&templatesLock);
+}
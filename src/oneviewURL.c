@@ -0,0 +1,209 @@
+
+// oneviewURL.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+
+#include "oneview.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The URL builder writes into a buffer that is owned by the session and re-used
+ * for every request, the buffer only grows when a URL is longer than any that
+ * has been built before, so building a URL doesn't normally touch the heap.
+ */
+
+#define OV_URL_INITIAL_SIZE 1024
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+oneviewURL *initURL()
+{
+    oneviewURL *url = malloc(sizeof(oneviewURL));
+    if (!url) {
+        return NULL;
+    }
+    url->data = malloc(OV_URL_INITIAL_SIZE);
+    if (!url->data) {
+        free(url);
+        return NULL;
+    }
+    url->size = OV_URL_INITIAL_SIZE;
+    url->length = 0;
+    url->parameters = 0;
+    url->data[0] = '\0';
+    return url;
+}
+
+void freeURL(oneviewURL *url)
+{
+    if (url) {
+        free(url->data);
+        free(url);
+    }
+}
+
+void ovURLReset(oneviewURL *url)
+{
+    if (url) {
+        url->length = 0;
+        url->parameters = 0;
+        url->data[0] = '\0';
+    }
+}
+
+/* Ensure that there is space for an additional number of bytes (plus the NULL terminator)
+ */
+
+static int ovURLReserve(oneviewURL *url, size_t additional)
+{
+    size_t required = url->length + additional + 1;
+    if (required <= url->size) {
+        return EXIT_SUCCESS;
+    }
+    size_t newSize = url->size;
+    while (newSize < required) {
+        newSize *= 2;
+    }
+    char *newData = realloc(url->data, newSize);
+    if (!newData) {
+        return EXIT_FAILURE;
+    }
+    url->data = newData;
+    url->size = newSize;
+    return EXIT_SUCCESS;
+}
+
+static int ovURLAppendRaw(oneviewURL *url, const char *text, size_t textLength)
+{
+    if (ovURLReserve(url, textLength) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    memcpy(url->data + url->length, text, textLength);
+    url->length += textLength;
+    url->data[url->length] = '\0';
+    return EXIT_SUCCESS;
+}
+
+int ovURLAppend(oneviewURL *url, const char *text)
+{
+    if (!url || !text) {
+        return EXIT_FAILURE;
+    }
+    size_t textLength = strlen(text);
+    if (ovURLAppendRaw(url, text, textLength) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    // A URI that already carries a query string means further parameters are appended with '&'
+    if (memchr(text, '?', textLength)) {
+        url->parameters++;
+    }
+    return EXIT_SUCCESS;
+}
+
+/* Percent-encode everything apart from the RFC 3986 unreserved characters, this
+ * replaces the use of curl_easy_escape() (which needed a CURL handle per call and
+ * returned a new allocation for every escaped string).
+ */
+
+int ovURLAppendEscaped(oneviewURL *url, const char *text)
+{
+    if (!url || !text) {
+        return EXIT_FAILURE;
+    }
+    // Worst case is every character being expanded to %XX
+    size_t textLength = strlen(text);
+    if (ovURLReserve(url, textLength * 3) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    char *output = url->data + url->length;
+    for (const unsigned char *input = (const unsigned char *)text; *input; input++) {
+        unsigned char c = *input;
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+            c == '-' || c == '_' || c == '.' || c == '~') {
+            *output++ = c;
+        } else {
+            *output++ = '%';
+            *output++ = hexDigits[c >> 4];
+            *output++ = hexDigits[c & 0x0F];
+        }
+    }
+    *output = '\0';
+    url->length = output - url->data;
+    return EXIT_SUCCESS;
+}
+
+/* Append a key=value pair to the query string, the first parameter is prefixed
+ * with a '?' and all subsequent parameters with a '&'
+ */
+
+int ovURLAddParameter(oneviewURL *url, const char *key, const char *value)
+{
+    if (!url || !key || !value) {
+        return EXIT_FAILURE;
+    }
+    if (ovURLAppendRaw(url, url->parameters ? "&" : "?", 1) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    url->parameters++;
+    if (ovURLAppendRaw(url, key, strlen(key)) == EXIT_FAILURE || ovURLAppendRaw(url, "=", 1) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    return ovURLAppendEscaped(url, value);
+}
+
+int ovURLAddIntegerParameter(oneviewURL *url, const char *key, long long value)
+{
+    char number[24];
+    snprintf(number, sizeof(number), "%lld", value);
+    return ovURLAddParameter(url, key, number);
+}
+
+/* Build a complete URL from the session address, the REST uri and an optional query
+ * all of the query fields can be combined.
+ */
+
+int ovURLBuild(oneviewURL *url, const char *address, const char *uri, oneviewQuery *query)
+{
+    if (!url || !address || !uri) {
+        return EXIT_FAILURE;
+    }
+    ovURLReset(url);
+    if (ovURLAppend(url, "https://") == EXIT_FAILURE ||
+        ovURLAppend(url, address) == EXIT_FAILURE ||
+        ovURLAppend(url, uri) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    if (!query) { // No query, typically for a POST
+        return EXIT_SUCCESS;
+    }
+    if (query->filter && ovURLAddParameter(url, "filter", query->filter) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    if (query->query && ovURLAddParameter(url, "query", query->query) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    if (query->sort && ovURLAddParameter(url, "sort", query->sort) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    if (query->fields && ovURLAddParameter(url, "fields", query->fields) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    if (query->start > 0 && ovURLAddIntegerParameter(url, "start", query->start) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    if (query->count > 0 && ovURLAddIntegerParameter(url, "count", query->count) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -14,7 +14,11 @@
 
 #include "oneview.h"
 #include "oneviewHTTP.h"
+#include "oneviewSnapshot.h"
+#include "oneviewExtract.h"
 #include "oneviewInfraKitConsole.h"
+#include "oneviewArena.h"
+#include "oneviewSessions.h"
 
 #include <jansson.h>
 #include <unistd.h>
@@ -34,14 +38,58 @@ oneviewSession *initSession()
     oneviewSession *session = malloc(sizeof(oneviewSession));
     session->cookie = NULL;
     session->address = NULL;
+    session->username = NULL;
+    session->password = NULL;
+    session->managed = -1;
     session->version = 0; // default to a zero header
     
     session->debug = malloc(sizeof(oneviewDebug));
-    session->debug->usedAddress = malloc(1024);
+    session->debug->url = initURL();
+    session->debug->usedAddress = session->debug->url->data;
     session->debug->buffer = NULL;
     return session;
 }
 
+void freeSession(oneviewSession *session)
+{
+    if (session) {
+        // Only an attached session holds its own password and token (see oneviewSessions.h)
+        if (session->managed >= 0) {
+            free(session->password);
+            free((char *)session->cookie);
+        }
+        freeURL(session->debug->url);
+        free(session->debug->buffer);
+        free(session->debug);
+        free(session);
+    }
+}
+
+/* Create and log in a session for the commands that run without InfraKit (statistics and
+ * export), returns NULL if the environment isn't set or the login fails
+ */
+
+oneviewSession *ovSessionFromEnvironment()
+{
+    const char *address = getenv("OV_ADDRESS");
+    const char *username = getenv("OV_USERNAME");
+    const char *password = getenv("OV_PASSWORD");
+    if (!address || !username || !password) {
+        ovPrintError(getPluginTime(), "OV_ADDRESS, OV_USERNAME and OV_PASSWORD need setting\n");
+        return NULL;
+    }
+    oneviewSession *session = initSession();
+    if (!session) {
+        return NULL;
+    }
+    if (ovSessionAttach(session, address, username, password) == EXIT_FAILURE) {
+        ovPrintError(getPluginTime(), "Login Failed\n");
+        freeSession(session);
+        return NULL;
+    }
+    return session;
+}
+
 oneviewQuery *initQuery()
 {
     oneviewQuery *query = malloc(sizeof(oneviewQuery));
@@ -49,6 +97,8 @@ oneviewQuery *initQuery()
     query->start = 0;
     query->query = NULL;
     query->filter = NULL;
+    query->sort = NULL;
+    query->fields = NULL;
     return query;
 }
 
@@ -78,41 +128,23 @@ int stringMatch(const char *string1, const char *string2)
 long long findVersionInJSON (char *httpBuffer)
 {
     // This is a function for handling the tiny piece of JSON that is returned from http://<appliance>/version
-    json_t *versionJSON = NULL;
-    json_error_t error;
-
-    // Parse the JSON
-    versionJSON = json_loads(httpBuffer, 0, &error);
-    
-    if (versionJSON) {
-        json_t *foundVersion = json_object_get(versionJSON, "currentVersion");
-        if (foundVersion) {
-            json_int_t version = json_integer_value(foundVersion);
-            json_decref(versionJSON);
-            return version;
-        }
-        json_decref(versionJSON);
+    ovJSONSlice currentVersion;
+    ovJSONField fields[] = {{ "currentVersion", &currentVersion }};
+    
+    if (httpBuffer && ovExtractFields(httpBuffer, strlen(httpBuffer), fields, 1) == 1) {
+        return ovSliceInteger(&currentVersion);
     }
     return 0;
 }
 
 const char *findCookieInJSON (char *httpBuffer)
 {
+    ovJSONSlice sessionID;
+    ovJSONField fields[] = {{ "sessionID", &sessionID }};
     
-    json_t *cookieJSON = NULL;
-    json_error_t error;
-    
-    // Parse the JSON
-    cookieJSON = json_loads(httpBuffer, 0, &error);
-    
-    if (cookieJSON) {
-        json_t *foundCookie = json_object_get(cookieJSON, "sessionID");
-        if (foundCookie) {
-            const char *cookie = strdup(json_string_value(foundCookie));
-            json_decref(cookieJSON);
-            return cookie;
-        }
-        json_decref(cookieJSON);
+    if (httpBuffer && ovExtractFields(httpBuffer, strlen(httpBuffer), fields, 1) == 1) {
+        // The session keeps its own copy of the cookie
+        return ovSliceDup(&sessionID);
     }
     return 0;
 }
@@ -127,7 +159,7 @@ char *createJSONLoginText(oneviewSession *session)
         
         json_t *reponseJSON = json_pack("{s:s,s:s}", "userName", session->username, "password", session->password);
         if (reponseJSON) {
-            char *login_text = json_dumps(reponseJSON, JSON_ENSURE_ASCII);
+            char *login_text = ovDumpJSON(reponseJSON, JSON_ENSURE_ASCII);
             session->debug->buffer= login_text;
             return session->debug->buffer;
         }
@@ -141,10 +173,19 @@ char *createJSONLoginText(oneviewSession *session)
     *
     */
 
+/* A refused token is renewed by the session manager, the request is then sent again
+ */
+
+static const char *renewSession(void *context)
+{
+    return ovSessionRenew((oneviewSession *)context);
+}
+
 void setOVHeaders(oneviewSession *session)
 {
     if (session)
     {
+        setHttpRenewal((session->managed >= 0) ? renewSession : NULL, session);
         appendHttpHeader("Content-Type: application/json");
         if (session->version > 0)
         {
@@ -171,8 +212,6 @@ long long identifyOneview(oneviewSession *session)
     
     char *httpData;
     long long version = 0;
-    // Wipe the contents of the allocated memory
-    memset(session->debug->usedAddress, 0, sizeof(1024));
     // Create the url and store it in the debug structure
     createURL(session, "/rest/version");
     
@@ -197,9 +236,8 @@ int ovLogin(oneviewSession *session)
     }
     char *httpData;
     char *json_text = createJSONLoginText(session);
-    // Wipe the contents of the allocated memory
-    memset(session->debug->usedAddress, 0, 1024);
-    
+    // The login text is freed here, so the session mustn't keep it
+    session->debug->buffer = NULL;
     // Create the url and store it in the debug structure
     createURL(session, "/rest/login-sessions");
 
@@ -236,7 +274,11 @@ int ovLogin(oneviewSession *session)
     return EXIT_SUCCESS;
 }
 
-int ovPostProfile(oneviewSession *session, char *profile)
+/* The create, delete and power functions return the response of OneView in response (unless
+ * it is NULL), for these operations it is the task that carries them out
+ */
+
+int ovPostProfile(oneviewSession *session, char *profile, char **response)
 {
     if (session->version == 0) {
         ovPrintWarning(getPluginTime(), "HPE Version not discovered, undefined API behavior (checking for session key)\n");
@@ -249,9 +291,6 @@ int ovPostProfile(oneviewSession *session, char *profile)
     
     char *httpData;
 
-    // Wipe the contents of the allocated memory
-    memset(session->debug->usedAddress, 0, 1024);
-    
     // Create the url and store it in the debug structure
     createURL(session, "/rest/server-profiles");
     
@@ -266,16 +305,74 @@ int ovPostProfile(oneviewSession *session, char *profile)
     // Call the function
     httpData = httpFunction(session->debug->usedAddress);
     
+    // The profile changes the hardware it is applied to
+    ovInvalidateHardwareSnapshot();
+    
     if(!httpData) {
         return EXIT_FAILURE;
     }
 
-    // release allocated memory
-    free (httpData);
+    if (response) {
+        *response = httpData;
+    } else {
+        free (httpData);
+    }
     return EXIT_SUCCESS;
 }
 
-int ovDeleteProfile(oneviewSession *session, char *profile)
+/* POST a batch of profiles with at most concurrency requests in flight, the response of each
+ * is placed in responses (NULL if the request failed or OneView returned an error) and the
+ * number created is returned.
+ */
+
+size_t ovPostProfiles(oneviewSession *session, char **profiles, size_t count, char **responses, int concurrency)
+{
+    size_t succeeded = 0;
+    if (!session || !session->address || !profiles || !responses || count == 0) {
+        return 0;
+    }
+    if (!session->cookie) {
+        ovPrintError(getPluginTime(), "No HPE OneView session Key, can't create profile without being logged in\n");
+        return 0;
+    }
+    char **urls = calloc(count, sizeof(char *));
+    if (!urls) {
+        return 0;
+    }
+    // Every profile is posted to the same url
+    createURL(session, "/rest/server-profiles");
+    for (size_t i = 0; i < count; i++) {
+        urls[i] = session->debug->usedAddress;
+    }
+    setOVHeaders(session);
+    SetHttpMethod(DCHTTPPOST);
+    httpMultiDataFunction(urls, profiles, count, responses, concurrency);
+    free(urls);
+    
+    // The profiles change the hardware they are applied to
+    ovInvalidateHardwareSnapshot();
+    
+    for (size_t i = 0; i < count; i++) {
+        if (!responses[i]) {
+            continue;
+        }
+        ovJSONSlice errorCode;
+        ovJSONField field = { "errorCode", &errorCode };
+        ovExtractFields(responses[i], strlen(responses[i]), &field, 1);
+        if (errorCode.type != OV_JSON_MISSING) {
+            char ovOutput[1024];
+            snprintf(ovOutput, sizeof(ovOutput), "Server profile %zu was rejected => %.*s\n", i, (int)errorCode.length, errorCode.start);
+            ovPrintWarning(getPluginTime(), ovOutput);
+            free(responses[i]);
+            responses[i] = NULL;
+            continue;
+        }
+        succeeded++;
+    }
+    return succeeded;
+}
+
+int ovDeleteProfile(oneviewSession *session, char *profile, char **response)
 {
     if (session->version == 0) {
         ovPrintWarning(getPluginTime(), "HPE Version not discovered, undefined API behavior (checking for session key)\n");
@@ -287,9 +384,6 @@ int ovDeleteProfile(oneviewSession *session, char *profile)
     }
     char *httpData;
     
-    // Wipe the contents of the allocated memory
-    memset(session->debug->usedAddress, 0, 1024);
-    
     // Create the url and store it in the debug structure
     createURL(session, profile);
     
@@ -300,6 +394,9 @@ int ovDeleteProfile(oneviewSession *session, char *profile)
     // Call the function
     httpData = httpFunction(session->debug->usedAddress);
     
+    // Removing the profile frees up the hardware it was applied to
+    ovInvalidateHardwareSnapshot();
+    
     if(!httpData) {
         free(profile);
         return EXIT_FAILURE;
@@ -307,11 +404,15 @@ int ovDeleteProfile(oneviewSession *session, char *profile)
     
     // release allocated memory
     free (profile);
-    free (httpData);
+    if (response) {
+        *response = httpData;
+    } else {
+        free (httpData);
+    }
     return EXIT_SUCCESS;
 }
 
-int ovPowerOffHardware(oneviewSession *session, const char *hardwareURI)
+int ovPowerOffHardware(oneviewSession *session, const char *hardwareURI, char **response)
 {
     if (session->version == 0) {
         ovPrintWarning(getPluginTime(), "HPE Version not discovered, undefined API behavior (checking for session key)\n");
@@ -323,8 +424,6 @@ int ovPowerOffHardware(oneviewSession *session, const char *hardwareURI)
     }
     char *httpData;
     
-    // Wipe the contents of the allocated memory
-    memset(session->debug->usedAddress, 0, 1024);
     // Create the url
     char powerURL[1024];
     snprintf(powerURL, 1024, "%s/powerState", hardwareURI);
@@ -333,7 +432,7 @@ int ovPowerOffHardware(oneviewSession *session, const char *hardwareURI)
     createURL(session, powerURL);
     
     json_t *powerJSON = json_pack("{s:s,s:s}", "powerState", "Off", "powerControl", "PressAndHold");
-    char *powerJSONText = json_dumps(powerJSON, JSON_ENSURE_ASCII);
+    char *powerJSONText = ovDumpJSON(powerJSON, JSON_ENSURE_ASCII);
     // Add the JSON test to be posted
     setHttpData(powerJSONText);
     
@@ -344,17 +443,81 @@ int ovPowerOffHardware(oneviewSession *session, const char *hardwareURI)
     // Call the function
     httpData = httpFunction(session->debug->usedAddress);
     
+    ovInvalidateHardwareSnapshot();
+    
     if(!httpData) {
         json_decref(powerJSON);
+        free(powerJSONText);
         return EXIT_FAILURE;
     }
     
     // release allocated memory
     json_decref(powerJSON);
-    free (httpData);
+    free(powerJSONText);
+    if (response) {
+        *response = httpData;
+    } else {
+        free (httpData);
+    }
     return EXIT_SUCCESS;
 }
 
+/* Power off a batch of servers with at most concurrency requests in flight, returns the
+ * number that OneView accepted. The response of each is placed in responses (if it isn't NULL).
+ */
+
+size_t ovPowerOffHardwareBatch(oneviewSession *session, const char **hardwareURIs, size_t count, int concurrency, char **responses)
+{
+    size_t succeeded = 0;
+    if (!session || !session->address || !session->cookie || !hardwareURIs || count == 0) {
+        return 0;
+    }
+    char **kept = responses;
+    char **urls = calloc(count, sizeof(char *));
+    char **bodies = calloc(count, sizeof(char *));
+    if (!responses) {
+        responses = calloc(count, sizeof(char *));
+    } else {
+        memset(responses, 0, sizeof(char *) * count);
+    }
+    json_t *powerJSON = json_pack("{s:s,s:s}", "powerState", "Off", "powerControl", "PressAndHold");
+    char *powerJSONText = ovDumpJSON(powerJSON, JSON_ENSURE_ASCII);
+    json_decref(powerJSON);
+    if (!urls || !bodies || !responses || !powerJSONText) {
+        goto cleanup;
+    }
+    for (size_t i = 0; i < count; i++) {
+        char powerURL[1024];
+        snprintf(powerURL, sizeof(powerURL), "%s/powerState", hardwareURIs[i]);
+        createURL(session, powerURL);
+        urls[i] = strdup(session->debug->usedAddress);
+        if (!urls[i]) {
+            goto cleanup;
+        }
+        bodies[i] = powerJSONText;
+    }
+    setOVHeaders(session);
+    SetHttpMethod(DCHTTPPUT);
+    succeeded = httpMultiDataFunction(urls, bodies, count, responses, concurrency);
+    
+    ovInvalidateHardwareSnapshot();
+    
+cleanup:
+    for (size_t i = 0; urls && i < count; i++) {
+        free(urls[i]);
+    }
+    for (size_t i = 0; !kept && responses && i < count; i++) {
+        free(responses[i]);
+    }
+    if (!kept) {
+        free(responses);
+    }
+    free(urls);
+    free(bodies);
+    free(powerJSONText);
+    return succeeded;
+}
+
  /*
   *
   * File Operations
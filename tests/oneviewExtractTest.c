@@ -0,0 +1,197 @@
+
+// oneviewExtractTest.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#include "oneviewExtract.h"
+#include "oneviewTest.h"
+
+#include <string.h>
+
+/* Every case is extracted twice, by walking the bytes and with a structural index of the
+ * buffer, and both have to give the same slice
+ */
+
+typedef struct {
+    const char *json;
+    const char *path;
+    int found;              // Return of ovExtractFields
+    int type;               // OV_JSON_* of the value
+    const char *value;      // Decoded string, or the raw text of any other value
+} extractCase;
+
+static const extractCase extractCases[] = {
+    { "{\"currentVersion\":800}", "currentVersion", 1, OV_JSON_NUMBER, "800" },
+    { " { \"a\" : \"b\" } ", "a", 1, OV_JSON_STRING, "b" },
+    { "{\"a\":1,\"b\":-2.5e3}", "b", 1, OV_JSON_NUMBER, "-2.5e3" },
+    { "{\"a\":true}", "a", 1, OV_JSON_TRUE, "true" },
+    { "{\"a\":false}", "a", 1, OV_JSON_FALSE, "false" },
+    { "{\"a\":null}", "a", 1, OV_JSON_NULL, "null" },
+    { "{\"a\":[1,{\"b\":2}],\"c\":3}", "a", 1, OV_JSON_ARRAY, "[1,{\"b\":2}]" },
+    { "{\"a\":{\"b\":[]},\"c\":3}", "a", 1, OV_JSON_OBJECT, "{\"b\":[]}" },
+    { "{\"attributes\":{\"state\":\"Completed\"}}", "attributes.state", 1, OV_JSON_STRING, "Completed" },
+    { "{\"attributes\":{\"other\":{\"state\":1}},\"state\":2}", "attributes.state", 0, OV_JSON_MISSING, NULL },
+    { "{\"a\":{\"b\":{\"c\":\"deep\"}}}", "a.b.c", 1, OV_JSON_STRING, "deep" },
+    { "{\"a\":\"x\",\"a\":\"y\"}", "a", 1, OV_JSON_STRING, "x" },
+    { "{\"name\":\"q\\\"uo\\\\te\"}", "name", 1, OV_JSON_STRING, "q\"uo\\te" },
+    { "{\"name\":\"a\\/b\\n\\t\"}", "name", 1, OV_JSON_STRING, "a/b\n\t" },
+    { "{\"name\":\"caf\\u00e9 \\u20ac\"}", "name", 1, OV_JSON_STRING, "caf\xc3\xa9 \xe2\x82\xac" },
+    { "{\"name\":\"\\ud83d\\ude00\"}", "name", 1, OV_JSON_STRING, "\xf0\x9f\x98\x80" },
+    { "{\"skip\":\"}\\\"{[\",\"name\":\"ok\"}", "name", 1, OV_JSON_STRING, "ok" },
+    { "{\"skip\":[\"]\",{\"}\":\"[\"}],\"name\":\"ok\"}", "name", 1, OV_JSON_STRING, "ok" },
+    { "{}", "a", 0, OV_JSON_MISSING, NULL },
+    { "[1,2]", "a", -1, OV_JSON_MISSING, NULL },
+    { "{\"a\" 1}", "a", -1, OV_JSON_MISSING, NULL },
+    { "{\"a\":\"unterminated}", "a", -1, OV_JSON_MISSING, NULL },
+    { "{\"b\":1", "a", -1, OV_JSON_MISSING, NULL },
+};
+
+static int sliceMatches(const ovJSONSlice *slice, int type, const char *value)
+{
+    if (slice->type != type) {
+        return 0;
+    }
+    if (type == OV_JSON_MISSING) {
+        return 1;
+    }
+    if (type == OV_JSON_STRING) {
+        char decoded[64];
+        return ovSliceCopy(slice, decoded, sizeof(decoded)) == strlen(value) && strcmp(decoded, value) == 0 &&
+               ovSliceEquals(slice, value);
+    }
+    return slice->length == strlen(value) && memcmp(slice->start, value, slice->length) == 0;
+}
+
+static void checkExtract(ovStructuralIndex *index)
+{
+    for (size_t i = 0; i < sizeof(extractCases) / sizeof(extractCases[0]); i++) {
+        const extractCase *test = &extractCases[i];
+        size_t length = strlen(test->json);
+        ovJSONSlice slice, indexedSlice;
+        ovJSONField field = { test->path, &slice };
+        ovJSONField indexedField = { test->path, &indexedSlice };
+        int found = ovExtractFields(test->json, length, &field, 1);
+        int indexedFound = -2;
+        if (ovBuildStructuralIndex(index, test->json, length) == EXIT_SUCCESS) {
+            indexedFound = ovExtractIndexedFields(index, test->json, length, &indexedField, 1);
+        }
+        ovTestCheck(found == test->found, test->json, "number of fields found");
+        ovTestCheck(indexedFound == test->found, test->json, "number of fields found with an index");
+        if (test->found >= 0) {
+            ovTestCheck(sliceMatches(&slice, test->type, test->value), test->json, "value");
+            ovTestCheck(sliceMatches(&indexedSlice, test->type, test->value), test->json, "value with an index");
+        }
+    }
+}
+
+/* Several fields in one pass, including an object and a value inside of it
+ */
+
+static void checkFields()
+{
+    static const char json[] = "{\"uri\":\"/rest/a\",\"status\":{\"state\":\"On\",\"power\":\"Off\"},\"count\":3}";
+    ovJSONSlice uri, status, state, power, missing;
+    ovJSONField fields[] = {
+        { "uri", &uri }, { "status", &status }, { "status.state", &state }, { "status.power", &power }, { "none", &missing }
+    };
+    int found = ovExtractFields(json, strlen(json), fields, 5);
+    ovTestCheck(found == 4, "fields", "number of fields found");
+    ovTestCheck(sliceMatches(&uri, OV_JSON_STRING, "/rest/a"), "fields", "uri");
+    ovTestCheck(sliceMatches(&status, OV_JSON_OBJECT, "{\"state\":\"On\",\"power\":\"Off\"}"), "fields", "status");
+    ovTestCheck(sliceMatches(&state, OV_JSON_STRING, "On"), "fields", "status.state");
+    ovTestCheck(sliceMatches(&power, OV_JSON_STRING, "Off"), "fields", "status.power");
+    ovTestCheck(missing.type == OV_JSON_MISSING, "fields", "none");
+}
+
+/* Walk the members of a collection, with and without an index
+ */
+
+static void checkMembers(ovStructuralIndex *index)
+{
+    static const char json[] = "{\"members\":[{\"name\":\"a\\\"\"}, {\"name\":\"b\"} ,\"c\",[],{}],\"count\":5}";
+    static const char *expected[] = { "{\"name\":\"a\\\"\"}", "{\"name\":\"b\"}", "c", "[]", "{}" };
+    ovJSONSlice members;
+    ovJSONField field = { "members", &members };
+    ovBuildStructuralIndex(index, json, strlen(json));
+    for (int indexed = 0; indexed <= 1; indexed++) {
+        const char *name = indexed ? "members with an index" : "members";
+        if (ovExtractIndexedFields(indexed ? index : NULL, json, strlen(json), &field, 1) != 1) {
+            ovTestCheck(0, name, "members not found");
+            continue;
+        }
+        size_t offset = 0, count = 0;
+        ovJSONSlice element;
+        while (ovNextIndexedElement(indexed ? index : NULL, &members, &offset, &element)) {
+            ovTestCheck(count < 5 && element.length == strlen(expected[count]) &&
+                        memcmp(element.start, expected[count], element.length) == 0, name, expected[count < 5 ? count : 4]);
+            count++;
+        }
+        ovTestCheck(count == 5, name, "number of elements");
+
+        ovJSONSlice object = { json, strlen(json), OV_JSON_OBJECT };
+        ovJSONSlice key, value;
+        offset = 0;
+        count = 0;
+        while (ovNextIndexedMember(indexed ? index : NULL, &object, &offset, &key, &value)) {
+            count++;
+        }
+        ovTestCheck(count == 2 && ovSliceEquals(&key, "count") && ovSliceInteger(&value) == 5, name, "object members");
+    }
+}
+
+/* The responses read on the hot paths (see findVersionInJSON and findCookieInJSON in
+ * oneviewUtils.c), the walk stops once every field has been found
+ */
+
+static void checkResponses()
+{
+    static const char version[] = "{\"currentVersion\":800,\"minimumVersion\":120}";
+    static const char login[] = "{\"partnerData\":{\"sessionID\":\"nested\"},\"sessionID\":\"LTIxNjUz_NDU5\"}";
+    static const char refused[] = "{\"errorCode\":\"AUTHN_AUTH_FAIL\",\"message\":\"Invalid user name or password.\"}";
+    static const char truncated[] = "{\"currentVersion\":1000,\"minimumVersion\":[1,";
+    ovJSONSlice value;
+    ovJSONField versionField = { "currentVersion", &value };
+    ovJSONField sessionField = { "sessionID", &value };
+    ovTestCheck(ovExtractFields(version, strlen(version), &versionField, 1) == 1 && ovSliceInteger(&value) == 800, "version", NULL);
+    ovTestCheck(ovExtractFields(login, strlen(login), &sessionField, 1) == 1 && sliceMatches(&value, OV_JSON_STRING, "LTIxNjUz_NDU5"),
+                "login", "the session of the response, not of the partner data");
+    ovTestCheck(ovExtractFields(refused, strlen(refused), &sessionField, 1) == 0, "login refused", NULL);
+    ovTestCheck(ovExtractFields(truncated, strlen(truncated), &versionField, 1) == 1 && ovSliceInteger(&value) == 1000,
+                "stops once found", NULL);
+}
+
+static void checkSliceCopy()
+{
+    ovJSONSlice slice = { "a\\u00e9bc", 9, OV_JSON_STRING };
+    char output[4];
+    ovTestCheck(ovSliceCopy(&slice, output, sizeof(output)) == 5 && strcmp(output, "a\xc3\xa9") == 0, "slice copy", "truncated");
+    char *copy = ovSliceDup(&slice);
+    ovTestCheck(copy && strcmp(copy, "a\xc3\xa9" "bc") == 0, "slice dup", NULL);
+    free(copy);
+    ovTestCheck(!ovSliceEquals(&slice, "a\xc3\xa9" "b"), "slice equals", "shorter value");
+    ovTestCheck(!ovSliceEquals(&slice, "a\xc3\xa9" "bcd"), "slice equals", "longer value");
+    ovJSONSlice number = { "-42", 3, OV_JSON_NUMBER };
+    ovTestCheck(ovSliceInteger(&number) == -42, "slice integer", NULL);
+    ovTestCheck(ovSliceDup(&number) == NULL, "slice dup", "not a string");
+}
+
+int main()
+{
+    ovStructuralIndex index;
+    initStructuralIndex(&index);
+    checkExtract(&index);
+    checkFields();
+    checkMembers(&index);
+    checkResponses();
+    checkSliceCopy();
+    freeStructuralIndex(&index);
+    return ovTestResult("oneviewExtractTest");
+}
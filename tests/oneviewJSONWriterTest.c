@@ -0,0 +1,208 @@
+
+// oneviewJSONWriterTest.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#include "oneviewJSONWriter.h"
+#include "oneviewTest.h"
+
+#include <limits.h>
+#include <string.h>
+#include <jansson.h>
+
+typedef struct {
+    const char *value;
+    const char *escaped;
+} escapeCase;
+
+static const escapeCase escapeCases[] = {
+    { "", "\"\"" },
+    { "Docker Template", "\"Docker Template\"" },
+    { "q\"uote", "\"q\\\"uote\"" },
+    { "back\\slash", "\"back\\\\slash\"" },
+    { "/rest/tasks/1", "\"/rest/tasks/1\"" },
+    { "\n\r\t\b\f", "\"\\n\\r\\t\\b\\f\"" },
+    { "\x01\x1f", "\"\\u0001\\u001f\"" },
+    { "\"\\\"", "\"\\\"\\\\\\\"\"" },
+    { "caf\xc3\xa9 \x7f", "\"caf\xc3\xa9 \x7f\"" },
+};
+
+/* Every string is written on its own and as a key, and has to read back as the same string
+ */
+
+static void checkEscaping(ovJSONWriter *writer)
+{
+    for (size_t i = 0; i < sizeof(escapeCases) / sizeof(escapeCases[0]); i++) {
+        const escapeCase *test = &escapeCases[i];
+        ovWriterReset(writer);
+        ovWriteString(writer, test->value);
+        ovTestCheck(!writer->failed && strcmp(ovWriterText(writer), test->escaped) == 0, test->escaped, ovWriterText(writer));
+
+        ovWriterReset(writer);
+        ovWriteBeginObject(writer);
+        ovWriteKey(writer, test->value);
+        ovWriteString(writer, test->value);
+        ovWriteEndObject(writer);
+        json_t *parsed = json_loadb(ovWriterText(writer), ovWriterLength(writer), 0, NULL);
+        const char *key = parsed ? json_object_iter_key(json_object_iter(parsed)) : NULL;
+        json_t *value = parsed ? json_object_iter_value(json_object_iter(parsed)) : NULL;
+        ovTestCheck(key && strcmp(key, test->value) == 0 && json_string_value(value) &&
+                    strcmp(json_string_value(value), test->value) == 0, test->escaped, "read back");
+        json_decref(parsed);
+    }
+}
+
+static void checkStructure(ovJSONWriter *writer)
+{
+    ovWriterReset(writer);
+    ovWriteRPCBegin(writer);
+    ovWriteKey(writer, "result");
+    ovWriteBeginObject(writer);
+    ovWriteKey(writer, "list");
+    ovWriteBeginArray(writer);
+    ovWriteInteger(writer, -1);
+    ovWriteBoolean(writer, 1);
+    ovWriteBoolean(writer, 0);
+    ovWriteString(writer, NULL);
+    ovWriteBeginArray(writer);
+    ovWriteEndArray(writer);
+    ovWriteBeginObject(writer);
+    ovWriteEndObject(writer);
+    ovWriteEndArray(writer);
+    ovWriteKey(writer, "tags");
+    json_t *tags = json_pack("{s:s}", "hw_uri", "/rest/server-hardware/1");
+    ovWriteJSON(writer, tags);
+    json_decref(tags);
+    ovWriteEndObject(writer);
+    ovWriteRPCEnd(writer, 7);
+    ovTestCheck(!writer->failed && strcmp(ovWriterText(writer),
+                "{\"jsonrpc\":\"2.0\",\"result\":{\"list\":[-1,true,false,null,[],{}],"
+                "\"tags\":{\"hw_uri\":\"/rest/server-hardware/1\"}},\"id\":7}") == 0, "structure", ovWriterText(writer));
+
+    ovWriterReset(writer);
+    ovWriteRPCError(writer, -32601, 3);
+    ovTestCheck(strcmp(ovWriterText(writer), "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32601},\"id\":3}") == 0,
+                "error", ovWriterText(writer));
+
+    // A key outside of an object, closing after a key and nesting too deeply all fail
+    ovWriterReset(writer);
+    ovTestCheck(ovWriteKey(writer, "a") == EXIT_FAILURE && writer->failed, "key outside of an object", NULL);
+    ovWriterReset(writer);
+    ovWriteBeginObject(writer);
+    ovWriteKey(writer, "a");
+    ovTestCheck(ovWriteEndObject(writer) == EXIT_FAILURE && writer->failed, "close after a key", NULL);
+    ovWriterReset(writer);
+    for (int i = 0; i < OV_WRITER_MAX_DEPTH; i++) {
+        ovWriteBeginArray(writer);
+    }
+    ovTestCheck(!writer->failed && ovWriteBeginArray(writer) == EXIT_FAILURE && writer->failed, "nesting", NULL);
+}
+
+/* Output larger than the inline buffer moves to the heap, and reads back the same
+ */
+
+static void checkGrowth(ovJSONWriter *writer)
+{
+    char value[1000];
+    memset(value, '"', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+    ovWriterReset(writer);
+    ovWriteBeginArray(writer);
+    for (int i = 0; i < 20; i++) {
+        ovWriteString(writer, value);
+    }
+    ovWriteEndArray(writer);
+    size_t expected = 2 + 20 * (2 + 2 * (sizeof(value) - 1)) + 19;
+    json_t *parsed = json_loadb(ovWriterText(writer), ovWriterLength(writer), 0, NULL);
+    ovTestCheck(!writer->failed && ovWriterLength(writer) == expected && ovWriterLength(writer) > OV_WRITER_INLINE_SIZE &&
+                json_array_size(parsed) == 20 && strcmp(json_string_value(json_array_get(parsed, 19)), value) == 0,
+                "growth", NULL);
+    json_decref(parsed);
+}
+
+static void checkValues(ovJSONWriter *writer)
+{
+    ovWriterReset(writer);
+    ovWriteBeginArray(writer);
+    ovWriteInteger(writer, LLONG_MIN);
+    ovWriteInteger(writer, LLONG_MAX);
+    ovWriteNull(writer);
+    ovWriteJSON(writer, NULL);
+    json_t *scalar = json_string("caf\xc3\xa9");
+    ovWriteJSON(writer, scalar);
+    json_decref(scalar);
+    ovWriteEndArray(writer);
+    // The case of the hex digits jansson escapes with depends on its version
+    static const char written[] = "[-9223372036854775808,9223372036854775807,null,null,\"caf\\u00";
+    json_t *parsed = json_loadb(ovWriterText(writer), ovWriterLength(writer), 0, NULL);
+    ovTestCheck(!writer->failed && strncmp(ovWriterText(writer), written, strlen(written)) == 0 &&
+                strcmp(json_string_value(json_array_get(parsed, 4)), "caf\xc3\xa9") == 0, "values", ovWriterText(writer));
+    json_decref(parsed);
+    ovTestCheck(ovWriteText(writer, NULL, 0) == EXIT_FAILURE, "values", "no text");
+}
+
+/* The replies of the plugin (see oneviewInfraKitInstance.c) read back as what was written,
+ * and a small reply is back in the inline buffer after a larger one
+ */
+
+static void checkReplies(ovJSONWriter *writer)
+{
+    ovWriterReset(writer);
+    ovWriteRPCBegin(writer);
+    ovWriteKey(writer, "result");
+    ovWriteBeginObject(writer);
+    ovWriteKey(writer, "Descriptions");
+    ovWriteBeginArray(writer);
+    for (int i = 0; i < 3; i++) {
+        ovWriteBeginObject(writer);
+        ovWriteKey(writer, "ID");
+        ovWriteString(writer, "docker-\"1\"");
+        ovWriteKey(writer, "LogicalID");
+        ovWriteNull(writer);
+        ovWriteKey(writer, "Tags");
+        json_t *tags = json_pack("{s:s,s:s}", "infrakit.group", "g1", "hw_uri", "/rest/server-hardware/1");
+        ovWriteJSON(writer, tags);
+        json_decref(tags);
+        ovWriteEndObject(writer);
+    }
+    ovWriteEndArray(writer);
+    ovWriteKey(writer, "Error");
+    ovWriteNull(writer);
+    ovWriteEndObject(writer);
+    ovWriteRPCEnd(writer, 42);
+
+    json_t *expected = json_pack("{s:s,s:{s:[{s:s,s:n,s:{s:s,s:s}},{s:s,s:n,s:{s:s,s:s}},{s:s,s:n,s:{s:s,s:s}}],s:n},s:i}",
+                                 "jsonrpc", "2.0", "result", "Descriptions",
+                                 "ID", "docker-\"1\"", "LogicalID", "Tags", "infrakit.group", "g1", "hw_uri", "/rest/server-hardware/1",
+                                 "ID", "docker-\"1\"", "LogicalID", "Tags", "infrakit.group", "g1", "hw_uri", "/rest/server-hardware/1",
+                                 "ID", "docker-\"1\"", "LogicalID", "Tags", "infrakit.group", "g1", "hw_uri", "/rest/server-hardware/1",
+                                 "Error", "id", 42);
+    json_t *parsed = json_loadb(ovWriterText(writer), ovWriterLength(writer), 0, NULL);
+    ovTestCheck(!writer->failed && json_equal(parsed, expected), "describe reply", ovWriterText(writer));
+    ovTestCheck(writer->data == writer->inlineData, "describe reply", "inline");
+    json_decref(parsed);
+    json_decref(expected);
+}
+
+int main()
+{
+    static ovJSONWriter writer;
+    if (initJSONWriter(&writer) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    checkEscaping(&writer);
+    checkStructure(&writer);
+    checkValues(&writer);
+    checkGrowth(&writer);
+    checkReplies(&writer);
+    freeJSONWriter(&writer);
+    return ovTestResult("oneviewJSONWriterTest");
+}
@@ -0,0 +1,144 @@
+
+// oneviewLedgerTest.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#include "oneviewInfraKitLedger.h"
+#include "oneviewIntern.h"
+#include "oneviewTest.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <jansson.h>
+
+/* The state module is stood in for by a state with two instances, the ledger is loaded from
+ * it the first time it is needed
+ */
+
+static const char stateText[] = "{\"StateVersion\":\"0.3.0\",\"OneViewGroups\":[{\"groupName\":\"g1\",\"Instances\":["
+                                "{\"ID\":\"a-1\",\"Tags\":{\"hw_uri\":\"/rest/server-hardware/A\"}},"
+                                "{\"ID\":\"b-1\",\"Tags\":{\"hw_uri\":\"/rest/server-hardware/B\"}}]}]}";
+static int stateLocked;
+
+void lockInstanceState()
+{
+    stateLocked++;
+}
+
+void unlockInstanceState()
+{
+    stateLocked--;
+}
+
+json_t *openInstanceState()
+{
+    return json_loads(stateText, 0, NULL);
+}
+
+int stringMatch(const char *string1, const char *string2)
+{
+    return string1 && string2 && strcmp(string1, string2) == 0;
+}
+
+static void checkOwner(int hardwareURI, const char *expected, const char *name)
+{
+    char *owner = ovLedgerOwner(hardwareURI);
+    ovTestCheck((!owner && !expected) || (owner && expected && strcmp(owner, expected) == 0), name, owner);
+    free(owner);
+}
+
+static void checkLoad()
+{
+    int a = ovIntern("/rest/server-hardware/A");
+    ovTestCheck(ovLedgerLoad() == EXIT_SUCCESS && stateLocked == 0, "load", NULL);
+    ovTestCheck(ovLedgerClaimed() == 2, "load", "servers of the state are held");
+    checkOwner(a, "a-1", "load owner");
+    ovTestCheck(ovLedgerClaim(a) == EXIT_FAILURE, "load", "a recorded server can't be claimed");
+    ovTestCheck(ovLedgerLoad() == EXIT_SUCCESS && ovLedgerClaimed() == 2, "load", "only loaded once");
+}
+
+/* A server is leased when it is claimed, recorded with its instance and released by it
+ */
+
+static void checkLeaseRecordRelease()
+{
+    int c = ovIntern("/rest/server-hardware/C");
+    ovTestCheck(!ovLedgerIsClaimed(c) && ovLedgerClaim(c) == EXIT_SUCCESS, "lease", NULL);
+    ovTestCheck(ovLedgerIsClaimed(c) && ovLedgerClaim(c) == EXIT_FAILURE, "lease", "claimed twice");
+    checkOwner(c, NULL, "lease owner");
+
+    ovTestCheck(ovLedgerRecord(c, "c-1") == EXIT_SUCCESS && ovLedgerIsClaimed(c), "record", NULL);
+    checkOwner(c, "c-1", "record owner");
+    ovTestCheck(ovLedgerRelease(c, NULL) == EXIT_FAILURE, "release", "a recorded server isn't freed as a lease");
+    ovTestCheck(ovLedgerRelease(c, "other-1") == EXIT_FAILURE && ovLedgerIsClaimed(c), "release", "another instance");
+    ovTestCheck(ovLedgerRelease(c, "c-1") == EXIT_SUCCESS && !ovLedgerIsClaimed(c), "release", NULL);
+    checkOwner(c, NULL, "release owner");
+    ovTestCheck(ovLedgerClaim(c) == EXIT_SUCCESS, "release", "claimed again");
+
+    // A lease that is given up (the instance never made it into the state)
+    ovTestCheck(ovLedgerRelease(c, NULL) == EXIT_SUCCESS && !ovLedgerIsClaimed(c), "release lease", NULL);
+
+    // An instance recorded without a lease (the state was written by another path)
+    int d = ovIntern("/rest/server-hardware/D");
+    ovTestCheck(ovLedgerRecord(d, "d-1") == EXIT_SUCCESS && ovLedgerClaim(d) == EXIT_FAILURE, "record unleased", NULL);
+    ovTestCheck(ovLedgerRelease(d, "d-1") == EXIT_SUCCESS, "record unleased", "released");
+
+    ovTestCheck(ovLedgerRelease(ovIntern("/rest/server-hardware/unknown"), NULL) == EXIT_FAILURE, "release", "unknown server");
+    ovTestCheck(ovLedgerClaim(OV_INTERN_NONE) == EXIT_FAILURE, "claim", "no server");
+    ovTestCheck(ovLedgerClaimed() == 2, "claimed", "only the servers of the state are left");
+}
+
+/* Threads racing to claim the same servers, each server is only claimed once
+ */
+
+#define RACE_THREADS 8
+#define RACE_SERVERS 64
+
+static int raceServers[RACE_SERVERS];
+
+static void *raceClaims(void *argument)
+{
+    size_t *claimed = argument;
+    for (int i = 0; i < RACE_SERVERS; i++) {
+        if (ovLedgerClaim(raceServers[i]) == EXIT_SUCCESS) {
+            (*claimed)++;
+        }
+    }
+    return NULL;
+}
+
+static void checkRace()
+{
+    char uri[64];
+    for (int i = 0; i < RACE_SERVERS; i++) {
+        snprintf(uri, sizeof(uri), "/rest/server-hardware/race-%d", i);
+        raceServers[i] = ovIntern(uri);
+    }
+    pthread_t threads[RACE_THREADS];
+    size_t claimed[RACE_THREADS] = { 0 };
+    for (int i = 0; i < RACE_THREADS; i++) {
+        pthread_create(&threads[i], NULL, raceClaims, &claimed[i]);
+    }
+    size_t total = 0;
+    for (int i = 0; i < RACE_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        total += claimed[i];
+    }
+    ovTestCheck(total == RACE_SERVERS && ovLedgerClaimed() == 2 + RACE_SERVERS, "race", "each server claimed once");
+}
+
+int main()
+{
+    checkLoad();
+    checkLeaseRecordRelease();
+    checkRace();
+    return ovTestResult("oneviewLedgerTest");
+}
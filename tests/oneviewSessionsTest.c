@@ -0,0 +1,159 @@
+
+// oneviewSessionsTest.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#include "oneviewSessions.h"
+#include "oneviewTest.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+/* The appliance is stood in for by a login that takes a while (so that the threads attaching
+ * at the same time all find it in progress) and gives out a new token every time, a password
+ * of "wrong" is refused
+ */
+
+static pthread_mutex_t countLock = PTHREAD_MUTEX_INITIALIZER;
+static int logins;
+static int identifies;
+
+oneviewSession *initSession()
+{
+    return calloc(1, sizeof(oneviewSession));
+}
+
+long long identifyOneview(oneviewSession *session)
+{
+    pthread_mutex_lock(&countLock);
+    identifies++;
+    pthread_mutex_unlock(&countLock);
+    return 800;
+}
+
+int ovLogin(oneviewSession *session)
+{
+    usleep(20000);
+    if (strcmp(session->password, "wrong") == 0) {
+        return EXIT_FAILURE;
+    }
+    char token[64];
+    pthread_mutex_lock(&countLock);
+    snprintf(token, sizeof(token), "token-%d", ++logins);
+    pthread_mutex_unlock(&countLock);
+    session->cookie = strdup(token);
+    return EXIT_SUCCESS;
+}
+
+int stringMatch(const char *string1, const char *string2)
+{
+    return string1 && string2 && strcmp(string1, string2) == 0;
+}
+
+#define TEST_THREADS 8
+
+typedef struct {
+    oneviewSession session;
+    int attached;
+    const char *renewed;
+} testThread;
+
+static void *attachThread(void *argument)
+{
+    testThread *thread = argument;
+    thread->attached = ovSessionAttach(&thread->session, "ov", "admin", "password");
+    return NULL;
+}
+
+static void *renewThread(void *argument)
+{
+    testThread *thread = argument;
+    thread->renewed = ovSessionRenew(&thread->session);
+    return NULL;
+}
+
+static void runThreads(testThread *threads, void *(*run)(void *))
+{
+    pthread_t ids[TEST_THREADS];
+    for (int i = 0; i < TEST_THREADS; i++) {
+        pthread_create(&ids[i], NULL, run, &threads[i]);
+    }
+    for (int i = 0; i < TEST_THREADS; i++) {
+        pthread_join(ids[i], NULL);
+    }
+}
+
+/* Threads attaching to the same appliance and user at once share one login, and each have
+ * their own copy of the token
+ */
+
+static void checkConcurrentAttach(testThread *threads)
+{
+    for (int i = 0; i < TEST_THREADS; i++) {
+        threads[i].session.managed = -1;
+    }
+    runThreads(threads, attachThread);
+    int attached = 1;
+    for (int i = 0; i < TEST_THREADS; i++) {
+        attached = attached && threads[i].attached == EXIT_SUCCESS && threads[i].session.version == 800 &&
+                   stringMatch(threads[i].session.cookie, "token-1") && (i == 0 || threads[i].session.cookie != threads[0].session.cookie);
+    }
+    ovTestCheck(attached, "concurrent attach", threads[0].session.cookie);
+    ovTestCheck(logins == 1 && identifies == 1, "concurrent attach", "one login");
+
+    // Once attached the password isn't needed again
+    ovTestCheck(ovSessionAttach(&threads[0].session, "ov", "admin", NULL) == EXIT_SUCCESS && logins == 1, "attach again", NULL);
+}
+
+/* A refused token is renewed once, the threads holding the same token all get the new one
+ */
+
+static void checkConcurrentRenew(testThread *threads)
+{
+    runThreads(threads, renewThread);
+    int renewed = 1;
+    for (int i = 0; i < TEST_THREADS; i++) {
+        renewed = renewed && stringMatch(threads[i].renewed, "token-2") && threads[i].renewed == threads[i].session.cookie;
+    }
+    ovTestCheck(renewed && logins == 2 && identifies == 1, "concurrent renew", threads[0].renewed);
+}
+
+static void checkCredentials()
+{
+    oneviewSession session;
+    memset(&session, 0, sizeof(session));
+    session.managed = -1;
+    ovTestCheck(ovSessionAttach(&session, "ov", "operator", NULL) == EXIT_FAILURE, "no password", NULL);
+    ovTestCheck(ovSessionAttach(&session, "ov", "operator", "wrong") == EXIT_FAILURE && session.managed == -1, "refused", NULL);
+    ovTestCheck(ovSessionAttach(&session, "ov", "operator", "operator") == EXIT_SUCCESS &&
+                stringMatch(session.cookie, "token-3") && identifies == 2, "another user", session.cookie);
+
+    // New credentials for an appliance and user log in again with them
+    ovTestCheck(ovSessionAttach(&session, "ov", "operator", "changed") == EXIT_SUCCESS &&
+                stringMatch(session.cookie, "token-4") && stringMatch(session.password, "changed"), "new password", session.cookie);
+    ovTestCheck(ovSessionAttach(&session, "ov", "operator", "wrong") == EXIT_FAILURE && logins == 4, "new password refused", NULL);
+    free(session.password);
+    free((char *)session.cookie);
+}
+
+int main()
+{
+    static testThread threads[TEST_THREADS];
+    checkConcurrentAttach(threads);
+    checkConcurrentRenew(threads);
+    checkCredentials();
+    for (int i = 0; i < TEST_THREADS; i++) {
+        free(threads[i].session.password);
+        free((char *)threads[i].session.cookie);
+    }
+    return ovTestResult("oneviewSessionsTest");
+}
@@ -0,0 +1,235 @@
+
+// oneviewSnapshotTest.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#include "oneviewSnapshot.h"
+#include "oneviewTest.h"
+
+#include <string.h>
+#include <jansson.h>
+
+/* The appliance is stood in for by a server-hardware collection of two pages, with three
+ * free servers of type A (two on the first page and one on the second), one of type A with a
+ * profile and one of type B. The inventory is stood in for by the same servers keyed by uri.
+ */
+
+static const char page1[] = "{\"members\":["
+    "{\"uri\":\"/rest/server-hardware/1\",\"name\":\"bay 1\",\"state\":\"NoProfileApplied\",\"powerState\":\"Off\","
+    "\"serverHardwareTypeUri\":\"/rest/server-hardware-types/A\",\"locationUri\":\"/rest/enclosures/1\"},"
+    "{\"uri\":\"/rest/server-hardware/2\",\"name\":\"bay 2\",\"state\":\"ProfileApplied\",\"powerState\":\"On\","
+    "\"serverProfileUri\":\"/rest/server-profiles/2\",\"serverHardwareTypeUri\":\"/rest/server-hardware-types/A\","
+    "\"locationUri\":\"/rest/enclosures/1\"},"
+    "{\"uri\":\"/rest/server-hardware/3\",\"name\":\"bay 3\",\"state\":\"NoProfileApplied\",\"powerState\":\"Off\","
+    "\"serverHardwareTypeUri\":\"/rest/server-hardware-types/B\",\"locationUri\":\"/rest/enclosures/2\"},"
+    "{\"uri\":\"/rest/server-hardware/4\",\"name\":\"bay 4\",\"state\":\"NoProfileApplied\",\"powerState\":\"Off\","
+    "\"serverHardwareTypeUri\":\"/rest/server-hardware-types/A\",\"locationUri\":\"/rest/enclosures/2\"}],"
+    "\"nextPageUri\":\"/rest/server-hardware?start=4&count=4\"}";
+static const char page2[] = "{\"members\":["
+    "{\"uri\":\"/rest/server-hardware/5\",\"name\":\"bay 5\",\"state\":\"NoProfileApplied\",\"powerState\":\"Off\","
+    "\"description\":\"a \\\"quoted\\\" description\",\"serverHardwareTypeUri\":\"/rest/server-hardware-types/A\","
+    "\"locationUri\":\"/rest/enclosures/2\"}],\"nextPageUri\":null}";
+
+static int restReads;
+static int failPage;
+static int live;
+static unsigned long generation = 1;
+
+char *ovQueryServerHardware(oneviewSession *session, oneviewQuery *query)
+{
+    restReads++;
+    return strdup(page1);
+}
+
+char *ovQueryWithURI(oneviewSession *session, const char *uri)
+{
+    restReads++;
+    return (!failPage && strcmp(uri, "/rest/server-hardware?start=4&count=4") == 0) ? strdup(page2) : NULL;
+}
+
+int inventoryIsLive()
+{
+    return live;
+}
+
+unsigned long inventoryGeneration()
+{
+    return generation;
+}
+
+json_t *inventoryCopyHardware(unsigned long *copied)
+{
+    json_t *inventory = json_object();
+    json_t *pages[] = { json_loads(page1, 0, NULL), json_loads(page2, 0, NULL) };
+    size_t index;
+    json_t *member;
+    for (int i = 0; i < 2; i++) {
+        json_array_foreach(json_object_get(pages[i], "members"), index, member) {
+            json_object_set(inventory, json_string_value(json_object_get(member, "uri")), member);
+        }
+        json_decref(pages[i]);
+    }
+    *copied = generation;
+    return inventory;
+}
+
+int stringMatch(const char *string1, const char *string2)
+{
+    return string1 && string2 && strcmp(string1, string2) == 0;
+}
+
+static void freeHardware(oneviewHardware *hardware)
+{
+    if (hardware) {
+        free(hardware->uri);
+        free(hardware->name);
+        free(hardware->state);
+        free(hardware->powerState);
+        free(hardware->serverProfileUri);
+        free(hardware->serverHardwareTypeUri);
+        free(hardware->enclosureUri);
+        free(hardware->description);
+        free(hardware);
+    }
+}
+
+/* Walk a chain of servers into servers, returning the number walked
+ */
+
+static size_t walkFree(oneviewHardwareSnapshot *snapshot, const char *typeURI, int *servers, size_t maxServers)
+{
+    size_t count = 0;
+    for (int server = ovSnapshotFirstFree(snapshot, typeURI); server != OV_SNAPSHOT_END && count < maxServers;
+         server = ovSnapshotNextFree(snapshot, server)) {
+        servers[count++] = server;
+    }
+    return count;
+}
+
+static int chainIs(const int *servers, size_t count, const int *expected, size_t expectedCount)
+{
+    return count == expectedCount && memcmp(servers, expected, count * sizeof(int)) == 0;
+}
+
+static void checkChains(oneviewHardwareSnapshot *snapshot, const char *test)
+{
+    int servers[8];
+    static const int freeOfA[] = { 0, 3, 4 };
+    static const int freeOfB[] = { 2 };
+    static const int ofA[] = { 0, 1, 3, 4 };
+    static const int inEnclosure2[] = { 2, 3, 4 };
+    ovTestCheck(snapshot && snapshot->count == 5 && snapshot->typeCount == 2 && snapshot->enclosureCount == 2, test, "counts");
+    ovTestCheck(chainIs(servers, walkFree(snapshot, "/rest/server-hardware-types/A", servers, 8), freeOfA, 3), test, "free of A");
+    ovTestCheck(chainIs(servers, walkFree(snapshot, "/rest/server-hardware-types/B", servers, 8), freeOfB, 1), test, "free of B");
+
+    // Walking a free list doesn't take the servers off of it, every holder sees every server
+    ovTestCheck(chainIs(servers, walkFree(snapshot, "/rest/server-hardware-types/A", servers, 8), freeOfA, 3), test, "walked again");
+
+    size_t count = 0;
+    for (int server = ovSnapshotFirstOfType(snapshot, "/rest/server-hardware-types/A"); server != OV_SNAPSHOT_END && count < 8;
+         server = snapshot->nextOfType[server]) {
+        servers[count++] = server;
+    }
+    ovTestCheck(chainIs(servers, count, ofA, 4), test, "of type A");
+    count = 0;
+    for (int server = ovSnapshotFirstInEnclosure(snapshot, "/rest/enclosures/2"); server != OV_SNAPSHOT_END && count < 8;
+         server = snapshot->nextInEnclosure[server]) {
+        servers[count++] = server;
+    }
+    ovTestCheck(chainIs(servers, count, inEnclosure2, 3), test, "in enclosure 2");
+
+    oneviewHardwareFilter filter = { ovSnapshotTypeId(snapshot, "/rest/server-hardware-types/A"), OV_SNAPSHOT_ANY,
+                                     OV_HARDWARE_STATE_NO_PROFILE, OV_POWER_OFF, 1 };
+    ovTestCheck(chainIs(servers, ovSnapshotSelect(snapshot, &filter, servers, 8), freeOfA, 3), test, "select");
+
+    ovTestCheck(ovSnapshotFirstFree(snapshot, "/rest/server-hardware-types/unknown") == OV_SNAPSHOT_END &&
+                ovSnapshotNextFree(snapshot, 5) == OV_SNAPSHOT_END && ovSnapshotNextFree(snapshot, -1) == OV_SNAPSHOT_END,
+                test, "out of range");
+}
+
+static void checkHardware(oneviewHardwareSnapshot *snapshot)
+{
+    oneviewHardware *assigned = ovSnapshotHardware(snapshot, ovSnapshotFindURI(snapshot, "/rest/server-hardware/2"));
+    ovTestCheck(assigned && stringMatch(assigned->name, "bay 2") && stringMatch(assigned->state, "ProfileApplied") &&
+                stringMatch(assigned->powerState, "On") && stringMatch(assigned->serverProfileUri, "/rest/server-profiles/2") &&
+                stringMatch(assigned->enclosureUri, "/rest/enclosures/1") && !assigned->description, "hardware", "assigned");
+    freeHardware(assigned);
+    oneviewHardware *described = ovSnapshotHardware(snapshot, ovSnapshotFindURI(snapshot, "/rest/server-hardware/5"));
+    ovTestCheck(described && stringMatch(described->description, "a \"quoted\" description") && !described->serverProfileUri &&
+                stringMatch(described->serverHardwareTypeUri, "/rest/server-hardware-types/A"), "hardware", "description");
+    freeHardware(described);
+    ovTestCheck(ovSnapshotFindURI(snapshot, "/rest/server-hardware/unknown") == OV_SNAPSHOT_END &&
+                ovSnapshotHardware(snapshot, 5) == NULL, "hardware", "unknown");
+}
+
+/* A snapshot is shared while it is fresh, a holder keeps its snapshot when it is invalidated
+ */
+
+static void checkLifeCycle(oneviewSession *session)
+{
+    oneviewHardwareSnapshot *snapshot = ovAcquireHardwareSnapshot(session);
+    ovTestCheck(snapshot && restReads == 2, "rest", "both pages read");
+    checkChains(snapshot, "rest");
+    checkHardware(snapshot);
+
+    oneviewHardwareSnapshot *shared = ovAcquireHardwareSnapshot(session);
+    ovTestCheck(shared == snapshot && restReads == 2, "shared", NULL);
+    ovReleaseHardwareSnapshot(shared);
+
+    ovInvalidateHardwareSnapshot();
+    ovTestCheck(ovCurrentHardwareSnapshot(session) == NULL, "invalidated", NULL);
+    checkChains(snapshot, "held after invalidation");
+    oneviewHardwareSnapshot *reloaded = ovAcquireHardwareSnapshot(session);
+    ovTestCheck(reloaded && reloaded != snapshot && restReads == 4, "reloaded", NULL);
+    ovReleaseHardwareSnapshot(snapshot);
+    ovReleaseHardwareSnapshot(reloaded);
+
+    // Another user doesn't get the snapshot of the first
+    oneviewSession other = *session;
+    other.username = "operator";
+    oneviewHardwareSnapshot *otherSnapshot = ovAcquireHardwareSnapshot(&other);
+    ovTestCheck(otherSnapshot && otherSnapshot != reloaded && restReads == 6, "other user", NULL);
+    ovReleaseHardwareSnapshot(otherSnapshot);
+
+    // A page that can't be read fails the load rather than leaving servers out
+    ovInvalidateHardwareSnapshot();
+    failPage = 1;
+    ovTestCheck(ovAcquireHardwareSnapshot(session) == NULL, "failed page", NULL);
+    failPage = 0;
+}
+
+static void checkInventory(oneviewSession *session)
+{
+    live = 1;
+    int reads = restReads;
+    oneviewHardwareSnapshot *snapshot = ovAcquireHardwareSnapshot(session);
+    ovTestCheck(snapshot && snapshot->generation == 1 && restReads == reads, "inventory", NULL);
+    checkChains(snapshot, "inventory");
+    generation++;
+    oneviewHardwareSnapshot *changed = ovAcquireHardwareSnapshot(session);
+    ovTestCheck(changed && changed != snapshot && changed->generation == 2, "inventory changed", NULL);
+    ovReleaseHardwareSnapshot(snapshot);
+    ovReleaseHardwareSnapshot(changed);
+    ovInvalidateHardwareSnapshot();
+    live = 0;
+}
+
+int main()
+{
+    oneviewSession session;
+    memset(&session, 0, sizeof(session));
+    session.address = "ov";
+    session.username = "admin";
+    session.cookie = "cookie";
+    checkLifeCycle(&session);
+    checkInventory(&session);
+    return ovTestResult("oneviewSnapshotTest");
+}
@@ -0,0 +1,203 @@
+
+// oneviewStateTest.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#include "oneviewInfraKitState.h"
+#include "oneviewInfraKitLedger.h"
+#include "oneviewIntern.h"
+#include "oneviewTest.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <jansson.h>
+
+/* The statuses an instance goes through as the pipeline posts its profile and the task
+ * tracker follows its task, and what a Destroy does to it at each of them. The state is a
+ * temporary file, the ledger is loaded from it.
+ */
+
+int instanceLogin(const char *address, const char *username, const char *password)
+{
+    return EXIT_FAILURE;
+}
+
+int stringMatch(const char *string1, const char *string2)
+{
+    return string1 && string2 && strcmp(string1, string2) == 0;
+}
+
+typedef struct {
+    const char *id;
+    const char *status;
+    const char *task;
+} stateInstance;
+
+static const stateInstance initialInstances[] = {
+    { "pending-1", OV_INSTANCE_PENDING, NULL },
+    { "pending-2", OV_INSTANCE_PENDING, NULL },
+    { "pending-3", OV_INSTANCE_PENDING, NULL },
+    { "pending-4", OV_INSTANCE_PENDING, NULL },
+    { "creating-1", OV_INSTANCE_CREATING, "/rest/tasks/c1" },
+    { "applied-1", OV_INSTANCE_APPLIED, "/rest/tasks/a1" },
+    { "failed-1", OV_INSTANCE_FAILED, NULL },
+    { "posting-1", OV_INSTANCE_POSTING, NULL },
+    { "destroyed-1", OV_INSTANCE_DESTROYED, NULL },
+};
+
+#define STATE_INSTANCES (sizeof(initialInstances) / sizeof(initialInstances[0]))
+
+static int writeInitialState()
+{
+    json_t *instances = json_array();
+    char hardwareURI[64];
+    for (size_t i = 0; i < STATE_INSTANCES; i++) {
+        snprintf(hardwareURI, sizeof(hardwareURI), "/rest/server-hardware/%s", initialInstances[i].id);
+        json_t *tags = json_pack("{s:s,s:s}", "hw_uri", hardwareURI, OV_INSTANCE_STATUS_TAG, initialInstances[i].status);
+        if (initialInstances[i].task) {
+            json_object_set_new(tags, OV_INSTANCE_TASK_TAG, json_string(initialInstances[i].task));
+        }
+        json_array_append_new(instances, json_pack("{s:s,s:o}", "ID", initialInstances[i].id, "Tags", tags));
+    }
+    json_t *state = json_pack("{s:s,s:[{s:s,s:o}]}", "StateVersion", "0.3.0", "OneViewGroups", "groupName", "g1", "Instances", instances);
+    char *text = json_dumps(state, 0);
+    int saved = saveInstanceState(text);
+    free(text);
+    json_decref(state);
+    return saved;
+}
+
+/* The status of an instance in the state (copied), NULL if it isn't there
+ */
+
+static char *statusOf(const char *instanceID)
+{
+    json_t *state = openInstanceState();
+    char *status = NULL;
+    size_t index;
+    json_t *instance;
+    json_array_foreach(json_object_get(findGroup(state, "g1"), "Instances"), index, instance) {
+        if (stringMatch(json_string_value(json_object_get(instance, "ID")), instanceID)) {
+            const char *value = json_string_value(json_object_get(json_object_get(instance, "Tags"), OV_INSTANCE_STATUS_TAG));
+            status = strdup(value ? value : "");
+        }
+    }
+    json_decref(state);
+    return status;
+}
+
+static void checkStatus(const char *instanceID, const char *expected, const char *test)
+{
+    char *status = statusOf(instanceID);
+    ovTestCheck((!status && !expected) || (status && expected && strcmp(status, expected) == 0), test, status ? status : instanceID);
+    free(status);
+}
+
+static int isClaimed(const char *instanceID)
+{
+    char hardwareURI[64];
+    snprintf(hardwareURI, sizeof(hardwareURI), "/rest/server-hardware/%s", instanceID);
+    return ovLedgerIsClaimed(ovIntern(hardwareURI));
+}
+
+/* Only pending instances are taken by the pipeline
+ */
+
+static void checkPosting()
+{
+    const char *ids[] = { "pending-1", "pending-2", "applied-1", "unknown" };
+    char posting[4];
+    ovTestCheck(markInstancesPosting(ids, 4, posting) == 2 && posting[0] && posting[1] && !posting[2] && !posting[3], "posting", NULL);
+    checkStatus("pending-1", OV_INSTANCE_POSTING, "posting");
+    checkStatus("applied-1", OV_INSTANCE_APPLIED, "posting not pending");
+}
+
+/* A Destroy removes what nothing was posted for, and defers what is being posted or created
+ */
+
+static void checkDestroy()
+{
+    ovTestCheck(destroyInstanceInState("pending-3", "g1") == OV_DESTROY_REMOVED && !isClaimed("pending-3"), "destroy pending", NULL);
+    checkStatus("pending-3", NULL, "destroy pending");
+    ovTestCheck(destroyInstanceInState("failed-1", "g1") == OV_DESTROY_REMOVED && !isClaimed("failed-1"), "destroy failed", NULL);
+    ovTestCheck(destroyInstanceInState("pending-2", "g1") == OV_DESTROY_DEFERRED && isClaimed("pending-2"), "destroy posting", NULL);
+    checkStatus("pending-2", OV_INSTANCE_DESTROYED, "destroy posting");
+    ovTestCheck(destroyInstanceInState("creating-1", "g1") == OV_DESTROY_DEFERRED, "destroy creating", NULL);
+    ovTestCheck(destroyInstanceInState("pending-2", "g1") == OV_DESTROY_DEFERRED, "destroy twice", NULL);
+    ovTestCheck(destroyInstanceInState("applied-1", "g1") == OV_DESTROY_POSTED && isClaimed("applied-1"), "destroy applied", NULL);
+    checkStatus("applied-1", OV_INSTANCE_APPLIED, "destroy applied");
+    ovTestCheck(destroyInstanceInState("unknown", "g1") == OV_DESTROY_NOT_FOUND, "destroy unknown", NULL);
+    ovTestCheck(destroyInstanceInState("pending-1", "g2") == OV_DESTROY_NOT_FOUND, "destroy in another group", NULL);
+}
+
+/* The posted profiles, a destroyed instance keeps its status and is flagged once its profile
+ * exists (to be deleted), or removed if its profile failed
+ */
+
+static void checkStatuses()
+{
+    const char *ids[] = { "pending-1", "pending-2" };
+    const char *creating[] = { OV_INSTANCE_CREATING, OV_INSTANCE_CREATING };
+    const char *tasks[] = { "/rest/tasks/p1", "/rest/tasks/p2" };
+    char destroyed[2];
+    ovTestCheck(setInstanceStatuses(ids, creating, tasks, 2, destroyed) == EXIT_SUCCESS && !destroyed[0] && !destroyed[1], "created", NULL);
+    checkStatus("pending-1", OV_INSTANCE_CREATING, "created");
+    checkStatus("pending-2", OV_INSTANCE_DESTROYED, "created while destroyed");
+
+    const char *applied[] = { OV_INSTANCE_APPLIED, OV_INSTANCE_APPLIED };
+    ovTestCheck(setInstanceStatuses(ids, applied, NULL, 2, destroyed) == EXIT_SUCCESS && !destroyed[0] && destroyed[1], "applied", NULL);
+    checkStatus("pending-1", OV_INSTANCE_APPLIED, "applied");
+    checkStatus("pending-2", OV_INSTANCE_DESTROYED, "applied while destroyed");
+
+    const char *creatingID[] = { "creating-1" };
+    const char *failed[] = { OV_INSTANCE_FAILED };
+    ovTestCheck(setInstanceStatuses(creatingID, failed, NULL, 1, NULL) == EXIT_SUCCESS && !isClaimed("creating-1"), "failed while destroyed", NULL);
+    checkStatus("creating-1", NULL, "failed while destroyed");
+
+    // The profile of the destroyed instance has been deleted
+    ovTestCheck(removeInstancesFromState(ids + 1, 1) == EXIT_SUCCESS && !isClaimed("pending-2") && isClaimed("pending-1"), "removed", NULL);
+    checkStatus("pending-2", NULL, "removed");
+}
+
+/* Instances the pipeline never finished are failed when the plugin starts again
+ */
+
+static void checkRestart()
+{
+    ovTestCheck(failPendingInstances() == 3, "restart", "pending, posting and destroyed without a task");
+    checkStatus("pending-4", OV_INSTANCE_FAILED, "restart pending");
+    checkStatus("posting-1", OV_INSTANCE_FAILED, "restart posting");
+    checkStatus("destroyed-1", OV_INSTANCE_FAILED, "restart destroyed");
+    checkStatus("pending-1", OV_INSTANCE_APPLIED, "restart applied");
+    checkStatus("applied-1", OV_INSTANCE_APPLIED, "restart applied");
+}
+
+int main()
+{
+    char path[] = "/tmp/oneviewStateTestXXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1) {
+        return EXIT_FAILURE;
+    }
+    close(fd);
+    setStatePath(path);
+    if (writeInitialState() == EXIT_FAILURE || ovLedgerLoad() == EXIT_FAILURE) {
+        unlink(path);
+        return EXIT_FAILURE;
+    }
+    ovTestCheck(ovLedgerClaimed() == STATE_INSTANCES, "ledger", "loaded from the state");
+    checkPosting();
+    checkDestroy();
+    checkStatuses();
+    checkRestart();
+    unlink(path);
+    return ovTestResult("oneviewStateTest");
+}
@@ -0,0 +1,173 @@
+
+// oneviewStructuralTest.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#include "oneviewStructural.h"
+#include "oneviewTest.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* The index is checked against a byte by byte walk of the buffer. make test runs this with
+ * OV_STRUCTURAL set to scalar and sse2 and with the widest classifier the processor has, so
+ * every implementation has to give the same positions as the walk (and so each other).
+ */
+
+#define TEST_BLOCK 64
+
+/* A backslash escapes the next byte wherever it is (only quotes are affected by escaping),
+ * a quote that isn't escaped opens or closes a string
+ */
+
+static size_t referenceIndex(const char *buffer, size_t length, uint32_t *positions)
+{
+    size_t count = 0;
+    int escaped = 0, inString = 0;
+    for (size_t i = 0; i < length; i++) {
+        char c = buffer[i];
+        int isEscaped = escaped;
+        escaped = (c == '\\' && !isEscaped);
+        if (c == '"' && !isEscaped) {
+            positions[count++] = (uint32_t)i;
+            inString = !inString;
+        } else if (!inString && (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',')) {
+            positions[count++] = (uint32_t)i;
+        }
+    }
+    return count;
+}
+
+static void checkBuffer(ovStructuralIndex *index, const char *name, const char *buffer, size_t length)
+{
+    char detail[256];
+    uint32_t *expected = malloc((length + 1) * sizeof(uint32_t));
+    if (!expected) {
+        ovTestCheck(0, name, "out of memory");
+        return;
+    }
+    size_t expectedCount = referenceIndex(buffer, length, expected);
+    if (ovBuildStructuralIndex(index, buffer, length) == EXIT_FAILURE) {
+        ovTestCheck(0, name, "the index wasn't built");
+        free(expected);
+        return;
+    }
+    size_t mismatch = 0;
+    while (mismatch < expectedCount && mismatch < index->count && index->positions[mismatch] == expected[mismatch]) {
+        mismatch++;
+    }
+    if (mismatch < expectedCount || index->count != expectedCount) {
+        snprintf(detail, sizeof(detail), "length %zu, %zu positions (expected %zu), first difference at position %zu",
+                 length, index->count, expectedCount, mismatch);
+        ovTestCheck(0, name, detail);
+    } else {
+        ovTestCheck(1, name, NULL);
+    }
+    free(expected);
+}
+
+/* A run of backslashes ending on the last byte of a block carries into the next block, the
+ * quote that follows is escaped only if the run is odd
+ */
+
+static void checkCarries(ovStructuralIndex *index)
+{
+    char buffer[4 * TEST_BLOCK + 1];
+    char name[64];
+    for (int block = 1; block <= 3; block++) {
+        for (int run = 1; run <= 5; run++) {
+            for (int tail = 0; tail <= 2; tail++) {
+                // {"k":"....\\\"..."} with the backslashes ending at the end of a block
+                size_t end = (size_t)block * TEST_BLOCK;
+                size_t length = end + 8 + tail;
+                memset(buffer, 'a', length);
+                memcpy(buffer, "{\"k\":\"", 6);
+                memset(buffer + end - run, '\\', run);
+                memcpy(buffer + end, "\",\"x\":1", 7);
+                buffer[length - 1] = '}';
+                snprintf(name, sizeof(name), "carry block %d run %d tail %d", block, run, tail);
+                checkBuffer(index, name, buffer, length);
+            }
+        }
+    }
+}
+
+/* Every length around a block boundary, so the tail block is padded by each amount
+ */
+
+static void checkTails(ovStructuralIndex *index)
+{
+    static const char pattern[] = "{\"a\\\\\":[1,\"b\\\"c\"],\"d\":{\"e\":\"}\\\\\"},";
+    char buffer[3 * TEST_BLOCK + 1];
+    char name[64];
+    for (size_t i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = pattern[i % (sizeof(pattern) - 1)];
+    }
+    for (size_t length = 0; length <= 3 * TEST_BLOCK; length++) {
+        snprintf(name, sizeof(name), "tail length %zu", length);
+        checkBuffer(index, name, buffer, length);
+    }
+    // A backslash as the last byte of the buffer (with and without a tail block)
+    for (size_t length = TEST_BLOCK - 1; length <= TEST_BLOCK + 1; length++) {
+        memset(buffer, '"', length);
+        buffer[length - 1] = '\\';
+        snprintf(name, sizeof(name), "trailing backslash %zu", length);
+        checkBuffer(index, name, buffer, length);
+    }
+}
+
+/* Random buffers of the bytes the classifiers look for, plus the bytes that only differ from
+ * a bracket by the case bit (the SIMD classifiers fold it to find both brackets at once)
+ */
+
+static void checkRandom(ovStructuralIndex *index)
+{
+    static const char alphabet[] = "\"\"\\\\{}[]:, a\x5b\x5d\xfb\xfd\xdb\x3a\x2c\x0c";
+    char name[64];
+    unsigned int seed = 12345;
+    for (int round = 0; round < 500; round++) {
+        size_t length = (round < 400) ? (size_t)(rand_r(&seed) % (4 * TEST_BLOCK)) : (size_t)(rand_r(&seed) % 70000);
+        char *buffer = malloc(length + 1);
+        if (!buffer) {
+            ovTestCheck(0, "random", "out of memory");
+            return;
+        }
+        for (size_t i = 0; i < length; i++) {
+            buffer[i] = alphabet[rand_r(&seed) % (sizeof(alphabet) - 1)];
+        }
+        snprintf(name, sizeof(name), "random round %d", round);
+        checkBuffer(index, name, buffer, length);
+        free(buffer);
+    }
+}
+
+static void checkSeek(ovStructuralIndex *index)
+{
+    static const char buffer[] = "{\"a\":[1, 2]}";
+    ovBuildStructuralIndex(index, buffer, strlen(buffer));
+    ovTestCheck(ovStructuralSeek(index, buffer) == 0, "seek start", NULL);
+    ovTestCheck(ovStructuralSeek(index, buffer + 6) == 5, "seek between", NULL);
+    ovTestCheck(ovStructuralSeek(index, buffer + 11) == 7, "seek last", NULL);
+    ovTestCheck(ovStructuralSeek(index, buffer + 12) == OV_STRUCTURAL_END, "seek end", NULL);
+}
+
+int main()
+{
+    ovStructuralIndex index;
+    initStructuralIndex(&index);
+    printf("Structural classifier: %s\n", ovStructuralImplementation());
+    checkCarries(&index);
+    checkTails(&index);
+    checkRandom(&index);
+    checkSeek(&index);
+    freeStructuralIndex(&index);
+    return ovTestResult("oneviewStructuralTest");
+}
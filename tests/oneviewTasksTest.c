@@ -0,0 +1,184 @@
+
+// oneviewTasksTest.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#include "oneviewInfraKitTasks.h"
+#include "oneviewInfraKitState.h"
+#include "oneviewInfraKitLedger.h"
+#include "oneviewSessions.h"
+#include "oneviewSnapshot.h"
+#include "oneviewIntern.h"
+#include "oneviewTest.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+/* The appliance is stood in for by /rest/tasks answering with the state of each task (the
+ * first task is still running the first time it is checked), the state and the ledger record
+ * what the tracker does with the tasks once they finish
+ */
+
+static pthread_mutex_t recordLock = PTHREAD_MUTEX_INITIALIZER;
+static int polls;
+static char firstFilter[1024];
+static char statuses[4][64];        // Status set for instance-1, instance-2, destroyed-1, unknown
+static int releasedPowerOff;
+static int deletedProfiles;
+static int removedDestroyed;
+static int invalidations;
+
+int stringMatch(const char *string1, const char *string2)
+{
+    return string1 && string2 && strcmp(string1, string2) == 0;
+}
+
+oneviewSession *initSession()
+{
+    oneviewSession *session = calloc(1, sizeof(oneviewSession));
+    if (session) {
+        session->managed = -1;
+    }
+    return session;
+}
+
+int ovSessionAttach(oneviewSession *session, const char *address, const char *username, const char *password)
+{
+    session->address = (char *)address;
+    session->username = (char *)username;
+    return EXIT_SUCCESS;
+}
+
+char *oneViewQuery(oneviewSession *session, oneviewQuery *query, char *queryType)
+{
+    pthread_mutex_lock(&recordLock);
+    if (polls++ == 0) {
+        snprintf(firstFilter, sizeof(firstFilter), "%s", query->filter);
+    }
+    int first = (polls == 1);
+    pthread_mutex_unlock(&recordLock);
+    return strdup(first ?
+        "{\"members\":["
+        "{\"uri\":\"/rest/tasks/create-1\",\"taskState\":\"Running\"},"
+        "{\"uri\":\"/rest/tasks/create-2\",\"taskState\":\"Error\",\"taskErrors\":[{\"message\":\"no \\\"bay\\\"\"}]},"
+        "{\"uri\":\"/rest/tasks/power-1\",\"taskState\":\"Completed\"},"
+        "{\"uri\":\"/rest/tasks/create-3\",\"taskState\":\"Warning\"}]}" :
+        "{\"members\":["
+        "{\"uri\":\"/rest/tasks/create-1\",\"taskState\":\"Completed\"},"
+        "{\"uri\":\"/rest/tasks/delete-1\",\"taskState\":\"Completed\"}]}");
+}
+
+char *serverProfileFromHardwareURI(oneviewSession *session, const char *hardwareURI)
+{
+    return stringMatch(hardwareURI, "/rest/server-hardware/3") ? strdup("/rest/server-profiles/3") : NULL;
+}
+
+int ovDeleteProfile(oneviewSession *session, char *profile, char **response)
+{
+    pthread_mutex_lock(&recordLock);
+    deletedProfiles += stringMatch(profile, "/rest/server-profiles/3");
+    pthread_mutex_unlock(&recordLock);
+    free(profile);
+    *response = strdup("{\"category\":\"tasks\",\"uri\":\"/rest/tasks/delete-1\"}");
+    return EXIT_SUCCESS;
+}
+
+static int instanceIndex(const char *instanceID)
+{
+    return stringMatch(instanceID, "instance-1") ? 0 : stringMatch(instanceID, "instance-2") ? 1 :
+           stringMatch(instanceID, "destroyed-1") ? 2 : 3;
+}
+
+int setInstanceStatuses(const char **instanceIDs, const char **newStatuses, const char **tasks, size_t count, char *destroyed)
+{
+    pthread_mutex_lock(&recordLock);
+    for (size_t i = 0; i < count; i++) {
+        snprintf(statuses[instanceIndex(instanceIDs[i])], sizeof(statuses[0]), "%s", newStatuses[i] ? newStatuses[i] : "none");
+        // destroyed-1 was destroyed while its profile was being created
+        destroyed[i] = (instanceIndex(instanceIDs[i]) == 2);
+    }
+    pthread_mutex_unlock(&recordLock);
+    return EXIT_SUCCESS;
+}
+
+int removeInstancesFromState(const char **instanceIDs, size_t count)
+{
+    pthread_mutex_lock(&recordLock);
+    removedDestroyed += (count == 1 && instanceIndex(instanceIDs[0]) == 2);
+    pthread_mutex_unlock(&recordLock);
+    return EXIT_SUCCESS;
+}
+
+int ovLedgerRelease(int hardwareURI, const char *instanceID)
+{
+    pthread_mutex_lock(&recordLock);
+    releasedPowerOff += (hardwareURI == ovIntern("/rest/server-hardware/power") && !instanceID);
+    pthread_mutex_unlock(&recordLock);
+    return EXIT_SUCCESS;
+}
+
+void ovInvalidateHardwareSnapshot()
+{
+    pthread_mutex_lock(&recordLock);
+    invalidations++;
+    pthread_mutex_unlock(&recordLock);
+}
+
+static void checkTaskFromResponse()
+{
+    char *uri = ovTaskFromResponse("{\"type\":\"TaskResourceV2\",\"uri\":\"/rest/tasks/1\",\"category\":\"tasks\"}");
+    ovTestCheck(uri && strcmp(uri, "/rest/tasks/1") == 0, "task from response", uri);
+    free(uri);
+    ovTestCheck(!ovTaskFromResponse("{\"category\":\"server-profiles\",\"uri\":\"/rest/server-profiles/1\"}"), "task from response", "not a task");
+    ovTestCheck(!ovTaskFromResponse("{\"category\":\"tasks\"}") && !ovTaskFromResponse("{\"category\":") && !ovTaskFromResponse(NULL),
+                "task from response", "no task");
+}
+
+/* Every task is checked with one request, each one is acted on as it finishes (the delete of
+ * the profile of the destroyed instance is tracked in turn)
+ */
+
+static void checkTracker()
+{
+    int address = ovIntern("ov");
+    int username = ovIntern("admin");
+    ovTestCheck(ovTrackTask(OV_TASK_PROFILE_CREATE, NULL, "instance-1", OV_INTERN_NONE, address, username) == EXIT_FAILURE,
+                "track", "no task");
+    ovTrackTask(OV_TASK_PROFILE_CREATE, "/rest/tasks/create-1", "instance-1", ovIntern("/rest/server-hardware/1"), address, username);
+    ovTrackTask(OV_TASK_PROFILE_CREATE, "/rest/tasks/create-2", "instance-2", ovIntern("/rest/server-hardware/2"), address, username);
+    ovTrackTask(OV_TASK_POWER_OFF, "/rest/tasks/power-1", NULL, ovIntern("/rest/server-hardware/power"), address, username);
+    ovTrackTask(OV_TASK_PROFILE_CREATE, "/rest/tasks/create-3", "destroyed-1", ovIntern("/rest/server-hardware/3"), address, username);
+    ovTestCheck(ovTrackTask(OV_TASK_PROFILE_CREATE, "/rest/tasks/create-1", "instance-1", OV_INTERN_NONE, address, username) == EXIT_SUCCESS &&
+                ovTasksTracked() == 4 && ovTaskIsTracked("/rest/tasks/create-3") && !ovTaskIsTracked("/rest/tasks/other"), "track", NULL);
+
+    ovTestCheck(ovTaskTrackerStart() == EXIT_SUCCESS && ovTaskTrackerStart() == EXIT_FAILURE, "tracker start", NULL);
+    for (int waited = 0; ovTasksTracked() != 0 && waited < 100; waited++) {
+        usleep(100000);
+    }
+    pthread_mutex_lock(&recordLock);
+    ovTestCheck(ovTasksTracked() == 0, "tracker", "every task finished");
+    ovTestCheck(strstr(firstFilter, "uri='/rest/tasks/create-1'") && strstr(firstFilter, "uri='/rest/tasks/create-2'") &&
+                strstr(firstFilter, "uri='/rest/tasks/power-1'") && strstr(firstFilter, "uri='/rest/tasks/create-3'"), "batch", firstFilter);
+    ovTestCheck(polls >= 2 && strcmp(statuses[0], OV_INSTANCE_APPLIED) == 0 && strcmp(statuses[1], OV_INSTANCE_FAILED) == 0,
+                "statuses", statuses[0]);
+    ovTestCheck(releasedPowerOff == 1, "power off", "server released");
+    ovTestCheck(deletedProfiles == 1 && removedDestroyed == 1, "destroyed", "profile deleted and instance removed");
+    ovTestCheck(!ovTaskIsTracked("/rest/tasks/delete-1") && invalidations >= 2, "destroyed", "delete tracked until it finished");
+    pthread_mutex_unlock(&recordLock);
+}
+
+int main()
+{
+    checkTaskFromResponse();
+    checkTracker();
+    return ovTestResult("oneviewTasksTest");
+}
@@ -0,0 +1,135 @@
+
+// oneviewTemplatesTest.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#include "oneviewTemplates.h"
+#include "oneviewIntern.h"
+#include "oneviewTest.h"
+
+#include <string.h>
+#include <jansson.h>
+
+/* The appliance is stood in for by three templates, the first has an eTag, the second has
+ * neither an eTag nor a modified time and the new profile of the third can't be read. The
+ * new profile of the second has the fields of an instance before the rest of it.
+ */
+
+static const char templatesText[] = "{\"members\":["
+    "{\"name\":\"Docker Template\",\"uri\":\"/rest/server-profile-templates/1\",\"serverHardwareTypeUri\":\"/rest/server-hardware-types/1\","
+    "\"enclosureGroupUri\":\"/rest/enclosure-groups/1\",\"eTag\":\"e1\",\"modified\":\"m1\"},"
+    "{\"name\":\"Untagged\",\"uri\":\"/rest/server-profile-templates/2\",\"serverHardwareTypeUri\":\"/rest/server-hardware-types/1\","
+    "\"enclosureGroupUri\":\"/rest/enclosure-groups/1\"},"
+    "{\"name\":\"Broken\",\"uri\":\"/rest/server-profile-templates/3\",\"serverHardwareTypeUri\":\"/rest/server-hardware-types/1\","
+    "\"enclosureGroupUri\":\"/rest/enclosure-groups/1\",\"eTag\":\"e3\"}],\"nextPageUri\":null}";
+
+static const char newProfile1[] = "{\"type\":\"ServerProfileV8\",\"serverProfileTemplateUri\":\"/rest/server-profile-templates/1\","
+                                  "\"connections\":[{\"id\":1,\"name\":\"@ov.name@ is not a marker\"}],\"affinity\":\"Bay\"}";
+static const char newProfile2[] = "{\"description\":\"\",\"serverHardwareUri\":null,\"name\":\"\",\"type\":\"ServerProfileV8\"}";
+
+static size_t newProfileReads;
+
+char *oneViewQueryIfChanged(oneviewSession *session, oneviewQuery *query, char *queryType, const char *eTag, int *unchanged, char *newETag, size_t newETagSize)
+{
+    *unchanged = 0;
+    snprintf(newETag, newETagSize, "collection");
+    return strdup(templatesText);
+}
+
+char *ovQueryWithURI(oneviewSession *session, const char *uri)
+{
+    return NULL;
+}
+
+size_t oneViewMultiQuery(oneviewSession *session, char **uris, size_t count, char **responses)
+{
+    size_t read = 0;
+    for (size_t i = 0; i < count; i++) {
+        responses[i] = NULL;
+        if (strstr(uris[i], "/rest/server-profile-templates/1/new-profile")) {
+            responses[i] = strdup(newProfile1);
+        } else if (strstr(uris[i], "/rest/server-profile-templates/2/new-profile")) {
+            responses[i] = strdup(newProfile2);
+        } else if (strstr(uris[i], "/rest/server-profile-templates/3/new-profile")) {
+            responses[i] = strdup("[]");
+        }
+        read += responses[i] ? 1 : 0;
+        newProfileReads++;
+    }
+    return read;
+}
+
+static int fieldIs(json_t *profile, const char *field, const char *expected)
+{
+    json_t *value = json_object_get(profile, field);
+    if (!expected) {
+        return json_is_null(value);
+    }
+    return json_is_string(value) && strcmp(json_string_value(value), expected) == 0;
+}
+
+/* Patch an instance into the new profile of a template, the body has to read back with the
+ * fields of the instance and the rest of the new profile as it was
+ */
+
+static json_t *checkProfile(oneviewSession *session, int templateURI, const char *name, const char *hardwareURI,
+                            const char *description, const char *test)
+{
+    char *body = ovTemplateProfile(session, templateURI, name, hardwareURI, description);
+    json_t *profile = body ? json_loads(body, 0, NULL) : NULL;
+    ovTestCheck(json_is_object(profile) && fieldIs(profile, "name", name) && fieldIs(profile, "serverHardwareUri", hardwareURI) &&
+                fieldIs(profile, "description", description) && fieldIs(profile, "type", "ServerProfileV8"), test, body);
+    free(body);
+    return profile;
+}
+
+static void checkPatching(oneviewSession *session)
+{
+    int template1 = ovIntern("/rest/server-profile-templates/1");
+    int template2 = ovIntern("/rest/server-profile-templates/2");
+    int template3 = ovIntern("/rest/server-profile-templates/3");
+    int unknown = ovIntern("/rest/server-profile-templates/unknown");
+    ovTestCheck(ovTemplateProfile(session, template1, "a", "b", "c") == NULL, "not prepared", NULL);
+
+    int templates[] = { template1, template2, template3, unknown, template1 };
+    ovTestCheck(ovTemplatesPrepare(session, templates, 5) == 2 && newProfileReads == 3, "prepare", "read once each");
+
+    json_t *profile = checkProfile(session, template1, "docker-1", "/rest/server-hardware/1", "Docker", "patch");
+    json_t *connection = json_array_get(json_object_get(profile, "connections"), 0);
+    ovTestCheck(fieldIs(profile, "affinity", "Bay") && fieldIs(connection, "name", "@ov.name@ is not a marker"),
+                "patch", "the rest of the new profile");
+    json_decref(profile);
+
+    // Fields before the rest of the new profile (and in another order), values that need escaping
+    json_decref(checkProfile(session, template2, "q\"uote", "/rest/server-hardware/\\2", "line\nbreak\ttab", "order and escaping"));
+    json_decref(checkProfile(session, template1, "caf\xc3\xa9", "/rest/server-hardware/1", NULL, "utf-8 and null"));
+    json_decref(checkProfile(session, template1, "\"@ov.description@\"", "@ov.name@", "@ov.serverHardwareUri@", "marker values"));
+
+    ovTestCheck(ovTemplateProfile(session, template3, "a", "b", "c") == NULL, "no prototype", "new profile not an object");
+    ovTestCheck(ovTemplateProfile(session, unknown, "a", "b", "c") == NULL, "no prototype", "unknown template");
+
+    // The template with an eTag is current, the one without is read for every batch
+    newProfileReads = 0;
+    ovTestCheck(ovTemplatesPrepare(session, templates, 2) == 2 && newProfileReads == 1, "prepare again", "untagged read again");
+
+    ovTemplatesClear();
+    ovTestCheck(ovTemplateProfile(session, template1, "a", "b", "c") == NULL, "clear", NULL);
+}
+
+int main()
+{
+    oneviewSession session;
+    memset(&session, 0, sizeof(session));
+    session.address = "ov";
+    session.cookie = "cookie";
+    checkPatching(&session);
+    return ovTestResult("oneviewTemplatesTest");
+}
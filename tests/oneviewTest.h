@@ -0,0 +1,42 @@
+
+// oneviewTest.h
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#ifndef oneviewTest_h
+#define oneviewTest_h
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Every test is a small program (built with make test), a check that fails is printed and
+ * the program exits with EXIT_FAILURE once all of the checks have run
+ */
+
+static int ovTestChecks;
+static int ovTestFailures;
+
+static void ovTestCheck(int passed, const char *name, const char *detail)
+{
+    ovTestChecks++;
+    if (!passed) {
+        ovTestFailures++;
+        printf("FAIL %s: %s\n", name, detail ? detail : "");
+    }
+}
+
+static int ovTestResult(const char *suite)
+{
+    printf("%s: %d checks, %d failed\n", suite, ovTestChecks, ovTestFailures);
+    return ovTestFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif /* oneviewTest_h */
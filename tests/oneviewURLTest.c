@@ -0,0 +1,146 @@
+
+// oneviewURLTest.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+#include "oneview.h"
+#include "oneviewTest.h"
+
+#include <string.h>
+
+typedef struct {
+    const char *text;
+    const char *escaped;
+} escapeCase;
+
+static const escapeCase escapeCases[] = {
+    { "", "" },
+    { "AZaz09-_.~", "AZaz09-_.~" },
+    { "a b", "a%20b" },
+    { "name='Docker Template'", "name%3D%27Docker%20Template%27" },
+    { "\"state\" = 'On' AND x<>y", "%22state%22%20%3D%20%27On%27%20AND%20x%3C%3Ey" },
+    { "/rest/server-hardware?start=0&count=1", "%2Frest%2Fserver-hardware%3Fstart%3D0%26count%3D1" },
+    { "100%+#", "100%25%2B%23" },
+    { "caf\xc3\xa9", "caf%C3%A9" },
+    { "\x01\x7f\xff", "%01%7F%FF" },
+};
+
+static void checkEscaping(oneviewURL *url)
+{
+    for (size_t i = 0; i < sizeof(escapeCases) / sizeof(escapeCases[0]); i++) {
+        ovURLReset(url);
+        int result = ovURLAppendEscaped(url, escapeCases[i].text);
+        ovTestCheck(result == EXIT_SUCCESS && strcmp(url->data, escapeCases[i].escaped) == 0 &&
+                    url->length == strlen(escapeCases[i].escaped), escapeCases[i].text, url->data);
+    }
+}
+
+typedef struct {
+    const char *uri;
+    const char *filter;
+    const char *sort;
+    int start;
+    int count;
+    const char *expected;
+    const char *queryText;
+    const char *fields;
+} buildCase;
+
+static const buildCase buildCases[] = {
+    { "/rest/version", NULL, NULL, 0, 0, "https://ov/rest/version" },
+    { "/rest/server-hardware", "\"state='NoProfileApplied'\"", NULL, 0, 0,
+      "https://ov/rest/server-hardware?filter=%22state%3D%27NoProfileApplied%27%22" },
+    { "/rest/server-hardware", NULL, "name:asc", 5, 10, "https://ov/rest/server-hardware?sort=name%3Aasc&start=5&count=10" },
+    { "/rest/tasks?view=tree", NULL, NULL, 0, 1, "https://ov/rest/tasks?view=tree&count=1" },
+    // Every field of the query together (each combination had its own format before)
+    { "/rest/server-profiles", "name='a b'", "name:asc", 2, 3,
+      "https://ov/rest/server-profiles?filter=name%3D%27a%20b%27&query=status%20EQ%20%27OK%27&sort=name%3Aasc"
+      "&fields=name%2Curi&start=2&count=3", "status EQ 'OK'", "name,uri" },
+    { "/rest/server-hardware", "state='On'", NULL, 0, 0,
+      "https://ov/rest/server-hardware?filter=state%3D%27On%27&query=x", "x", NULL },
+    { "/rest/server-hardware", NULL, NULL, 0, 0, "https://ov/rest/server-hardware?query=x&fields=uri", "x", "uri" },
+    { "/rest/tasks", NULL, NULL, -1, -1, "https://ov/rest/tasks" },
+};
+
+static void checkBuild(oneviewURL *url)
+{
+    for (size_t i = 0; i < sizeof(buildCases) / sizeof(buildCases[0]); i++) {
+        const buildCase *test = &buildCases[i];
+        oneviewQuery query;
+        memset(&query, 0, sizeof(query));
+        query.filter = (char *)test->filter;
+        query.sort = (char *)test->sort;
+        query.start = test->start;
+        query.count = test->count;
+        query.query = (char *)test->queryText;
+        query.fields = (char *)test->fields;
+        int result = ovURLBuild(url, "ov", test->uri, &query);
+        ovTestCheck(result == EXIT_SUCCESS && strcmp(url->data, test->expected) == 0, test->expected, url->data);
+    }
+    ovTestCheck(ovURLBuild(url, "ov", "/rest/login-sessions", NULL) == EXIT_SUCCESS &&
+                strcmp(url->data, "https://ov/rest/login-sessions") == 0, "no query", url->data);
+    ovTestCheck(ovURLBuild(url, NULL, "/rest/version", NULL) == EXIT_FAILURE &&
+                ovURLAddParameter(url, "filter", NULL) == EXIT_FAILURE, "missing", NULL);
+
+    ovURLReset(url);
+    ovTestCheck(ovURLAddIntegerParameter(url, "start", -5) == EXIT_SUCCESS && ovURLAddIntegerParameter(url, "count", 0) == EXIT_SUCCESS &&
+                strcmp(url->data, "?start=-5&count=0") == 0, "integer parameters", url->data);
+}
+
+/* URLs that fit the buffer are built in it, without allocating for each one
+ */
+
+static void checkReuse(oneviewURL *url)
+{
+    ovURLBuild(url, "ov", "/rest/version", NULL);
+    char *data = url->data;
+    size_t size = url->size;
+    oneviewQuery query;
+    memset(&query, 0, sizeof(query));
+    query.filter = "uri='/rest/tasks/1' OR uri='/rest/tasks/2'";
+    query.count = 2;
+    int reused = 1;
+    for (int i = 0; i < 100; i++) {
+        reused = reused && ovURLBuild(url, "ov", "/rest/tasks", &query) == EXIT_SUCCESS && url->data == data && url->size == size;
+    }
+    ovTestCheck(reused, "reuse", url->data);
+}
+
+/* A URL longer than the initial buffer grows it, and the buffer is kept for the next URL
+ */
+
+static void checkGrowth(oneviewURL *url)
+{
+    char value[3000];
+    memset(value, ' ', sizeof(value) - 1);
+    value[sizeof(value) - 1] = '\0';
+    ovURLReset(url);
+    int result = ovURLAddParameter(url, "q", value);
+    ovTestCheck(result == EXIT_SUCCESS && url->length == 3 + 3 * (sizeof(value) - 1) &&
+                strlen(url->data) == url->length && strncmp(url->data, "?q=%20", 6) == 0, "growth", NULL);
+    size_t size = url->size;
+    ovURLReset(url);
+    ovTestCheck(url->size == size && url->length == 0 && url->data[0] == '\0', "reset", NULL);
+}
+
+int main()
+{
+    oneviewURL *url = initURL();
+    if (!url) {
+        return EXIT_FAILURE;
+    }
+    checkEscaping(url);
+    checkBuild(url);
+    checkReuse(url);
+    checkGrowth(url);
+    freeURL(url);
+    return ovTestResult("oneviewURLTest");
+}
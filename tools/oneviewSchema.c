@@ -0,0 +1,358 @@
+
+// oneviewSchema.c
+
+/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView
+ *
+ * Dan Finneran <finneran@hpe.com>
+ *
+ * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;
+ *
+ * This software may be modified and distributed under the terms
+ * of the Apache 2.0 license.  See the LICENSE file for details.
+ */
+
+/* Generates the typed structs and parsers of the OneView resources from the files in schema/
+ * (this is run by the Makefile whenever a schema changes)
+ *
+ * ./tools/oneviewSchema <header> <source> <schema> [schema ...]
+ *
+ * A schema names the resource and then lists its fields, one per line:
+ *
+ *  # Comment, the first comment becomes the comment of the struct
+ *  resource ServerHardware
+ *  string uri
+ *  integer memoryMb
+ *
+ * The types are string, integer, boolean, object and array. Strings, objects and arrays are
+ * slices of the response (nothing is copied), integers are long long and booleans are int.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MAX_RESOURCES 32
+#define MAX_FIELDS 64   // A field is a bit of present
+#define MAX_NAME 128
+
+#define TYPE_STRING  0
+#define TYPE_INTEGER 1
+#define TYPE_BOOLEAN 2
+#define TYPE_OBJECT  3
+#define TYPE_ARRAY   4
+
+static const char *typeNames[] = { "string", "integer", "boolean", "object", "array" };
+
+typedef struct {
+    char key[MAX_NAME];
+    int type;
+} schemaField;
+
+typedef struct {
+    char name[MAX_NAME];            // e.g. ServerHardware
+    char macro[MAX_NAME];           // e.g. SERVER_HARDWARE
+    char comment[256];
+    schemaField fields[MAX_FIELDS];
+    int fieldCount;
+} schemaResource;
+
+static schemaResource resources[MAX_RESOURCES];
+static int resourceCount = 0;
+
+static void schemaError(const char *path, int line, const char *message, const char *detail)
+{
+    fprintf(stderr, "%s:%d: %s%s%s\n", path, line, message, detail ? " " : "", detail ? detail : "");
+    exit(EXIT_FAILURE);
+}
+
+static int isIdentifier(const char *text)
+{
+    if (!isalpha((unsigned char)*text) && *text != '_') {
+        return 0;
+    }
+    for (text++; *text; text++) {
+        if (!isalnum((unsigned char)*text) && *text != '_') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* serverHardwareTypeUri -> SERVER_HARDWARE_TYPE_URI */
+
+static void macroName(const char *name, char *macro, size_t size)
+{
+    size_t used = 0;
+    for (size_t i = 0; name[i] && used + 2 < size; i++) {
+        if (i != 0 && isupper((unsigned char)name[i]) && !isupper((unsigned char)name[i - 1])) {
+            macro[used++] = '_';
+        }
+        macro[used++] = toupper((unsigned char)name[i]);
+    }
+    macro[used] = '\0';
+}
+
+static void readSchema(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        schemaError(path, 0, "unable to open the schema", NULL);
+    }
+    schemaResource *resource = NULL;
+    char comment[256] = "";
+    char text[512];
+    int line = 0;
+    while (fgets(text, sizeof(text), file)) {
+        line++;
+        char *start = text;
+        while (isspace((unsigned char)*start)) {
+            start++;
+        }
+        char *end = start + strlen(start);
+        while (end > start && isspace((unsigned char)end[-1])) {
+            *--end = '\0';
+        }
+        if (*start == '\0') {
+            continue;
+        }
+        if (*start == '#') {
+            if (comment[0] == '\0' && !resource) {
+                start++;
+                while (isspace((unsigned char)*start)) {
+                    start++;
+                }
+                snprintf(comment, sizeof(comment), "%s", start);
+            }
+            continue;
+        }
+        char word[MAX_NAME], name[MAX_NAME], extra[MAX_NAME];
+        if (sscanf(start, "%127s %127s %127s", word, name, extra) != 2) {
+            schemaError(path, line, "expected \"<type> <key>\" or \"resource <Name>\"", NULL);
+        }
+        if (!isIdentifier(name)) {
+            schemaError(path, line, "not a C identifier:", name);
+        }
+        if (strcmp(word, "resource") == 0) {
+            if (resource) {
+                schemaError(path, line, "only one resource can be in a schema", NULL);
+            }
+            if (resourceCount == MAX_RESOURCES) {
+                schemaError(path, line, "too many resources", NULL);
+            }
+            for (int i = 0; i < resourceCount; i++) {
+                if (strcmp(resources[i].name, name) == 0) {
+                    schemaError(path, line, "resource is already defined:", name);
+                }
+            }
+            resource = &resources[resourceCount++];
+            snprintf(resource->name, sizeof(resource->name), "%s", name);
+            macroName(name, resource->macro, sizeof(resource->macro));
+            snprintf(resource->comment, sizeof(resource->comment), "%s", comment[0] ? comment : name);
+            continue;
+        }
+        if (!resource) {
+            schemaError(path, line, "a field comes before the resource", NULL);
+        }
+        int type = -1;
+        for (int i = 0; i < (int)(sizeof(typeNames) / sizeof(char *)); i++) {
+            if (strcmp(word, typeNames[i]) == 0) {
+                type = i;
+            }
+        }
+        if (type == -1) {
+            schemaError(path, line, "unknown type:", word);
+        }
+        if (strcmp(name, "present") == 0) {
+            schemaError(path, line, "present is reserved", NULL);
+        }
+        for (int i = 0; i < resource->fieldCount; i++) {
+            if (strcmp(resource->fields[i].key, name) == 0) {
+                schemaError(path, line, "field is already defined:", name);
+            }
+        }
+        if (resource->fieldCount == MAX_FIELDS) {
+            schemaError(path, line, "too many fields", NULL);
+        }
+        schemaField *field = &resource->fields[resource->fieldCount++];
+        snprintf(field->key, sizeof(field->key), "%s", name);
+        field->type = type;
+    }
+    fclose(file);
+    if (!resource || resource->fieldCount == 0) {
+        schemaError(path, line, "a schema needs a resource and at least one field", NULL);
+    }
+}
+
+static const char *baseName(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+static void writeBanner(FILE *file, const char *path)
+{
+    fprintf(file, "\n// %s\n\n", baseName(path));
+    fprintf(file, "/* instance-infrakit-oneview - A Docker InfraKit plugin for HPE OneView\n"
+                  " *\n"
+                  " * Dan Finneran <finneran@hpe.com>\n"
+                  " *\n"
+                  " * (c) Copyright [2017] Hewlett Packard Enterprise Development LP;\n"
+                  " *\n"
+                  " * This software may be modified and distributed under the terms\n"
+                  " * of the Apache 2.0 license.  See the LICENSE file for details.\n"
+                  " */\n\n");
+    fprintf(file, "/* Generated from schema/ by tools/oneviewSchema, edit the schema and run make rather than\n"
+                  " * editing this file\n"
+                  " */\n\n");
+}
+
+static void writeHeader(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        schemaError(path, 0, "unable to write", NULL);
+    }
+    writeBanner(file, path);
+    fprintf(file, "#ifndef oneviewResources_h\n#define oneviewResources_h\n\n");
+    fprintf(file, "#include \"oneviewExtract.h\"\n\n");
+    fprintf(file, "/* Each parser reads the top level members of one resource (a member of a collection, or the\n"
+                  " * response of a GET) in a single pass. Strings, objects and arrays are slices of the buffer,\n"
+                  " * so they are only valid while it is. A value is only taken if it has the type in the\n"
+                  " * schema, the fields that were taken are set in present. Returns the number of fields that\n"
+                  " * were found or -1 if the buffer isn't an object.\n"
+                  " */\n\n");
+    for (int r = 0; r < resourceCount; r++) {
+        schemaResource *resource = &resources[r];
+        fprintf(file, "// %s\n", resource->comment);
+        for (int i = 0; i < resource->fieldCount; i++) {
+            char macro[MAX_NAME];
+            macroName(resource->fields[i].key, macro, sizeof(macro));
+            fprintf(file, "#define OV_%s_%s (1ULL << %d)\n", resource->macro, macro, i);
+        }
+        fprintf(file, "\ntypedef struct {\n");
+        for (int i = 0; i < resource->fieldCount; i++) {
+            schemaField *field = &resource->fields[i];
+            const char *ctype = (field->type == TYPE_INTEGER) ? "long long" : (field->type == TYPE_BOOLEAN) ? "int" : "ovJSONSlice";
+            fprintf(file, "    %s %s;\n", ctype, field->key);
+        }
+        fprintf(file, "    unsigned long long present;\n");
+        fprintf(file, "} oneview%s;\n\n", resource->name);
+    }
+    for (int r = 0; r < resourceCount; r++) {
+        fprintf(file, "int ovParse%s(const ovStructuralIndex *index, const char *buffer, size_t length, oneview%s *resource);\n",
+                resources[r].name, resources[r].name);
+    }
+    fprintf(file, "\n#endif /* oneviewResources_h */\n");
+    if (fclose(file) != 0) {
+        schemaError(path, 0, "unable to write", NULL);
+    }
+}
+
+static int compareLength(const void *a, const void *b)
+{
+    const char *keyA = ((const schemaField *)a)->key;
+    const char *keyB = ((const schemaField *)b)->key;
+    size_t lengthA = strlen(keyA);
+    size_t lengthB = strlen(keyB);
+    return (lengthA != lengthB) ? (lengthA > lengthB) - (lengthA < lengthB) : strcmp(keyA, keyB);
+}
+
+static void writeTake(FILE *file, const schemaResource *resource, const schemaField *field)
+{
+    static const char *checks[] = {
+        "value.type == OV_JSON_STRING",
+        "value.type == OV_JSON_NUMBER",
+        "value.type == OV_JSON_TRUE || value.type == OV_JSON_FALSE",
+        "value.type == OV_JSON_OBJECT",
+        "value.type == OV_JSON_ARRAY"
+    };
+    char macro[MAX_NAME];
+    macroName(field->key, macro, sizeof(macro));
+    fprintf(file, "                    if (%s) {\n", checks[field->type]);
+    switch (field->type) {
+        case TYPE_INTEGER:
+            fprintf(file, "                        resource->%s = ovSliceInteger(&value);\n", field->key);
+            break;
+        case TYPE_BOOLEAN:
+            fprintf(file, "                        resource->%s = (value.type == OV_JSON_TRUE);\n", field->key);
+            break;
+        default:
+            fprintf(file, "                        resource->%s = value;\n", field->key);
+            break;
+    }
+    fprintf(file, "                        resource->present |= OV_%s_%s;\n", resource->macro, macro);
+    fprintf(file, "                    }\n");
+}
+
+static void writeSource(const char *path, const char *headerPath)
+{
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        schemaError(path, 0, "unable to write", NULL);
+    }
+    writeBanner(file, path);
+    fprintf(file, "#include \"%s\"\n\n#include <string.h>\n\n", baseName(headerPath));
+    fprintf(file, "static int isObject(const char *buffer, size_t length)\n"
+                  "{\n"
+                  "    const char *end = buffer + length;\n"
+                  "    while (buffer < end && (*buffer == ' ' || *buffer == '\\t' || *buffer == '\\n' || *buffer == '\\r')) {\n"
+                  "        buffer++;\n"
+                  "    }\n"
+                  "    return (buffer < end) && (*buffer == '{');\n"
+                  "}\n");
+    for (int r = 0; r < resourceCount; r++) {
+        schemaResource *resource = &resources[r];
+        // The keys are matched on their length first, then compared
+        schemaField sorted[MAX_FIELDS];
+        memcpy(sorted, resource->fields, sizeof(schemaField) * resource->fieldCount);
+        qsort(sorted, resource->fieldCount, sizeof(schemaField), compareLength);
+        unsigned long long all = (resource->fieldCount == 64) ? ~0ULL : ((1ULL << resource->fieldCount) - 1);
+
+        fprintf(file, "\n/* %s */\n\n", resource->comment);
+        fprintf(file, "int ovParse%s(const ovStructuralIndex *index, const char *buffer, size_t length, oneview%s *resource)\n",
+                resource->name, resource->name);
+        fprintf(file, "{\n"
+                      "    if (!buffer || !resource || !isObject(buffer, length)) {\n"
+                      "        return -1;\n"
+                      "    }\n"
+                      "    memset(resource, 0, sizeof(oneview%s));\n"
+                      "    ovJSONSlice object = { buffer, length, OV_JSON_OBJECT };\n"
+                      "    ovJSONSlice key, value;\n"
+                      "    size_t offset = 0;\n"
+                      "    while (resource->present != 0x%llxULL && ovNextIndexedMember(index, &object, &offset, &key, &value)) {\n"
+                      "        switch (key.length) {\n", resource->name, all);
+        for (int i = 0; i < resource->fieldCount; ) {
+            size_t length = strlen(sorted[i].key);
+            fprintf(file, "            case %zu:\n", length);
+            for (int first = i; i < resource->fieldCount && strlen(sorted[i].key) == length; i++) {
+                fprintf(file, "                %sif (memcmp(key.start, \"%s\", %zu) == 0) {\n", (i == first) ? "" : "} else ",
+                        sorted[i].key, length);
+                writeTake(file, resource, &sorted[i]);
+            }
+            fprintf(file, "                }\n"
+                          "                break;\n");
+        }
+        fprintf(file, "        }\n"
+                      "    }\n"
+                      "    return __builtin_popcountll(resource->present);\n"
+                      "}\n");
+    }
+    if (fclose(file) != 0) {
+        schemaError(path, 0, "unable to write", NULL);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 4) {
+        fprintf(stderr, "Usage: ./oneviewSchema <header> <source> <schema> [schema ...]\n");
+        return EXIT_FAILURE;
+    }
+    for (int i = 3; i < argc; i++) {
+        readSchema(argv[i]);
+    }
+    writeHeader(argv[1]);
+    writeSource(argv[2], argv[1]);
+    return EXIT_SUCCESS;
+}